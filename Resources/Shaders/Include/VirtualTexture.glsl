@@ -0,0 +1,92 @@
+// Samples a virtual texture through its page table, and marks the pages wanted in the feedback buffer.
+// Define VIRTUAL_TEXTURE_SET and the bindings before including to move the resources.
+
+#ifndef VIRTUAL_TEXTURE_SET
+#define VIRTUAL_TEXTURE_SET 0
+#endif
+#ifndef VIRTUAL_TEXTURE_ATLAS_BINDING
+#define VIRTUAL_TEXTURE_ATLAS_BINDING 0
+#endif
+#ifndef VIRTUAL_TEXTURE_PAGE_TABLE_BINDING
+#define VIRTUAL_TEXTURE_PAGE_TABLE_BINDING 1
+#endif
+#ifndef VIRTUAL_TEXTURE_FEEDBACK_BINDING
+#define VIRTUAL_TEXTURE_FEEDBACK_BINDING 2
+#endif
+
+#define PAGE_TABLE_VALID 0x80000000u
+
+struct VirtualTextureInfo
+{
+    uvec2 pageCount;
+    uint levelCount;
+    uint pageSize;
+    uint border;
+    uint atlasPages;
+    float lodBias;
+    uint padding;
+};
+
+// pipelines give virtualAtlas the LinearClamp stock sampler as an immutable sampler, so it is never written
+layout(set = VIRTUAL_TEXTURE_SET, binding = VIRTUAL_TEXTURE_ATLAS_BINDING) uniform sampler2D virtualAtlas;
+
+layout(set = VIRTUAL_TEXTURE_SET, binding = VIRTUAL_TEXTURE_PAGE_TABLE_BINDING) readonly buffer VirtualPageTable
+{
+    uint virtualPageTable[];
+};
+
+layout(set = VIRTUAL_TEXTURE_SET, binding = VIRTUAL_TEXTURE_FEEDBACK_BINDING) writeonly buffer VirtualFeedback
+{
+    uint virtualFeedback[];
+};
+
+uvec2 VirtualLevelPages(VirtualTextureInfo info, uint level)
+{
+    return max(info.pageCount >> level, uvec2(1));
+}
+
+uint VirtualPageIndex(VirtualTextureInfo info, uvec2 page, uint level)
+{
+    uint index = 0;
+    for (uint i = 0; i < level; i++)
+    {
+        uvec2 pages = VirtualLevelPages(info, i);
+        index += pages.x * pages.y;
+    }
+    return index + page.y * VirtualLevelPages(info, level).x + page.x;
+}
+
+vec4 SampleVirtual(VirtualTextureInfo info, vec2 uv)
+{
+    // choose the level the same way hardware would for a texture of the full size, using the unwrapped
+    // coordinates so the derivatives don't jump where the texture repeats
+    vec2 texels = uv * vec2(info.pageCount * info.pageSize);
+    vec2 dx = dFdx(texels);
+    vec2 dy = dFdy(texels);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + info.lodBias;
+    uint level = uint(clamp(lod, 0.0, float(info.levelCount - 1)));
+
+    uv = fract(uv);
+
+    uvec2 levelPages = VirtualLevelPages(info, level);
+    uvec2 page = min(uvec2(uv * vec2(levelPages)), levelPages - 1);
+    uint index = VirtualPageIndex(info, page, level);
+
+    virtualFeedback[index] = 1;
+
+    uint entry = virtualPageTable[index];
+    if ((entry & PAGE_TABLE_VALID) == 0)
+    {
+        return vec4(0.0);
+    }
+
+    // the entry may be for a coarser page, so find the position within that page
+    uvec2 slot = uvec2(entry & 0xFFF, (entry >> 12) & 0xFFF);
+    uint residentLevel = (entry >> 24) & 0x1F;
+    vec2 position = fract(uv * vec2(VirtualLevelPages(info, residentLevel)));
+
+    float tileSize = float(info.pageSize + 2 * info.border);
+    vec2 atlasTexel = vec2(slot) * tileSize + float(info.border) + position * float(info.pageSize);
+
+    return textureLod(virtualAtlas, atlasTexel / (tileSize * float(info.atlasPages)), 0.0);
+}
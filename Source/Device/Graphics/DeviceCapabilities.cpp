@@ -0,0 +1,197 @@
+#include "stdafx.h"
+#include "DeviceCapabilities.h"
+
+#define LOG_TAG MANTIS_TEXT("DeviceCapabilities")
+
+namespace Mantis
+{
+    /// <summary>
+    /// The vendors whose GPUs are tile based: ARM, Qualcomm, Imagination and Apple.
+    /// </summary>
+    static const eastl::vector<uint32_t> TILE_BASED_VENDORS =
+    {
+        0x13B5,
+        0x5143,
+        0x1010,
+        0x106B,
+    };
+
+    DeviceCapabilities DeviceCapabilities::Query(const VkPhysicalDevice& device, const uint32_t& instanceApiVersion)
+    {
+        DeviceCapabilities capabilities;
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device, &properties);
+
+        capabilities.apiVersion = eastl::min(properties.apiVersion, instanceApiVersion);
+
+        // Vulkan can't report this, so it is assumed from the vendor
+        capabilities.tileBasedRenderer = eastl::find(TILE_BASED_VENDORS.begin(), TILE_BASED_VENDORS.end(), properties.vendorID) != TILE_BASED_VENDORS.end();
+
+        // the Vulkan 1.1 and 1.2 structures were only added in 1.2, so older devices are left at the baseline
+        if (capabilities.apiVersion < VK_API_VERSION_1_2)
+        {
+            return capabilities;
+        }
+
+        VkPhysicalDeviceVulkan11Features features11 = {};
+        features11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+        VkPhysicalDeviceVulkan12Features features12 = {};
+        features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceVulkan13Features features13 = {};
+        features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+
+        features11.pNext = &features12;
+
+        // older devices may still support these through the extensions they were promoted from
+        VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features = {};
+        synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+        VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = {};
+        dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+
+        if (capabilities.apiVersion >= VK_API_VERSION_1_3)
+        {
+            features12.pNext = &features13;
+        }
+        else
+        {
+            uint32_t extensionCount;
+            vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+            eastl::vector<VkExtensionProperties> extensions(extensionCount);
+            vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+
+            const auto isSupported = [&](const char* name)
+            {
+                return eastl::any_of(extensions.begin(), extensions.end(), [&](const VkExtensionProperties& extension)
+                {
+                    return strcmp(extension.extensionName, name) == 0;
+                });
+            };
+
+            if (isSupported(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME))
+            {
+                synchronization2Features.pNext = features12.pNext;
+                features12.pNext = &synchronization2Features;
+            }
+            if (isSupported(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+            {
+                dynamicRenderingFeatures.pNext = features12.pNext;
+                features12.pNext = &dynamicRenderingFeatures;
+            }
+        }
+
+        VkPhysicalDeviceFeatures2 features = {};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &features11;
+        vkGetPhysicalDeviceFeatures2(device, &features);
+
+        VkPhysicalDeviceVulkan11Properties properties11 = {};
+        properties11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_PROPERTIES;
+        VkPhysicalDeviceVulkan12Properties properties12 = {};
+        properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+        properties11.pNext = &properties12;
+
+        VkPhysicalDeviceProperties2 properties2 = {};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &properties11;
+        vkGetPhysicalDeviceProperties2(device, &properties2);
+
+        capabilities.timelineSemaphore = features12.timelineSemaphore;
+        capabilities.descriptorIndexing =
+            features12.descriptorIndexing &&
+            features12.runtimeDescriptorArray &&
+            features12.descriptorBindingPartiallyBound &&
+            features12.descriptorBindingVariableDescriptorCount &&
+            features12.descriptorBindingSampledImageUpdateAfterBind &&
+            features12.descriptorBindingStorageBufferUpdateAfterBind &&
+            features12.shaderSampledImageArrayNonUniformIndexing;
+        capabilities.bufferDeviceAddress = features12.bufferDeviceAddress;
+        capabilities.shaderDrawParameters = features11.shaderDrawParameters;
+        capabilities.synchronization2 = features13.synchronization2 || synchronization2Features.synchronization2;
+        capabilities.dynamicRendering = features13.dynamicRendering || dynamicRenderingFeatures.dynamicRendering;
+
+        capabilities.subgroupSize = properties11.subgroupSize;
+        capabilities.maxBindlessSampledImages = properties12.maxDescriptorSetUpdateAfterBindSampledImages;
+        capabilities.maxBindlessStorageBuffers = properties12.maxDescriptorSetUpdateAfterBindStorageBuffers;
+
+        if (capabilities.timelineSemaphore &&
+            capabilities.descriptorIndexing &&
+            capabilities.bufferDeviceAddress &&
+            capabilities.shaderDrawParameters)
+        {
+            capabilities.tier = DeviceTier::Bindless;
+
+            if (capabilities.synchronization2 && capabilities.dynamicRendering)
+            {
+                capabilities.tier = DeviceTier::Modern;
+            }
+        }
+
+        return capabilities;
+    }
+
+    DeviceCapabilities DeviceCapabilities::LimitTo(const DeviceTier& maxTier) const
+    {
+        auto capabilities = *this;
+
+        // capabilities above the tier are dropped even if available, so each tier always runs the same paths
+        if (maxTier < DeviceTier::Modern || tier < DeviceTier::Modern)
+        {
+            capabilities.synchronization2 = false;
+            capabilities.dynamicRendering = false;
+        }
+        if (maxTier < DeviceTier::Bindless || tier < DeviceTier::Bindless)
+        {
+            capabilities.timelineSemaphore = false;
+            capabilities.descriptorIndexing = false;
+            capabilities.bufferDeviceAddress = false;
+            capabilities.shaderDrawParameters = false;
+        }
+
+        capabilities.tier = eastl::min(tier, maxTier);
+        return capabilities;
+    }
+
+    String DeviceCapabilities::ToString() const
+    {
+        String result;
+        result.sprintf("Tier: %s Vulkan: %u.%u.%u",
+            GetTierName(tier),
+            VK_VERSION_MAJOR(apiVersion),
+            VK_VERSION_MINOR(apiVersion),
+            VK_VERSION_PATCH(apiVersion));
+
+        const auto append = [&](const char* name, const bool& enabled)
+        {
+            if (enabled)
+            {
+                result.append_sprintf(" %s", name);
+            }
+        };
+
+        append("timelineSemaphore", timelineSemaphore);
+        append("descriptorIndexing", descriptorIndexing);
+        append("bufferDeviceAddress", bufferDeviceAddress);
+        append("shaderDrawParameters", shaderDrawParameters);
+        append("synchronization2", synchronization2);
+        append("dynamicRendering", dynamicRendering);
+        append("tileBasedRenderer", tileBasedRenderer);
+
+        return result;
+    }
+
+    const char* DeviceCapabilities::GetTierName(const DeviceTier& tier)
+    {
+        switch (tier)
+        {
+            case DeviceTier::Baseline:  return "Baseline";
+            case DeviceTier::Bindless:  return "Bindless";
+            case DeviceTier::Modern:    return "Modern";
+            default:
+                Logger::ErrorT(LOG_TAG, "Unknown device tier!");
+                return "Unknown";
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Mantis.h"
+
+namespace Mantis
+{
+    /// <summary>
+    /// A set of device capabilities that enable the renderer's faster paths. Each tier includes the ones below it.
+    /// </summary>
+    enum struct DeviceTier : uint32_t
+    {
+        /// <summary>
+        /// Vulkan 1.1 with the core features, which every supported device has.
+        /// </summary>
+        Baseline = 0,
+        /// <summary>
+        /// Vulkan 1.2 with timeline semaphores, descriptor indexing, buffer device addresses and shader draw
+        /// parameters, which allow bindless resources and GPU driven rendering.
+        /// </summary>
+        Bindless = 1,
+        /// <summary>
+        /// Vulkan 1.3 with synchronization2 and dynamic rendering, or Vulkan 1.2 with the extensions they were promoted from.
+        /// </summary>
+        Modern = 2,
+    };
+
+    /// <summary>
+    /// The optional capabilities of a device that the renderer can make use of.
+    /// </summary>
+    struct DeviceCapabilities
+    {
+        /// <summary>
+        /// The Vulkan version usable with the device, which is limited by the instance version.
+        /// </summary>
+        uint32_t apiVersion = VK_API_VERSION_1_1;
+        /// <summary>
+        /// The highest tier all of whose capabilities are available.
+        /// </summary>
+        DeviceTier tier = DeviceTier::Baseline;
+
+        bool timelineSemaphore = false;
+        /// <summary>
+        /// Partially bound, variably sized and update after bind descriptor arrays that are non-uniformly indexed.
+        /// </summary>
+        bool descriptorIndexing = false;
+        bool bufferDeviceAddress = false;
+        bool shaderDrawParameters = false;
+        bool synchronization2 = false;
+        bool dynamicRendering = false;
+
+        /// <summary>
+        /// The number of invocations in a subgroup, or zero if unknown.
+        /// </summary>
+        uint32_t subgroupSize = 0;
+        /// <summary>
+        /// The most sampled images an update after bind descriptor set may contain.
+        /// </summary>
+        uint32_t maxBindlessSampledImages = 0;
+        /// <summary>
+        /// The most storage buffers an update after bind descriptor set may contain.
+        /// </summary>
+        uint32_t maxBindlessStorageBuffers = 0;
+        /// <summary>
+        /// Is the device a tile based GPU, where merging render passes into subpasses keeps attachments in tile memory.
+        /// </summary>
+        bool tileBasedRenderer = false;
+
+        /// <summary>
+        /// Reads the capabilities of a device.
+        /// </summary>
+        /// <param name="device">The device to query.</param>
+        /// <param name="instanceApiVersion">The version of the instance the device was enumerated from.</param>
+        static DeviceCapabilities Query(const VkPhysicalDevice& device, const uint32_t& instanceApiVersion);
+
+        /// <summary>
+        /// Gets these capabilities without those belonging to higher tiers.
+        /// </summary>
+        /// <param name="maxTier">The highest tier to keep the capabilities of.</param>
+        DeviceCapabilities LimitTo(const DeviceTier& maxTier) const;
+
+        /// <summary>
+        /// Gets a description of the capabilities for logging.
+        /// </summary>
+        String ToString() const;
+
+        /// <summary>
+        /// Gets the name of a tier.
+        /// </summary>
+        static const char* GetTierName(const DeviceTier& tier);
+    };
+}
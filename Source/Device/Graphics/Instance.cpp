@@ -13,6 +13,11 @@ namespace Mantis
         "VK_LAYER_KHRONOS_validation",
     };
 
+    /// <summary>
+    /// The newest Vulkan version the renderer has fast paths for.
+    /// </summary>
+    static const uint32_t MAX_API_VERSION = VK_API_VERSION_1_3;
+
     static const eastl::vector<const char*> INSTANCE_EXTENTIONS =
     {
         VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
@@ -62,12 +67,13 @@ namespace Mantis
         }
     }
 
-    Instance::Instance() :
+    Instance::Instance(const bool& headless) :
         m_debugCallback(VK_NULL_HANDLE),
-        m_instance(VK_NULL_HANDLE)
+        m_instance(VK_NULL_HANDLE),
+        m_apiVersion(VK_API_VERSION_1_1)
     {
         SetupLayers();
-        SetupExtensions();
+        SetupExtensions(headless);
         CreateInstance();
         CreateDebugCallback();
     }
@@ -119,13 +125,17 @@ namespace Mantis
 #endif
     }
 
-    void Instance::SetupExtensions()
+    void Instance::SetupExtensions(const bool& headless)
     {
-        auto instanceExtensions = Window::GetInstanceExtensions();
-
-        for (uint32_t i = 0; i < instanceExtensions.second; i++)
+        // the windowing system is not initialized when headless
+        if (!headless)
         {
-            m_instanceExtensions.emplace_back(instanceExtensions.first[i]);
+            auto instanceExtensions = Window::GetInstanceExtensions();
+
+            for (uint32_t i = 0; i < instanceExtensions.second; i++)
+            {
+                m_instanceExtensions.emplace_back(instanceExtensions.first[i]);
+            }
         }
 
         for (const auto& instanceExtension : INSTANCE_EXTENTIONS)
@@ -146,7 +156,12 @@ namespace Mantis
         applicationInfo.applicationVersion = VK_MAKE_VERSION(MANTIS_VERSION_MAJOR, MANTIS_VERSION_MINOR, MANTIS_VERSION_PATCH);
         applicationInfo.pEngineName = "Mantis Engine";
         applicationInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        applicationInfo.apiVersion = VK_API_VERSION_1_1;
+        // request the newest version the loader supports, as devices can only use versions up to the instance version
+        uint32_t loaderVersion = VK_API_VERSION_1_1;
+        vkEnumerateInstanceVersion(&loaderVersion);
+        m_apiVersion = eastl::clamp(loaderVersion, static_cast<uint32_t>(VK_API_VERSION_1_1), MAX_API_VERSION);
+
+        applicationInfo.apiVersion = m_apiVersion;
 
         VkInstanceCreateInfo instanceCreateInfo = {};
         instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -17,7 +17,11 @@ namespace Mantis
     class Instance
     {
     public:
-        Instance();
+        /// <summary>
+        /// Creates a new instance.
+        /// </summary>
+        /// <param name="headless">Create the instance without the extentions needed to present to windows.</param>
+        explicit Instance(const bool& headless = false);
         ~Instance();
 
         /// <summary>
@@ -40,6 +44,11 @@ namespace Mantis
         /// </summary>
         const VkInstance& GetInstance() const { return m_instance; }
 
+        /// <summary>
+        /// Gets the highest Vulkan version that may be used with this instance.
+        /// </summary>
+        const uint32_t& GetApiVersion() const { return m_apiVersion; }
+
     private:
         static VkResult FvkCreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pCallback);
         static void FvkDestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT messenger, const VkAllocationCallbacks* pAllocator);
@@ -52,7 +61,7 @@ namespace Mantis
         /// <summary>
         /// Determines which extentions to request.
         /// </summary>
-        void SetupExtensions();
+        void SetupExtensions(const bool& headless);
 
         /// <summary>
         /// Creates the underlying Vulkan instance.
@@ -66,6 +75,7 @@ namespace Mantis
 
         VkInstance m_instance;
         VkDebugUtilsMessengerEXT m_debugCallback;
+        uint32_t m_apiVersion;
 
         eastl::vector<const char*> m_instanceLayers;
         eastl::vector<const char*> m_instanceExtensions;
@@ -12,11 +12,18 @@ namespace Mantis
         m_instance(instance),
         m_physicalDevice(physicalDevice),
         m_logicalDevice(VK_NULL_HANDLE),
+        m_graphicsPipelineLibrary(false),
+        m_cmdDrawIndexedIndirectCount(nullptr),
+        m_cmdBeginRendering(nullptr),
+        m_cmdEndRendering(nullptr),
+        m_waitForPresent(nullptr),
         m_supportedQueues(0),
         m_graphicsFamily(eastl::numeric_limits<uint32_t>::max()),
         m_presentFamily(eastl::numeric_limits<uint32_t>::max()),
         m_computeFamily(eastl::numeric_limits<uint32_t>::max()),
         m_transferFamily(eastl::numeric_limits<uint32_t>::max()),
+        m_computeQueueIndex(0),
+        m_transferQueueIndex(0),
         m_graphicsQueue(VK_NULL_HANDLE),
         m_presentQueue(VK_NULL_HANDLE),
         m_computeQueue(VK_NULL_HANDLE),
@@ -41,12 +48,12 @@ namespace Mantis
         uint32_t queueFamilyCount;
         vkGetPhysicalDeviceQueueFamilyProperties(*m_physicalDevice, &queueFamilyCount, nullptr);
 
-        eastl::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
-        vkGetPhysicalDeviceQueueFamilyProperties(*m_physicalDevice, &queueFamilyCount, queueFamilies.data());
+        m_queueFamilies.resize(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(*m_physicalDevice, &queueFamilyCount, m_queueFamilies.data());
 
         for (uint32_t i = 0; i < queueFamilyCount; i++)
         {
-            VkQueueFlags flags = queueFamilies[i].queueFlags;
+            VkQueueFlags flags = m_queueFamilies[i].queueFlags;
 
             // get the first queue that supports graphics
             if ((flags & VK_QUEUE_GRAPHICS_BIT) && m_graphicsFamily == eastl::numeric_limits<uint32_t>::max())
@@ -57,22 +64,29 @@ namespace Mantis
 
             // get the first queue that supports presentation
             VkBool32 presentSupport = VK_FALSE;
-            vkGetPhysicalDeviceSurfaceSupportKHR(*m_physicalDevice, i, *surface, &presentSupport);
 
-            if ((queueFamilies[i].queueCount > 0 && presentSupport) && m_presentFamily == eastl::numeric_limits<uint32_t>::max())
+            if (surface != nullptr)
+            {
+                vkGetPhysicalDeviceSurfaceSupportKHR(*m_physicalDevice, i, *surface, &presentSupport);
+            }
+
+            if ((m_queueFamilies[i].queueCount > 0 && presentSupport) && m_presentFamily == eastl::numeric_limits<uint32_t>::max())
             {
                 m_presentFamily = i;
             }
 
-            // get the first queue that supports compute
-            if ((flags & VK_QUEUE_COMPUTE_BIT) && m_computeFamily == eastl::numeric_limits<uint32_t>::max())
+            // get the first queue with compute support, but prefer dedicated ones so compute can run alongside graphics work
+            if ((flags & VK_QUEUE_COMPUTE_BIT) && (m_computeFamily == eastl::numeric_limits<uint32_t>::max() ||
+                (!(flags & VK_QUEUE_GRAPHICS_BIT) && (m_queueFamilies[m_computeFamily].queueFlags & VK_QUEUE_GRAPHICS_BIT))))
             {
                 m_computeFamily = i;
                 m_supportedQueues |= VK_QUEUE_COMPUTE_BIT;
             }
 
-            // get the first queue with transfer support, but prefer dedicated ones
-            if ((flags & VK_QUEUE_TRANSFER_BIT) && (m_transferFamily == eastl::numeric_limits<uint32_t>::max() || flags == VK_QUEUE_TRANSFER_BIT))
+            // get the first queue with transfer support, but prefer dedicated ones without graphics or compute, which
+            // are usually the copy engines. Families may also report sparse binding or protected support, which are ignored.
+            if ((flags & VK_QUEUE_TRANSFER_BIT) && (m_transferFamily == eastl::numeric_limits<uint32_t>::max() ||
+                (!(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) && (m_queueFamilies[m_transferFamily].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))))
             {
                 m_transferFamily = i;
                 m_supportedQueues |= VK_QUEUE_TRANSFER_BIT;
@@ -83,63 +97,186 @@ namespace Mantis
         {
             Logger::ErrorT(LOG_TAG, "Failed to find queue family supporting VK_QUEUE_GRAPHICS_BIT!");
         }
+
+        // headless devices never present, so the graphics queue stands in for the present queue
+        if (surface == nullptr)
+        {
+            m_presentFamily = m_graphicsFamily;
+        }
     }
 
     void LogicalDevice::CreateLogicalDevice()
     {
-        eastl::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        float queuePriorities[] = { 0.0f };
-
-        if (m_supportedQueues & VK_QUEUE_GRAPHICS_BIT)
+        if (!(m_supportedQueues & VK_QUEUE_GRAPHICS_BIT))
         {
-            VkDeviceQueueCreateInfo graphicsQueueCreateInfo = {};
-            graphicsQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-            graphicsQueueCreateInfo.queueFamilyIndex = m_graphicsFamily;
-            graphicsQueueCreateInfo.queueCount = 1;
-            graphicsQueueCreateInfo.pQueuePriorities = queuePriorities;
-            queueCreateInfos.emplace_back(graphicsQueueCreateInfo);
+            m_graphicsFamily = VK_NULL_HANDLE;
         }
-        else
+        if (!(m_supportedQueues & VK_QUEUE_COMPUTE_BIT))
         {
-            m_graphicsFamily = VK_NULL_HANDLE;
+            m_computeFamily = m_graphicsFamily;
+        }
+        if (!(m_supportedQueues & VK_QUEUE_TRANSFER_BIT))
+        {
+            m_transferFamily = m_graphicsFamily;
         }
 
-        if (m_supportedQueues & VK_QUEUE_COMPUTE_BIT && m_computeFamily != m_graphicsFamily)
+        // Give each queue type its own queue where the family has enough queues, so that work submitted
+        // to different queue types can execute concurrently. Otherwise the last queue in the family is shared.
+        eastl::vector<uint32_t> queueCounts(m_queueFamilies.size(), 0);
+
+        const auto requestQueue = [&](const uint32_t& family) -> uint32_t
         {
-            VkDeviceQueueCreateInfo computeQueueCreateInfo = {};
-            computeQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-            computeQueueCreateInfo.queueFamilyIndex = m_computeFamily;
-            computeQueueCreateInfo.queueCount = 1;
-            computeQueueCreateInfo.pQueuePriorities = queuePriorities;
-            queueCreateInfos.emplace_back(computeQueueCreateInfo);
+            if (queueCounts[family] < m_queueFamilies[family].queueCount)
+            {
+                return queueCounts[family]++;
+            }
+            return queueCounts[family] - 1;
+        };
 
+        requestQueue(m_graphicsFamily);
+        m_computeQueueIndex = requestQueue(m_computeFamily);
+        m_transferQueueIndex = requestQueue(m_transferFamily);
+
+        if (m_computeFamily != m_graphicsFamily)
+        {
             Logger::InfoT(LOG_TAG, "Creating dedicated compute queue.");
         }
-        else
+        else if (m_computeQueueIndex != 0)
         {
-            m_computeFamily = m_graphicsFamily;
+            Logger::InfoT(LOG_TAG, "Creating separate compute queue in the graphics queue family.");
         }
 
-        if (m_supportedQueues & VK_QUEUE_TRANSFER_BIT && m_transferFamily != m_graphicsFamily && m_transferFamily != m_computeFamily)
+        if (m_transferFamily != m_graphicsFamily && m_transferFamily != m_computeFamily)
         {
-            VkDeviceQueueCreateInfo transferQueueCreateInfo = {};
-            transferQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-            transferQueueCreateInfo.queueFamilyIndex = m_transferFamily;
-            transferQueueCreateInfo.queueCount = 1;
-            transferQueueCreateInfo.pQueuePriorities = queuePriorities;
-            queueCreateInfos.emplace_back(transferQueueCreateInfo);
-            
             Logger::InfoT(LOG_TAG, "Creating dedicated transfer queue.");
         }
-        else
+
+        // the queues are given equal priority
+        eastl::vector<float> queuePriorities(3, 0.0f);
+        eastl::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+
+        for (uint32_t i = 0; i < queueCounts.size(); i++)
         {
-            m_transferFamily = m_graphicsFamily;
+            if (queueCounts[i] > 0)
+            {
+                VkDeviceQueueCreateInfo queueCreateInfo = {};
+                queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+                queueCreateInfo.queueFamilyIndex = i;
+                queueCreateInfo.queueCount = queueCounts[i];
+                queueCreateInfo.pQueuePriorities = queuePriorities.data();
+                queueCreateInfos.emplace_back(queueCreateInfo);
+            }
         }
 
         m_enabledFeatures = GetFeaturesToRequest(m_physicalDevice->GetFeatures());
 
         VkDeviceCreateInfo deviceCreateInfo = {};
         deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+
+        // enable everything in the best tier supported, up to the configured limit
+        m_capabilities = m_physicalDevice->GetCapabilities().LimitTo(RendererConfig::Get().maxDeviceTier);
+
+        VkPhysicalDeviceVulkan11Features features11 = {};
+        features11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+        VkPhysicalDeviceVulkan12Features features12 = {};
+        features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceVulkan13Features features13 = {};
+        features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+        VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features = {};
+        synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+        VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = {};
+        dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+
+        if (m_capabilities.tier >= DeviceTier::Bindless)
+        {
+            features11.shaderDrawParameters = VK_TRUE;
+
+            features12.timelineSemaphore = VK_TRUE;
+            features12.descriptorIndexing = VK_TRUE;
+            features12.runtimeDescriptorArray = VK_TRUE;
+            features12.descriptorBindingPartiallyBound = VK_TRUE;
+            features12.descriptorBindingVariableDescriptorCount = VK_TRUE;
+            features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+            features12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+            features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+            features12.bufferDeviceAddress = VK_TRUE;
+
+            // the extension is promoted to this feature, which must be enabled to match when both are used
+            features12.drawIndirectCount = m_physicalDevice->IsExtentionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+            features11.pNext = &features12;
+            features12.pNext = const_cast<void*>(deviceCreateInfo.pNext);
+            deviceCreateInfo.pNext = &features11;
+
+            if (m_capabilities.tier >= DeviceTier::Modern && m_capabilities.apiVersion >= VK_API_VERSION_1_3)
+            {
+                features13.synchronization2 = VK_TRUE;
+                features13.dynamicRendering = VK_TRUE;
+
+                features13.pNext = features12.pNext;
+                features12.pNext = &features13;
+            }
+            else if (m_capabilities.tier >= DeviceTier::Modern)
+            {
+                // Vulkan 1.2 devices provide these through their extensions instead
+                synchronization2Features.synchronization2 = VK_TRUE;
+                dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+
+                synchronization2Features.pNext = &dynamicRenderingFeatures;
+                dynamicRenderingFeatures.pNext = features12.pNext;
+                features12.pNext = &synchronization2Features;
+            }
+        }
+
+        Logger::InfoTF(LOG_TAG, "Enabling device tier: %s", DeviceCapabilities::GetTierName(m_capabilities.tier));
+
+        // the extention being present does not mean the feature is, so it must be queried
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibraryFeatures = {};
+        graphicsPipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+
+        if (m_physicalDevice->IsExtentionEnabled(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME))
+        {
+            VkPhysicalDeviceFeatures2 features = {};
+            features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features.pNext = &graphicsPipelineLibraryFeatures;
+            vkGetPhysicalDeviceFeatures2(*m_physicalDevice, &features);
+
+            if (graphicsPipelineLibraryFeatures.graphicsPipelineLibrary)
+            {
+                graphicsPipelineLibraryFeatures.pNext = const_cast<void*>(deviceCreateInfo.pNext);
+                deviceCreateInfo.pNext = &graphicsPipelineLibraryFeatures;
+                m_graphicsPipelineLibrary = true;
+
+                Logger::InfoT(LOG_TAG, "Enabling graphics pipeline libraries.");
+            }
+        }
+
+        // present waits are only useful with present IDs to wait on
+        VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {};
+        presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+        VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
+        presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+        bool presentWait = false;
+
+        if (m_physicalDevice->IsExtentionEnabled(VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+            m_physicalDevice->IsExtentionEnabled(VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+        {
+            presentIdFeatures.pNext = &presentWaitFeatures;
+
+            VkPhysicalDeviceFeatures2 features = {};
+            features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features.pNext = &presentIdFeatures;
+            vkGetPhysicalDeviceFeatures2(*m_physicalDevice, &features);
+
+            if (presentIdFeatures.presentId && presentWaitFeatures.presentWait)
+            {
+                presentWaitFeatures.pNext = const_cast<void*>(deviceCreateInfo.pNext);
+                deviceCreateInfo.pNext = &presentIdFeatures;
+                presentWait = true;
+
+                Logger::InfoT(LOG_TAG, "Enabling present waits.");
+            }
+        }
         deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
         deviceCreateInfo.enabledLayerCount = static_cast<uint32_t>(m_instance->GetInstanceLayers().size());
@@ -155,8 +292,35 @@ namespace Mantis
 
         vkGetDeviceQueue(m_logicalDevice, m_graphicsFamily, 0, &m_graphicsQueue);
         vkGetDeviceQueue(m_logicalDevice, m_presentFamily, 0, &m_presentQueue);
-        vkGetDeviceQueue(m_logicalDevice, m_computeFamily, 0, &m_computeQueue);
-        vkGetDeviceQueue(m_logicalDevice, m_transferFamily, 0, &m_transferQueue);
+        vkGetDeviceQueue(m_logicalDevice, m_computeFamily, m_computeQueueIndex, &m_computeQueue);
+        vkGetDeviceQueue(m_logicalDevice, m_transferFamily, m_transferQueueIndex, &m_transferQueue);
+
+        // queues the family has too few of are shared, so work meant to overlap is serialized instead
+        if (m_computeQueue == m_graphicsQueue)
+        {
+            Logger::WarningT(LOG_TAG, "The compute queue is the graphics queue, async compute work will run serially.");
+        }
+        if (m_transferQueue == m_graphicsQueue)
+        {
+            Logger::WarningT(LOG_TAG, "The transfer queue is the graphics queue, uploads will run serially.");
+        }
+
+        if (m_physicalDevice->IsExtentionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME))
+        {
+            m_cmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(m_logicalDevice, "vkCmdDrawIndexedIndirectCountKHR"));
+        }
+
+        if (m_capabilities.dynamicRendering)
+        {
+            bool core = m_capabilities.apiVersion >= VK_API_VERSION_1_3;
+            m_cmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(vkGetDeviceProcAddr(m_logicalDevice, core ? "vkCmdBeginRendering" : "vkCmdBeginRenderingKHR"));
+            m_cmdEndRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(m_logicalDevice, core ? "vkCmdEndRendering" : "vkCmdEndRenderingKHR"));
+        }
+
+        if (presentWait)
+        {
+            m_waitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(m_logicalDevice, "vkWaitForPresentKHR"));
+        }
     }
 
     VkPhysicalDeviceFeatures LogicalDevice::GetFeaturesToRequest(const VkPhysicalDeviceFeatures& deviceFeatures)
@@ -252,6 +416,12 @@ namespace Mantis
             Logger::WarningT(LOG_TAG, "Selected GPU does not support shader storage write without format!");
         }
 
+        // pipeline statistics are only used for profiling, so their absence is not worth a warning
+        if (deviceFeatures.pipelineStatisticsQuery)
+        {
+            enabledFeatures.pipelineStatisticsQuery = VK_TRUE;
+        }
+
         if (deviceFeatures.geometryShader)
         {
             enabledFeatures.geometryShader = VK_TRUE;
@@ -270,6 +440,33 @@ namespace Mantis
             Logger::WarningT(LOG_TAG, "Selected GPU does not support tessellation shaders!");
         }
 
+        if (deviceFeatures.multiDrawIndirect)
+        {
+            enabledFeatures.multiDrawIndirect = VK_TRUE;
+        }
+        else
+        {
+            Logger::WarningT(LOG_TAG, "Selected GPU does not support multi draw indirect!");
+        }
+
+        if (deviceFeatures.drawIndirectFirstInstance)
+        {
+            enabledFeatures.drawIndirectFirstInstance = VK_TRUE;
+        }
+        else
+        {
+            Logger::WarningT(LOG_TAG, "Selected GPU does not support indirect draws with a first instance!");
+        }
+
+        if (deviceFeatures.shaderStorageImageArrayDynamicIndexing)
+        {
+            enabledFeatures.shaderStorageImageArrayDynamicIndexing = VK_TRUE;
+        }
+        else
+        {
+            Logger::WarningT(LOG_TAG, "Selected GPU does not support dynamic indexing of storage image arrays!");
+        }
+
         if (deviceFeatures.multiViewport)
         {
             enabledFeatures.multiViewport = VK_TRUE;
@@ -44,6 +44,35 @@ namespace Mantis
         /// </summary>
         const VkPhysicalDeviceFeatures& GetEnabledFeatures() const { return m_enabledFeatures; }
 
+        /// <summary>
+        /// Gets the optional capabilities that are enabled on this device, which the renderer's fast paths should check for.
+        /// </summary>
+        const DeviceCapabilities& GetCapabilities() const { return m_capabilities; }
+
+        /// <summary>
+        /// Gets if graphics pipelines can be linked from separately created pipeline libraries.
+        /// </summary>
+        const bool& SupportsGraphicsPipelineLibrary() const { return m_graphicsPipelineLibrary; }
+
+        /// <summary>
+        /// Gets the function used to record indexed indirect draws with a GPU written draw count.
+        /// Will be null if the device does not support it.
+        /// </summary>
+        const PFN_vkCmdDrawIndexedIndirectCountKHR& GetCmdDrawIndexedIndirectCount() const { return m_cmdDrawIndexedIndirectCount; }
+
+        /// <summary>
+        /// Gets the functions used to begin and end dynamic rendering, from the core or the extension depending on the device version.
+        /// Will be null if dynamic rendering is not enabled.
+        /// </summary>
+        const PFN_vkCmdBeginRenderingKHR& GetCmdBeginRendering() const { return m_cmdBeginRendering; }
+        const PFN_vkCmdEndRenderingKHR& GetCmdEndRendering() const { return m_cmdEndRendering; }
+
+        /// <summary>
+        /// Gets the function used to wait until a present with a given ID has been displayed.
+        /// Will be null if the device does not support present IDs and present waits.
+        /// </summary>
+        const PFN_vkWaitForPresentKHR& GetWaitForPresent() const { return m_waitForPresent; }
+
         /// <summary>
         /// Gets the graphcis queue for this device.
         /// </summary>
@@ -64,6 +93,17 @@ namespace Mantis
         /// </summary>
         const VkQueue& GetTransferQueue() const { return m_transferQueue; }
 
+        /// <summary>
+        /// Gets if the compute queue is separate from the graphics queue, so compute work can execute concurrently with graphics work.
+        /// </summary>
+        bool HasAsyncCompute() const { return m_computeQueue != m_graphicsQueue; }
+
+        /// <summary>
+        /// Gets if the transfer queue is separate from the graphics queue and in another queue family, so uploads can execute
+        /// concurrently with graphics work but resources must have their ownership transferred between the queues.
+        /// </summary>
+        bool HasDedicatedTransfer() const { return m_transferQueue != m_graphicsQueue && m_transferFamily != m_graphicsFamily; }
+
         /// <summary>
         /// Gets a queue for this device.
         /// </summary>
@@ -91,6 +131,11 @@ namespace Mantis
         /// </summary>
         const uint32_t& GetTransferFamily() const { return m_transferFamily; }
 
+        /// <summary>
+        /// Gets the properties of each queue family on this device.
+        /// </summary>
+        const eastl::vector<VkQueueFamilyProperties>& GetQueueFamilies() const { return m_queueFamilies; }
+
         /// <summary>
         /// Gets a queue family index for this device.
         /// </summary>
@@ -114,12 +159,21 @@ namespace Mantis
 
         VkDevice m_logicalDevice;
         VkPhysicalDeviceFeatures m_enabledFeatures;
+        DeviceCapabilities m_capabilities;
+        bool m_graphicsPipelineLibrary;
+        PFN_vkCmdDrawIndexedIndirectCountKHR m_cmdDrawIndexedIndirectCount;
+        PFN_vkCmdBeginRenderingKHR m_cmdBeginRendering;
+        PFN_vkCmdEndRenderingKHR m_cmdEndRendering;
+        PFN_vkWaitForPresentKHR m_waitForPresent;
 
         VkQueueFlags m_supportedQueues;
         uint32_t m_graphicsFamily;
         uint32_t m_presentFamily;
         uint32_t m_computeFamily;
         uint32_t m_transferFamily;
+        uint32_t m_computeQueueIndex;
+        uint32_t m_transferQueueIndex;
+        eastl::vector<VkQueueFamilyProperties> m_queueFamilies;
 
         VkQueue m_graphicsQueue;
         VkQueue m_presentQueue;
@@ -11,8 +11,57 @@ namespace Mantis
     };
     static const eastl::vector<const char*> OPTIONAL_DEVICE_EXTENTIONS =
     {
+        VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
+        VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME,
+        VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME,
+        VK_KHR_PRESENT_ID_EXTENSION_NAME,
+        VK_KHR_PRESENT_WAIT_EXTENSION_NAME,
+        VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME,
+        VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
     };
 
+    /// <summary>
+    /// The extentions that depend on extentions promoted to Vulkan 1.2, which older devices do not enable.
+    /// </summary>
+    static const eastl::vector<const char*> VULKAN_1_2_DEVICE_EXTENTIONS =
+    {
+        VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
+    };
+
+    /// <summary>
+    /// The extentions that are only used to present to windows, which headless devices do not require or enable.
+    /// </summary>
+    static const eastl::vector<const char*> PRESENTATION_DEVICE_EXTENTIONS =
+    {
+        VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+        VK_KHR_PRESENT_ID_EXTENSION_NAME,
+        VK_KHR_PRESENT_WAIT_EXTENSION_NAME,
+    };
+
+    static eastl::vector<const char*> GetDeviceExtentions(const eastl::vector<const char*>& extentions, const bool& headless, const uint32_t& apiVersion)
+    {
+        eastl::vector<const char*> result;
+
+        for (const auto& extention : extentions)
+        {
+            const auto isIn = [&](const eastl::vector<const char*>& list)
+            {
+                return eastl::any_of(list.begin(), list.end(), [&](const char* other)
+                {
+                    return strcmp(extention, other) == 0;
+                });
+            };
+
+            if ((!headless || !isIn(PRESENTATION_DEVICE_EXTENTIONS)) &&
+                (apiVersion >= VK_API_VERSION_1_2 || !isIn(VULKAN_1_2_DEVICE_EXTENTIONS)))
+            {
+                result.push_back(extention);
+            }
+        }
+
+        return result;
+    }
+
     static const eastl::vector<VkSampleCountFlagBits> SAMPLE_FLAG_BITS = 
     { 
         VK_SAMPLE_COUNT_64_BIT,
@@ -23,12 +72,14 @@ namespace Mantis
         VK_SAMPLE_COUNT_2_BIT,
     };
 
-    PhysicalDevice::PhysicalDevice(const Instance* instance) :
+    PhysicalDevice::PhysicalDevice(const Instance* instance, const bool& headless) :
         m_instance(instance),
         m_physicalDevice(VK_NULL_HANDLE),
+        m_headless(headless),
         m_properties({}),
         m_memoryProperties({}),
         m_features({}),
+        m_capabilities(),
         m_msaaSamples(VK_SAMPLE_COUNT_1_BIT),
         m_extentions({})
     {
@@ -40,7 +91,7 @@ namespace Mantis
         vkEnumeratePhysicalDevices(*m_instance, &physicalDeviceCount, physicalDevices.data());
 
         // select the best GPU
-        m_physicalDevice = ChoosePhysicalDevice(physicalDevices);
+        m_physicalDevice = ChoosePhysicalDevice(physicalDevices, m_headless, m_instance->GetApiVersion());
 
         if (m_physicalDevice == nullptr)
         {
@@ -51,35 +102,37 @@ namespace Mantis
         vkGetPhysicalDeviceProperties(m_physicalDevice, &m_properties);
         vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_memoryProperties);
         vkGetPhysicalDeviceFeatures(m_physicalDevice, &m_features);
+        m_capabilities = DeviceCapabilities::Query(m_physicalDevice, m_instance->GetApiVersion());
         m_msaaSamples = GetMaxUsableSampleCount(m_properties);
 
         // get the extentions to request on this device
         auto supportedExtentions = GetSupportedExtentions(m_physicalDevice);
-        for (const auto& extention : GetExtentions(supportedExtentions, REQUIRED_DEVICE_EXTENTIONS))
+        for (const auto& extention : GetExtentions(supportedExtentions, GetDeviceExtentions(REQUIRED_DEVICE_EXTENTIONS, m_headless, m_capabilities.apiVersion)))
         {
             m_extentions.push_back(extention);
         }
-        for (const auto& extention : GetExtentions(supportedExtentions, OPTIONAL_DEVICE_EXTENTIONS))
+        for (const auto& extention : GetExtentions(supportedExtentions, GetDeviceExtentions(OPTIONAL_DEVICE_EXTENTIONS, m_headless, m_capabilities.apiVersion)))
         {
             m_extentions.push_back(extention);
         }
 
         Logger::InfoTF(LOG_TAG, "Selected device: %s ID: %i ", m_properties.deviceName, m_properties.deviceID);
+        Logger::InfoTF(LOG_TAG, "Device capabilities: %s", m_capabilities.ToString().c_str());
     }
 
-    VkPhysicalDevice PhysicalDevice::ChoosePhysicalDevice(const eastl::vector<VkPhysicalDevice>& devices)
+    VkPhysicalDevice PhysicalDevice::ChoosePhysicalDevice(const eastl::vector<VkPhysicalDevice>& devices, const bool& headless, const uint32_t& apiVersion)
     {
         // Sort all the devices by rank
         eastl::vector_multimap<int32_t, VkPhysicalDevice> rankedDevices;
 
         for (const auto& device : devices)
         {
-            int32_t score = ScorePhysicalDevice(device);
+            int32_t score = ScorePhysicalDevice(device, headless, apiVersion);
             rankedDevices.emplace(score, device);
         }
 
         // make sure the best candidate scored higher than 0
-        if (rankedDevices.rbegin()->first > 0)
+        if (!rankedDevices.empty() && rankedDevices.rbegin()->first > 0)
         {
             return rankedDevices.rbegin()->second;
         }
@@ -87,7 +140,7 @@ namespace Mantis
         return nullptr;
     }
 
-    int32_t PhysicalDevice::ScorePhysicalDevice(const VkPhysicalDevice& device)
+    int32_t PhysicalDevice::ScorePhysicalDevice(const VkPhysicalDevice& device, const bool& headless, const uint32_t& apiVersion)
     {
         // get device information
         VkPhysicalDeviceProperties physicalDeviceProperties;
@@ -100,26 +153,42 @@ namespace Mantis
 
         LogDeviceInfo(physicalDeviceProperties, supportedExtentions);
 
+        auto capabilities = DeviceCapabilities::Query(device, apiVersion);
+
         // require important extensions to be supported
-        if (GetExtentions(supportedExtentions, REQUIRED_DEVICE_EXTENTIONS).size() != REQUIRED_DEVICE_EXTENTIONS.size())
+        auto requiredExtentions = GetDeviceExtentions(REQUIRED_DEVICE_EXTENTIONS, headless, capabilities.apiVersion);
+
+        if (GetExtentions(supportedExtentions, requiredExtentions).size() != requiredExtentions.size())
         {
             return 0;
         }
 
-        // rank the device by its capabilities
-        int32_t score = 0;
+        // Rank the device by its capabilities, software implementations still score above zero so they can be used when there is no GPU.
+        // The weights are chosen so the device type is most important, then the tier, then the optional extentions.
+        int32_t score = 1;
 
-        // check for optional extention support
-        score += static_cast<int32_t>(GetExtentions(supportedExtentions, OPTIONAL_DEVICE_EXTENTIONS).size()) * 1000;
-
-        // adds a large score boost for discrete GPUs
-        if (physicalDeviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+        switch (physicalDeviceProperties.deviceType)
         {
-            score += 10000;
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+                score += 30000000;
+                break;
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+                score += 20000000;
+                break;
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+                score += 10000000;
+                break;
+            default:
+                break;
         }
 
+        score += static_cast<int32_t>(capabilities.tier) * 1000000;
+
+        // check for optional extention support
+        score += static_cast<int32_t>(GetExtentions(supportedExtentions, GetDeviceExtentions(OPTIONAL_DEVICE_EXTENTIONS, headless, capabilities.apiVersion)).size()) * 100000;
+
         // gives a higher score to devices with a higher maximum texture size
-        score += physicalDeviceProperties.limits.maxImageDimension2D;
+        score += static_cast<int32_t>(eastl::min(physicalDeviceProperties.limits.maxImageDimension2D, 65536u));
 
         return score;
     }
@@ -154,6 +223,18 @@ namespace Mantis
         return extentions;
     }
 
+    bool PhysicalDevice::IsExtentionEnabled(const char* extention) const
+    {
+        for (const auto& enabledExtention : m_extentions)
+        {
+            if (strcmp(extention, enabledExtention) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
     VkSampleCountFlagBits PhysicalDevice::GetMaxUsableSampleCount(const VkPhysicalDeviceProperties& deviceProperties)
     {
         VkSampleCountFlags counts = eastl::min(deviceProperties.limits.framebufferColorSampleCounts, deviceProperties.limits.framebufferDepthSampleCounts);
@@ -168,18 +249,40 @@ namespace Mantis
         return VK_SAMPLE_COUNT_1_BIT;
     }
 
-    VkMemoryPropertyFlags PhysicalDevice::GetMemoryPropertyFlags(const uint32_t& memoryTypeBit) const
+    VkMemoryPropertyFlags PhysicalDevice::GetMemoryPropertyFlags(const uint32_t& memoryTypeIndex) const
     {
+        if (memoryTypeIndex < m_memoryProperties.memoryTypeCount)
+        {
+            return m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+        }
+
+        Logger::InfoTF(LOG_TAG, "Unable to find memory type!");
+        return 0;
+    }
+
+    bool PhysicalDevice::IsDeviceMemoryHostVisible() const
+    {
+        VkDeviceSize deviceLocalSize = 0;
+        VkDeviceSize hostVisibleSize = 0;
+
         for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++)
         {
-            uint32_t memoryType = 1 << i;
-            if (memoryType == memoryTypeBit)
+            const auto& memoryType = m_memoryProperties.memoryTypes[i];
+            auto heapSize = m_memoryProperties.memoryHeaps[memoryType.heapIndex].size;
+
+            if (HAS_FLAGS(memoryType.propertyFlags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
             {
-                return m_memoryProperties.memoryTypes[memoryType].propertyFlags;
+                deviceLocalSize = eastl::max(deviceLocalSize, heapSize);
+
+                if (HAS_FLAGS(memoryType.propertyFlags, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+                {
+                    hostVisibleSize = eastl::max(hostVisibleSize, heapSize);
+                }
             }
         }
 
-        Logger::InfoTF(LOG_TAG, "Unable to find memory type!");
+        // without resizable BAR only a small window of device memory can be mapped
+        return deviceLocalSize > 0 && hostVisibleSize == deviceLocalSize;
     }
 
     VkFormat PhysicalDevice::FindSupportedFormat(const eastl::vector<VkFormat>& candidates, const VkImageTiling& tiling, const VkFormatFeatureFlags& features) const
@@ -2,6 +2,7 @@
 
 #include "Mantis.h"
 #include "Instance.h"
+#include "DeviceCapabilities.h"
 
 namespace Mantis
 {
@@ -11,7 +12,12 @@ namespace Mantis
     class PhysicalDevice
     {
     public:
-        explicit PhysicalDevice(const Instance* instance);
+        /// <summary>
+        /// Selects the most capable physical device.
+        /// </summary>
+        /// <param name="instance">The instance to enumerate the devices of.</param>
+        /// <param name="headless">Select a device that does not need to present to windows, which may be a software implementation.</param>
+        explicit PhysicalDevice(const Instance* instance, const bool& headless = false);
 
         /// <summary>
         /// Gets the underlying physical device.
@@ -43,21 +49,43 @@ namespace Mantis
         /// </summary>
         const VkPhysicalDeviceFeatures& GetFeatures() const { return m_features; }
 
+        /// <summary>
+        /// Gets the optional capabilities supported by this device.
+        /// </summary>
+        const DeviceCapabilities& GetCapabilities() const { return m_capabilities; }
+
         /// <summary>
         /// Gets the number of MSAA samples supported by this device.
         /// </summary>
         const VkSampleCountFlagBits& GetMsaaSamples() const { return m_msaaSamples; }
 
+        /// <summary>
+        /// Gets if the device was selected without the ability to present to windows.
+        /// </summary>
+        const bool& IsHeadless() const { return m_headless; }
+
         /// <summary>
         /// Gets the extentions to use on this device.
         /// </summary>
         const eastl::vector<const char*>& GetExtentions() const { return m_extentions; }
 
+        /// <summary>
+        /// Checks if an extention is enabled on this device.
+        /// </summary>
+        /// <param name="extention">The name of the extention.</param>
+        bool IsExtentionEnabled(const char* extention) const;
+
         /// <summary>
         /// Gets the memory property flags for a memory type.
         /// </summary>
-        /// <param name="memoryTypeBit">The type of memory.</param>
-        VkMemoryPropertyFlags PhysicalDevice::GetMemoryPropertyFlags(const uint32_t& memoryTypeBit) const;
+        /// <param name="memoryTypeIndex">The index of the memory type.</param>
+        VkMemoryPropertyFlags GetMemoryPropertyFlags(const uint32_t& memoryTypeIndex) const;
+
+        /// <summary>
+        /// Checks if all device local memory can be mapped by the host, as on integrated GPUs or
+        /// discrete GPUs with resizable BAR enabled.
+        /// </summary>
+        bool IsDeviceMemoryHostVisible() const;
 
         /// <summary>
         /// Selects the first format which meets the provided requirements.
@@ -73,15 +101,19 @@ namespace Mantis
         /// Determines the most suitable device from a list of devices.
         /// </summary>
         /// <param name="devices">The devices to rank.</param>
+        /// <param name="headless">Do not require the device to present to windows.</param>
+        /// <param name="apiVersion">The version of the instance the devices were enumerated from.</param>
         /// <returns>The best ranking device.</returns>
-        static VkPhysicalDevice ChoosePhysicalDevice(const eastl::vector<VkPhysicalDevice>& devices);
+        static VkPhysicalDevice ChoosePhysicalDevice(const eastl::vector<VkPhysicalDevice>& devices, const bool& headless, const uint32_t& apiVersion);
 
         /// <summary>
         /// Ranks the capabilities of a device.
         /// </summary>
         /// <param name="device">The device to rank.</param>
+        /// <param name="headless">Do not require the device to present to windows.</param>
+        /// <param name="apiVersion">The version of the instance the device was enumerated from.</param>
         /// <returns>The score of the device. If zero or less the device does not support required features.</returns>
-        static int32_t ScorePhysicalDevice(const VkPhysicalDevice& device);
+        static int32_t ScorePhysicalDevice(const VkPhysicalDevice& device, const bool& headless, const uint32_t& apiVersion);
 
         /// <summary>
         /// Gets all extenstions supported by a device.
@@ -112,10 +144,12 @@ namespace Mantis
 
         const Instance* m_instance;
         VkPhysicalDevice m_physicalDevice;
+        bool m_headless;
 
         VkPhysicalDeviceProperties m_properties;
         VkPhysicalDeviceMemoryProperties m_memoryProperties;
         VkPhysicalDeviceFeatures m_features;
+        DeviceCapabilities m_capabilities;
         VkSampleCountFlagBits m_msaaSamples;
         eastl::vector<const char*> m_extentions;
     };
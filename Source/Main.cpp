@@ -6,6 +6,11 @@
 #include "Device/Graphics/PhysicalDevice.h"
 #include "Device/Graphics/LogicalDevice.h"
 #include "Device/Graphics/Surface.h"
+#include "Renderer/Renderer.h"
+#include "Renderer/FrameContext.h"
+#include "Renderer/Renderpass/OffscreenSwapchain.h"
+#include "Renderer/Renderpass/SwapchainPresenter.h"
+#include "Utils/Profiler.h"
 #include <random>
 #include <chrono>
 #include <thread>
@@ -27,22 +32,126 @@ void* operator new[](size_t size, size_t alignment, size_t alignmentOffset, cons
 
 namespace Mantis
 {
+    /// <summary>
+    /// The number of frames rendered when running headless.
+    /// </summary>
+    static const uint32_t HEADLESS_FRAME_COUNT = 60;
+
+    /// <summary>
+    /// Renders a fixed number of frames without a window, presenting to an offscreen swapchain.
+    /// </summary>
+    /// <param name="dumpPath">The path presented images are dumped to, or empty to not dump them.</param>
+    static void RunHeadless(const String& dumpPath)
+    {
+        Renderer::InitHeadless();
+
+        {
+            OffscreenSwapchain swapchain(Vector2Int(800, 600));
+            swapchain.SetDumpPath(PathRoot::OutputDir, dumpPath);
+
+            for (uint32_t i = 0; i < HEADLESS_FRAME_COUNT; i++)
+            {
+                auto renderer = Renderer::Get();
+                renderer->BeginFrame();
+
+                auto& frame = renderer->GetFrame();
+                auto& image = swapchain.GetImage(swapchain.AcquireNextImage());
+
+                // nothing renders into the backbuffer yet, so the image is cleared to show progress
+                auto& commandBuffer = frame.RequestCommandBuffer();
+                image.TransitionImageLayout(commandBuffer, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+                auto shade = static_cast<float>(i) / HEADLESS_FRAME_COUNT;
+                VkClearColorValue color = { { shade, shade, shade, 1.0f } };
+                VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+                vkCmdClearColorImage(commandBuffer, image.GetImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &color, 1, &range);
+
+                swapchain.Present(frame, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+                renderer->EndFrame();
+            }
+        }
+
+        Renderer::Deinit();
+    }
+
+    /// <summary>
+    /// Clears an acquired swapchain image and makes it ready to present, since nothing renders into the backbuffer yet.
+    /// </summary>
+    /// <param name="commandBuffer">The graphics command buffer to record to.</param>
+    /// <param name="image">The acquired swapchain image.</param>
+    /// <param name="color">The color to clear to.</param>
+    static void ClearSwapchainImage(const CommandBuffer& commandBuffer, const VkImage& image, const VkClearColorValue& color)
+    {
+        VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+        // the acquire semaphore is waited on at the color attachment output stage, which this barrier chains from
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange = range;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &color, 1, &range);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
     void main(int c, char* args[])
     {
         // report the build information
         Logger::Info(MANTIS_VERSION_TEXT);
 
+        Profiler::Init();
+
+        // "-headless [dump path]" renders offscreen, for machines without a display
+        if (c > 1 && strcmp(args[1], "-headless") == 0)
+        {
+            RunHeadless(c > 2 ? String(args[2]) : String());
+            Profiler::Deinit();
+            return;
+        }
+
         Window::Init();
 
         eastl::shared_ptr<Window> window = Window::Create();
 
-        while (!window->IsClosed())
         {
-            Window::Update();
-            //window->SwapBuffers();
+            // recreates the swapchain as the window is resized, without stalling the frames in flight
+            SwapchainPresenter presenter(window.get());
+
+            while (!window->IsClosed())
+            {
+                Window::Update();
+
+                // waits until the frame pacer lets the frame start and a frame context is free
+                auto& frame = Renderer::Get()->BeginFrame();
+                auto result = presenter.Acquire(frame);
+
+                // nothing is presented while the window is minimized
+                if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)
+                {
+                    VkClearColorValue color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+                    ClearSwapchainImage(frame.RequestCommandBuffer(), presenter.GetSwapchain().GetActiveImage(), color);
+                }
+
+                Renderer::Get()->EndFrame();
+            }
         }
 
         Window::Deinit();
+        Profiler::Deinit();
 
         /*
         std::random_device dev;
@@ -34,6 +34,9 @@
 #if !defined(NDEBUG)
 #   define MANTIS_DEBUG
 #endif
+#if !defined(MANTIS_NO_PROFILE)
+#   define MANTIS_PROFILE
+#endif
 
 // Recommend that the compiler inline this function.
 #define MANTIS_INLINE inline
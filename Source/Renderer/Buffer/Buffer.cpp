@@ -2,6 +2,11 @@
 #include "Buffer.h"
 
 #include "Renderer/Renderer.h"
+#include "Renderer/Streaming/StreamingEngine.h"
+
+#if defined(MANTIS_64) || defined(MANTIS_32)
+#   include <emmintrin.h>
+#endif
 
 #define LOG_TAG MANTIS_TEXT("Buffer")
 
@@ -11,21 +16,30 @@ namespace Mantis
         const VkDeviceSize& size,
         const VkBufferUsageFlags& usage,
         const VmaMemoryUsage& memoryUsage,
-        const void* data
+        const void* data,
+        const VmaAllocationCreateFlags& allocationFlags
     )
         : m_buffer(VK_NULL_HANDLE)
         , m_allocator(Renderer::Get()->GetAllocator())
         , m_allocation(VK_NULL_HANDLE)
         , m_memoryFlags(0)
+        , m_mappedData(nullptr)
         , m_size(size)
-        , m_usage(usage)
+        , m_usage(memoryUsage == VMA_MEMORY_USAGE_GPU_ONLY ? usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT : usage)
         , m_mapMode(MapMode::None)
     {
         VmaAllocationCreateInfo allocCreateInfo = {};
+        allocCreateInfo.flags = allocationFlags;
         allocCreateInfo.usage = memoryUsage;
         allocCreateInfo.memoryTypeBits = 0;
         allocCreateInfo.pool = VK_NULL_HANDLE;
 
+        // when all device memory can be mapped prefer memory which can be written directly instead of staged
+        if (memoryUsage == VMA_MEMORY_USAGE_GPU_ONLY && Renderer::Get()->GetPhysicalDevice()->IsDeviceMemoryHostVisible())
+        {
+            allocCreateInfo.preferredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        }
+
         CreateBuffer(allocCreateInfo, data);
     }
 
@@ -33,17 +47,20 @@ namespace Mantis
         const VkDeviceSize& size,
         const VkBufferUsageFlags& usage,
         const VkMemoryPropertyFlags& properties,
-        const void* data
+        const void* data,
+        const VmaAllocationCreateFlags& allocationFlags
     )
         : m_buffer(VK_NULL_HANDLE)
         , m_allocator(Renderer::Get()->GetAllocator())
         , m_allocation(VK_NULL_HANDLE)
         , m_memoryFlags(0)
+        , m_mappedData(nullptr)
         , m_size(size)
         , m_usage(usage)
         , m_mapMode(MapMode::None)
     {
         VmaAllocationCreateInfo allocCreateInfo = {};
+        allocCreateInfo.flags = allocationFlags;
         allocCreateInfo.requiredFlags = properties;
         allocCreateInfo.memoryTypeBits = 0;
         allocCreateInfo.pool = VK_NULL_HANDLE;
@@ -53,6 +70,12 @@ namespace Mantis
 
     Buffer::~Buffer()
     {
+        // requests already submitted never touch the buffer again, and the buffer is only destroyed once they complete
+        if (auto streamingEngine = Renderer::Get()->GetStreamingEngine())
+        {
+            streamingEngine->Cancel(*this);
+        }
+
 		Renderer::Get()->DestroyBuffer(m_buffer, m_allocation);
     }
 
@@ -67,15 +90,19 @@ namespace Mantis
         {
             m_mapMode = mode;
 
-            if (Renderer::Check(vmaMapMemory(m_allocator, m_allocation, data)))
+            if (m_mappedData != nullptr)
+            {
+                *data = m_mappedData;
+            }
+            else if (Renderer::Check(vmaMapMemory(m_allocator, m_allocation, data)))
             {
                 Logger::ErrorT(LOG_TAG, "Failed to map buffer!");
             }
 
             // update the host memory to reflect the current buffer contents
-            if (HAS_FLAGS(m_mapMode, MapMode::Read) && HAS_NO_FLAG(m_memoryFlags, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+            if (HAS_FLAGS(m_mapMode, MapMode::Read))
             {
-                vmaInvalidateAllocation(m_allocator, m_allocation, 0, VK_WHOLE_SIZE);
+                Invalidate();
             }
         }
         else
@@ -88,12 +115,16 @@ namespace Mantis
     {
         if (m_mapMode != MapMode::None)
         {
-            vmaUnmapMemory(m_allocator, m_allocation);
+            // persistently mapped buffers stay mapped until they are destroyed
+            if (m_mappedData == nullptr)
+            {
+                vmaUnmapMemory(m_allocator, m_allocation);
+            }
 
             // if the buffer was writen flush to make the changes visible
-            if (HAS_FLAGS(m_mapMode, MapMode::Write) && HAS_NO_FLAG(m_memoryFlags, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+            if (HAS_FLAGS(m_mapMode, MapMode::Write))
             {
-                vmaFlushAllocation(m_allocator, m_allocation, 0, VK_WHOLE_SIZE);
+                Flush();
             }
 
             m_mapMode = MapMode::None;
@@ -104,6 +135,136 @@ namespace Mantis
         }
     }
 
+    void Buffer::Flush(const VkDeviceSize& offset, const VkDeviceSize& size)
+    {
+        if (HAS_FLAGS(m_memoryFlags, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+        {
+            return;
+        }
+
+        VkDeviceSize atomOffset;
+        VkDeviceSize atomSize;
+        GetAtomRange(offset, size, atomOffset, atomSize);
+
+        vmaFlushAllocation(m_allocator, m_allocation, atomOffset, atomSize);
+    }
+
+    void Buffer::Invalidate(const VkDeviceSize& offset, const VkDeviceSize& size)
+    {
+        if (HAS_FLAGS(m_memoryFlags, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+        {
+            return;
+        }
+
+        VkDeviceSize atomOffset;
+        VkDeviceSize atomSize;
+        GetAtomRange(offset, size, atomOffset, atomSize);
+
+        vmaInvalidateAllocation(m_allocator, m_allocation, atomOffset, atomSize);
+    }
+
+    void Buffer::StreamCopy(void* dst, const void* src, const size_t& size)
+    {
+#if defined(MANTIS_64) || defined(MANTIS_32)
+        auto d = static_cast<uint8_t*>(dst);
+        auto s = static_cast<const uint8_t*>(src);
+        auto remaining = size;
+
+        // the streaming stores require an aligned destination
+        auto head = eastl::min<size_t>((16 - (reinterpret_cast<uintptr_t>(d) & 15)) & 15, remaining);
+        memcpy(d, s, head);
+        d += head;
+        s += head;
+        remaining -= head;
+
+        for (; remaining >= 64; remaining -= 64, d += 64, s += 64)
+        {
+            auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+            auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 16));
+            auto c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 32));
+            auto e = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 48));
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d), a);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d + 16), b);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d + 32), c);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d + 48), e);
+        }
+
+        for (; remaining >= 16; remaining -= 16, d += 16, s += 16)
+        {
+            _mm_stream_si128(reinterpret_cast<__m128i*>(d), _mm_loadu_si128(reinterpret_cast<const __m128i*>(s)));
+        }
+
+        memcpy(d, s, remaining);
+
+        // the streaming stores are weakly ordered, so they must complete before the memory is used
+        _mm_sfence();
+#else
+        memcpy(dst, src, size);
+#endif
+    }
+
+    void Buffer::Write(const void* data, const VkDeviceSize& size, const VkDeviceSize& offset)
+    {
+        if (offset + size > m_size)
+        {
+            Logger::ErrorTF(LOG_TAG, "Cannot write %llu bytes at offset %llu to a buffer of %llu bytes!",
+                static_cast<unsigned long long>(size), static_cast<unsigned long long>(offset), static_cast<unsigned long long>(m_size));
+            return;
+        }
+
+        // memory the host cannot access is filled from staging memory on the GPU
+        if (HAS_NO_FLAG(m_memoryFlags, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+        {
+            Renderer::Get()->GetStreamingEngine()->Upload(*this, data, size, offset);
+            return;
+        }
+
+        void* mapped = m_mappedData;
+
+        if (mapped == nullptr && Renderer::Check(vmaMapMemory(m_allocator, m_allocation, &mapped)))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to map buffer!");
+            return;
+        }
+
+        auto dst = static_cast<uint8_t*>(mapped) + offset;
+
+        // uncached host memory is write-combined, where reading back the destination is very slow
+        if (HAS_NO_FLAG(m_memoryFlags, VK_MEMORY_PROPERTY_HOST_CACHED_BIT))
+        {
+            StreamCopy(dst, data, static_cast<size_t>(size));
+        }
+        else
+        {
+            memcpy(dst, data, static_cast<size_t>(size));
+        }
+
+        if (m_mappedData == nullptr)
+        {
+            vmaUnmapMemory(m_allocator, m_allocation);
+        }
+
+        Flush(offset, size);
+    }
+
+    void Buffer::GetAtomRange(const VkDeviceSize& offset, const VkDeviceSize& size, VkDeviceSize& atomOffset, VkDeviceSize& atomSize) const
+    {
+        auto atom = Renderer::Get()->GetPhysicalDevice()->GetProperties().limits.nonCoherentAtomSize;
+
+        atomOffset = offset & ~(atom - 1);
+
+        // ranges reaching the end of the buffer do not need to be a multiple of the atom size
+        if (size == VK_WHOLE_SIZE || offset + size >= m_size)
+        {
+            atomSize = VK_WHOLE_SIZE;
+        }
+        else
+        {
+            auto end = eastl::min((offset + size + atom - 1) & ~(atom - 1), m_size);
+            atomSize = end - atomOffset;
+        }
+    }
+
     void Buffer::CreateBuffer(const VmaAllocationCreateInfo& allocCreateInfo, const void* data)
     {
         auto logicalDevice = Renderer::Get()->GetLogicalDevice();
@@ -131,13 +292,15 @@ namespace Mantis
         // get the properties of the memory the buffer is stored in
         m_memoryFlags = Renderer::Get()->GetPhysicalDevice()->GetMemoryPropertyFlags(allocInfo.memoryType);
 
-        // if a pointer to the buffer data has been passed, map the buffer and copy over the data
+        if (HAS_FLAGS(allocCreateInfo.flags, VMA_ALLOCATION_CREATE_MAPPED_BIT))
+        {
+            m_mappedData = allocInfo.pMappedData;
+        }
+
+        // if a pointer to the buffer data has been passed, copy over the data
         if (data != nullptr)
         {
-            void* mapped;
-            Map(&mapped, MapMode::Write);
-            memcpy(mapped, data, static_cast<size_t>(m_size));
-            Unmap();
+            Write(data, m_size);
         }
     }
 }
@@ -35,11 +35,13 @@ namespace Mantis
         /// <param name="usage">Usage flag bitmask for the buffer.</param>
         /// <param name="memoryUsage">Memory usage for this buffer.</param>
         /// <param name="data">The data that should be copied to the buffer after creation.</param>
+        /// <param name="allocationFlags">Allocation flags, such as VMA_ALLOCATION_CREATE_MAPPED_BIT to keep the buffer mapped.</param>
         explicit Buffer(
             const VkDeviceSize& size,
             const VkBufferUsageFlags& usage,
             const VmaMemoryUsage& memoryUsage,
-            const void* data = nullptr
+            const void* data = nullptr,
+            const VmaAllocationCreateFlags& allocationFlags = 0
         );
 
         /// <summary>
@@ -49,11 +51,13 @@ namespace Mantis
         /// <param name="usage">Usage flag bitmask for the buffer.</param>
         /// <param name="properties">Memory properties for this buffer.</param>
         /// <param name="data">The data that should be copied to the buffer after creation.</param>
+        /// <param name="allocationFlags">Allocation flags, such as VMA_ALLOCATION_CREATE_MAPPED_BIT to keep the buffer mapped.</param>
         explicit Buffer(
             const VkDeviceSize& size,
             const VkBufferUsageFlags& usage,
             const VkMemoryPropertyFlags& properties,
-            const void* data = nullptr
+            const void* data = nullptr,
+            const VmaAllocationCreateFlags& allocationFlags = 0
         );
 
         /// <summary>
@@ -76,6 +80,11 @@ namespace Mantis
         /// </summary>
         const VkBufferUsageFlags& GetUsage() const { return m_usage; }
 
+        /// <summary>
+        /// Gets the pointer to the buffer memory if the buffer was created persistently mapped, otherwise null.
+        /// </summary>
+        void* GetMappedData() const { return m_mappedData; }
+
         /// <summary>
         /// Sets the name of this instance.
         /// </summary>
@@ -93,14 +102,54 @@ namespace Mantis
         /// </summary>
         void Unmap();
 
+        /// <summary>
+        /// Makes host writes to a range of the buffer visible to the device. Does nothing for coherent memory.
+        /// </summary>
+        /// <param name="offset">The start of the written range in bytes.</param>
+        /// <param name="size">The size of the written range in bytes.</param>
+        void Flush(const VkDeviceSize& offset = 0, const VkDeviceSize& size = VK_WHOLE_SIZE);
+
+        /// <summary>
+        /// Makes device writes to a range of the buffer visible to the host. Does nothing for coherent memory.
+        /// </summary>
+        /// <param name="offset">The start of the range to read in bytes.</param>
+        /// <param name="size">The size of the range to read in bytes.</param>
+        void Invalidate(const VkDeviceSize& offset = 0, const VkDeviceSize& size = VK_WHOLE_SIZE);
+
+        /// <summary>
+        /// Copies data into the buffer and flushes the written range. Write-combined memory is written
+        /// using non-temporal stores, so streamed data does not pass through the CPU caches. Memory the
+        /// host cannot access is queued to be filled by the streaming engine.
+        /// </summary>
+        /// <param name="data">The data to copy in.</param>
+        /// <param name="size">The number of bytes to copy.</param>
+        /// <param name="offset">The offset in the buffer to copy to in bytes.</param>
+        void Write(const void* data, const VkDeviceSize& size, const VkDeviceSize& offset = 0);
+
+        /// <summary>
+        /// Copies memory using non-temporal stores, which bypass the cache and fill whole write-combining
+        /// lines, instead of reading each destination line into the cache first. Used to fill mapped memory
+        /// that is written once and not read back by the host.
+        /// </summary>
+        /// <param name="dst">The memory to copy to.</param>
+        /// <param name="src">The memory to copy from.</param>
+        /// <param name="size">The number of bytes to copy.</param>
+        static void StreamCopy(void* dst, const void* src, const size_t& size);
+
     protected:
         void CreateBuffer(const VmaAllocationCreateInfo& allocCreateInfo, const void* data);
 
+        /// <summary>
+        /// Expands a range to the non-coherent atom size, as required when flushing or invalidating.
+        /// </summary>
+        void GetAtomRange(const VkDeviceSize& offset, const VkDeviceSize& size, VkDeviceSize& atomOffset, VkDeviceSize& atomSize) const;
+
         VkBuffer m_buffer;
         
         VmaAllocator m_allocator;
         VmaAllocation m_allocation;
         VkMemoryPropertyFlags m_memoryFlags;
+        void* m_mappedData;
         
         VkDeviceSize m_size;
         VkBufferUsageFlags m_usage;
@@ -5,16 +5,13 @@
 
 namespace Mantis
 {
-    StorageBuffer::StorageBuffer(const VkDeviceSize& size, const void* data) :
-        Buffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, data)
+    StorageBuffer::StorageBuffer(const VkDeviceSize& size, const void* data, const VkBufferUsageFlags& usage, const VmaMemoryUsage& memoryUsage) :
+        Buffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | usage, memoryUsage, data)
     {}
 
     void StorageBuffer::Update(const void* data)
     {
-        void* buffer;
-        Buffer::Map(&buffer);
-        memcpy(buffer, data, static_cast<size_t>(m_size));
-        Buffer::Unmap();
+        Buffer::Write(data, m_size);
     }
 
     VkDescriptorSetLayoutBinding StorageBuffer::GetDescriptorSetLayout(const uint32_t& binding, const VkDescriptorType& descriptorType, const VkShaderStageFlags& stage, const uint32_t& count)
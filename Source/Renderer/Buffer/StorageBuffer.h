@@ -12,7 +12,19 @@ namespace Mantis
         public Buffer
     {
     public:
-        explicit StorageBuffer(const VkDeviceSize& size, const void* data = nullptr);
+        /// <summary>
+        /// Creates a new storage buffer.
+        /// </summary>
+        /// <param name="size">Size of the buffer in bytes.</param>
+        /// <param name="data">The data that should be copied to the buffer after creation.</param>
+        /// <param name="usage">Usage flags needed in addition to storage buffer usage, such as indirect buffer usage.</param>
+        /// <param name="memoryUsage">Memory usage for this buffer.</param>
+        explicit StorageBuffer(
+            const VkDeviceSize& size,
+            const void* data = nullptr,
+            const VkBufferUsageFlags& usage = 0,
+            const VmaMemoryUsage& memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY
+        );
 
         /// <summary>
         /// Updates the contents of this buffer.
@@ -0,0 +1,72 @@
+#include "stdafx.h"
+#include "UniformAllocator.h"
+
+#include "Renderer/Renderer.h"
+#include "Renderer/FrameContext.h"
+
+#define LOG_TAG MANTIS_TEXT("UniformAllocator")
+
+namespace Mantis
+{
+    UniformAllocator::UniformAllocator(const VkDeviceSize& frameSize, const uint32_t& frameCount, const uint32_t& range) :
+        Buffer(
+            AlignFrameSize(frameSize) * frameCount,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            static_cast<VkMemoryPropertyFlags>(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+            nullptr,
+            VMA_ALLOCATION_CREATE_MAPPED_BIT
+        ),
+        m_alignment(Renderer::Get()->GetPhysicalDevice()->GetProperties().limits.minUniformBufferOffsetAlignment),
+        m_frameSize(AlignFrameSize(frameSize)),
+        m_range(range)
+    {
+        auto maxRange = Renderer::Get()->GetPhysicalDevice()->GetProperties().limits.maxUniformBufferRange;
+
+        if (m_range > maxRange)
+        {
+            Logger::WarningTF(LOG_TAG, "Uniform range %u exceeds the device limit of %u!", m_range, maxRange);
+            m_range = maxRange;
+        }
+
+        if (m_range > m_frameSize)
+        {
+            Logger::ErrorTF(LOG_TAG, "Uniform range %u is larger than the frame size %llu!", m_range, static_cast<unsigned long long>(m_frameSize));
+        }
+    }
+
+    UniformAllocation UniformAllocator::Allocate(const VkDeviceSize& size)
+    {
+        // each frame context recycles its region once its fence has been waited on
+        return Renderer::Get()->GetFrame().AllocateUniform(size);
+    }
+
+    WriteDescriptorSet UniformAllocator::GetWriteDescriptor(const uint32_t& binding, const VkDescriptorType& descriptorType, const eastl::optional<OffsetSize>& offsetSize) const
+    {
+        // the allocation offsets are applied when binding, so the descriptor always starts at the beginning of the buffer
+        VkDescriptorBufferInfo bufferInfo = {};
+        bufferInfo.buffer = m_buffer;
+        bufferInfo.offset = 0;
+        bufferInfo.range = m_range;
+
+        if (offsetSize)
+        {
+            bufferInfo.range = eastl::min<VkDeviceSize>(offsetSize->GetSize(), m_range);
+        }
+
+        VkWriteDescriptorSet descriptorWrite = {};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = VK_NULL_HANDLE;
+        descriptorWrite.dstBinding = binding;
+        descriptorWrite.dstArrayElement = 0;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.descriptorType = descriptorType;
+
+        return WriteDescriptorSet(descriptorWrite, bufferInfo);
+    }
+
+    VkDeviceSize UniformAllocator::AlignFrameSize(const VkDeviceSize& frameSize)
+    {
+        auto alignment = Renderer::Get()->GetPhysicalDevice()->GetProperties().limits.minUniformBufferOffsetAlignment;
+        return (frameSize + alignment - 1) & ~(alignment - 1);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include "Buffer.h"
+#include "Renderer/Descriptor/Descriptor.h"
+
+namespace Mantis
+{
+    /// <summary>
+    /// A range of a uniform allocator that may be written for the current frame.
+    /// </summary>
+    struct UniformAllocation
+    {
+        /// <summary>
+        /// The buffer containing the allocation.
+        /// </summary>
+        VkBuffer buffer;
+        /// <summary>
+        /// The dynamic offset to bind the allocation with.
+        /// </summary>
+        uint32_t offset;
+        /// <summary>
+        /// The mapped memory of the allocation. Null if the allocation failed.
+        /// </summary>
+        void* data;
+    };
+
+    /// <summary>
+    /// Sub-allocates per frame uniform data from a single persistently mapped buffer.
+    /// </summary>
+    /// <remarks>
+    /// The buffer is split into a region for each frame context. Allocations are made through the context of
+    /// the frame being recorded, linear within its region, which is recycled once the context's fence shows the
+    /// GPU has finished with it. Bind the buffer once to a uniform block the pipeline declares as dynamic, and pass the allocation offsets
+    /// when binding the descriptor set, instead of creating a buffer for every draw. The renderer owns the
+    /// allocator, see <see cref="Renderer::GetUniformAllocator"/>.
+    /// </remarks>
+    class UniformAllocator :
+        public Descriptor,
+        public Buffer
+    {
+    public:
+        /// <summary>
+        /// Creates a new uniform allocator.
+        /// </summary>
+        /// <param name="frameSize">The number of bytes that may be allocated each frame.</param>
+        /// <param name="frameCount">The number of frame contexts, each of which gets its own region.</param>
+        /// <param name="range">The size of the largest uniform block bound using the allocator.</param>
+        explicit UniformAllocator(const VkDeviceSize& frameSize, const uint32_t& frameCount, const uint32_t& range = 256);
+
+        /// <summary>
+        /// Gets the size of the largest allocation.
+        /// </summary>
+        const uint32_t& GetRange() const { return m_range; }
+
+        /// <summary>
+        /// Gets the alignment of the allocation offsets.
+        /// </summary>
+        const VkDeviceSize& GetAlignment() const { return m_alignment; }
+
+        /// <summary>
+        /// Gets the size in bytes of the region each frame context allocates from.
+        /// </summary>
+        const VkDeviceSize& GetFrameSize() const { return m_frameSize; }
+
+        /// <summary>
+        /// Gets the offset of the region a frame context allocates from.
+        /// </summary>
+        /// <param name="frameIndex">The position of the frame context in the ring.</param>
+        VkDeviceSize GetRegionOffset(const uint32_t& frameIndex) const { return frameIndex * m_frameSize; }
+
+        /// <summary>
+        /// Allocates uniform memory for the frame being recorded from its frame context. Thread safe.
+        /// </summary>
+        /// <param name="size">The size of the allocation in bytes.</param>
+        /// <returns>The allocation, with null data if there was not enough space.</returns>
+        UniformAllocation Allocate(const VkDeviceSize& size);
+
+        /// <summary>
+        /// Allocates uniform memory for the frame being recorded and copies in a value. Thread safe.
+        /// </summary>
+        /// <param name="value">The value to copy in.</param>
+        /// <returns>The allocation, with null data if there was not enough space.</returns>
+        template<typename T>
+        UniformAllocation Allocate(const T& value)
+        {
+            auto allocation = Allocate(sizeof(T));
+
+            if (allocation.data != nullptr)
+            {
+                memcpy(allocation.data, &value, sizeof(T));
+            }
+
+            return allocation;
+        }
+
+        WriteDescriptorSet GetWriteDescriptor(const uint32_t& binding, const VkDescriptorType& descriptorType, const eastl::optional<OffsetSize>& offsetSize) const override;
+
+    private:
+        static VkDeviceSize AlignFrameSize(const VkDeviceSize& frameSize);
+
+        VkDeviceSize m_alignment;
+        VkDeviceSize m_frameSize;
+        uint32_t m_range;
+    };
+}
\ No newline at end of file
@@ -6,15 +6,12 @@
 namespace Mantis
 {
     UniformBuffer::UniformBuffer(const VkDeviceSize& size, const void* data) :
-        Buffer(size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, data)
+        Buffer(size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, data, VMA_ALLOCATION_CREATE_MAPPED_BIT)
     {}
 
     void UniformBuffer::Update(const void* data)
     {
-        void* buffer;
-        Buffer::Map(&buffer);
-        memcpy(buffer, data, static_cast<size_t>(m_size));
-        Buffer::Unmap();
+        Buffer::Write(data, m_size);
     }
 
     VkDescriptorSetLayoutBinding UniformBuffer::GetDescriptorSetLayout(const uint32_t& binding, const VkDescriptorType& descriptorType, const VkShaderStageFlags& stage, const uint32_t& count)
@@ -2,6 +2,10 @@
 #include "CommandBuffer.h"
 
 #include "Renderer/Renderer.h"
+#include "Renderer/Renderpass/RenderingInfo.h"
+#include "Renderer/Renderpass/RenderpassCache.h"
+#include "Renderer/RenderGraph/RenderPassInfo.h"
+#include "Renderer/Image/ImageView.h"
 
 #define LOG_TAG MANTIS_TEXT("CommandBuffer")
 
@@ -13,18 +17,21 @@ namespace Mantis
         m_queueType(queueType),
         m_recording(false)
     {
-        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+        Allocate(bufferLevel);
 
-        VkCommandBufferAllocateInfo allocateInfo = {};
-        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocateInfo.commandPool = *m_commandPool;
-        allocateInfo.level = bufferLevel;
-        allocateInfo.commandBufferCount = 1;
-
-        if (Renderer::Check(vkAllocateCommandBuffers(*logicalDevice, &allocateInfo, &m_commandBuffer)))
+        if (begin)
         {
-            Logger::ErrorT(LOG_TAG, "Failed to create command buffer!");
+            Begin();
         }
+    }
+
+    CommandBuffer::CommandBuffer(const eastl::shared_ptr<CommandPool>& commandPool, const VkCommandBufferLevel& bufferLevel, const bool& begin) :
+        m_commandPool(commandPool),
+        m_commandBuffer(VK_NULL_HANDLE),
+        m_queueType(commandPool->GetQueueType()),
+        m_recording(false)
+    {
+        Allocate(bufferLevel);
 
         if (begin)
         {
@@ -39,6 +46,22 @@ namespace Mantis
         vkFreeCommandBuffers(*logicalDevice, *m_commandPool, 1, &m_commandBuffer);
     }
 
+    void CommandBuffer::Allocate(const VkCommandBufferLevel& bufferLevel)
+    {
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        VkCommandBufferAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.commandPool = *m_commandPool;
+        allocateInfo.level = bufferLevel;
+        allocateInfo.commandBufferCount = 1;
+
+        if (Renderer::Check(vkAllocateCommandBuffers(*logicalDevice, &allocateInfo, &m_commandBuffer)))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to create command buffer!");
+        }
+    }
+
     void CommandBuffer::Begin(const VkCommandBufferUsageFlags& usage)
     {
         if (!m_recording)
@@ -58,7 +81,7 @@ namespace Mantis
 
     void CommandBuffer::End()
     {
-        if (!m_recording)
+        if (m_recording)
         {
             if (Renderer::Check(vkEndCommandBuffer(m_commandBuffer)))
             {
@@ -69,6 +92,78 @@ namespace Mantis
         }
     }
 
+    void CommandBuffer::BeginRendering(const RenderingInfo& renderingInfo)
+    {
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        if (!logicalDevice->GetCapabilities().dynamicRendering)
+        {
+            Logger::ErrorT(LOG_TAG, "Dynamic rendering is not enabled on this device!");
+            return;
+        }
+
+        logicalDevice->GetCmdBeginRendering()(m_commandBuffer, &renderingInfo.GetRenderingInfo());
+    }
+
+    void CommandBuffer::EndRendering()
+    {
+        Renderer::Get()->GetLogicalDevice()->GetCmdEndRendering()(m_commandBuffer);
+    }
+
+    void CommandBuffer::BeginRenderPass(const RenderPassInfo& info, const VkSubpassContents& contents)
+    {
+        auto renderpassCache = Renderer::Get()->GetRenderpassCache();
+
+        auto renderPass = renderpassCache->GetRenderpass(info);
+        auto framebuffer = renderpassCache->GetFramebuffer(renderPass, info);
+
+        VkClearValue clearValues[RendererConfig::MAX_ATTACHMENTS + 1];
+        uint32_t clearValueCount = info.numColorAttachments;
+
+        for (uint32_t i = 0; i < info.numColorAttachments; i++)
+        {
+            clearValues[i].color = info.clearColor[i];
+        }
+        if (info.depthStencil != nullptr)
+        {
+            clearValues[clearValueCount++].depthStencil = info.clearDepthStencil;
+        }
+
+        // the render area must be within the attachments, which the default area is not
+        VkExtent2D extent = { UINT32_MAX, UINT32_MAX };
+
+        for (uint32_t i = 0; i < info.numColorAttachments; i++)
+        {
+            extent.width = eastl::min(extent.width, info.colorAttachments[i]->GetExtent().width);
+            extent.height = eastl::min(extent.height, info.colorAttachments[i]->GetExtent().height);
+        }
+        if (info.depthStencil != nullptr)
+        {
+            extent.width = eastl::min(extent.width, info.depthStencil->GetExtent().width);
+            extent.height = eastl::min(extent.height, info.depthStencil->GetExtent().height);
+        }
+
+        VkRenderPassBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        beginInfo.renderPass = renderPass;
+        beginInfo.framebuffer = framebuffer;
+        beginInfo.renderArea = RenderingInfo::ClampRenderArea(info.renderArea, extent);
+        beginInfo.clearValueCount = clearValueCount;
+        beginInfo.pClearValues = clearValues;
+
+        vkCmdBeginRenderPass(m_commandBuffer, &beginInfo, contents);
+    }
+
+    void CommandBuffer::NextSubpass(const VkSubpassContents& contents)
+    {
+        vkCmdNextSubpass(m_commandBuffer, contents);
+    }
+
+    void CommandBuffer::EndRenderPass()
+    {
+        vkCmdEndRenderPass(m_commandBuffer);
+    }
+
     void CommandBuffer::SubmitIdle()
     {
         if (m_recording)
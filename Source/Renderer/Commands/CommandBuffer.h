@@ -5,6 +5,9 @@
 
 namespace Mantis
 {
+    class RenderingInfo;
+    struct RenderPassInfo;
+
     class CommandBuffer
     {
     public:
@@ -20,6 +23,18 @@ namespace Mantis
             const bool& begin = true
         );
 
+        /// <summary>
+        /// Creates a new command buffer allocated from a specific command pool.
+        /// </summary>
+        /// <param name="commandPool">The pool to allocate from, which determines the queue the buffer runs on.</param>
+        /// <param name="bufferLevel">The buffer level.</param>
+        /// <param name="begin">If recording will start right away.</param>
+        explicit CommandBuffer(
+            const eastl::shared_ptr<CommandPool>& commandPool,
+            const VkCommandBufferLevel& bufferLevel = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            const bool& begin = true
+        );
+
         ~CommandBuffer();
 
         /// <summary>
@@ -53,6 +68,36 @@ namespace Mantis
         /// </summary>
         void End();
 
+        /// <summary>
+        /// Begins rendering to the attachments described, without using a render pass. The device must have the dynamic rendering capability.
+        /// </summary>
+        /// <param name="renderingInfo">The attachments to render to.</param>
+        void BeginRendering(const RenderingInfo& renderingInfo);
+
+        /// <summary>
+        /// Ends rendering begun with <see cref="BeginRendering"/>.
+        /// </summary>
+        void EndRendering();
+
+        /// <summary>
+        /// Begins a render pass rendering to the attachments described, using a render pass and framebuffer
+        /// from the renderpass cache.
+        /// </summary>
+        /// <param name="info">The attachments and subpasses to render.</param>
+        /// <param name="contents">How the commands of the first subpass are given.</param>
+        void BeginRenderPass(const RenderPassInfo& info, const VkSubpassContents& contents = VK_SUBPASS_CONTENTS_INLINE);
+
+        /// <summary>
+        /// Moves to the next subpass of the current render pass.
+        /// </summary>
+        /// <param name="contents">How the commands of the subpass are given.</param>
+        void NextSubpass(const VkSubpassContents& contents = VK_SUBPASS_CONTENTS_INLINE);
+
+        /// <summary>
+        /// Ends the render pass begun with <see cref="BeginRenderPass"/>.
+        /// </summary>
+        void EndRenderPass();
+
         /// <summary>
         /// Submits the command buffer to the queue and will hold the current thread idle until it has finished.
         /// </summary>
@@ -73,6 +118,8 @@ namespace Mantis
         );
 
     private:
+        void Allocate(const VkCommandBufferLevel& bufferLevel);
+
         eastl::shared_ptr<CommandPool> m_commandPool;
 
         VkCommandBuffer m_commandBuffer;
@@ -31,4 +31,13 @@ namespace Mantis
 
         vkDestroyCommandPool(*logicalDevice, m_commandPool, nullptr);
     }
+    void CommandPool::Reset()
+    {
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        if (Renderer::Check(vkResetCommandPool(*logicalDevice, m_commandPool, 0)))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to reset command pool!");
+        }
+    }
 }
@@ -28,6 +28,16 @@ namespace Mantis
         /// </summary>
         const VkCommandPool& GetCommandPool() const { return m_commandPool; }
 
+        /// <summary>
+        /// Gets the queue type this command pool allocates commands for.
+        /// </summary>
+        const QueueType& GetQueueType() const { return m_queueType; }
+
+        /// <summary>
+        /// Returns all command buffers allocated from this pool to the initial state. None of them may be pending execution.
+        /// </summary>
+        void Reset();
+
     private:
         VkCommandPool m_commandPool;
         QueueType m_queueType;
@@ -46,8 +46,8 @@ namespace Mantis
         vkUpdateDescriptorSets(*logicalDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
     }
 
-    void DescriptorSet::BindDescriptor(const CommandBuffer& commandBuffer)
+    void DescriptorSet::BindDescriptor(const CommandBuffer& commandBuffer, const uint32_t& dynamicOffsetCount, const uint32_t* dynamicOffsets)
     {
-        vkCmdBindDescriptorSets(commandBuffer, m_pipelineBindPoint, m_pipelineLayout, 0, 1, &m_descriptorSet, 0, nullptr);
+        vkCmdBindDescriptorSets(commandBuffer, m_pipelineBindPoint, m_pipelineLayout, 0, 1, &m_descriptorSet, dynamicOffsetCount, dynamicOffsets);
     }
 }
@@ -19,7 +19,13 @@ namespace Mantis
 
         void Update(const eastl::vector<VkWriteDescriptorSet>& descriptorWrites);
 
-        void BindDescriptor(const CommandBuffer& commandBuffer);
+        /// <summary>
+        /// Binds the descriptor set.
+        /// </summary>
+        /// <param name="commandBuffer">The command buffer to record to.</param>
+        /// <param name="dynamicOffsetCount">The number of dynamic offsets.</param>
+        /// <param name="dynamicOffsets">The offsets for each dynamic descriptor, in binding order.</param>
+        void BindDescriptor(const CommandBuffer& commandBuffer, const uint32_t& dynamicOffsetCount = 0, const uint32_t* dynamicOffsets = nullptr);
 
         const VkDescriptorSet& GetDescriptorSet() const { return m_descriptorSet; }
 
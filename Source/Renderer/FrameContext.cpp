@@ -0,0 +1,433 @@
+#include "stdafx.h"
+#include "FrameContext.h"
+
+#include "Renderer/Renderer.h"
+#include "Renderer/Renderpass/Swapchain.h"
+
+#define LOG_TAG MANTIS_TEXT("FrameContext")
+
+namespace Mantis
+{
+    FrameContext::FrameContext(const uint32_t& index) :
+        m_index(index),
+        m_frame(0),
+        m_fence(true),
+        m_swapchain(nullptr),
+        m_presentedSwapchain(nullptr),
+        m_presentResult(VK_SUCCESS),
+        m_queryPool(VK_NULL_HANDLE),
+        m_timestampMask(0),
+        m_timestampsWritten(false),
+        m_gpuTime(0.0f),
+        m_uniformHead(0),
+        m_stagingHead(0),
+        m_recording(false)
+    {
+        m_graphicsCommands.pool = eastl::make_shared<CommandPool>(QueueType::Graphics);
+        m_graphicsCommands.used = 0;
+        m_computeCommands.pool = eastl::make_shared<CommandPool>(QueueType::Compute);
+        m_computeCommands.used = 0;
+
+        // time the graphics work if the queue supports timestamps
+        auto physicalDevice = Renderer::Get()->GetPhysicalDevice();
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        uint32_t queueFamilyCount;
+        vkGetPhysicalDeviceQueueFamilyProperties(*physicalDevice, &queueFamilyCount, nullptr);
+
+        eastl::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(*physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+        auto timestampBits = queueFamilies[logicalDevice->GetGraphicsFamily()].timestampValidBits;
+
+        if (timestampBits > 0)
+        {
+            m_timestampMask = timestampBits < 64 ? (1ull << timestampBits) - 1 : ~0ull;
+
+            VkQueryPoolCreateInfo queryPoolInfo = {};
+            queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            queryPoolInfo.queryCount = 2;
+
+            if (Renderer::Check(vkCreateQueryPool(*logicalDevice, &queryPoolInfo, nullptr, &m_queryPool)))
+            {
+                Logger::ErrorT(LOG_TAG, "Failed to create timestamp query pool!");
+                m_queryPool = VK_NULL_HANDLE;
+            }
+        }
+
+        const auto& config = RendererConfig::Get();
+
+        m_stagingBuffer = eastl::make_unique<Buffer>(
+            config.frameStagingSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VMA_MEMORY_USAGE_CPU_ONLY,
+            nullptr,
+            VMA_ALLOCATION_CREATE_MAPPED_BIT
+        );
+    }
+
+    FrameContext::~FrameContext()
+    {
+        // the renderer waits for the device to be idle before destroying the frames
+        for (const auto& destroy : m_submittedDeletions)
+        {
+            destroy();
+        }
+        for (const auto& destroy : m_deletionQueue)
+        {
+            destroy();
+        }
+
+        if (m_queryPool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(*Renderer::Get()->GetLogicalDevice(), m_queryPool, nullptr);
+        }
+    }
+
+    bool FrameContext::IsComplete() const
+    {
+        return vkGetFenceStatus(*Renderer::Get()->GetLogicalDevice(), m_fence.GetFence()) == VK_SUCCESS;
+    }
+
+    void FrameContext::Wait()
+    {
+        m_fence.Wait();
+    }
+
+    void FrameContext::Begin(const uint64_t& frame)
+    {
+        // this only blocks when the GPU is still executing the last frame to use this context, meaning the ring is full
+        m_fence.Wait();
+        m_fence.Reset();
+
+        ReadTimestamps();
+
+        eastl::vector<eastl::function<void()>> deletions;
+        {
+            std::lock_guard<std::mutex> lock(m_deletionMutex);
+            deletions.swap(m_submittedDeletions);
+        }
+
+        for (const auto& destroy : deletions)
+        {
+            destroy();
+        }
+
+        for (auto commands : { &m_graphicsCommands, &m_computeCommands })
+        {
+            if (commands->used > 0)
+            {
+                commands->pool->Reset();
+                commands->used = 0;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_allocationMutex);
+            m_uniformHead = 0;
+            m_stagingHead = 0;
+            m_recording = true;
+        }
+
+        m_frame = frame;
+        m_swapchain = nullptr;
+        m_presentedSwapchain = nullptr;
+    }
+
+    void FrameContext::ReleaseSwapchain(const Swapchain& swapchain)
+    {
+        if (m_swapchain == &swapchain)
+        {
+            m_swapchain = nullptr;
+        }
+
+        if (m_presentedSwapchain == &swapchain)
+        {
+            m_presentedSwapchain = nullptr;
+        }
+    }
+
+    void FrameContext::ReadTimestamps()
+    {
+        if (!m_timestampsWritten)
+        {
+            return;
+        }
+
+        m_timestampsWritten = false;
+
+        uint64_t timestamps[2];
+        auto result = vkGetQueryPoolResults(
+            *Renderer::Get()->GetLogicalDevice(),
+            m_queryPool,
+            0,
+            2,
+            sizeof(timestamps),
+            timestamps,
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT
+        );
+
+        if (result == VK_SUCCESS)
+        {
+            auto period = Renderer::Get()->GetPhysicalDevice()->GetProperties().limits.timestampPeriod;
+            auto ticks = (timestamps[1] - timestamps[0]) & m_timestampMask;
+
+            m_gpuTime = static_cast<float>(static_cast<double>(ticks) * period / 1000000.0);
+        }
+    }
+
+    void FrameContext::Submit()
+    {
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        {
+            std::lock_guard<std::mutex> lock(m_allocationMutex);
+            m_recording = false;
+        }
+
+        FlushStaging();
+
+        auto endCommands = [](CommandBuffers& commands)
+        {
+            eastl::vector<VkCommandBuffer> buffers;
+            buffers.reserve(commands.used);
+
+            for (uint32_t i = 0; i < commands.used; i++)
+            {
+                commands.buffers[i]->End();
+                buffers.push_back(*commands.buffers[i]);
+            }
+
+            return buffers;
+        };
+
+        if (m_queryPool != VK_NULL_HANDLE && m_graphicsCommands.used > 0)
+        {
+            const auto& lastBuffer = *m_graphicsCommands.buffers[m_graphicsCommands.used - 1];
+            vkCmdWriteTimestamp(lastBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 1);
+            m_timestampsWritten = true;
+        }
+
+        auto graphicsBuffers = endCommands(m_graphicsCommands);
+        auto computeBuffers = endCommands(m_computeCommands);
+
+        // when the compute queue is the graphics queue the compute work is submitted first in the same batch, with no semaphore
+        if (!logicalDevice->HasAsyncCompute())
+        {
+            graphicsBuffers.insert(graphicsBuffers.begin(), computeBuffers.begin(), computeBuffers.end());
+            computeBuffers.clear();
+        }
+
+        VkSemaphore waitSemaphores[2];
+        VkPipelineStageFlags waitStages[2];
+        uint32_t waitCount = 0;
+
+        if (!computeBuffers.empty())
+        {
+            VkSubmitInfo computeInfo = {};
+            computeInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            computeInfo.commandBufferCount = static_cast<uint32_t>(computeBuffers.size());
+            computeInfo.pCommandBuffers = computeBuffers.data();
+            computeInfo.signalSemaphoreCount = 1;
+            computeInfo.pSignalSemaphores = &m_computeSemaphore.GetSemaphore();
+
+            if (Renderer::Check(vkQueueSubmit(logicalDevice->GetComputeQueue(), 1, &computeInfo, VK_NULL_HANDLE)))
+            {
+                Logger::ErrorT(LOG_TAG, "Failed to submit frame compute commands!");
+            }
+            else
+            {
+                // the compute results may be consumed by any stage of the graphics work
+                waitSemaphores[waitCount] = m_computeSemaphore.GetSemaphore();
+                waitStages[waitCount++] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            }
+        }
+
+        if (m_swapchain)
+        {
+            waitSemaphores[waitCount] = m_acquireSemaphore.GetSemaphore();
+            waitStages[waitCount++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        }
+
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = waitCount;
+        submitInfo.pWaitSemaphores = waitSemaphores;
+        submitInfo.pWaitDstStageMask = waitStages;
+        submitInfo.commandBufferCount = static_cast<uint32_t>(graphicsBuffers.size());
+        submitInfo.pCommandBuffers = graphicsBuffers.data();
+
+        if (m_swapchain)
+        {
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &m_presentSemaphore.GetSemaphore();
+        }
+
+        // the fence is submitted even when there is no work, so the next wait on this context completes
+        if (Renderer::Check(vkQueueSubmit(logicalDevice->GetGraphicsQueue(), 1, &submitInfo, m_fence.GetFence())))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to submit frame graphics commands!");
+        }
+
+        if (m_swapchain)
+        {
+            m_presentResult = m_swapchain->QueuePresent(logicalDevice->GetPresentQueue(), &m_presentSemaphore);
+            m_presentedSwapchain = m_swapchain;
+            m_swapchain = nullptr;
+        }
+
+        // anything released while recording may be used by this submission
+        std::lock_guard<std::mutex> lock(m_deletionMutex);
+
+        for (auto& destroy : m_deletionQueue)
+        {
+            m_submittedDeletions.push_back(eastl::move(destroy));
+        }
+        m_deletionQueue.clear();
+    }
+
+    void FrameContext::DeferDestroy(eastl::function<void()>&& destroy)
+    {
+        std::lock_guard<std::mutex> lock(m_deletionMutex);
+        m_deletionQueue.push_back(eastl::move(destroy));
+    }
+
+    CommandBuffer& FrameContext::RequestCommandBuffer(const QueueType& queueType)
+    {
+        auto& commands = GetCommandBuffers(queueType);
+
+        // command buffers are kept between frames and reused once their pool has been reset
+        if (commands.used == commands.buffers.size())
+        {
+            commands.buffers.push_back(eastl::make_unique<CommandBuffer>(commands.pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, false));
+        }
+
+        auto& commandBuffer = *commands.buffers[commands.used++];
+        commandBuffer.Begin();
+
+        // the frame is timed from the start of the first graphics command buffer
+        if (m_queryPool != VK_NULL_HANDLE && &commands == &m_graphicsCommands && commands.used == 1)
+        {
+            vkCmdResetQueryPool(commandBuffer, m_queryPool, 0, 2);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, 0);
+        }
+
+        return commandBuffer;
+    }
+
+    VkResult FrameContext::AcquireImage(Swapchain& swapchain)
+    {
+        auto result = swapchain.AcquireNextImage(&m_acquireSemaphore);
+
+        // the semaphore is only signaled when an image was acquired
+        if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)
+        {
+            m_swapchain = &swapchain;
+        }
+
+        return result;
+    }
+
+    UniformAllocation FrameContext::AllocateUniform(const VkDeviceSize& size)
+    {
+        const auto& allocator = *Renderer::Get()->GetUniformAllocator();
+
+        UniformAllocation allocation = {};
+        allocation.buffer = allocator.GetBuffer();
+
+        if (size > allocator.GetRange())
+        {
+            Logger::ErrorTF(LOG_TAG, "Cannot allocate %llu bytes, the uniform range is %u!", static_cast<unsigned long long>(size), allocator.GetRange());
+            return allocation;
+        }
+
+        std::lock_guard<std::mutex> lock(m_allocationMutex);
+
+        // the memory would be reused while the GPU may still read it
+        if (!m_recording)
+        {
+            Logger::ErrorT(LOG_TAG, "Cannot allocate uniform memory from a frame that has not begun!");
+            return allocation;
+        }
+
+        auto alignment = allocator.GetAlignment();
+        auto offset = (m_uniformHead + alignment - 1) & ~(alignment - 1);
+
+        // the whole bound range must fit in the region, not just the allocated size
+        if (offset + allocator.GetRange() > allocator.GetFrameSize())
+        {
+            Logger::ErrorTF(LOG_TAG, "Out of frame uniform memory, %llu bytes are available each frame!", static_cast<unsigned long long>(allocator.GetFrameSize()));
+            return allocation;
+        }
+
+        m_uniformHead = offset + size;
+
+        auto regionOffset = allocator.GetRegionOffset(m_index) + offset;
+
+        allocation.offset = static_cast<uint32_t>(regionOffset);
+        allocation.data = static_cast<uint8_t*>(allocator.GetMappedData()) + regionOffset;
+        return allocation;
+    }
+
+    StagingAllocation FrameContext::AllocateStaging(const VkDeviceSize& size, const VkDeviceSize& alignment)
+    {
+        StagingAllocation allocation = {};
+        allocation.buffer = m_stagingBuffer->GetBuffer();
+
+        std::lock_guard<std::mutex> lock(m_allocationMutex);
+
+        if (!m_recording)
+        {
+            Logger::ErrorT(LOG_TAG, "Cannot allocate staging memory from a frame that has not begun!");
+            return allocation;
+        }
+
+        // texel sizes such as 12 bytes are not powers of two
+        auto offset = (m_stagingHead + alignment - 1) / alignment * alignment;
+
+        if (offset + size > m_stagingBuffer->GetSize())
+        {
+            Logger::ErrorTF(LOG_TAG, "Out of frame staging memory, %llu bytes are available each frame!", static_cast<unsigned long long>(m_stagingBuffer->GetSize()));
+            return allocation;
+        }
+
+        m_stagingHead = offset + size;
+
+        allocation.offset = offset;
+        allocation.data = static_cast<uint8_t*>(m_stagingBuffer->GetMappedData()) + offset;
+        return allocation;
+    }
+
+    void FrameContext::FlushStaging()
+    {
+        // does nothing for coherent memory, the uniform allocator is always coherent
+        std::lock_guard<std::mutex> lock(m_allocationMutex);
+
+        if (m_stagingHead > 0)
+        {
+            m_stagingBuffer->Flush(0, m_stagingHead);
+        }
+    }
+
+    VkDeviceSize FrameContext::GetStagingAvailable(const VkDeviceSize& alignment)
+    {
+        std::lock_guard<std::mutex> lock(m_allocationMutex);
+
+        auto offset = (m_stagingHead + alignment - 1) / alignment * alignment;
+        return offset < m_stagingBuffer->GetSize() ? m_stagingBuffer->GetSize() - offset : 0;
+    }
+
+    FrameContext::CommandBuffers& FrameContext::GetCommandBuffers(const QueueType& queueType)
+    {
+        switch (queueType)
+        {
+            case QueueType::Graphics:   return m_graphicsCommands;
+            case QueueType::Compute:    return m_computeCommands;
+            default:
+                Logger::ErrorT(LOG_TAG, "Frame command buffers must run on the graphics or compute queue!");
+                return m_graphicsCommands;
+        }
+    }
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include "Renderer/Buffer/Buffer.h"
+#include "Renderer/Buffer/UniformAllocator.h"
+#include "Renderer/Commands/CommandBuffer.h"
+#include "Renderer/Utils/Fence.h"
+#include "Renderer/Utils/Semaphore.h"
+
+namespace Mantis
+{
+    class Swapchain;
+
+    /// <summary>
+    /// A range of a frame's staging buffer that may be written for the current frame.
+    /// </summary>
+    struct StagingAllocation
+    {
+        /// <summary>
+        /// The buffer containing the allocation.
+        /// </summary>
+        VkBuffer buffer;
+        /// <summary>
+        /// The offset of the allocation in the buffer.
+        /// </summary>
+        VkDeviceSize offset;
+        /// <summary>
+        /// The mapped memory of the allocation. Null if the allocation failed.
+        /// </summary>
+        void* data;
+    };
+
+    /// <summary>
+    /// The resources used to record and submit one frame.
+    /// </summary>
+    /// <remarks>
+    /// The renderer keeps a ring of frame contexts, one for each frame in flight. A context is only recycled
+    /// once the fence signaled by its last submission has completed, so the CPU records the next frame while
+    /// the GPU is still executing the previous ones, and only waits when every context in the ring is in
+    /// flight. Recycling resets the command pools and the staging and uniform allocators, and destroys the
+    /// resources released while the context was last recorded.
+    /// </remarks>
+    class FrameContext :
+        public NonCopyable
+    {
+    public:
+        /// <summary>
+        /// Creates a new frame context.
+        /// </summary>
+        /// <param name="index">The position of the context in the ring.</param>
+        explicit FrameContext(const uint32_t& index);
+
+        ~FrameContext();
+
+        /// <summary>
+        /// Gets the position of the context in the ring.
+        /// </summary>
+        const uint32_t& GetIndex() const { return m_index; }
+
+        /// <summary>
+        /// Gets the number of the frame the context was last begun for.
+        /// </summary>
+        const uint64_t& GetFrame() const { return m_frame; }
+
+        /// <summary>
+        /// Gets the fence signaled once the last submission of this context has completed.
+        /// </summary>
+        const Fence& GetFence() const { return m_fence; }
+
+        /// <summary>
+        /// Gets if the last submission of this context has completed.
+        /// </summary>
+        bool IsComplete() const;
+
+        /// <summary>
+        /// Waits until the last submission of this context has completed.
+        /// </summary>
+        void Wait();
+
+        /// <summary>
+        /// Gets a command buffer that is recording, which is submitted when the frame ends in the order it was
+        /// requested. Compute command buffers are submitted before the graphics command buffers, which wait on them.
+        /// Must only be called on the render thread.
+        /// </summary>
+        /// <param name="queueType">The queue to run the command buffer on, graphics or compute.</param>
+        CommandBuffer& RequestCommandBuffer(const QueueType& queueType = QueueType::Graphics);
+
+        /// <summary>
+        /// Acquires the next swapchain image for this frame. The graphics command buffers wait for the image to be
+        /// available, and the image is presented once they have completed.
+        /// </summary>
+        /// <param name="swapchain">The swapchain to acquire from.</param>
+        /// <returns>The result of the image acquisition.</returns>
+        VkResult AcquireImage(Swapchain& swapchain);
+
+        /// <summary>
+        /// Gets the result of the last presentation of this context.
+        /// </summary>
+        const VkResult& GetPresentResult() const { return m_presentResult; }
+
+        /// <summary>
+        /// Gets the swapchain the last submission of this context presented to, or null if nothing was presented.
+        /// </summary>
+        const Swapchain* GetPresentedSwapchain() const { return m_presentedSwapchain; }
+
+        /// <summary>
+        /// Gets the time in milliseconds the GPU spent executing the graphics commands of the last completed
+        /// submission of this context, measured with timestamp queries. Zero if not known.
+        /// </summary>
+        const float& GetGpuTime() const { return m_gpuTime; }
+
+        /// <summary>
+        /// Allocates uniform memory from this context's region of the renderer's uniform allocator, which is valid
+        /// until the frame has completed. The frame must have begun and not yet been submitted. Thread safe.
+        /// </summary>
+        /// <param name="size">The size of the allocation in bytes.</param>
+        /// <returns>The allocation, with null data if there was not enough space or the frame is not being recorded.</returns>
+        UniformAllocation AllocateUniform(const VkDeviceSize& size);
+
+        /// <summary>
+        /// Allocates staging memory to copy from that is valid until the frame has completed. The frame must have
+        /// begun and not yet been submitted. Thread safe.
+        /// </summary>
+        /// <param name="size">The size of the allocation in bytes.</param>
+        /// <param name="alignment">The alignment of the allocation offset in bytes.</param>
+        /// <returns>The allocation, with null data if there was not enough space or the frame is not being recorded.</returns>
+        StagingAllocation AllocateStaging(const VkDeviceSize& size, const VkDeviceSize& alignment = 16);
+
+        /// <summary>
+        /// Gets the largest staging allocation that can currently be made. Thread safe.
+        /// </summary>
+        /// <param name="alignment">The alignment of the allocation offset in bytes.</param>
+        VkDeviceSize GetStagingAvailable(const VkDeviceSize& alignment = 16);
+
+        /// <summary>
+        /// Makes the staging memory written so far visible to the device. Must be called before submitting work
+        /// which copies from it, the frame's own submission does so itself. Thread safe.
+        /// </summary>
+        void FlushStaging();
+
+    private:
+        friend class Renderer;
+
+        struct CommandBuffers
+        {
+            eastl::shared_ptr<CommandPool> pool;
+            eastl::vector<eastl::unique_ptr<CommandBuffer>> buffers;
+            uint32_t used;
+        };
+
+        /// <summary>
+        /// Waits until the last submission of this context has completed and recycles its resources.
+        /// </summary>
+        /// <param name="frame">The number of the frame that is starting.</param>
+        void Begin(const uint64_t& frame);
+
+        /// <summary>
+        /// Forgets a swapchain which is being destroyed, so a swapchain later created at the same address is not
+        /// mistaken for it.
+        /// </summary>
+        /// <param name="swapchain">The swapchain being destroyed.</param>
+        void ReleaseSwapchain(const Swapchain& swapchain);
+
+        /// <summary>
+        /// Submits the requested command buffers and presents any acquired image.
+        /// </summary>
+        void Submit();
+
+        /// <summary>
+        /// Reads the timestamps written by the last submission, which must have completed.
+        /// </summary>
+        void ReadTimestamps();
+
+        /// <summary>
+        /// Queues a destruction to run once the next submission of this context has completed. Thread safe.
+        /// </summary>
+        /// <param name="destroy">The function that destroys the resource.</param>
+        void DeferDestroy(eastl::function<void()>&& destroy);
+
+        CommandBuffers& GetCommandBuffers(const QueueType& queueType);
+
+        uint32_t m_index;
+        uint64_t m_frame;
+
+        Fence m_fence;
+        Semaphore m_acquireSemaphore;
+        Semaphore m_presentSemaphore;
+        Semaphore m_computeSemaphore;
+
+        CommandBuffers m_graphicsCommands;
+        CommandBuffers m_computeCommands;
+
+        Swapchain* m_swapchain;
+        const Swapchain* m_presentedSwapchain;
+        VkResult m_presentResult;
+
+        VkQueryPool m_queryPool;
+        uint64_t m_timestampMask;
+        bool m_timestampsWritten;
+        float m_gpuTime;
+
+        std::mutex m_allocationMutex;
+        eastl::unique_ptr<Buffer> m_stagingBuffer;
+        VkDeviceSize m_uniformHead;
+        VkDeviceSize m_stagingHead;
+
+        /// <summary>
+        /// If the frame has begun and not yet been submitted, so memory can be allocated from it.
+        /// </summary>
+        bool m_recording;
+
+        std::mutex m_deletionMutex;
+        eastl::vector<eastl::function<void()>> m_deletionQueue;
+        eastl::vector<eastl::function<void()>> m_submittedDeletions;
+    };
+}
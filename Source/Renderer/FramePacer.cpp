@@ -0,0 +1,180 @@
+#include "stdafx.h"
+#include "FramePacer.h"
+
+#include "Renderer/Renderer.h"
+#include "Renderer/FrameContext.h"
+#include "Renderer/Renderpass/Swapchain.h"
+
+#define LOG_TAG MANTIS_TEXT("FramePacer")
+
+namespace Mantis
+{
+    /// <summary>
+    /// The longest time in nanoseconds to wait for a presentation, since presentations may never be displayed
+    /// while the window is minimized.
+    /// </summary>
+    static const uint64_t PRESENT_TIMEOUT = 100 * 1000 * 1000;
+
+    /// <summary>
+    /// The weight given to each new sample when smoothing the frame timings.
+    /// </summary>
+    static const float SMOOTHING = 0.1f;
+
+    FramePacer::FramePacer() :
+        m_frameStart(),
+        m_lastDisplayed(),
+        m_hasDisplayed(false)
+    {
+    }
+
+    void FramePacer::BeginFrame()
+    {
+        const auto& config = RendererConfig::Get();
+        auto start = Clock::now();
+
+        // find the frames which have been displayed since the last frame
+        while (!m_queuedFrames.empty() && RetireFrame(false))
+        {
+        }
+
+        m_stats.queuedFrames = static_cast<uint32_t>(m_queuedFrames.size());
+
+        // limit the number of frames waiting to be displayed
+        auto maxQueuedFrames = eastl::max(config.maxQueuedFrames, 1u);
+
+        while (m_queuedFrames.size() >= maxQueuedFrames)
+        {
+            RetireFrame(true);
+        }
+
+        if (config.framePacing == FramePacing::LowLatency && m_hasDisplayed && m_stats.presentInterval > 0.0f)
+        {
+            // start late enough that the frame completes just before the refresh after the queued frames are displayed
+            auto refreshes = static_cast<float>(m_queuedFrames.size() + 1);
+            auto work = m_stats.cpuTime + m_stats.gpuTime + config.framePacingMargin;
+
+            auto target = m_lastDisplayed + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<float, std::milli>(m_stats.presentInterval * refreshes - work));
+
+            // never wait longer than a refresh, in case the estimates are stale
+            auto latest = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<float, std::milli>(m_stats.presentInterval));
+
+            std::this_thread::sleep_until(eastl::min(target, latest));
+        }
+
+        auto now = Clock::now();
+
+        Smooth(m_stats.pacingWait, ToMilliseconds(now - start));
+
+        if (m_frameStart != Clock::time_point())
+        {
+            Smooth(m_stats.frameInterval, ToMilliseconds(now - m_frameStart));
+        }
+
+        m_frameStart = now;
+    }
+
+    void FramePacer::EndFrame(FrameContext& frame)
+    {
+        Smooth(m_stats.cpuTime, ToMilliseconds(Clock::now() - m_frameStart));
+
+        // the GPU time is from the last frame to complete using the context
+        if (frame.GetGpuTime() > 0.0f)
+        {
+            Smooth(m_stats.gpuTime, frame.GetGpuTime());
+        }
+
+        QueuedFrame queued = {};
+        queued.context = &frame;
+        queued.frame = frame.GetFrame();
+        queued.start = m_frameStart;
+
+        auto swapchain = frame.GetPresentedSwapchain();
+        auto presented = frame.GetPresentResult() == VK_SUCCESS || frame.GetPresentResult() == VK_SUBOPTIMAL_KHR;
+
+        if (swapchain != nullptr && presented && swapchain->SupportsPresentWait())
+        {
+            queued.swapchain = swapchain;
+            queued.presentId = swapchain->GetPresentId();
+        }
+
+        m_stats.presentWait = queued.swapchain != nullptr;
+        m_queuedFrames.push_back(queued);
+    }
+
+    void FramePacer::OnSwapchainDestroyed(const Swapchain& swapchain)
+    {
+        // fall back to waiting for the frames to complete on the GPU
+        for (auto& queued : m_queuedFrames)
+        {
+            if (queued.swapchain == &swapchain)
+            {
+                queued.swapchain = nullptr;
+            }
+        }
+    }
+
+    bool FramePacer::RetireFrame(const bool& wait)
+    {
+        auto& queued = m_queuedFrames.front();
+        auto displayed = false;
+
+        if (queued.swapchain != nullptr)
+        {
+            auto result = queued.swapchain->WaitForPresent(queued.presentId, wait ? PRESENT_TIMEOUT : 0);
+
+            if (result == VK_TIMEOUT && !wait)
+            {
+                return false;
+            }
+
+            // presentations which time out or fail are dropped without timing them
+            displayed = result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR;
+        }
+        else
+        {
+            // the context has been reused for a later frame, so the frame must have completed
+            if (queued.context->GetFrame() == queued.frame)
+            {
+                if (wait)
+                {
+                    queued.context->Wait();
+                }
+                else if (!queued.context->IsComplete())
+                {
+                    return false;
+                }
+            }
+
+            displayed = true;
+        }
+
+        if (displayed)
+        {
+            auto now = Clock::now();
+
+            if (m_hasDisplayed)
+            {
+                Smooth(m_stats.presentInterval, ToMilliseconds(now - m_lastDisplayed));
+            }
+            Smooth(m_stats.latency, ToMilliseconds(now - queued.start));
+
+            m_lastDisplayed = now;
+            m_hasDisplayed = true;
+        }
+
+        m_queuedFrames.pop_front();
+        return true;
+    }
+
+    float FramePacer::ToMilliseconds(const Clock::duration& duration)
+    {
+        return std::chrono::duration<float, std::milli>(duration).count();
+    }
+
+    void FramePacer::Smooth(float& value, const float& sample)
+    {
+        value = value > 0.0f ? value + (sample - value) * SMOOTHING : sample;
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include <chrono>
+
+namespace Mantis
+{
+    class FrameContext;
+    class Swapchain;
+
+    /// <summary>
+    /// Smoothed timings of recent frames, in milliseconds.
+    /// </summary>
+    struct FrameStats
+    {
+        /// <summary>
+        /// The time spent recording a frame, from the frame starting to its submission.
+        /// </summary>
+        float cpuTime = 0.0f;
+        /// <summary>
+        /// The time the GPU spends executing a frame.
+        /// </summary>
+        float gpuTime = 0.0f;
+        /// <summary>
+        /// The time between the start of consecutive frames.
+        /// </summary>
+        float frameInterval = 0.0f;
+        /// <summary>
+        /// The time between consecutive frames being displayed. Approximated by the time between frames completing
+        /// on the GPU when present waits are not supported.
+        /// </summary>
+        float presentInterval = 0.0f;
+        /// <summary>
+        /// The time between a frame starting and it being displayed.
+        /// </summary>
+        float latency = 0.0f;
+        /// <summary>
+        /// The time the pacer delayed the start of a frame.
+        /// </summary>
+        float pacingWait = 0.0f;
+        /// <summary>
+        /// The number of frames submitted but not yet displayed when the last frame started.
+        /// </summary>
+        uint32_t queuedFrames = 0;
+        /// <summary>
+        /// Are presentation times measured using present waits.
+        /// </summary>
+        bool presentWait = false;
+    };
+
+    /// <summary>
+    /// Schedules the start of frames and measures frame timings.
+    /// </summary>
+    /// <remarks>
+    /// The number of frames that are submitted but not yet displayed is limited to the configured maximum, using
+    /// present waits where supported and otherwise waiting for the frames to complete on the GPU. With low latency
+    /// pacing, the start of each frame is also delayed so that, given the recent CPU and GPU frame times, it
+    /// completes just before the display refresh it will be presented at. Input read at the start of a frame is
+    /// then as recent as possible when displayed, without missing the refresh.
+    /// </remarks>
+    class FramePacer :
+        public NonCopyable
+    {
+    public:
+        FramePacer();
+
+        /// <summary>
+        /// Waits until the next frame should start. Called by the renderer when a frame begins.
+        /// </summary>
+        void BeginFrame();
+
+        /// <summary>
+        /// Records a frame that has been submitted. Called by the renderer when a frame ends.
+        /// </summary>
+        /// <param name="frame">The context the frame was submitted with.</param>
+        void EndFrame(FrameContext& frame);
+
+        /// <summary>
+        /// Gets the smoothed timings of recent frames.
+        /// </summary>
+        const FrameStats& GetStats() const { return m_stats; }
+
+        /// <summary>
+        /// Stops waiting on presentations from a swapchain that is being destroyed.
+        /// </summary>
+        /// <param name="swapchain">The swapchain being destroyed.</param>
+        void OnSwapchainDestroyed(const Swapchain& swapchain);
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        /// <summary>
+        /// A frame that has been submitted but is not yet known to be displayed.
+        /// </summary>
+        struct QueuedFrame
+        {
+            FrameContext* context;
+            uint64_t frame;
+            const Swapchain* swapchain;
+            uint64_t presentId;
+            Clock::time_point start;
+        };
+
+        /// <summary>
+        /// Checks if the oldest queued frame has been displayed, optionally waiting for it.
+        /// </summary>
+        /// <param name="wait">Wait until the frame has been displayed.</param>
+        /// <returns>True if the frame was displayed and removed from the queue.</returns>
+        bool RetireFrame(const bool& wait);
+
+        static float ToMilliseconds(const Clock::duration& duration);
+
+        static void Smooth(float& value, const float& sample);
+
+        eastl::deque<QueuedFrame> m_queuedFrames;
+
+        Clock::time_point m_frameStart;
+        Clock::time_point m_lastDisplayed;
+        bool m_hasDisplayed;
+
+        FrameStats m_stats;
+    };
+}
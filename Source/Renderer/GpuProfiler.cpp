@@ -0,0 +1,538 @@
+#include "stdafx.h"
+#include "GpuProfiler.h"
+
+#include "Renderer/Renderer.h"
+#include "Renderer/FrameContext.h"
+#include "Renderer/Commands/CommandBuffer.h"
+#include "Utils/TraceWriter.h"
+
+#define LOG_TAG MANTIS_TEXT("GpuProfiler")
+
+namespace Mantis
+{
+    /// <summary>
+    /// The pipeline statistics counted by scopes that request them, in the order the results are written.
+    /// </summary>
+    static const VkQueryPipelineStatisticFlags PIPELINE_STATISTICS =
+        VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+    /// <summary>
+    /// The number of counters in each pipeline statistics result.
+    /// </summary>
+    static const uint32_t PIPELINE_STATISTIC_COUNT = 6;
+
+    static VkQueryPool CreateQueryPool(const VkQueryType& type, const uint32_t& count, const VkQueryPipelineStatisticFlags& statistics)
+    {
+        VkQueryPoolCreateInfo queryPoolInfo = {};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = type;
+        queryPoolInfo.queryCount = count;
+        queryPoolInfo.pipelineStatistics = statistics;
+
+        VkQueryPool pool = VK_NULL_HANDLE;
+
+        if (Renderer::Check(vkCreateQueryPool(*Renderer::Get()->GetLogicalDevice(), &queryPoolInfo, nullptr, &pool)))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to create query pool!");
+            return VK_NULL_HANDLE;
+        }
+
+        return pool;
+    }
+
+    static float GetMean(const eastl::vector<float>& samples)
+    {
+        auto total = 0.0f;
+        for (auto sample : samples)
+        {
+            total += sample;
+        }
+        return total / samples.size();
+    }
+
+    static float GetPercentile(const eastl::vector<float>& sorted, const float& percentile)
+    {
+        auto index = static_cast<size_t>(percentile * (sorted.size() - 1) + 0.5f);
+        return sorted[eastl::min(index, sorted.size() - 1)];
+    }
+
+    GpuProfiler::GpuProfiler() :
+        m_current(nullptr),
+        m_maxScopes(eastl::max(RendererConfig::Get().gpuProfilerMaxScopes, 1u)),
+        m_timestampMasks(),
+        m_timestampPeriod(Renderer::Get()->GetPhysicalDevice()->GetProperties().limits.timestampPeriod),
+        m_historySize(eastl::max(RendererConfig::Get().gpuProfilerHistory, 1u)),
+        m_traceOrigins(),
+        m_hasTraceOrigins(),
+        m_warnedScopeLimit(false)
+    {
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+        const auto& queueFamilies = logicalDevice->GetQueueFamilies();
+
+        uint32_t families[QUEUE_COUNT] = {
+            logicalDevice->GetGraphicsFamily(),
+            logicalDevice->GetComputeFamily(),
+        };
+
+        for (uint32_t queue = 0; queue < QUEUE_COUNT; queue++)
+        {
+            auto timestampBits = queueFamilies[families[queue]].timestampValidBits;
+
+            if (timestampBits > 0)
+            {
+                m_timestampMasks[queue] = timestampBits < 64 ? (1ull << timestampBits) - 1 : ~0ull;
+            }
+            else
+            {
+                Logger::WarningTF(LOG_TAG, "The %s queue does not support timestamps, so it can't be profiled!", GetQueueName(queue));
+            }
+        }
+
+        auto statistics = RendererConfig::Get().gpuProfilerStatistics && logicalDevice->GetEnabledFeatures().pipelineStatisticsQuery;
+
+        m_frames.resize(Renderer::Get()->GetFramesInFlight());
+
+        for (auto& queries : m_frames)
+        {
+            for (uint32_t queue = 0; queue < QUEUE_COUNT; queue++)
+            {
+                queries.timestampPools[queue] = m_timestampMasks[queue] != 0 ? CreateQueryPool(VK_QUERY_TYPE_TIMESTAMP, 2 * m_maxScopes, 0) : VK_NULL_HANDLE;
+                queries.timestampCounts[queue] = 0;
+            }
+
+            queries.statisticsPool = statistics ? CreateQueryPool(VK_QUERY_TYPE_PIPELINE_STATISTICS, m_maxScopes, PIPELINE_STATISTICS) : VK_NULL_HANDLE;
+            queries.statisticsCount = 0;
+            queries.computeReset = false;
+            queries.frame = 0;
+        }
+    }
+
+    GpuProfiler::~GpuProfiler()
+    {
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        for (auto& queries : m_frames)
+        {
+            for (auto pool : queries.timestampPools)
+            {
+                if (pool != VK_NULL_HANDLE)
+                {
+                    vkDestroyQueryPool(*logicalDevice, pool, nullptr);
+                }
+            }
+
+            if (queries.statisticsPool != VK_NULL_HANDLE)
+            {
+                vkDestroyQueryPool(*logicalDevice, queries.statisticsPool, nullptr);
+            }
+        }
+    }
+
+    void GpuProfiler::BeginFrame(FrameContext& frame)
+    {
+        auto& queries = m_frames[frame.GetIndex() % m_frames.size()];
+
+        ReadResults(queries);
+
+        queries.frame = frame.GetFrame();
+        m_current = &queries;
+
+        // The graphics queries are reset at the start of the first graphics command buffer, which executes before any
+        // scopes in the frame. Compute command buffers are submitted separately, so they are reset by the first scope.
+        auto graphicsPool = queries.timestampPools[0];
+
+        if (graphicsPool != VK_NULL_HANDLE || queries.statisticsPool != VK_NULL_HANDLE)
+        {
+            auto& commandBuffer = frame.RequestCommandBuffer(QueueType::Graphics);
+
+            if (graphicsPool != VK_NULL_HANDLE)
+            {
+                vkCmdResetQueryPool(commandBuffer, graphicsPool, 0, 2 * m_maxScopes);
+            }
+            if (queries.statisticsPool != VK_NULL_HANDLE)
+            {
+                vkCmdResetQueryPool(commandBuffer, queries.statisticsPool, 0, m_maxScopes);
+            }
+        }
+    }
+
+    uint32_t GpuProfiler::BeginScope(const CommandBuffer& commandBuffer, const String& name, const bool& statistics)
+    {
+        if (m_current == nullptr)
+        {
+            return INVALID_SCOPE;
+        }
+
+        auto& queries = *m_current;
+
+        uint32_t queue;
+        switch (commandBuffer.GetQueueType())
+        {
+            case QueueType::Graphics:   queue = 0; break;
+            case QueueType::Compute:    queue = 1; break;
+            default:
+                return INVALID_SCOPE;
+        }
+
+        auto pool = queries.timestampPools[queue];
+
+        if (pool == VK_NULL_HANDLE)
+        {
+            return INVALID_SCOPE;
+        }
+
+        if (queries.timestampCounts[queue] + 2 > 2 * m_maxScopes)
+        {
+            if (!m_warnedScopeLimit)
+            {
+                Logger::WarningTF(LOG_TAG, "More than %u scopes were profiled in a frame, the rest are ignored!", m_maxScopes);
+                m_warnedScopeLimit = true;
+            }
+            return INVALID_SCOPE;
+        }
+
+        if (queue == 1 && !queries.computeReset)
+        {
+            vkCmdResetQueryPool(commandBuffer, pool, 0, 2 * m_maxScopes);
+            queries.computeReset = true;
+        }
+
+        Scope scope = {};
+        scope.name = name;
+        scope.queue = queue;
+        scope.query = queries.timestampCounts[queue];
+        scope.statistics = INVALID_SCOPE;
+        scope.ended = false;
+
+        queries.timestampCounts[queue] += 2;
+
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pool, scope.query);
+
+        // graphics statistics can only be queried in command buffers that support graphics
+        if (statistics && queue == 0 && queries.statisticsPool != VK_NULL_HANDLE && queries.statisticsCount < m_maxScopes)
+        {
+            scope.statistics = queries.statisticsCount++;
+            vkCmdBeginQuery(commandBuffer, queries.statisticsPool, scope.statistics, 0);
+        }
+
+        queries.scopes.push_back(eastl::move(scope));
+        return static_cast<uint32_t>(queries.scopes.size() - 1);
+    }
+
+    void GpuProfiler::EndScope(const CommandBuffer& commandBuffer, const uint32_t& scope)
+    {
+        if (m_current == nullptr || scope >= m_current->scopes.size())
+        {
+            return;
+        }
+
+        auto& queries = *m_current;
+        auto& data = queries.scopes[scope];
+
+        if (data.statistics != INVALID_SCOPE)
+        {
+            vkCmdEndQuery(commandBuffer, queries.statisticsPool, data.statistics);
+        }
+
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queries.timestampPools[data.queue], data.query + 1);
+        data.ended = true;
+    }
+
+    void GpuProfiler::ReadResults(FrameQueries& queries)
+    {
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        // each result is followed by its availability, since a scope may have been recorded into a command buffer that was never submitted
+        eastl::vector<uint64_t> timestamps[QUEUE_COUNT];
+
+        for (uint32_t queue = 0; queue < QUEUE_COUNT; queue++)
+        {
+            auto count = queries.timestampCounts[queue];
+
+            if (count == 0)
+            {
+                continue;
+            }
+
+            timestamps[queue].resize(2 * count);
+
+            // the frame has completed, so the results are available without waiting and any that aren't never will be
+            auto result = vkGetQueryPoolResults(
+                *logicalDevice,
+                queries.timestampPools[queue],
+                0,
+                count,
+                timestamps[queue].size() * sizeof(uint64_t),
+                timestamps[queue].data(),
+                2 * sizeof(uint64_t),
+                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+            );
+
+            if (result != VK_SUCCESS && result != VK_NOT_READY)
+            {
+                Renderer::Check(result);
+                timestamps[queue].clear();
+            }
+        }
+
+        eastl::vector<uint64_t> statistics;
+        const uint32_t statisticsStride = PIPELINE_STATISTIC_COUNT + 1;
+
+        if (queries.statisticsCount > 0)
+        {
+            statistics.resize(queries.statisticsCount * statisticsStride);
+
+            auto result = vkGetQueryPoolResults(
+                *logicalDevice,
+                queries.statisticsPool,
+                0,
+                queries.statisticsCount,
+                statistics.size() * sizeof(uint64_t),
+                statistics.data(),
+                statisticsStride * sizeof(uint64_t),
+                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+            );
+
+            if (result != VK_SUCCESS && result != VK_NOT_READY)
+            {
+                Renderer::Check(result);
+                statistics.clear();
+            }
+        }
+
+        for (const auto& scope : queries.scopes)
+        {
+            const auto& queueTimestamps = timestamps[scope.queue];
+
+            if (!scope.ended || queueTimestamps.empty())
+            {
+                continue;
+            }
+
+            auto beginResult = &queueTimestamps[2 * scope.query];
+            auto endResult = &queueTimestamps[2 * (scope.query + 1)];
+
+            if (beginResult[1] == 0 || endResult[1] == 0)
+            {
+                continue;
+            }
+
+            auto mask = m_timestampMasks[scope.queue];
+            auto begin = beginResult[0] & mask;
+            auto end = endResult[0] & mask;
+            auto ticks = (end - begin) & mask;
+            auto duration = static_cast<double>(ticks) * m_timestampPeriod / 1000.0;
+
+            PipelineStatistics scopeStatistics;
+            auto results = !statistics.empty() && scope.statistics != INVALID_SCOPE ? &statistics[scope.statistics * statisticsStride] : nullptr;
+            auto hasStatistics = results != nullptr && results[PIPELINE_STATISTIC_COUNT] != 0;
+
+            if (hasStatistics)
+            {
+                scopeStatistics.inputVertices = results[0];
+                scopeStatistics.inputPrimitives = results[1];
+                scopeStatistics.vertexInvocations = results[2];
+                scopeStatistics.clippingPrimitives = results[3];
+                scopeStatistics.fragmentInvocations = results[4];
+                scopeStatistics.computeInvocations = results[5];
+            }
+
+            AddSample(scope.name, scope.queue, static_cast<float>(duration / 1000.0), hasStatistics ? &scopeStatistics : nullptr);
+
+            // Timestamps written on different queues can't be compared, so trace times are in microseconds from the
+            // first timestamp of the same queue.
+            if (!m_hasTraceOrigins[scope.queue])
+            {
+                m_traceOrigins[scope.queue] = begin;
+                m_hasTraceOrigins[scope.queue] = true;
+            }
+
+            TraceEvent event = {};
+            event.name = scope.name;
+            event.queue = scope.queue;
+            event.frame = queries.frame;
+            event.start = static_cast<double>((begin - m_traceOrigins[scope.queue]) & mask) * m_timestampPeriod / 1000.0;
+            event.duration = duration;
+            m_traceEvents.push_back(eastl::move(event));
+        }
+
+        // only keep the events from the frames kept in the history
+        while (!m_traceEvents.empty() && m_traceEvents.front().frame + m_historySize <= queries.frame)
+        {
+            m_traceEvents.pop_front();
+        }
+
+        for (uint32_t queue = 0; queue < QUEUE_COUNT; queue++)
+        {
+            queries.timestampCounts[queue] = 0;
+        }
+
+        queries.statisticsCount = 0;
+        queries.computeReset = false;
+        queries.scopes.clear();
+    }
+
+    void GpuProfiler::AddSample(const String& name, const uint32_t& queue, const float& time, const PipelineStatistics* statistics)
+    {
+        auto& history = m_history[name];
+
+        history.queue = queue == 0 ? QueueType::Graphics : QueueType::Compute;
+
+        if (history.samples.size() < m_historySize)
+        {
+            history.samples.push_back(time);
+            history.next = static_cast<uint32_t>(history.samples.size() % m_historySize);
+        }
+        else
+        {
+            history.samples[history.next] = time;
+            history.next = (history.next + 1) % m_historySize;
+        }
+
+        if (statistics != nullptr)
+        {
+            history.statistics = *statistics;
+            history.hasStatistics = true;
+        }
+    }
+
+    float GpuProfiler::GetAverageTime(const String& name) const
+    {
+        auto itr = m_history.find(name);
+
+        if (itr == m_history.end() || itr->second.samples.empty())
+        {
+            return 0.0f;
+        }
+
+        return GetMean(itr->second.samples);
+    }
+
+    eastl::vector<GpuScopeStats> GpuProfiler::GetScopeStats() const
+    {
+        eastl::vector<GpuScopeStats> stats;
+        stats.reserve(m_history.size());
+
+        for (const auto& entry : m_history)
+        {
+            const auto& history = entry.second;
+
+            if (history.samples.empty())
+            {
+                continue;
+            }
+
+            auto sorted = history.samples;
+            eastl::sort(sorted.begin(), sorted.end());
+
+            auto lastIndex = (history.next + history.samples.size() - 1) % history.samples.size();
+
+            GpuScopeStats scope;
+            scope.name = entry.first;
+            scope.queue = history.queue;
+            scope.last = history.samples[lastIndex];
+            scope.average = GetMean(sorted);
+            scope.median = GetPercentile(sorted, 0.5f);
+            scope.p95 = GetPercentile(sorted, 0.95f);
+            scope.p99 = GetPercentile(sorted, 0.99f);
+            scope.samples = static_cast<uint32_t>(sorted.size());
+            scope.statistics = history.statistics;
+            scope.hasStatistics = history.hasStatistics;
+            stats.push_back(eastl::move(scope));
+        }
+
+        eastl::sort(stats.begin(), stats.end(), [](const GpuScopeStats& a, const GpuScopeStats& b)
+        {
+            return a.average > b.average;
+        });
+
+        return stats;
+    }
+
+    bool GpuProfiler::WriteTrace(const PathRoot& root, const String& path) const
+    {
+        TraceWriter trace;
+
+        for (uint32_t queue = 0; queue < QUEUE_COUNT; queue++)
+        {
+            trace.AddThreadName(queue, GetQueueName(queue));
+        }
+
+        for (const auto& event : m_traceEvents)
+        {
+            trace.BeginEvent(event.name.c_str(), "gpu", event.queue, event.start, event.duration);
+            trace.AddArgument("frame", event.frame);
+            trace.EndEvent();
+        }
+
+        return trace.Write(root, path);
+    }
+
+    bool GpuProfiler::WriteSummary(const PathRoot& root, const String& path) const
+    {
+        auto stats = GetScopeStats();
+
+        String text;
+        text.append_sprintf("%-40s %-8s %9s %9s %9s %9s %9s %8s\n", "Scope", "Queue", "Last", "Average", "Median", "P95", "P99", "Samples");
+
+        for (const auto& scope : stats)
+        {
+            text.append_sprintf("%-40s %-8s %9.3f %9.3f %9.3f %9.3f %9.3f %8u\n",
+                scope.name.c_str(),
+                GetQueueName(scope.queue == QueueType::Graphics ? 0 : 1),
+                scope.last,
+                scope.average,
+                scope.median,
+                scope.p95,
+                scope.p99,
+                scope.samples);
+
+            if (scope.hasStatistics)
+            {
+                text.append_sprintf("    vertices: %llu, primitives: %llu, vertex invocations: %llu, clipped primitives: %llu, fragment invocations: %llu, compute invocations: %llu\n",
+                    static_cast<unsigned long long>(scope.statistics.inputVertices),
+                    static_cast<unsigned long long>(scope.statistics.inputPrimitives),
+                    static_cast<unsigned long long>(scope.statistics.vertexInvocations),
+                    static_cast<unsigned long long>(scope.statistics.clippingPrimitives),
+                    static_cast<unsigned long long>(scope.statistics.fragmentInvocations),
+                    static_cast<unsigned long long>(scope.statistics.computeInvocations));
+            }
+        }
+
+        text.append("\nTimes are in milliseconds.\n");
+
+        return TraceWriter::WriteFile(root, path, text);
+    }
+
+    const char* GpuProfiler::GetQueueName(const uint32_t& queue)
+    {
+        return queue == 0 ? "Graphics" : "Compute";
+    }
+
+    GpuProfileScope::GpuProfileScope(const CommandBuffer& commandBuffer, const String& name, const bool& statistics) :
+        m_commandBuffer(commandBuffer),
+        m_scope(GpuProfiler::INVALID_SCOPE)
+    {
+        auto profiler = Renderer::Get()->GetGpuProfiler();
+
+        if (profiler != nullptr)
+        {
+            m_scope = profiler->BeginScope(commandBuffer, name, statistics);
+        }
+    }
+
+    GpuProfileScope::~GpuProfileScope()
+    {
+        auto profiler = Renderer::Get()->GetGpuProfiler();
+
+        if (profiler != nullptr)
+        {
+            profiler->EndScope(m_commandBuffer, m_scope);
+        }
+    }
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include "IO/Filesystem.h"
+#include "Device/Graphics/LogicalDevice.h"
+#include "Renderer/RendererConfig.h"
+
+namespace Mantis
+{
+    class CommandBuffer;
+    class FrameContext;
+
+    /// <summary>
+    /// The pipeline statistics counted during a profiler scope.
+    /// </summary>
+    struct PipelineStatistics
+    {
+        uint64_t inputVertices = 0;
+        uint64_t inputPrimitives = 0;
+        uint64_t vertexInvocations = 0;
+        uint64_t clippingPrimitives = 0;
+        uint64_t fragmentInvocations = 0;
+        uint64_t computeInvocations = 0;
+    };
+
+    /// <summary>
+    /// The timings of a profiler scope over recent frames, in milliseconds.
+    /// </summary>
+    struct GpuScopeStats
+    {
+        /// <summary>
+        /// The name of the scope.
+        /// </summary>
+        String name;
+        /// <summary>
+        /// The queue the scope was last executed on.
+        /// </summary>
+        QueueType queue = QueueType::Graphics;
+        /// <summary>
+        /// The time of the most recent sample.
+        /// </summary>
+        float last = 0.0f;
+        /// <summary>
+        /// The mean time over the recent samples.
+        /// </summary>
+        float average = 0.0f;
+        float median = 0.0f;
+        float p95 = 0.0f;
+        float p99 = 0.0f;
+        /// <summary>
+        /// The number of recent samples the timings are computed from.
+        /// </summary>
+        uint32_t samples = 0;
+        /// <summary>
+        /// The pipeline statistics of the most recent sample that recorded them.
+        /// </summary>
+        PipelineStatistics statistics;
+        /// <summary>
+        /// Have pipeline statistics been recorded for the scope.
+        /// </summary>
+        bool hasStatistics = false;
+    };
+
+    /// <summary>
+    /// Measures the GPU time of scopes within a frame's command buffers using timestamp queries.
+    /// </summary>
+    /// <remarks>
+    /// Each frame context has its own query pools. The results are read when the context is next begun, after its
+    /// fence has been waited on, so reading them never stalls. Samples are accumulated per scope name, so scopes
+    /// should be named after the work they measure, such as the render graph pass names. Scopes whose queries never
+    /// executed are skipped. Timestamps are only comparable on the queue that wrote them, so each queue's trace is
+    /// timed from its own first scope.
+    /// </remarks>
+    class GpuProfiler :
+        public NonCopyable
+    {
+    public:
+        /// <summary>
+        /// The scope returned when a scope could not be begun.
+        /// </summary>
+        static const uint32_t INVALID_SCOPE = ~0u;
+
+        GpuProfiler();
+        ~GpuProfiler();
+
+        /// <summary>
+        /// Reads the results of the last frame to use a context and prepares its queries. Called by the renderer when a frame begins.
+        /// </summary>
+        /// <param name="frame">The context of the frame that is starting.</param>
+        void BeginFrame(FrameContext& frame);
+
+        /// <summary>
+        /// Begins timing a scope. Must be called on the render thread with a command buffer from the current frame.
+        /// </summary>
+        /// <param name="commandBuffer">A graphics or compute command buffer to record into.</param>
+        /// <param name="name">The name to accumulate the samples under.</param>
+        /// <param name="statistics">Also count pipeline statistics, which is only supported on graphics command buffers.
+        /// The scope must then begin and end in the same subpass.</param>
+        /// <returns>The scope to end, or INVALID_SCOPE if the scope can't be timed.</returns>
+        uint32_t BeginScope(const CommandBuffer& commandBuffer, const String& name, const bool& statistics = false);
+
+        /// <summary>
+        /// Ends timing a scope.
+        /// </summary>
+        /// <param name="commandBuffer">The command buffer the scope was begun in.</param>
+        /// <param name="scope">The scope to end.</param>
+        void EndScope(const CommandBuffer& commandBuffer, const uint32_t& scope);
+
+        /// <summary>
+        /// Gets the mean time in milliseconds of a scope over the recent samples, or zero if it has not been measured.
+        /// </summary>
+        /// <param name="name">The name of the scope.</param>
+        float GetAverageTime(const String& name) const;
+
+        /// <summary>
+        /// Gets the timings of all measured scopes, slowest first.
+        /// </summary>
+        eastl::vector<GpuScopeStats> GetScopeStats() const;
+
+        /// <summary>
+        /// Writes the recent samples to a trace file, which can be opened in chrome://tracing or Perfetto. Each queue is a
+        /// separate track timed from its own first scope, so the tracks are not aligned with each other.
+        /// </summary>
+        /// <param name="root">The folder the path is relative to.</param>
+        /// <param name="path">The path of the file.</param>
+        /// <returns>True if the file was written.</returns>
+        bool WriteTrace(const PathRoot& root, const String& path) const;
+
+        /// <summary>
+        /// Writes a table of the timings of all measured scopes to a text file.
+        /// </summary>
+        /// <param name="root">The folder the path is relative to.</param>
+        /// <param name="path">The path of the file.</param>
+        /// <returns>True if the file was written.</returns>
+        bool WriteSummary(const PathRoot& root, const String& path) const;
+
+    private:
+        /// <summary>
+        /// The queues that can be profiled, which each use their own query pool.
+        /// </summary>
+        static const uint32_t QUEUE_COUNT = 2;
+
+        struct Scope
+        {
+            String name;
+            uint32_t queue;
+            uint32_t query;
+            uint32_t statistics;
+            bool ended;
+        };
+
+        struct FrameQueries
+        {
+            VkQueryPool timestampPools[QUEUE_COUNT];
+            uint32_t timestampCounts[QUEUE_COUNT];
+            VkQueryPool statisticsPool;
+            uint32_t statisticsCount;
+            bool computeReset;
+            uint64_t frame;
+            eastl::vector<Scope> scopes;
+        };
+
+        struct ScopeHistory
+        {
+            QueueType queue = QueueType::Graphics;
+            eastl::vector<float> samples;
+            uint32_t next = 0;
+            PipelineStatistics statistics;
+            bool hasStatistics = false;
+        };
+
+        struct TraceEvent
+        {
+            String name;
+            uint32_t queue;
+            uint64_t frame;
+            double start;
+            double duration;
+        };
+
+        /// <summary>
+        /// Accumulates the results of the scopes last recorded with a frame context, which must have completed.
+        /// </summary>
+        void ReadResults(FrameQueries& queries);
+
+        void AddSample(const String& name, const uint32_t& queue, const float& time, const PipelineStatistics* statistics);
+
+        static const char* GetQueueName(const uint32_t& queue);
+
+        eastl::vector<FrameQueries> m_frames;
+        FrameQueries* m_current;
+        uint32_t m_maxScopes;
+        uint64_t m_timestampMasks[QUEUE_COUNT];
+        double m_timestampPeriod;
+
+        eastl::unordered_map<String, ScopeHistory> m_history;
+        uint32_t m_historySize;
+
+        eastl::deque<TraceEvent> m_traceEvents;
+        uint64_t m_traceOrigins[QUEUE_COUNT];
+        bool m_hasTraceOrigins[QUEUE_COUNT];
+        bool m_warnedScopeLimit;
+    };
+
+    /// <summary>
+    /// Times the GPU work recorded into a command buffer while the object is in scope, if GPU profiling is enabled.
+    /// </summary>
+    class GpuProfileScope :
+        public NonCopyable
+    {
+    public:
+        /// <summary>
+        /// Begins the scope.
+        /// </summary>
+        /// <param name="commandBuffer">A graphics or compute command buffer from the current frame.</param>
+        /// <param name="name">The name to accumulate the samples under.</param>
+        /// <param name="statistics">Also count pipeline statistics.</param>
+        GpuProfileScope(const CommandBuffer& commandBuffer, const String& name, const bool& statistics = false);
+
+        /// <summary>
+        /// Ends the scope.
+        /// </summary>
+        ~GpuProfileScope();
+
+    private:
+        const CommandBuffer& m_commandBuffer;
+        uint32_t m_scope;
+    };
+}
@@ -0,0 +1,618 @@
+#include "stdafx.h"
+#include "BlockDecoder.h"
+
+#define LOG_TAG MANTIS_TEXT("BlockDecoder")
+
+namespace Mantis
+{
+    /// <summary>
+    /// The width and height of a block in texels.
+    /// </summary>
+    static const uint32_t BLOCK_SIZE = 4;
+
+    /// <summary>
+    /// The BC7 modes, indexed by the number of zero bits before the first set bit of a block.
+    /// </summary>
+    struct Bc7Mode
+    {
+        uint32_t subsets;
+        uint32_t partitionBits;
+        uint32_t rotationBits;
+        uint32_t indexSelectionBits;
+        uint32_t colorBits;
+        uint32_t alphaBits;
+        /// <summary>
+        /// Each endpoint has its own p-bit, which is the lowest bit of every channel of the endpoint.
+        /// </summary>
+        bool endpointPBits;
+        /// <summary>
+        /// Both endpoints of a subset share a p-bit.
+        /// </summary>
+        bool sharedPBits;
+        uint32_t indexBits;
+        uint32_t secondaryIndexBits;
+    };
+
+    static const Bc7Mode BC7_MODES[8] =
+    {
+        { 3, 4, 0, 0, 4, 0, true, false, 3, 0 },
+        { 2, 6, 0, 0, 6, 0, false, true, 3, 0 },
+        { 3, 6, 0, 0, 5, 0, false, false, 2, 0 },
+        { 2, 6, 0, 0, 7, 0, true, false, 2, 0 },
+        { 1, 0, 2, 1, 5, 6, false, false, 2, 3 },
+        { 1, 0, 2, 0, 7, 8, false, false, 2, 2 },
+        { 1, 0, 0, 0, 7, 7, true, false, 4, 0 },
+        { 2, 6, 0, 0, 5, 5, true, false, 2, 0 },
+    };
+
+    /// <summary>
+    /// The two subset partitions shared by BC6H and BC7, with a set bit for each texel in the second subset.
+    /// </summary>
+    static const uint16_t BC7_PARTITIONS_2[64] =
+    {
+        0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+        0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+        0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+        0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+        0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+        0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+        0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+        0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+    };
+
+    /// <summary>
+    /// The three subset partitions, with two bits giving the subset of each texel.
+    /// </summary>
+    static const uint32_t BC7_PARTITIONS_3[64] =
+    {
+        0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+        0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+        0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+        0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+        0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+        0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+        0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+        0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254,
+    };
+
+    /// <summary>
+    /// The anchor texel of the second subset of each two subset partition.
+    /// </summary>
+    static const uint8_t BC7_ANCHORS_2[64] =
+    {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+        15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+        15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+        6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,
+    };
+
+    /// <summary>
+    /// The anchor texels of the second and third subsets of each three subset partition.
+    /// </summary>
+    static const uint8_t BC7_ANCHORS_3[2][64] =
+    {
+        {
+            3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+            3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+            8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+            3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3,
+        },
+        {
+            15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+            15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+            15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+            15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8,
+        },
+    };
+
+    /// <summary>
+    /// The interpolation weights out of 64 for each index size.
+    /// </summary>
+    static const uint8_t BC7_WEIGHTS_2[4] = { 0, 21, 43, 64 };
+    static const uint8_t BC7_WEIGHTS_3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+    static const uint8_t BC7_WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    static uint16_t ReadU16(const uint8_t* data)
+    {
+        return static_cast<uint16_t>(data[0] | (data[1] << 8));
+    }
+
+    static uint32_t ReadU32(const uint8_t* data)
+    {
+        return static_cast<uint32_t>(data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24));
+    }
+
+    static uint64_t ReadU48(const uint8_t* data)
+    {
+        return static_cast<uint64_t>(ReadU32(data)) | (static_cast<uint64_t>(ReadU16(data + 4)) << 32);
+    }
+
+    /// <summary>
+    /// Decodes the colors of a BC1 block into RGBA texels.
+    /// </summary>
+    /// <param name="block">The 8 byte color block.</param>
+    /// <param name="fourColor">Always use four colors, as BC2 and BC3 do, instead of using three colors and transparent black when the endpoints are ordered.</param>
+    /// <param name="texels">The 16 texels to write, with 4 bytes per texel.</param>
+    static void DecodeColorBlock(const uint8_t* block, const bool& fourColor, uint8_t* texels)
+    {
+        uint16_t c0 = ReadU16(block + 0);
+        uint16_t c1 = ReadU16(block + 2);
+        uint32_t indices = ReadU32(block + 4);
+
+        uint8_t palette[4][4];
+
+        auto expand = [](const uint16_t& color, uint8_t* out)
+        {
+            uint32_t r = (color >> 11) & 0x1F;
+            uint32_t g = (color >> 5) & 0x3F;
+            uint32_t b = color & 0x1F;
+
+            out[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+            out[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+            out[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+            out[3] = 255;
+        };
+
+        expand(c0, palette[0]);
+        expand(c1, palette[1]);
+
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            if (fourColor || c0 > c1)
+            {
+                palette[2][c] = static_cast<uint8_t>((2 * palette[0][c] + palette[1][c] + 1) / 3);
+                palette[3][c] = static_cast<uint8_t>((palette[0][c] + 2 * palette[1][c] + 1) / 3);
+            }
+            else
+            {
+                palette[2][c] = static_cast<uint8_t>((palette[0][c] + palette[1][c] + 1) / 2);
+                palette[3][c] = 0;
+            }
+        }
+
+        palette[2][3] = 255;
+        palette[3][3] = fourColor || c0 > c1 ? 255 : 0;
+
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            memcpy(texels + i * 4, palette[(indices >> (i * 2)) & 0x3], 4);
+        }
+    }
+
+    /// <summary>
+    /// Decodes a BC4 block, which is also used for the alpha of BC3 and both channels of BC5.
+    /// </summary>
+    /// <param name="block">The 8 byte block.</param>
+    /// <param name="isSigned">Are the values signed normalized.</param>
+    /// <param name="texels">The first channel of the 16 texels to write.</param>
+    /// <param name="stride">The number of bytes between texels.</param>
+    static void DecodeChannelBlock(const uint8_t* block, const bool& isSigned, uint8_t* texels, const uint32_t& stride)
+    {
+        int32_t values[8];
+
+        if (isSigned)
+        {
+            // both -128 and -127 represent -1
+            values[0] = eastl::max<int32_t>(static_cast<int8_t>(block[0]), -127);
+            values[1] = eastl::max<int32_t>(static_cast<int8_t>(block[1]), -127);
+        }
+        else
+        {
+            values[0] = block[0];
+            values[1] = block[1];
+        }
+
+        auto interpolate = [&values](const int32_t& weight0, const int32_t& weight1, const int32_t& divisor)
+        {
+            int32_t sum = weight0 * values[0] + weight1 * values[1];
+
+            // round to nearest, away from zero for negative values
+            return sum >= 0 ? (sum + divisor / 2) / divisor : (sum - divisor / 2) / divisor;
+        };
+
+        if (values[0] > values[1])
+        {
+            for (int32_t i = 1; i < 7; i++)
+            {
+                values[i + 1] = interpolate(7 - i, i, 7);
+            }
+        }
+        else
+        {
+            for (int32_t i = 1; i < 5; i++)
+            {
+                values[i + 1] = interpolate(5 - i, i, 5);
+            }
+
+            values[6] = isSigned ? -127 : 0;
+            values[7] = isSigned ? 127 : 255;
+        }
+
+        uint64_t indices = ReadU48(block + 2);
+
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            texels[i * stride] = static_cast<uint8_t>(values[(indices >> (i * 3)) & 0x7]);
+        }
+    }
+
+    /// <summary>
+    /// Decodes the explicit alpha of a BC2 block.
+    /// </summary>
+    /// <param name="block">The 8 byte alpha block.</param>
+    /// <param name="texels">The 16 RGBA texels to write the alpha of.</param>
+    static void DecodeExplicitAlphaBlock(const uint8_t* block, uint8_t* texels)
+    {
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            uint32_t alpha = (block[i / 2] >> ((i % 2) * 4)) & 0xF;
+            texels[i * 4 + 3] = static_cast<uint8_t>(alpha * 17);
+        }
+    }
+
+    /// <summary>
+    /// Reads the bits of a BC7 block from the lowest bit up.
+    /// </summary>
+    class Bc7BitReader
+    {
+    public:
+        explicit Bc7BitReader(const uint8_t* block) :
+            m_low(static_cast<uint64_t>(ReadU32(block)) | (static_cast<uint64_t>(ReadU32(block + 4)) << 32)),
+            m_high(static_cast<uint64_t>(ReadU32(block + 8)) | (static_cast<uint64_t>(ReadU32(block + 12)) << 32)),
+            m_position(0)
+        {
+        }
+
+        uint32_t Read(const uint32_t& count)
+        {
+            uint32_t value = 0;
+
+            for (uint32_t i = 0; i < count; i++, m_position++)
+            {
+                auto bit = m_position < 64 ? (m_low >> m_position) & 1 : (m_high >> (m_position - 64)) & 1;
+                value |= static_cast<uint32_t>(bit) << i;
+            }
+
+            return value;
+        }
+
+    private:
+        uint64_t m_low;
+        uint64_t m_high;
+        uint32_t m_position;
+    };
+
+    /// <summary>
+    /// Decodes a BC7 block into RGBA texels.
+    /// </summary>
+    /// <param name="block">The 16 byte block.</param>
+    /// <param name="texels">The 16 texels to write, with 4 bytes per texel.</param>
+    static void DecodeBc7Block(const uint8_t* block, uint8_t* texels)
+    {
+        uint32_t modeIndex = 0;
+
+        while (modeIndex < 8 && (block[0] & (1 << modeIndex)) == 0)
+        {
+            modeIndex++;
+        }
+
+        // reserved modes decode to transparent black
+        if (modeIndex == 8)
+        {
+            memset(texels, 0, 16 * 4);
+            return;
+        }
+
+        const auto& mode = BC7_MODES[modeIndex];
+        Bc7BitReader reader(block);
+        reader.Read(modeIndex + 1);
+
+        auto partition = reader.Read(mode.partitionBits);
+        auto rotation = reader.Read(mode.rotationBits);
+        auto indexSelection = reader.Read(mode.indexSelectionBits);
+
+        // the channels are stored one after another, each with both endpoints of every subset
+        uint32_t endpoints[3][2][4] = {};
+        uint32_t channelCount = mode.alphaBits > 0 ? 4 : 3;
+
+        for (uint32_t c = 0; c < channelCount; c++)
+        {
+            for (uint32_t subset = 0; subset < mode.subsets; subset++)
+            {
+                for (uint32_t e = 0; e < 2; e++)
+                {
+                    endpoints[subset][e][c] = reader.Read(c < 3 ? mode.colorBits : mode.alphaBits);
+                }
+            }
+        }
+
+        uint32_t colorBits = mode.colorBits;
+        uint32_t alphaBits = mode.alphaBits;
+
+        if (mode.endpointPBits || mode.sharedPBits)
+        {
+            uint32_t pBits[3][2] = {};
+
+            for (uint32_t subset = 0; subset < mode.subsets; subset++)
+            {
+                if (mode.sharedPBits)
+                {
+                    pBits[subset][0] = pBits[subset][1] = reader.Read(1);
+                }
+                else
+                {
+                    pBits[subset][0] = reader.Read(1);
+                    pBits[subset][1] = reader.Read(1);
+                }
+            }
+
+            for (uint32_t subset = 0; subset < mode.subsets; subset++)
+            {
+                for (uint32_t e = 0; e < 2; e++)
+                {
+                    for (uint32_t c = 0; c < channelCount; c++)
+                    {
+                        endpoints[subset][e][c] = (endpoints[subset][e][c] << 1) | pBits[subset][e];
+                    }
+                }
+            }
+
+            colorBits++;
+            alphaBits = alphaBits > 0 ? alphaBits + 1 : 0;
+        }
+
+        // expand the endpoints to 8 bits by repeating the high bits
+        for (uint32_t subset = 0; subset < mode.subsets; subset++)
+        {
+            for (uint32_t e = 0; e < 2; e++)
+            {
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    auto bits = c < 3 ? colorBits : alphaBits;
+                    auto& value = endpoints[subset][e][c];
+                    value = bits == 0 ? 255 : ((value << (8 - bits)) | (value >> (2 * bits - 8)));
+                }
+            }
+        }
+
+        auto getSubset = [&mode, &partition](const uint32_t& texel) -> uint32_t
+        {
+            switch (mode.subsets)
+            {
+                case 2:
+                    return (BC7_PARTITIONS_2[partition] >> texel) & 0x1;
+                case 3:
+                    return (BC7_PARTITIONS_3[partition] >> (texel * 2)) & 0x3;
+                default:
+                    return 0;
+            }
+        };
+
+        auto isAnchor = [&mode, &partition](const uint32_t& texel)
+        {
+            switch (mode.subsets)
+            {
+                case 2:
+                    return texel == 0 || texel == BC7_ANCHORS_2[partition];
+                case 3:
+                    return texel == 0 || texel == BC7_ANCHORS_3[0][partition] || texel == BC7_ANCHORS_3[1][partition];
+                default:
+                    return texel == 0;
+            }
+        };
+
+        // the anchor texel of each subset has the highest index bit implied to be zero
+        uint32_t indices[16];
+        uint32_t secondaryIndices[16] = {};
+
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            indices[i] = reader.Read(isAnchor(i) ? mode.indexBits - 1 : mode.indexBits);
+        }
+
+        if (mode.secondaryIndexBits > 0)
+        {
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                secondaryIndices[i] = reader.Read(i == 0 ? mode.secondaryIndexBits - 1 : mode.secondaryIndexBits);
+            }
+        }
+
+        auto getWeight = [](const uint32_t& bits, const uint32_t& index) -> uint32_t
+        {
+            switch (bits)
+            {
+                case 2:
+                    return BC7_WEIGHTS_2[index];
+                case 3:
+                    return BC7_WEIGHTS_3[index];
+                default:
+                    return BC7_WEIGHTS_4[index];
+            }
+        };
+
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            auto subset = getSubset(i);
+            auto colorWeight = getWeight(mode.indexBits, indices[i]);
+            auto alphaWeight = colorWeight;
+
+            // modes with separate alpha indices may swap which set is used for colors
+            if (mode.secondaryIndexBits > 0)
+            {
+                auto secondaryWeight = getWeight(mode.secondaryIndexBits, secondaryIndices[i]);
+                colorWeight = indexSelection ? secondaryWeight : colorWeight;
+                alphaWeight = indexSelection ? alphaWeight : secondaryWeight;
+            }
+
+            uint8_t* texel = texels + i * 4;
+
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                auto weight = c < 3 ? colorWeight : alphaWeight;
+                auto e0 = endpoints[subset][0][c];
+                auto e1 = endpoints[subset][1][c];
+                texel[c] = static_cast<uint8_t>(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+            }
+
+            // the rotation swaps alpha with one of the color channels
+            if (rotation > 0)
+            {
+                eastl::swap(texel[3], texel[rotation - 1]);
+            }
+        }
+    }
+
+    bool BlockDecoder::IsSupported(const VkFormat& format)
+    {
+        return GetDecodedFormat(format) != VK_FORMAT_UNDEFINED;
+    }
+
+    VkFormat BlockDecoder::GetDecodedFormat(const VkFormat& format)
+    {
+        switch (format)
+        {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+            case VK_FORMAT_BC2_UNORM_BLOCK:
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+                return VK_FORMAT_R8G8B8A8_UNORM;
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            case VK_FORMAT_BC2_SRGB_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                return VK_FORMAT_R8G8B8A8_SRGB;
+            case VK_FORMAT_BC4_UNORM_BLOCK:
+                return VK_FORMAT_R8_UNORM;
+            case VK_FORMAT_BC4_SNORM_BLOCK:
+                return VK_FORMAT_R8_SNORM;
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+                return VK_FORMAT_R8G8_UNORM;
+            case VK_FORMAT_BC5_SNORM_BLOCK:
+                return VK_FORMAT_R8G8_SNORM;
+            default:
+                return VK_FORMAT_UNDEFINED;
+        }
+    }
+
+    eastl::vector<uint8_t> BlockDecoder::Decode(
+        const uint8_t* data,
+        const VkExtent3D& extent,
+        const VkFormat& format,
+        const uint32_t& layerCount)
+    {
+        uint32_t blockBytes;
+        uint32_t channels;
+
+        switch (format)
+        {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                blockBytes = 8;
+                channels = 4;
+                break;
+            case VK_FORMAT_BC2_UNORM_BLOCK:
+            case VK_FORMAT_BC2_SRGB_BLOCK:
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                blockBytes = 16;
+                channels = 4;
+                break;
+            case VK_FORMAT_BC4_UNORM_BLOCK:
+            case VK_FORMAT_BC4_SNORM_BLOCK:
+                blockBytes = 8;
+                channels = 1;
+                break;
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+            case VK_FORMAT_BC5_SNORM_BLOCK:
+                blockBytes = 16;
+                channels = 2;
+                break;
+            default:
+                Logger::ErrorTF(LOG_TAG, "Cannot decode format %u!", format);
+                return {};
+        }
+
+        uint32_t blocksX = (extent.width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        uint32_t blocksY = (extent.height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        uint32_t slices = extent.depth * layerCount;
+
+        size_t sliceSize = static_cast<size_t>(extent.width) * extent.height * channels;
+        eastl::vector<uint8_t> texels(sliceSize * slices);
+
+        uint8_t block[16 * 4];
+
+        for (uint32_t slice = 0; slice < slices; slice++)
+        {
+            auto dst = texels.data() + slice * sliceSize;
+
+            for (uint32_t by = 0; by < blocksY; by++)
+            {
+                for (uint32_t bx = 0; bx < blocksX; bx++)
+                {
+                    switch (format)
+                    {
+                        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                            DecodeColorBlock(data, false, block);
+                            // the transparent color is black with no alpha channel
+                            for (uint32_t i = 0; i < 16; i++)
+                            {
+                                block[i * 4 + 3] = 255;
+                            }
+                            break;
+                        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+                        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                            DecodeColorBlock(data, false, block);
+                            break;
+                        case VK_FORMAT_BC2_UNORM_BLOCK:
+                        case VK_FORMAT_BC2_SRGB_BLOCK:
+                            DecodeColorBlock(data + 8, true, block);
+                            DecodeExplicitAlphaBlock(data, block);
+                            break;
+                        case VK_FORMAT_BC3_UNORM_BLOCK:
+                        case VK_FORMAT_BC3_SRGB_BLOCK:
+                            DecodeColorBlock(data + 8, true, block);
+                            DecodeChannelBlock(data, false, block + 3, 4);
+                            break;
+                        case VK_FORMAT_BC4_UNORM_BLOCK:
+                        case VK_FORMAT_BC4_SNORM_BLOCK:
+                            DecodeChannelBlock(data, format == VK_FORMAT_BC4_SNORM_BLOCK, block, 1);
+                            break;
+                        case VK_FORMAT_BC5_UNORM_BLOCK:
+                        case VK_FORMAT_BC5_SNORM_BLOCK:
+                            DecodeChannelBlock(data + 0, format == VK_FORMAT_BC5_SNORM_BLOCK, block + 0, 2);
+                            DecodeChannelBlock(data + 8, format == VK_FORMAT_BC5_SNORM_BLOCK, block + 1, 2);
+                            break;
+                        case VK_FORMAT_BC7_UNORM_BLOCK:
+                        case VK_FORMAT_BC7_SRGB_BLOCK:
+                            DecodeBc7Block(data, block);
+                            break;
+                        default:
+                            break;
+                    }
+
+                    data += blockBytes;
+
+                    // blocks on the right and bottom edges may extend past the image
+                    uint32_t width = eastl::min(BLOCK_SIZE, extent.width - bx * BLOCK_SIZE);
+                    uint32_t height = eastl::min(BLOCK_SIZE, extent.height - by * BLOCK_SIZE);
+
+                    for (uint32_t y = 0; y < height; y++)
+                    {
+                        auto row = dst + ((static_cast<size_t>(by) * BLOCK_SIZE + y) * extent.width + bx * BLOCK_SIZE) * channels;
+                        memcpy(row, block + y * BLOCK_SIZE * channels, width * channels);
+                    }
+                }
+            }
+        }
+
+        return texels;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Mantis.h"
+
+namespace Mantis
+{
+    /// <summary>
+    /// Decodes block compressed images on the CPU, for devices which cannot sample the compressed format.
+    /// </summary>
+    /// <remarks>
+    /// BC1 to BC5 and BC7 are decoded to 8 bit UNORM formats with the same channels, keeping the sRGB encoding.
+    /// Decoding quadruples the memory used by BC1 and BC4 images and doubles it for the others, so this is
+    /// only a fallback to keep content working. BC6H is not decoded, since it would need a floating point
+    /// target that costs four times the memory, and neither are UASTC or other supercompressed KTX2 data,
+    /// which the texture container does not store. Textures in those formats fail to load on devices
+    /// which cannot sample them.
+    /// </remarks>
+    class BlockDecoder
+    {
+    public:
+        /// <summary>
+        /// Checks if a format can be decoded.
+        /// </summary>
+        /// <param name="format">The format to check.</param>
+        static bool IsSupported(const VkFormat& format);
+
+        /// <summary>
+        /// Gets the format a block compressed format is decoded to.
+        /// </summary>
+        /// <param name="format">The block compressed format.</param>
+        /// <returns>The decoded format, or undefined if the format cannot be decoded.</returns>
+        static VkFormat GetDecodedFormat(const VkFormat& format);
+
+        /// <summary>
+        /// Decodes a mip level of an image.
+        /// </summary>
+        /// <param name="data">The blocks of each layer and depth slice, stored one after another.</param>
+        /// <param name="extent">The resolution of the level in texels.</param>
+        /// <param name="format">The block compressed format of the data.</param>
+        /// <param name="layerCount">The number of layers in the data.</param>
+        /// <returns>The decoded texels of each layer, laid out in the same order. Empty if the format is not supported.</returns>
+        static eastl::vector<uint8_t> Decode(
+            const uint8_t* data,
+            const VkExtent3D& extent,
+            const VkFormat& format,
+            const uint32_t& layerCount = 1
+        );
+    };
+}
@@ -3,6 +3,10 @@
 
 #include "Renderer/Renderer.h"
 #include "Renderer/Buffer/Buffer.h"
+#include "Renderer/Image/ImageView.h"
+#include "Renderer/Image/MipGenerator.h"
+#include "Renderer/Image/SamplerCache.h"
+#include "Renderer/Streaming/StreamingEngine.h"
 
 #define LOG_TAG MANTIS_TEXT("Image")
 
@@ -12,12 +16,24 @@ namespace Mantis
         m_image(VK_NULL_HANDLE),
         m_allocator(Renderer::Get()->GetAllocator()),
         m_allocation(VK_NULL_HANDLE),
-        m_memoryFlags(0)
+        m_memoryFlags(0),
+        m_filter(VK_FILTER_LINEAR),
+        m_addressMode(VK_SAMPLER_ADDRESS_MODE_REPEAT),
+        m_anisotropic(false)
     {
     }
 
     Image::~Image()
     {
+        // requests already submitted never touch the image again, and the image is only destroyed once they complete
+        if (auto streamingEngine = Renderer::Get()->GetStreamingEngine())
+        {
+            streamingEngine->Cancel(*this);
+        }
+
+        // the views are queued for destruction before the image they reference
+        m_views.clear();
+
 		Renderer::Get()->DestroyImage(m_image, m_allocation);
     }
 
@@ -40,11 +56,14 @@ namespace Mantis
         const VkCompareOp& compareOp)
     {
         m_usage = usage;
+        m_flags = flags;
         m_extent = extent;
+        m_type = type;
         m_format = format;
         m_samples = samples;
         m_mipLevels = mipLevels;
         m_arrayLayers = arrayLayers;
+        m_subresourceLayouts.assign(m_mipLevels * m_arrayLayers, VK_IMAGE_LAYOUT_UNDEFINED);
 
         m_filter = filter;
         m_addressMode = addressMode;
@@ -118,11 +137,87 @@ namespace Mantis
         }
     }
 
+    void Image::CreateSampler(const bool& compare, const VkCompareOp& compareOp)
+    {
+        SamplerCreateInfo createInfo = {};
+        createInfo.magFilter = m_filter;
+        createInfo.minFilter = m_filter;
+        createInfo.mipmapMode = m_filter == VK_FILTER_NEAREST ? VK_SAMPLER_MIPMAP_MODE_NEAREST : VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        createInfo.addressModeU = m_addressMode;
+        createInfo.addressModeV = m_addressMode;
+        createInfo.addressModeW = m_addressMode;
+        createInfo.mipLodBias = 0.0f;
+        createInfo.anisotropyEnable = m_anisotropic ? VK_TRUE : VK_FALSE;
+        createInfo.maxAnisotropy = m_anisotropic ? 16.0f : 1.0f;
+        createInfo.compareEnable = compare ? VK_TRUE : VK_FALSE;
+        createInfo.compareOp = compare ? compareOp : VK_COMPARE_OP_NEVER;
+        createInfo.minLod = 0.0f;
+        createInfo.maxLod = VK_LOD_CLAMP_NONE;
+        createInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+        createInfo.unnormalizedCoordinates = VK_FALSE;
+
+        // images with the same sampler settings share a sampler, since devices limit how many may exist
+        m_sampler = Renderer::Get()->GetSamplerCache()->Get(createInfo);
+    }
+
     void Image::SetName(const String& name)
     {
         SetDebugName(name, VK_OBJECT_TYPE_IMAGE, (uint64_t)m_image);
     }
 
+    const ImageView& Image::GetView(const ImageViewCreateInfo& createInfo) const
+    {
+        // resolve the defaults so equivalent requests share a view
+        ImageViewCreateInfo key = createInfo;
+
+        if (key.format == VK_FORMAT_UNDEFINED)
+        {
+            key.format = m_format;
+        }
+        if (key.levels == VK_REMAINING_MIP_LEVELS)
+        {
+            key.levels = m_mipLevels - key.baseLevel;
+        }
+        if (key.layers == VK_REMAINING_ARRAY_LAYERS)
+        {
+            key.layers = m_arrayLayers - key.baseLayer;
+        }
+
+        std::lock_guard<std::mutex> lock(m_viewMutex);
+
+        auto& view = m_views[key];
+
+        if (view == nullptr)
+        {
+            view = eastl::make_unique<ImageView>(this, key);
+        }
+
+        return *view;
+    }
+
+    size_t Image::ViewHash::operator()(const ImageViewCreateInfo& createInfo) const
+    {
+        size_t hash = 0;
+
+        auto combine = [&hash](const size_t& value)
+        {
+            hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        };
+
+        combine(eastl::hash<uint32_t>()(createInfo.format));
+        combine(eastl::hash<uint32_t>()(createInfo.type));
+        combine(eastl::hash<uint32_t>()(createInfo.swizzle.r));
+        combine(eastl::hash<uint32_t>()(createInfo.swizzle.g));
+        combine(eastl::hash<uint32_t>()(createInfo.swizzle.b));
+        combine(eastl::hash<uint32_t>()(createInfo.swizzle.a));
+        combine(eastl::hash<uint32_t>()(createInfo.baseLevel));
+        combine(eastl::hash<uint32_t>()(createInfo.levels));
+        combine(eastl::hash<uint32_t>()(createInfo.baseLayer));
+        combine(eastl::hash<uint32_t>()(createInfo.layers));
+
+        return hash;
+    }
+
     VkDescriptorSetLayoutBinding Image::GetDescriptorSetLayout(
         const uint32_t& binding,
         const VkDescriptorType& descriptorType,
@@ -132,7 +227,7 @@ namespace Mantis
         VkDescriptorSetLayoutBinding layoutBinding = {};
         layoutBinding.binding = binding;
         layoutBinding.descriptorType = descriptorType;
-        layoutBinding.descriptorCount = 1;
+        layoutBinding.descriptorCount = count;
         layoutBinding.stageFlags = stage;
         layoutBinding.pImmutableSamplers = nullptr;
 
@@ -161,63 +256,128 @@ namespace Mantis
         //return WriteDescriptorSet(descriptorWrite, imageInfo);
     }
 
-    eastl::unique_ptr<uint8_t[]> Image::GetContents(
-        uint32_t& size,
-        VkExtent3D& extent,
+    VkExtent3D Image::GetMipExtent(const uint32_t& mipLevel) const
+    {
+        VkExtent3D extent = {};
+        extent.width  = eastl::max(m_extent.width  >> mipLevel, 1u);
+        extent.height = eastl::max(m_extent.height >> mipLevel, 1u);
+        extent.depth  = eastl::max(m_extent.depth  >> mipLevel, 1u);
+        return extent;
+    }
+
+    uint64_t Image::GetContents(
+        const VkImageLayout& layout,
+        StreamingEngine::ReadbackCallback&& callback,
         const uint32_t& mipLevel,
-        const uint32_t& arrayLayer) const
+        const uint32_t& arrayLayer,
+        const StreamPriority& priority)
     {
-        //auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+        if (mipLevel >= m_mipLevels)
+        {
+            Logger::ErrorTF(LOG_TAG, "Cannot get contents of mip level %u, image only has %u mip levels!", mipLevel, m_mipLevels);
+            return 0;
+        }
+        if (arrayLayer >= m_arrayLayers)
+        {
+            Logger::ErrorTF(LOG_TAG, "Cannot get contents of layer %u, image only has %u layers!", arrayLayer, m_arrayLayers);
+            return 0;
+        }
+        if (layout == VK_IMAGE_LAYOUT_UNDEFINED || layout == VK_IMAGE_LAYOUT_PREINITIALIZED)
+        {
+            Logger::ErrorT(LOG_TAG, "Cannot get contents of an image with undefined contents!");
+            return 0;
+        }
 
-        //if (arrayLayer >= m_arrayLayers)
-        //{
-        //    Logger::ErrorTF(LOG_TAG, "Cannot get contents of layer %u, image only has %u layers!", arrayLayer, m_arrayLayers);
-        //    return nullptr;
-        //}
+        // only one aspect of an image can be copied at a time
+        auto aspect = GetImageAspect(m_format);
 
-        //uint32_t level = eastl::min(mipLevel, m_mipLevels - 1);
+        if (HAS_FLAGS(aspect, VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT))
+        {
+            Logger::ErrorT(LOG_TAG, "Cannot get contents of a combined depth stencil image!");
+            return 0;
+        }
 
-        //extent.width = eastl::max(m_extent.width >> level, 1u);
-        //extent.height = eastl::max(m_extent.height >> level, 1u);
-        //extent.depth = 1;
+        auto extent = GetMipExtent(mipLevel);
+
+        VkBufferImageCopy region = {};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = aspect;
+        region.imageSubresource.mipLevel = mipLevel;
+        region.imageSubresource.baseArrayLayer = arrayLayer;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = extent;
+
+        auto streamingEngine = Renderer::Get()->GetStreamingEngine();
+        return streamingEngine->Readback(*this, GetSize(extent, m_format), region, layout, eastl::move(callback), priority);
+    }
 
-        //CommandBuffer cmd = CommandBuffer(QueueType::);
+    std::future<ImageContents> Image::GetContentsAsync(
+        const VkImageLayout& layout,
+        const uint32_t& mipLevel,
+        const uint32_t& arrayLayer,
+        const StreamPriority& priority)
+    {
+        // the callback must be copyable, so the promise is shared with it
+        auto promise = eastl::make_shared<std::promise<ImageContents>>();
+        auto future = promise->get_future();
 
-        //InsertImageMemoryBarrier(commandBuffer, dstImage, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        //    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_IMAGE_ASPECT_COLOR_BIT, 1, 0, 1, 0);
+        ImageContents contents = {};
+        contents.extent = GetMipExtent(mipLevel);
+        contents.format = m_format;
 
+        auto request = GetContents(layout, [promise, contents](const void* data, const VkDeviceSize& size) mutable
+        {
+            auto bytes = static_cast<const uint8_t*>(data);
+            contents.data.assign(bytes, bytes + size);
+            promise->set_value(eastl::move(contents));
+        }, mipLevel, arrayLayer, priority);
 
-        //VkImage dstImage;
-        //VkDeviceMemory dstImageMemory;
-        //CopyImage(m_image, dstImage, dstImageMemory, m_format, m_extent, m_layout, level, arrayLayer);
+        if (request == 0)
+        {
+            promise->set_value(eastl::move(contents));
+        }
 
-        //VkImageSubresource dstImageSubresource = {};
-        //dstImageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        //dstImageSubresource.mipLevel = 0;
-        //dstImageSubresource.arrayLayer = 0;
+        return future;
+    }
 
-        //VkSubresourceLayout dstSubresourceLayout;
-        //vkGetImageSubresourceLayout(*logicalDevice, dstImage, &dstImageSubresource, &dstSubresourceLayout);
+    eastl::unique_ptr<uint8_t[]> Image::GetContents(
+        uint32_t& size,
+        VkExtent3D& extent,
+        const VkImageLayout& layout,
+        const uint32_t& mipLevel,
+        const uint32_t& arrayLayer)
+    {
+        eastl::unique_ptr<uint8_t[]> contents;
 
-        //auto contents = std::make_unique<uint8_t[]>(dstSubresourceLayout.size);
+        auto request = GetContents(layout, [&contents, &size](const void* data, const VkDeviceSize& dataSize)
+        {
+            size = static_cast<uint32_t>(dataSize);
+            contents = eastl::make_unique<uint8_t[]>(size);
+            memcpy(contents.get(), data, size);
+        }, mipLevel, arrayLayer, StreamPriority::Immediate);
 
-        //void* data;
-        //vkMapMemory(*logicalDevice, dstImageMemory, dstSubresourceLayout.offset, dstSubresourceLayout.size, 0, &data);
-        //std::memcpy(contents.get(), data, static_cast<size_t>(dstSubresourceLayout.size));
-        //vkUnmapMemory(*logicalDevice, dstImageMemory);
+        if (request == 0)
+        {
+            size = 0;
+            return nullptr;
+        }
 
-        //vkFreeMemory(*logicalDevice, dstImageMemory, nullptr);
-        //vkDestroyImage(*logicalDevice, dstImage, nullptr);
+        extent = GetMipExtent(mipLevel);
 
-        //return contents;
+        Renderer::Get()->GetStreamingEngine()->Wait(request);
+        return contents;
     }
 
-    void Image::SetContents(
+    uint64_t Image::SetContents(
         const uint8_t* contents,
         const uint32_t& baseMipLevel,
         const uint32_t& mipLevelCount,
         const uint32_t& baseLayer,
-        const uint32_t& layerCount)
+        const uint32_t& layerCount,
+        const StreamPriority& priority)
     {
         uint32_t endMip = baseMipLevel + mipLevelCount;
         uint32_t endLayer = baseLayer + layerCount;
@@ -226,12 +386,12 @@ namespace Mantis
         if (endMip > m_mipLevels)
         {
             Logger::ErrorTF(LOG_TAG, "Cannot set contents of mip levels %u to %u, image only has %u mip levels!", baseMipLevel, endMip - 1, m_mipLevels);
-            return;
+            return 0;
         }
         if (endLayer > m_arrayLayers)
         {
             Logger::ErrorTF(LOG_TAG, "Cannot set contents of layers %u to %u, image only has %u layers!", baseLayer, endLayer - 1, m_arrayLayers);
-            return;
+            return 0;
         }
 
         // prepare to copy all layers and mips
@@ -243,10 +403,7 @@ namespace Mantis
             for (uint32_t mip = baseMipLevel; mip < endMip; mip++)
             {
                 // compute the resolution of the mip map
-                VkExtent3D mipExtent = {};
-                mipExtent.width  = eastl::max(m_extent.width  >> mip, 1u);
-                mipExtent.height = eastl::max(m_extent.height >> mip, 1u);
-                mipExtent.depth  = eastl::max(m_extent.depth  >> mip, 1u);
+                auto mipExtent = GetMipExtent(mip);
 
                 // determine the the mapping between regions to copy between
                 VkBufferImageCopy region = {};
@@ -267,79 +424,95 @@ namespace Mantis
             }
         }
 
-        // get a staging buffer of suitable size and copy in the contents
-        Buffer stagingBuffer = Buffer(
-            size,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            contents
-        );
-
-        // check if a separate transfer queue should be used
-        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
-
-        auto graphicsFamily = logicalDevice->GetGraphicsFamily();
-        auto transferFamily = logicalDevice->GetTransferFamily();
-
-        bool isUnifiedQueue = graphicsFamily == transferFamily;
-
-        // create a command buffer to do the copy with
-        CommandBuffer cmd = CommandBuffer(isUnifiedQueue ? QueueType::Graphics : QueueType::Transfer);
-
-        // transition the image to a layout suitable to copy to
-        TransitionImageLayout(cmd,
-            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-        );
-
-        // copy the contents to the image
-        vkCmdCopyBufferToImage(cmd, stagingBuffer.GetBuffer(), m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+        // the upload is staged and submitted by the streaming engine
+        return Renderer::Get()->GetStreamingEngine()->Upload(*this, contents, size, regions, priority);
+    }
 
-        if (isUnifiedQueue)
+    void Image::GenerateMipmaps(const CommandBuffer& commandBuffer)
+    {
+        if (m_mipLevels < 2)
         {
-            TransitionImageLayout(cmd,
-                VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-            );
-
-            cmd.SubmitIdle();
+            return;
         }
-        else
-        {
-            TransitionImageLayout(cmd,
-                transferFamily, graphicsFamily,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-            );
-            
-            cmd.SubmitIdle();
 
-            CommandBuffer cmd = CommandBuffer(QueueType::Graphics);
-
-            TransitionImageLayout(cmd,
-                transferFamily, graphicsFamily,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-            );
+        // the base level is read from the layout it was left in, so it must be known
+        for (uint32_t layer = 0; layer < m_arrayLayers; layer++)
+        {
+            if (GetSubresourceLayout(0, layer) == VK_IMAGE_LAYOUT_UNDEFINED)
+            {
+                Logger::ErrorT(LOG_TAG, "Cannot generate mip maps, the layout of the base level is unknown!");
+                return;
+            }
+        }
 
-            cmd.SubmitIdle();
+        // generate all the levels in a single dispatch where possible
+        if (Renderer::Get()->GetMipGenerator()->Generate(commandBuffer, *this))
+        {
+            return;
         }
-    }
 
-    void Image::GenerateMipmaps(const CommandBuffer& commandBuffer)
-    {
         auto physicalDevice = Renderer::Get()->GetPhysicalDevice();
 
         // check that blitting is supported for the image type
         VkFormatProperties formatProperties;
         vkGetPhysicalDeviceFormatProperties(*physicalDevice, m_format, &formatProperties);
 
-        if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+        if (!HAS_FLAGS(formatProperties.optimalTilingFeatures, VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT))
         {
-            Logger::ErrorT(LOG_TAG, "Device does not support linear blitting!");
+            Logger::ErrorT(LOG_TAG, "Device does not support blitting the image format, mip maps must be generated offline!");
             return;
         }
 
+        VkFilter filter = VK_FILTER_LINEAR;
+
+        if (HAS_NO_FLAG(formatProperties.optimalTilingFeatures, VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+        {
+            Logger::WarningT(LOG_TAG, "Device does not support linear blitting, using nearest filtering for mip maps!");
+            filter = VK_FILTER_NEAREST;
+        }
+
         VkImageAspectFlags aspect = GetImageAspect(m_format);
 
+        // each layer of the base level is blitted from the layout it was left in, while the contents of the other levels are discarded
+        eastl::vector<VkImageMemoryBarrier> barriers(m_arrayLayers + 1);
+        for (auto& barrier : barriers)
+        {
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = m_image;
+            barrier.subresourceRange.aspectMask = aspect;
+        }
+
+        for (uint32_t layer = 0; layer < m_arrayLayers; layer++)
+        {
+            auto& barrier = barriers[layer];
+            barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            barrier.oldLayout = GetSubresourceLayout(0, layer);
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barrier.subresourceRange.baseMipLevel = 0;
+            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.baseArrayLayer = layer;
+            barrier.subresourceRange.layerCount = 1;
+        }
+
+        auto& mipBarrier = barriers[m_arrayLayers];
+        mipBarrier.srcAccessMask = 0;
+        mipBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        mipBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        mipBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        mipBarrier.subresourceRange.baseMipLevel = 1;
+        mipBarrier.subresourceRange.levelCount = m_mipLevels - 1;
+        mipBarrier.subresourceRange.baseArrayLayer = 0;
+        mipBarrier.subresourceRange.layerCount = m_arrayLayers;
+
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+            0, nullptr,
+            0, nullptr,
+            static_cast<uint32_t>(barriers.size()), barriers.data());
+
         // generate all the mip maps
         VkImageMemoryBarrier barrier = {};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -355,16 +528,20 @@ namespace Mantis
         {
             barrier.subresourceRange.baseMipLevel = i - 1;
 
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-
-            vkCmdPipelineBarrier(commandBuffer,
-                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                0, nullptr,
-                0, nullptr,
-                1, &barrier);
+            // the base level is already a blit source
+            if (i > 1)
+            {
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+                barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+                vkCmdPipelineBarrier(commandBuffer,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                    0, nullptr,
+                    0, nullptr,
+                    1, &barrier);
+            }
 
             VkImageBlit blit = {};
             blit.srcOffsets[0] = { 0, 0, 0 };
@@ -380,7 +557,7 @@ namespace Mantis
             blit.dstSubresource.baseArrayLayer = 0;
             blit.dstSubresource.layerCount = m_arrayLayers;
 
-            vkCmdBlitImage(commandBuffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+            vkCmdBlitImage(commandBuffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, filter);
 
             barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
             barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
@@ -388,7 +565,7 @@ namespace Mantis
             barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
             vkCmdPipelineBarrier(commandBuffer,
-                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
                 0, nullptr,
                 0, nullptr,
                 1, &barrier);
@@ -400,7 +577,31 @@ namespace Mantis
         barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
         barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        for (uint32_t layer = 0; layer < m_arrayLayers; layer++)
+        {
+            for (uint32_t level = 0; level < m_mipLevels; level++)
+            {
+                SetSubresourceLayout(level, layer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            }
+        }
+    }
+
+    VkImageLayout Image::GetSubresourceLayout(const uint32_t& mipLevel, const uint32_t& arrayLayer) const
+    {
+        auto index = arrayLayer * m_mipLevels + mipLevel;
+        return index < m_subresourceLayouts.size() ? m_subresourceLayouts[index] : VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+
+    void Image::SetSubresourceLayout(const uint32_t& mipLevel, const uint32_t& arrayLayer, const VkImageLayout& layout)
+    {
+        auto index = arrayLayer * m_mipLevels + mipLevel;
+
+        if (index < m_subresourceLayouts.size())
+        {
+            m_subresourceLayouts[index] = layout;
+        }
     }
 
     void Image::TransitionImageLayout(
@@ -409,6 +610,24 @@ namespace Mantis
         const uint32_t& dstQueueFamilyIndex,
         const VkImageLayout& srcImageLayout,
         const VkImageLayout& dstImageLayout)
+    {
+        VkImageSubresourceRange subresourceRange = {};
+        subresourceRange.aspectMask = GetImageAspect(m_format);
+        subresourceRange.baseMipLevel = 0;
+        subresourceRange.levelCount = m_mipLevels;
+        subresourceRange.baseArrayLayer = 0;
+        subresourceRange.layerCount = m_arrayLayers;
+
+        TransitionImageLayout(commandBuffer, srcQueueFamilyIndex, dstQueueFamilyIndex, srcImageLayout, dstImageLayout, subresourceRange);
+    }
+
+    void Image::TransitionImageLayout(
+        const CommandBuffer& commandBuffer,
+        const uint32_t& srcQueueFamilyIndex,
+        const uint32_t& dstQueueFamilyIndex,
+        const VkImageLayout& srcImageLayout,
+        const VkImageLayout& dstImageLayout,
+        const VkImageSubresourceRange& subresourceRange)
     {
         // check if there is a resourece ownership transition to a different queue
         bool isQueueTransfer = srcQueueFamilyIndex != dstQueueFamilyIndex;
@@ -422,11 +641,7 @@ namespace Mantis
         barrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
         barrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
         barrier.image = m_image;
-        barrier.subresourceRange.aspectMask = GetImageAspect(m_format);
-        barrier.subresourceRange.baseMipLevel = 0;
-        barrier.subresourceRange.levelCount = m_mipLevels;
-        barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount = m_arrayLayers;
+        barrier.subresourceRange = subresourceRange;
 
         VkPipelineStageFlags srcStage;
         if (isQueueTransfer && queueIndex == dstQueueFamilyIndex)
@@ -463,8 +678,13 @@ namespace Mantis
                     srcStage = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
                     break;
                 case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+                    // the image may be sampled by any shader stage, not only fragment shaders
                     barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-                    srcStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+                    srcStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+                    break;
+                case VK_IMAGE_LAYOUT_GENERAL:
+                    barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+                    srcStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
                     break;
                 default:
                     Logger::ErrorT(LOG_TAG, "Unsupported image layout transition source!");
@@ -500,7 +720,11 @@ namespace Mantis
                     break;
                 case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
                     barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-                    dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+                    dstStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+                    break;
+                case VK_IMAGE_LAYOUT_GENERAL:
+                    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+                    dstStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
                     break;
                 default:
                     Logger::ErrorT(LOG_TAG, "Unsupported image layout transition destination!");
@@ -798,7 +1022,7 @@ namespace Mantis
             case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
             case VK_FORMAT_BC4_UNORM_BLOCK:
             case VK_FORMAT_BC4_SNORM_BLOCK:
-                return eastl::max(extents.width / 4u, 1u) * eastl::max(extents.height / 4u, 1u) * extents.depth * 8;
+                return ((extents.width + 3) / 4) * ((extents.height + 3) / 4) * extents.depth * 8;
             case VK_FORMAT_BC2_UNORM_BLOCK:
             case VK_FORMAT_BC2_SRGB_BLOCK:
             case VK_FORMAT_BC3_UNORM_BLOCK:
@@ -809,7 +1033,7 @@ namespace Mantis
             case VK_FORMAT_BC6H_SFLOAT_BLOCK:
             case VK_FORMAT_BC7_UNORM_BLOCK:
             case VK_FORMAT_BC7_SRGB_BLOCK:
-                return eastl::max(extents.width / 4u, 1u) * eastl::max(extents.height / 4u, 1u) * extents.depth * 16;
+                return ((extents.width + 3) / 4) * ((extents.height + 3) / 4) * extents.depth * 16;
             // depth texture formats
             case VK_FORMAT_S8_UINT:
                 return texels * 1;
@@ -824,8 +1048,10 @@ namespace Mantis
             case VK_FORMAT_D32_SFLOAT_S8_UINT:
                 return texels * 5;
             default:
-                Logger::ErrorTF(LOG_TAG, "Cannot compute reqired image size, unsupported format: &u", static_cast<uint32_t>(format));
+                Logger::ErrorTF(LOG_TAG, "Cannot compute reqired image size, unsupported format: %u", static_cast<uint32_t>(format));
                 break;
         }
+
+        return 0;
     }
 }
\ No newline at end of file
@@ -2,8 +2,11 @@
 
 #include "Mantis.h"
 
+#include <future>
+
 #include "Renderer/Utils/Nameable.h"
 #include "Renderer/Descriptor/Descriptor.h"
+#include "Renderer/Streaming/StreamingEngine.h"
 
 namespace Mantis
 {
@@ -119,6 +122,69 @@ namespace Mantis
 	};
 
 
+    /// <summary>
+    /// A copy of part of an image read back from the device.
+    /// </summary>
+    struct ImageContents
+    {
+        /// <summary>
+        /// The tightly packed texel data. Empty if the readback failed.
+        /// </summary>
+        eastl::vector<uint8_t> data;
+        /// <summary>
+        /// The resolution of the data in texels.
+        /// </summary>
+        VkExtent3D extent;
+        /// <summary>
+        /// The format of the data.
+        /// </summary>
+        VkFormat format;
+    };
+
+    /// <summary>
+    /// The creation options for an image view.
+    /// </summary>
+    struct ImageViewCreateInfo
+    {
+        // uses the format of the associated image by default
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        // assumes the type from the associated image by default
+        VkImageViewType type = VK_IMAGE_VIEW_TYPE_RANGE_SIZE;
+        VkComponentMapping swizzle =
+        {
+            VK_COMPONENT_SWIZZLE_R,
+            VK_COMPONENT_SWIZZLE_G,
+            VK_COMPONENT_SWIZZLE_B,
+            VK_COMPONENT_SWIZZLE_A,
+        };
+        uint32_t baseLevel = 0;
+        uint32_t levels = VK_REMAINING_MIP_LEVELS;
+        uint32_t baseLayer = 0;
+        uint32_t layers = VK_REMAINING_ARRAY_LAYERS;
+
+        bool operator == (const ImageViewCreateInfo& other) const
+        {
+            return format == other.format &&
+                type == other.type &&
+                swizzle.r == other.swizzle.r &&
+                swizzle.g == other.swizzle.g &&
+                swizzle.b == other.swizzle.b &&
+                swizzle.a == other.swizzle.a &&
+                baseLevel == other.baseLevel &&
+                levels == other.levels &&
+                baseLayer == other.baseLayer &&
+                layers == other.layers;
+        }
+
+        bool operator != (const ImageViewCreateInfo& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    class ImageView;
+    class Sampler;
+
     /// <summary>
     /// Manages an image.
     /// </summary>
@@ -158,6 +224,11 @@ namespace Mantis
         /// </summary>
         const VkImageType& GetType() const { return m_type; }
 
+        /// <summary>
+        /// The flags this image was created with.
+        /// </summary>
+        const VkImageCreateFlags& GetFlags() const { return m_flags; }
+
         /// <summary>
         /// The format of this image.
         /// </summary>
@@ -171,7 +242,7 @@ namespace Mantis
         /// <summary>
         /// The number of mip map levels in this image.
         /// </summary>
-        const uint32_t& GetLevelCount() const { return m_arrayLayers; }
+        const uint32_t& GetLevelCount() const { return m_mipLevels; }
 
         /// <summary>
         /// The number of layers in this image.
@@ -194,6 +265,18 @@ namespace Mantis
         /// </summary>
         void SetName(const String& name);
 
+        /// <summary>
+        /// Gets a view of this image. Views are created the first time they are requested and are
+        /// then reused until the image is destroyed. Thread safe.
+        /// </summary>
+        /// <param name="createInfo">The subresources, format and swizzle of the view. The whole image by default.</param>
+        const ImageView& GetView(const ImageViewCreateInfo& createInfo = {}) const;
+
+        /// <summary>
+        /// Gets the sampler used to sample this image, which is shared with every image using the same sampler settings.
+        /// </summary>
+        const Sampler& GetSampler() const { return *m_sampler; }
+
         WriteDescriptorSet GetWriteDescriptor(
             const uint32_t& binding,
             const VkDescriptorType& descriptorType, 
@@ -201,19 +284,80 @@ namespace Mantis
         ) const override;
 
         /// <summary>
-        /// Gets a copy of the image contents.
+        /// Gets the layout a subresource was left in by the last streaming upload or mip map generation, or undefined if it has never been written by either.
+        /// </summary>
+        /// <param name="mipLevel">The mip map level of the subresource.</param>
+        /// <param name="arrayLayer">The array layer of the subresource.</param>
+        VkImageLayout GetSubresourceLayout(const uint32_t& mipLevel, const uint32_t& arrayLayer) const;
+
+        /// <summary>
+        /// Sets the layout a subresource is left in by a streaming upload, mip map generation or other work recorded
+        /// by the caller. Must only be called on the render thread.
+        /// </summary>
+        /// <param name="mipLevel">The mip map level of the subresource.</param>
+        /// <param name="arrayLayer">The array layer of the subresource.</param>
+        /// <param name="layout">The layout of the subresource once the upload has completed.</param>
+        void SetSubresourceLayout(const uint32_t& mipLevel, const uint32_t& arrayLayer, const VkImageLayout& layout);
+
+        /// <summary>
+        /// Gets the resolution of a mip map level.
+        /// </summary>
+        /// <param name="mipLevel">The mip map level.</param>
+        VkExtent3D GetMipExtent(const uint32_t& mipLevel) const;
+
+        /// <summary>
+        /// Queues a copy of the image contents back to the host without stalling. The image is transitioned
+        /// from the given layout for the copy and then back again, so the whole image must be in that layout
+        /// when the readback is submitted after the frame. Thread safe.
+        /// </summary>
+        /// <param name="layout">The layout of the image when the readback is submitted.</param>
+        /// <param name="callback">The function given the tightly packed texels, invoked on the render thread once the copy completes.</param>
+        /// <param name="mipLevel">The mipmap level index to copy.</param>
+        /// <param name="arrayLayer">The array layer to copy.</param>
+        /// <param name="priority">The priority of the readback.</param>
+        /// <returns>The streaming request ID, used to check when the readback has completed. Zero if the request was invalid.</returns>
+        uint64_t GetContents(
+            const VkImageLayout& layout,
+            StreamingEngine::ReadbackCallback&& callback,
+            const uint32_t& mipLevel = 0,
+            const uint32_t& arrayLayer = 0,
+            const StreamPriority& priority = StreamPriority::Normal
+        );
+
+        /// <summary>
+        /// Queues a copy of the image contents back to the host without stalling. The future is resolved
+        /// on the render thread once the copy completes, usually a few frames later, so it should not be
+        /// waited on from the render thread. Thread safe.
+        /// </summary>
+        /// <param name="layout">The layout of the image when the readback is submitted.</param>
+        /// <param name="mipLevel">The mipmap level index to copy.</param>
+        /// <param name="arrayLayer">The array layer to copy.</param>
+        /// <param name="priority">The priority of the readback.</param>
+        /// <returns>The image contents, with no data if the request was invalid.</returns>
+        std::future<ImageContents> GetContentsAsync(
+            const VkImageLayout& layout,
+            const uint32_t& mipLevel = 0,
+            const uint32_t& arrayLayer = 0,
+            const StreamPriority& priority = StreamPriority::Normal
+        );
+
+        /// <summary>
+        /// Gets a copy of the image contents, blocking until the copy completes. The copy is submitted immediately,
+        /// so it sees the work already submitted but not the frame being recorded. Must be called on the render thread.
         /// </summary>
         /// <param name="size">The size of the image contents in bytes.</param>
         /// <param name="extent">The resolution of the image in pixels.</param>
+        /// <param name="layout">The layout of the image.</param>
         /// <param name="mipLevel">The mipmap level index to sample.</param>
         /// <param name="arrayLayer">The array level to sample.</param>
-        /// <returns>A copy of the image pixels.</returns>
+        /// <returns>A copy of the image pixels, or null if the image could not be read.</returns>
         eastl::unique_ptr<uint8_t[]> GetContents(
             uint32_t& size,
             VkExtent3D& extent,
+            const VkImageLayout& layout,
             const uint32_t& mipLevel = 0,
             const uint32_t& arrayLayer = 0
-        ) const;
+        );
 
         /// <summary>
         /// Sets the contents of this image. The data must be laid out such that the
@@ -225,12 +369,15 @@ namespace Mantis
         /// <param name="mipLevelCount">The number of mip map levels to set.</param>
         /// <param name="baseLayer">The first layer to copy into.</param>
         /// <param name="layerCount">The number of layers to copy.</param>
-        void SetContents(
+        /// <param name="priority">The priority of the upload.</param>
+        /// <returns>The streaming request ID, used to check when the upload has completed.</returns>
+        uint64_t SetContents(
             const uint8_t* contents,
             const uint32_t& baseMipLevel = 0,
             const uint32_t& mipLevelCount = 1,
             const uint32_t& baseLayer = 0,
-            const uint32_t& layerCount = 1
+            const uint32_t& layerCount = 1,
+            const StreamPriority& priority = StreamPriority::Immediate
         );
 
         static VkDescriptorSetLayoutBinding GetDescriptorSetLayout(
@@ -241,7 +388,9 @@ namespace Mantis
         );
 
         /// <summary>
-        /// Generates the mip maps for this image.
+        /// Generates the mip maps for this image. The base level is read from the layout given by <see cref="GetSubresourceLayout"/>,
+        /// so any upload to it must have been submitted, and all levels are left in the shader read only layout, which is
+        /// tracked from then on. Uses compute when the image supports it, otherwise a blit for each level. Must be called on the render thread.
         /// </summary>
         /// <param name="commandBuffer">The command buffer to generate the mip maps on.</param>
         void GenerateMipmaps(const CommandBuffer& commandBuffer);
@@ -254,6 +403,24 @@ namespace Mantis
             const VkImageLayout& dstImageLayout
         );
 
+        /// <summary>
+        /// Transitions the layout of part of the image.
+        /// </summary>
+        /// <param name="commandBuffer">The command buffer to record the barrier to.</param>
+        /// <param name="srcQueueFamilyIndex">The queue family releasing ownership, or ignored if there is no ownership transfer.</param>
+        /// <param name="dstQueueFamilyIndex">The queue family acquiring ownership, or ignored if there is no ownership transfer.</param>
+        /// <param name="srcImageLayout">The current layout of the subresources.</param>
+        /// <param name="dstImageLayout">The new layout of the subresources.</param>
+        /// <param name="subresourceRange">The subresources to transition.</param>
+        void TransitionImageLayout(
+            const CommandBuffer& commandBuffer,
+            const uint32_t& srcQueueFamilyIndex,
+            const uint32_t& dstQueueFamilyIndex,
+            const VkImageLayout& srcImageLayout,
+            const VkImageLayout& dstImageLayout,
+            const VkImageSubresourceRange& subresourceRange
+        );
+
         void InsertMemoryBarrier(
             const CommandBuffer& commandBuffer,
             const uint32_t& srcQueueFamilyIndex,
@@ -292,6 +459,14 @@ namespace Mantis
             return levels;
         }
 
+        /// <summary>
+        /// Gets the number of bytes required to fit the specified texture.
+        /// </summary>
+        /// <param name="extents">The extents of the image.</param>
+        /// <param name="format">The format of the image.</param>
+        /// <returns>The size in bytes.</returns>
+        static VkDeviceSize GetSize(const VkExtent3D& extents, const VkFormat& format);
+
     protected:
         /// <summary>
         /// Creates the image resources.
@@ -330,16 +505,13 @@ namespace Mantis
             const bool& compare = false,
             const VkCompareOp& compareOp = VK_COMPARE_OP_ALWAYS
         );
-        
-        /// <summary>
-        /// Gets the number of bytes required to fit the specified texture.
-        /// </summary>
-        /// <param name="extents">The extents of the image.</param>
-        /// <param name="format">The format of the image.</param>
-        /// <returns>The size in bytes.</returns>
-        static VkDeviceSize GetSize(const VkExtent3D& extents, const VkFormat& format);
 
     private:
+        struct ViewHash
+        {
+            size_t operator()(const ImageViewCreateInfo& createInfo) const;
+        };
+
         void CreateImage(
             const VkMemoryPropertyFlags& properties,
             const VkImageCreateFlags& flags,
@@ -347,6 +519,13 @@ namespace Mantis
             const VkImageTiling& tiling
         );
 
+        /// <summary>
+        /// Gets the sampler matching the sampler settings of this image from the sampler cache.
+        /// </summary>
+        /// <param name="compare">Should the sampler use a comparison mode.</param>
+        /// <param name="compareOp">The comparison operation used by the sampler.</param>
+        void CreateSampler(const bool& compare, const VkCompareOp& compareOp);
+
         VkImage m_image;
 
         VmaAllocator m_allocator;
@@ -361,5 +540,15 @@ namespace Mantis
         VkSampleCountFlagBits m_samples;
         uint32_t m_mipLevels;
         uint32_t m_arrayLayers;
+
+        VkFilter m_filter;
+        VkSamplerAddressMode m_addressMode;
+        bool m_anisotropic;
+        eastl::shared_ptr<Sampler> m_sampler;
+
+        eastl::vector<VkImageLayout> m_subresourceLayouts;
+
+        mutable std::mutex m_viewMutex;
+        mutable eastl::unordered_map<ImageViewCreateInfo, eastl::unique_ptr<ImageView>, ViewHash> m_views;
     };
 }
\ No newline at end of file
@@ -14,6 +14,9 @@ namespace Mantis
         const ImageViewCreateInfo& createInfo
     )
         : m_view(VK_NULL_HANDLE)
+        , m_format(VK_FORMAT_UNDEFINED)
+        , m_extent({ 0, 0 })
+        , m_samples(VK_SAMPLE_COUNT_1_BIT)
     {
         auto logicalDevice = Renderer::Get()->GetLogicalDevice();
 
@@ -30,6 +33,10 @@ namespace Mantis
         }
 
         VkFormat format = createInfo.format != VK_FORMAT_UNDEFINED ? createInfo.format : image->GetFormat();
+        m_format = format;
+        m_extent.width = eastl::max(image->GetExtents().width >> createInfo.baseLevel, 1u);
+        m_extent.height = eastl::max(image->GetExtents().height >> createInfo.baseLevel, 1u);
+        m_samples = image->GetSamples();
 
         VkImageViewCreateInfo info = {};
         info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -7,30 +7,8 @@
 
 namespace Mantis
 {
-	/// <summary>
-	/// The creation options for an image view.
-	/// </summary>
-    struct ImageViewCreateInfo
-    {
-        // uses the format of the associated image by default
-        VkFormat format = VK_FORMAT_UNDEFINED;
-        // assumes the type from the associated image by default
-        VkImageViewType type = VK_IMAGE_VIEW_TYPE_RANGE_SIZE;
-        VkComponentMapping swizzle =
-        {
-            VK_COMPONENT_SWIZZLE_R,
-            VK_COMPONENT_SWIZZLE_G,
-            VK_COMPONENT_SWIZZLE_B,
-            VK_COMPONENT_SWIZZLE_A,
-        };
-        uint32_t baseLevel = 0;
-        uint32_t levels = VK_REMAINING_MIP_LEVELS;
-        uint32_t baseLayer = 0;
-        uint32_t layers = VK_REMAINING_ARRAY_LAYERS;
-    };
-
     /// <summary>
-    /// Manages an image view.
+    /// Manages an image view. Views which are used repeatedly should be obtained using <see cref="Image::GetView"/>.
     /// </summary>
     class ImageView
         : public NonCopyable
@@ -52,6 +30,26 @@ namespace Mantis
         /// </summary>
         virtual ~ImageView();
 
+        /// <summary>
+        /// Gets the underlying image view.
+        /// </summary>
+        const VkImageView& GetView() const { return m_view; }
+
+        /// <summary>
+        /// Gets the format the image is viewed as.
+        /// </summary>
+        const VkFormat& GetFormat() const { return m_format; }
+
+        /// <summary>
+        /// Gets the size of the first mip level in the view.
+        /// </summary>
+        const VkExtent2D& GetExtent() const { return m_extent; }
+
+        /// <summary>
+        /// Gets the number of samples in the viewed image.
+        /// </summary>
+        const VkSampleCountFlagBits& GetSamples() const { return m_samples; }
+
         /// <summary>
         /// Sets the name of this instance.
         /// </summary>
@@ -61,5 +59,8 @@ namespace Mantis
         static VkImageViewType GetImageViewType(const Image* image, const ImageViewCreateInfo& createInfo);
 
         VkImageView m_view;
+        VkFormat m_format;
+        VkExtent2D m_extent;
+        VkSampleCountFlagBits m_samples;
     };
 }
@@ -0,0 +1,241 @@
+#include "stdafx.h"
+#include "MipChain.h"
+
+#include "Renderer/Image/Image.h"
+#include "Renderer/Utils/Format.h"
+
+#if defined(MANTIS_64) || defined(MANTIS_32)
+#   include <emmintrin.h>
+#endif
+
+#define LOG_TAG MANTIS_TEXT("MipChain")
+
+namespace Mantis
+{
+    /// <summary>
+    /// Lookup tables for converting between sRGB and linear values.
+    /// </summary>
+    struct SrgbTables
+    {
+        /// <summary>
+        /// The linear value of each 8 bit sRGB value.
+        /// </summary>
+        float toLinear[256];
+
+        /// <summary>
+        /// The 8 bit sRGB value for linear values quantized to 12 bits, which is precise enough to round trip.
+        /// </summary>
+        uint8_t toSrgb[4096];
+
+        SrgbTables()
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                float c = i / 255.0f;
+                toLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+            }
+
+            for (uint32_t i = 0; i < 4096; i++)
+            {
+                float l = (i + 0.5f) / 4096.0f;
+                float s = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+                toSrgb[i] = static_cast<uint8_t>(eastl::min(s * 255.0f + 0.5f, 255.0f));
+            }
+        }
+    };
+
+    static const SrgbTables& GetSrgbTables()
+    {
+        static SrgbTables tables;
+        return tables;
+    }
+
+    static void DownsampleLinear(const uint8_t* src, const uint32_t& srcWidth, const uint32_t& srcHeight, uint8_t* dst, const uint32_t& dstWidth, const uint32_t& dstHeight)
+    {
+#if defined(MANTIS_64) || defined(MANTIS_32)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi16(2);
+#endif
+
+        for (uint32_t y = 0; y < dstHeight; y++)
+        {
+            auto row0 = src + eastl::min(y * 2 + 0, srcHeight - 1) * srcWidth * 4;
+            auto row1 = src + eastl::min(y * 2 + 1, srcHeight - 1) * srcWidth * 4;
+            auto out = dst + y * dstWidth * 4;
+
+            uint32_t x = 0;
+
+#if defined(MANTIS_64) || defined(MANTIS_32)
+            // filter two texels at a time while all four source texels of both rows are in bounds
+            for (; x + 2 <= dstWidth && x * 2 + 4 <= srcWidth; x += 2)
+            {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+
+                // widen to 16 bits and add the rows, leaving two texel sums in each register
+                __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+                // add the horizontally adjacent texels
+                lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+                hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+                __m128i sum = _mm_unpacklo_epi64(lo, hi);
+                sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(sum, sum));
+            }
+#endif
+
+            for (; x < dstWidth; x++)
+            {
+                auto x0 = eastl::min(x * 2 + 0, srcWidth - 1) * 4;
+                auto x1 = eastl::min(x * 2 + 1, srcWidth - 1) * 4;
+
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    out[x * 4 + c] = static_cast<uint8_t>((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+                }
+            }
+        }
+    }
+
+    static void DownsampleSrgb(const uint8_t* src, const uint32_t& srcWidth, const uint32_t& srcHeight, uint8_t* dst, const uint32_t& dstWidth, const uint32_t& dstHeight)
+    {
+        const auto& tables = GetSrgbTables();
+
+#if defined(MANTIS_64) || defined(MANTIS_32)
+        const __m128 quarter = _mm_set1_ps(0.25f);
+
+        auto load = [&tables](const uint8_t* texel)
+        {
+            return _mm_set_ps(texel[3] * (1.0f / 255.0f), tables.toLinear[texel[2]], tables.toLinear[texel[1]], tables.toLinear[texel[0]]);
+        };
+#else
+        auto load = [&tables](const uint8_t* texel, const uint32_t& c)
+        {
+            return c < 3 ? tables.toLinear[texel[c]] : texel[c] * (1.0f / 255.0f);
+        };
+#endif
+
+        for (uint32_t y = 0; y < dstHeight; y++)
+        {
+            auto row0 = src + eastl::min(y * 2 + 0, srcHeight - 1) * srcWidth * 4;
+            auto row1 = src + eastl::min(y * 2 + 1, srcHeight - 1) * srcWidth * 4;
+            auto out = dst + y * dstWidth * 4;
+
+            for (uint32_t x = 0; x < dstWidth; x++)
+            {
+                auto x0 = eastl::min(x * 2 + 0, srcWidth - 1) * 4;
+                auto x1 = eastl::min(x * 2 + 1, srcWidth - 1) * 4;
+
+                alignas(16) float result[4];
+
+#if defined(MANTIS_64) || defined(MANTIS_32)
+                __m128 sum = _mm_add_ps(
+                    _mm_add_ps(load(row0 + x0), load(row0 + x1)),
+                    _mm_add_ps(load(row1 + x0), load(row1 + x1))
+                );
+
+                _mm_store_ps(result, _mm_mul_ps(sum, quarter));
+#else
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    result[c] = (load(row0 + x0, c) + load(row0 + x1, c) + load(row1 + x0, c) + load(row1 + x1, c)) * 0.25f;
+                }
+#endif
+
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    out[x * 4 + c] = tables.toSrgb[eastl::min(static_cast<uint32_t>(result[c] * 4096.0f), 4095u)];
+                }
+
+                out[x * 4 + 3] = static_cast<uint8_t>(result[3] * 255.0f + 0.5f);
+            }
+        }
+    }
+
+    bool MipChain::IsSupported(const VkFormat& format)
+    {
+        switch (format)
+        {
+            case VK_FORMAT_R8G8B8A8_UNORM:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+            case VK_FORMAT_B8G8R8A8_UNORM:
+            case VK_FORMAT_B8G8R8A8_SRGB:
+            case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+            case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    eastl::vector<uint8_t> MipChain::Generate(
+        const uint8_t* data,
+        const VkExtent3D& extent,
+        const VkFormat& format,
+        const uint32_t& mipLevels,
+        const uint32_t& layerCount)
+    {
+        if (!IsSupported(format))
+        {
+            Logger::ErrorTF(LOG_TAG, "Cannot generate mip maps for format %u!", format);
+            return {};
+        }
+        if (extent.depth != 1)
+        {
+            Logger::ErrorT(LOG_TAG, "Cannot generate mip maps for 3D images!");
+            return {};
+        }
+
+        auto maxLevels = Image::NumMipLevels(extent);
+        auto levels = mipLevels == 0 ? maxLevels : eastl::min(mipLevels, maxLevels);
+        auto isSrgb = Format::IsSrgb(format);
+
+        // all the formats are four bytes per texel
+        VkDeviceSize layerSize = 0;
+        for (uint32_t level = 0; level < levels; level++)
+        {
+            layerSize += static_cast<VkDeviceSize>(eastl::max(extent.width >> level, 1u)) * eastl::max(extent.height >> level, 1u) * 4;
+        }
+
+        eastl::vector<uint8_t> contents(static_cast<size_t>(layerSize * layerCount));
+
+        auto baseSize = static_cast<size_t>(extent.width) * extent.height * 4;
+        auto dst = contents.data();
+
+        for (uint32_t layer = 0; layer < layerCount; layer++)
+        {
+            memcpy(dst, data + layer * baseSize, baseSize);
+
+            auto src = dst;
+            auto srcWidth = extent.width;
+            auto srcHeight = extent.height;
+            dst += baseSize;
+
+            // each level is filtered from the previous one
+            for (uint32_t level = 1; level < levels; level++)
+            {
+                auto dstWidth = eastl::max(extent.width >> level, 1u);
+                auto dstHeight = eastl::max(extent.height >> level, 1u);
+
+                if (isSrgb)
+                {
+                    DownsampleSrgb(src, srcWidth, srcHeight, dst, dstWidth, dstHeight);
+                }
+                else
+                {
+                    DownsampleLinear(src, srcWidth, srcHeight, dst, dstWidth, dstHeight);
+                }
+
+                src = dst;
+                srcWidth = dstWidth;
+                srcHeight = dstHeight;
+                dst += static_cast<size_t>(dstWidth) * dstHeight * 4;
+            }
+        }
+
+        return contents;
+    }
+}
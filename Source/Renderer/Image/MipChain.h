@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Mantis.h"
+
+namespace Mantis
+{
+    /// <summary>
+    /// Generates mip maps on the CPU, so images which never change can be uploaded with every level
+    /// instead of generating the levels each time they are loaded.
+    /// </summary>
+    /// <remarks>
+    /// Each level is box filtered from the previous level, with edges clamped for odd sizes. sRGB
+    /// formats are filtered in linear space, while alpha is always treated as linear.
+    /// </remarks>
+    class MipChain
+    {
+    public:
+        /// <summary>
+        /// Checks if mip maps can be generated for a format.
+        /// </summary>
+        /// <param name="format">The format to check.</param>
+        static bool IsSupported(const VkFormat& format);
+
+        /// <summary>
+        /// Generates the mip maps for the layers of an image.
+        /// </summary>
+        /// <param name="data">The texels of the base level of each layer, with the layers stored one after another.</param>
+        /// <param name="extent">The resolution of the base level. Must have a depth of one.</param>
+        /// <param name="format">The format of the texels.</param>
+        /// <param name="mipLevels">The number of levels to generate including the base level, or zero for a full chain.</param>
+        /// <param name="layerCount">The number of layers in the data.</param>
+        /// <returns>Every level of each layer, laid out as expected by <see cref="Image::SetContents"/>. Empty if the data is not supported.</returns>
+        static eastl::vector<uint8_t> Generate(
+            const uint8_t* data,
+            const VkExtent3D& extent,
+            const VkFormat& format,
+            const uint32_t& mipLevels = 0,
+            const uint32_t& layerCount = 1
+        );
+    };
+}
@@ -0,0 +1,274 @@
+#include "stdafx.h"
+#include "MipGenerator.h"
+
+#include "Renderer/Renderer.h"
+#include "Renderer/Buffer/StorageBuffer.h"
+#include "Renderer/Image/ImageView.h"
+#include "Renderer/Image/SamplerCache.h"
+#include "Renderer/Utils/Format.h"
+
+#define LOG_TAG MANTIS_TEXT("MipGenerator")
+
+namespace Mantis
+{
+    static const char* DOWNSAMPLE_SHADER = "Resources/Shaders/Image/Downsample.comp";
+
+    MipGenerator::MipGenerator()
+    {
+    }
+
+    bool MipGenerator::IsSupported(const Image& image) const
+    {
+        auto physicalDevice = Renderer::Get()->GetPhysicalDevice();
+        auto& features = Renderer::Get()->GetLogicalDevice()->GetEnabledFeatures();
+
+        if (!features.shaderStorageImageWriteWithoutFormat || !features.shaderStorageImageArrayDynamicIndexing)
+        {
+            return false;
+        }
+
+        auto format = image.GetFormat();
+        auto levels = image.GetLevelCount();
+        auto extent = image.GetExtents();
+
+        // the last workgroup reduces one texel from each tile, which it can only do for up to a tile of tiles
+        if (extent.width > TILE_SIZE * TILE_SIZE || extent.height > TILE_SIZE * TILE_SIZE)
+        {
+            return false;
+        }
+
+        if (image.GetType() != VK_IMAGE_TYPE_2D ||
+            image.GetSamples() != VK_SAMPLE_COUNT_1_BIT ||
+            levels < 2 || levels > MAX_LEVELS + 1 ||
+            Format::HasDepthOrStencil(format) ||
+            HAS_NO_FLAG(image.GetUsage(), VK_IMAGE_USAGE_SAMPLED_BIT) ||
+            HAS_NO_FLAG(image.GetUsage(), VK_IMAGE_USAGE_STORAGE_BIT))
+        {
+            return false;
+        }
+
+        // sRGB formats can't be written as storage images, so the levels are written through UNORM views
+        auto storageFormat = Format::GetLinearFormat(format);
+
+        if (storageFormat != format && !HAS_FLAGS(image.GetFlags(), VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT))
+        {
+            return false;
+        }
+
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(*physicalDevice, format, &formatProperties);
+
+        if (HAS_NO_FLAG(formatProperties.optimalTilingFeatures, VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+        {
+            return false;
+        }
+
+        vkGetPhysicalDeviceFormatProperties(*physicalDevice, storageFormat, &formatProperties);
+
+        return HAS_FLAGS(formatProperties.optimalTilingFeatures, VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT);
+    }
+
+    bool MipGenerator::Generate(const CommandBuffer& commandBuffer, Image& image)
+    {
+        if (!IsSupported(image))
+        {
+            return false;
+        }
+
+        auto format = image.GetFormat();
+        auto storageFormat = Format::GetLinearFormat(format);
+        auto extent = image.GetExtents();
+        auto levels = image.GetLevelCount();
+        auto layers = image.GetLayerCount();
+        auto frame = Renderer::Get()->GetFrameCount();
+
+        uint32_t groupsX = (extent.width + TILE_SIZE - 1) / TILE_SIZE;
+        uint32_t groupsY = (extent.height + TILE_SIZE - 1) / TILE_SIZE;
+
+        // the views are owned by the image so they are reused when the mip maps are generated again
+        ImageViewCreateInfo sourceViewInfo = {};
+        sourceViewInfo.type = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        sourceViewInfo.baseLevel = 0;
+        sourceViewInfo.levels = 1;
+
+        auto& sourceView = image.GetView(sourceViewInfo);
+
+        eastl::vector<const ImageView*> mipViews;
+        for (uint32_t level = 1; level < levels; level++)
+        {
+            ImageViewCreateInfo mipViewInfo = {};
+            mipViewInfo.format = storageFormat;
+            mipViewInfo.type = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+            mipViewInfo.baseLevel = level;
+            mipViewInfo.levels = 1;
+
+            mipViews.push_back(&image.GetView(mipViewInfo));
+        }
+
+        // one counter per layer to find the last workgroup, and the sixth level of each tile for it to reduce,
+        // which are only destroyed once the frame is no longer in flight so they only need to live until recorded
+        StorageBuffer counters(layers * sizeof(uint32_t));
+        StorageBuffer intermediate(layers * TILE_SIZE * TILE_SIZE * sizeof(float) * 4);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // free the descriptor sets used by frames which have completed
+        auto completed = eastl::remove_if(m_descriptorSets.begin(), m_descriptorSets.end(), [&frame](const eastl::pair<uint64_t, eastl::unique_ptr<DescriptorSet>>& descriptorSet)
+        {
+            return descriptorSet.first + RendererConfig::MAX_FRAMES_IN_FLIGHT <= frame;
+        });
+        m_descriptorSets.erase(completed, m_descriptorSets.end());
+
+        auto& pipeline = GetPipeline(storageFormat != format);
+        auto descriptorSet = eastl::make_unique<DescriptorSet>(pipeline);
+
+        // sampling between four texels with a linear filter gives their average
+        VkDescriptorImageInfo sourceInfo = {};
+        sourceInfo.sampler = Renderer::Get()->GetSamplerCache()->GetStockSampler(StockSampler::LinearClamp).GetSampler();
+        sourceInfo.imageView = sourceView.GetView();
+        sourceInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        // every element of the array is given a view, but only those for existing levels are written to
+        eastl::array<VkDescriptorImageInfo, MAX_LEVELS> mipInfos = {};
+        for (uint32_t i = 0; i < MAX_LEVELS; i++)
+        {
+            mipInfos[i].sampler = VK_NULL_HANDLE;
+            mipInfos[i].imageView = mipViews[eastl::min<size_t>(i, mipViews.size() - 1)]->GetView();
+            mipInfos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        }
+
+        auto countersWrite = counters.GetWriteDescriptor(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, eastl::nullopt);
+        auto intermediateWrite = intermediate.GetWriteDescriptor(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, eastl::nullopt);
+
+        eastl::vector<VkWriteDescriptorSet> descriptorWrites(4);
+
+        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[0].dstBinding = 0;
+        descriptorWrites[0].descriptorCount = 1;
+        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[0].pImageInfo = &sourceInfo;
+
+        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[1].dstBinding = 1;
+        descriptorWrites[1].descriptorCount = MAX_LEVELS;
+        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        descriptorWrites[1].pImageInfo = mipInfos.data();
+
+        descriptorWrites[2] = countersWrite.GetWriteDescriptorSet();
+        descriptorWrites[3] = intermediateWrite.GetWriteDescriptorSet();
+
+        for (auto& descriptorWrite : descriptorWrites)
+        {
+            descriptorWrite.dstSet = descriptorSet->GetDescriptorSet();
+        }
+
+        descriptorSet->Update(descriptorWrites);
+
+        vkCmdFillBuffer(commandBuffer, counters.GetBuffer(), 0, VK_WHOLE_SIZE, 0);
+
+        // each layer of the base level is read by the shader from the layout it was left in, while the contents
+        // of the other levels are discarded
+        eastl::vector<VkImageMemoryBarrier> imageBarriers(layers + 1);
+        for (auto& barrier : imageBarriers)
+        {
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = image.GetImage();
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+
+        for (uint32_t layer = 0; layer < layers; layer++)
+        {
+            auto& barrier = imageBarriers[layer];
+            barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.oldLayout = image.GetSubresourceLayout(0, layer);
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            barrier.subresourceRange.baseMipLevel = 0;
+            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.baseArrayLayer = layer;
+            barrier.subresourceRange.layerCount = 1;
+        }
+
+        auto& mipBarrier = imageBarriers[layers];
+        mipBarrier.srcAccessMask = 0;
+        mipBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        mipBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        mipBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        mipBarrier.subresourceRange.baseMipLevel = 1;
+        mipBarrier.subresourceRange.levelCount = levels - 1;
+        mipBarrier.subresourceRange.baseArrayLayer = 0;
+        mipBarrier.subresourceRange.layerCount = layers;
+
+        VkMemoryBarrier memoryBarrier = {};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        // the base level may have been written by any earlier work, and is made visible to every later stage
+        // since it is not part of the final barrier
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            1, &memoryBarrier,
+            0, nullptr,
+            static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+        );
+
+        PushDownsample push = {};
+        push.size[0] = extent.width;
+        push.size[1] = extent.height;
+        push.texelSize[0] = 1.0f / extent.width;
+        push.texelSize[1] = 1.0f / extent.height;
+        push.mipCount = levels - 1;
+        push.workGroupCount = groupsX * groupsY;
+
+        pipeline.BindPipeline(commandBuffer);
+        descriptorSet->BindDescriptor(commandBuffer);
+        vkCmdPushConstants(commandBuffer, pipeline.GetPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushDownsample), &push);
+        vkCmdDispatch(commandBuffer, groupsX, groupsY, layers);
+
+        // the generated levels are left ready to sample, the same as after a blit
+        mipBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        mipBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        mipBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        mipBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &mipBarrier
+        );
+
+        for (uint32_t layer = 0; layer < layers; layer++)
+        {
+            for (uint32_t level = 0; level < levels; level++)
+            {
+                image.SetSubresourceLayout(level, layer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            }
+        }
+
+        m_descriptorSets.emplace_back(frame, eastl::move(descriptorSet));
+        return true;
+    }
+
+    const PipelineCompute& MipGenerator::GetPipeline(const bool& srgb)
+    {
+        auto& pipeline = m_pipelines[srgb ? 1 : 0];
+
+        // pipelines are created on first use so the shader is only compiled when needed
+        if (pipeline == nullptr)
+        {
+            pipeline = eastl::make_unique<PipelineCompute>(DOWNSAMPLE_SHADER, eastl::vector<Shader::Define>(), false, SpecializationConstants().Set("SRGB", srgb));
+        }
+
+        return *pipeline;
+    }
+}
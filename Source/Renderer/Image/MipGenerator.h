@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include "Image.h"
+#include "Renderer/Commands/CommandBuffer.h"
+#include "Renderer/Descriptor/DescriptorSet.h"
+#include "Renderer/Pipeline/ComputePipeline.h"
+
+namespace Mantis
+{
+    /// <summary>
+    /// Generates the mip maps of images using a compute shader.
+    /// </summary>
+    /// <remarks>
+    /// All the levels are written by a single dispatch, instead of a blit and a pair of barriers for
+    /// each level. sRGB images are filtered in linear space, which requires them to be created with
+    /// mutable format and extended usage so the levels can be written through UNORM storage views.
+    /// </remarks>
+    class MipGenerator :
+        public NonCopyable
+    {
+    public:
+        /// <summary>
+        /// The largest number of levels that can be generated, not including the base level.
+        /// </summary>
+        static const uint32_t MAX_LEVELS = 12;
+
+        MipGenerator();
+
+        /// <summary>
+        /// Checks if an image can have its mip maps generated using compute. Images larger than 4096 texels
+        /// in either dimension are not supported.
+        /// </summary>
+        /// <param name="image">The image to check.</param>
+        bool IsSupported(const Image& image) const;
+
+        /// <summary>
+        /// Records the generation of the mip maps for an image. The base level is read from the layouts tracked by
+        /// the image, and all levels are left in the shader read only layout, which is written back to the image.
+        /// The command buffer must be submitted before the end of the frame. Must be called on the render thread.
+        /// </summary>
+        /// <param name="commandBuffer">The command buffer to record to.</param>
+        /// <param name="image">The image to generate the mip maps for.</param>
+        /// <returns>False if compute generation is not supported for the image, in which case nothing is recorded.</returns>
+        bool Generate(const CommandBuffer& commandBuffer, Image& image);
+
+    private:
+        /// <summary>
+        /// The size of the region of the base level reduced by each workgroup.
+        /// </summary>
+        static const uint32_t TILE_SIZE = 64;
+
+        struct PushDownsample
+        {
+            uint32_t size[2];
+            float texelSize[2];
+            uint32_t mipCount;
+            uint32_t workGroupCount;
+        };
+
+        const PipelineCompute& GetPipeline(const bool& srgb);
+
+        std::mutex m_mutex;
+        eastl::unique_ptr<PipelineCompute> m_pipelines[2];
+        eastl::vector<eastl::pair<uint64_t, eastl::unique_ptr<DescriptorSet>>> m_descriptorSets;
+    };
+}
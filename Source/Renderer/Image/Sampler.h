@@ -23,6 +23,31 @@ namespace Mantis
         float maxLod;
         VkBorderColor borderColor;
         VkBool32 unnormalizedCoordinates;
+
+        bool operator == (const SamplerCreateInfo& other) const
+        {
+            return
+                magFilter == other.magFilter &&
+                minFilter == other.minFilter &&
+                mipmapMode == other.mipmapMode &&
+                addressModeU == other.addressModeU &&
+                addressModeV == other.addressModeV &&
+                addressModeW == other.addressModeW &&
+                mipLodBias == other.mipLodBias &&
+                anisotropyEnable == other.anisotropyEnable &&
+                maxAnisotropy == other.maxAnisotropy &&
+                compareEnable == other.compareEnable &&
+                compareOp == other.compareOp &&
+                minLod == other.minLod &&
+                maxLod == other.maxLod &&
+                borderColor == other.borderColor &&
+                unnormalizedCoordinates == other.unnormalizedCoordinates;
+        }
+
+        bool operator != (const SamplerCreateInfo& other) const
+        {
+            return !(*this == other);
+        }
     };
 
     /// <summary>
@@ -0,0 +1,156 @@
+#include "stdafx.h"
+#include "SamplerCache.h"
+
+#include "Renderer/Renderer.h"
+
+#define LOG_TAG MANTIS_TEXT("SamplerCache")
+
+namespace Mantis
+{
+    static const char* STOCK_SAMPLER_NAMES[] =
+    {
+        "NearestClamp",
+        "LinearClamp",
+        "TrilinearClamp",
+        "NearestWrap",
+        "LinearWrap",
+        "TrilinearWrap",
+        "AnisotropicWrap",
+        "LinearShadow",
+    };
+
+    static_assert(eastl::size(STOCK_SAMPLER_NAMES) == static_cast<size_t>(StockSampler::Count), "Every stock sampler must have a name!");
+
+    SamplerCache::SamplerCache()
+    {
+        for (size_t i = 0; i < m_stockSamplers.size(); i++)
+        {
+            m_stockSamplers[i] = Get(GetStockSamplerInfo(static_cast<StockSampler>(i)));
+            m_stockSamplers[i]->SetName(STOCK_SAMPLER_NAMES[i]);
+        }
+    }
+
+    eastl::shared_ptr<Sampler> SamplerCache::Get(const SamplerCreateInfo& createInfo)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_samplers.find(createInfo);
+
+        if (it != m_samplers.end())
+        {
+            if (auto sampler = it->second.lock())
+            {
+                return sampler;
+            }
+        }
+
+        // samplers are only destroyed once released, so drop any entries for samplers which no longer exist
+        for (auto entry = m_samplers.begin(); entry != m_samplers.end();)
+        {
+            entry = entry->second.expired() ? m_samplers.erase(entry) : eastl::next(entry);
+        }
+
+        auto sampler = eastl::make_shared<Sampler>(createInfo);
+        m_samplers[createInfo] = sampler;
+        return sampler;
+    }
+
+    SamplerCreateInfo SamplerCache::GetStockSamplerInfo(const StockSampler& sampler)
+    {
+        SamplerCreateInfo info = {};
+        info.magFilter = VK_FILTER_LINEAR;
+        info.minFilter = VK_FILTER_LINEAR;
+        info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        info.mipLodBias = 0.0f;
+        info.anisotropyEnable = VK_FALSE;
+        info.maxAnisotropy = 1.0f;
+        info.compareEnable = VK_FALSE;
+        info.compareOp = VK_COMPARE_OP_NEVER;
+        info.minLod = 0.0f;
+        info.maxLod = VK_LOD_CLAMP_NONE;
+        info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+        info.unnormalizedCoordinates = VK_FALSE;
+
+        switch (sampler)
+        {
+            case StockSampler::NearestClamp:
+            case StockSampler::LinearClamp:
+            case StockSampler::TrilinearClamp:
+            case StockSampler::LinearShadow:
+                info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                break;
+            default:
+                break;
+        }
+
+        switch (sampler)
+        {
+            case StockSampler::NearestClamp:
+            case StockSampler::NearestWrap:
+                info.magFilter = VK_FILTER_NEAREST;
+                info.minFilter = VK_FILTER_NEAREST;
+                info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+                break;
+            case StockSampler::LinearClamp:
+            case StockSampler::LinearWrap:
+                info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+                break;
+            case StockSampler::AnisotropicWrap:
+                info.anisotropyEnable = VK_TRUE;
+                info.maxAnisotropy = 16.0f;
+                break;
+            case StockSampler::LinearShadow:
+                info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+                info.compareEnable = VK_TRUE;
+                info.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+                break;
+            default:
+                break;
+        }
+
+        return info;
+    }
+
+    size_t SamplerCache::CreateInfoHash::operator()(const SamplerCreateInfo& createInfo) const
+    {
+        size_t hash = 0;
+
+        auto combine = [&hash](const size_t& value)
+        {
+            hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        };
+
+        // floats are hashed by their bits, which keeps negative values such as a lod bias distinct, with
+        // negative zero folded into zero since they compare equal
+        auto combineFloat = [&combine](const float& value)
+        {
+            auto folded = value == 0.0f ? 0.0f : value;
+            uint32_t bits;
+            memcpy(&bits, &folded, sizeof(bits));
+            combine(eastl::hash<uint32_t>()(bits));
+        };
+
+        combine(eastl::hash<uint32_t>()(createInfo.magFilter));
+        combine(eastl::hash<uint32_t>()(createInfo.minFilter));
+        combine(eastl::hash<uint32_t>()(createInfo.mipmapMode));
+        combine(eastl::hash<uint32_t>()(createInfo.addressModeU));
+        combine(eastl::hash<uint32_t>()(createInfo.addressModeV));
+        combine(eastl::hash<uint32_t>()(createInfo.addressModeW));
+        combineFloat(createInfo.mipLodBias);
+        combine(eastl::hash<uint32_t>()(createInfo.anisotropyEnable));
+        combineFloat(createInfo.maxAnisotropy);
+        combine(eastl::hash<uint32_t>()(createInfo.compareEnable));
+        combine(eastl::hash<uint32_t>()(createInfo.compareOp));
+        combineFloat(createInfo.minLod);
+        combineFloat(createInfo.maxLod);
+        combine(eastl::hash<uint32_t>()(createInfo.borderColor));
+        combine(eastl::hash<uint32_t>()(createInfo.unnormalizedCoordinates));
+
+        return hash;
+    }
+}
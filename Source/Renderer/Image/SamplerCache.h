@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include "Sampler.h"
+
+namespace Mantis
+{
+    /// <summary>
+    /// Commonly used samplers which always exist.
+    /// </summary>
+    enum struct StockSampler
+    {
+        NearestClamp,
+        LinearClamp,
+        TrilinearClamp,
+        NearestWrap,
+        LinearWrap,
+        TrilinearWrap,
+        AnisotropicWrap,
+        LinearShadow,
+        Count,
+    };
+
+    /// <summary>
+    /// Shares samplers between everything that uses the same sampler settings.
+    /// </summary>
+    /// <remarks>
+    /// Devices limit how many samplers may exist at once, often to around 4000, so samplers should
+    /// be obtained from here instead of being created for every image. A sampler is destroyed once
+    /// nothing references it. The stock samplers can also be baked into descriptor set layouts as
+    /// immutable samplers by listing the combined image sampler with its stock sampler when creating
+    /// a pipeline, in which case the sampler never needs to be written.
+    /// </remarks>
+    class SamplerCache :
+        public NonCopyable
+    {
+    public:
+        SamplerCache();
+
+        /// <summary>
+        /// Gets a sampler with the given settings, creating it if no matching sampler exists. Thread safe.
+        /// </summary>
+        /// <param name="createInfo">The sampler settings.</param>
+        eastl::shared_ptr<Sampler> Get(const SamplerCreateInfo& createInfo);
+
+        /// <summary>
+        /// Gets a stock sampler.
+        /// </summary>
+        /// <param name="sampler">The stock sampler to get.</param>
+        const Sampler& GetStockSampler(const StockSampler& sampler) const { return *m_stockSamplers[static_cast<size_t>(sampler)]; }
+
+        /// <summary>
+        /// Gets the settings used by a stock sampler.
+        /// </summary>
+        /// <param name="sampler">The stock sampler to get the settings for.</param>
+        static SamplerCreateInfo GetStockSamplerInfo(const StockSampler& sampler);
+
+    private:
+        struct CreateInfoHash
+        {
+            size_t operator()(const SamplerCreateInfo& createInfo) const;
+        };
+
+        std::mutex m_mutex;
+        eastl::unordered_map<SamplerCreateInfo, eastl::weak_ptr<Sampler>, CreateInfoHash> m_samplers;
+
+        eastl::array<eastl::shared_ptr<Sampler>, static_cast<size_t>(StockSampler::Count)> m_stockSamplers;
+    };
+}
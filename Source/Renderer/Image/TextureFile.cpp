@@ -0,0 +1,376 @@
+#include "stdafx.h"
+#include "TextureFile.h"
+
+#include "Renderer/Renderer.h"
+#include "Renderer/Image/BlockDecoder.h"
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+#define LOG_TAG MANTIS_TEXT("TextureFile")
+
+namespace Mantis
+{
+    static const uint8_t IDENTIFIER[12] = { 0xAB, 'M', 'T', 'X', ' ', '1', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    /// <summary>
+    /// The alignment of the level data in the file, which is large enough for any texel block.
+    /// </summary>
+    static const uint64_t LEVEL_ALIGNMENT = 16;
+
+    /// <summary>
+    /// The number of worker threads currently decoding levels, shared by every upload so concurrent uploads
+    /// don't start more threads than there are cores.
+    /// </summary>
+    static std::atomic<uint32_t> s_decodeWorkers{ 0 };
+
+    /// <summary>
+    /// Reserves up to the given number of decode workers, without exceeding one less than the number of cores.
+    /// </summary>
+    /// <param name="count">The number of workers wanted.</param>
+    /// <returns>The number of workers reserved, which may be zero if all are busy.</returns>
+    static uint32_t ReserveDecodeWorkers(const uint32_t& count)
+    {
+        auto maxWorkers = eastl::max(std::thread::hardware_concurrency(), 2u) - 1;
+        auto current = s_decodeWorkers.load();
+
+        while (true)
+        {
+            auto reserved = eastl::min(count, maxWorkers - eastl::min(current, maxWorkers));
+
+            if (reserved == 0 || s_decodeWorkers.compare_exchange_weak(current, current + reserved))
+            {
+                return reserved;
+            }
+        }
+    }
+
+    static_assert(sizeof(TextureFileHeader) == 48, "The texture file header must be tightly packed!");
+    static_assert(sizeof(TextureFileLevel) == 16, "The texture file level index must be tightly packed!");
+
+    TextureFile::TextureFile() :
+        m_header(),
+        m_imageFormat(VK_FORMAT_UNDEFINED)
+    {
+    }
+
+    bool TextureFile::Open(const PathRoot& root, const String& path)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_path = path;
+        m_file = Filesystem::Open(root, path, FileMode::Read);
+
+        if (m_file == nullptr)
+        {
+            return false;
+        }
+
+        auto header = reinterpret_cast<uint8_t*>(&m_header);
+
+        if (!m_file->Read(header, sizeof(m_header), sizeof(m_header)))
+        {
+            Logger::ErrorTF(LOG_TAG, "Failed to read header of texture \"%s\"!", m_path.c_str());
+            return false;
+        }
+        if (memcmp(m_header.identifier, IDENTIFIER, sizeof(IDENTIFIER)) != 0)
+        {
+            Logger::ErrorTF(LOG_TAG, "\"%s\" is not a supported texture file!", m_path.c_str());
+            return false;
+        }
+        if (m_header.width == 0 || m_header.height == 0 || m_header.depth == 0 ||
+            m_header.layerCount == 0 || (m_header.faceCount != 1 && m_header.faceCount != 6) ||
+            m_header.levelCount == 0 || m_header.levelCount > Image::NumMipLevels(GetExtent()))
+        {
+            Logger::ErrorTF(LOG_TAG, "Texture \"%s\" has an invalid header!", m_path.c_str());
+            return false;
+        }
+
+        m_levels.resize(m_header.levelCount);
+
+        auto levels = reinterpret_cast<uint8_t*>(m_levels.data());
+        auto levelsSize = static_cast<int>(m_levels.size() * sizeof(TextureFileLevel));
+
+        if (!m_file->Read(levels, levelsSize, levelsSize))
+        {
+            Logger::ErrorTF(LOG_TAG, "Failed to read level index of texture \"%s\"!", m_path.c_str());
+            return false;
+        }
+
+        for (uint32_t level = 0; level < m_header.levelCount; level++)
+        {
+            auto size = Image::GetSize(GetLevelExtent(level), GetFormat()) * GetLayerCount();
+
+            if (size == 0 || m_levels[level].size != size || m_levels[level].offset % LEVEL_ALIGNMENT != 0)
+            {
+                Logger::ErrorTF(LOG_TAG, "Texture \"%s\" has an invalid entry for level %u!", m_path.c_str(), level);
+                return false;
+            }
+        }
+
+        // fall back to decoding formats which can't be sampled
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(*Renderer::Get()->GetPhysicalDevice(), GetFormat(), &formatProperties);
+
+        if (HAS_FLAGS(formatProperties.optimalTilingFeatures, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+        {
+            m_imageFormat = GetFormat();
+        }
+        else if (BlockDecoder::IsSupported(GetFormat()))
+        {
+            Logger::WarningTF(LOG_TAG, "Format %u of texture \"%s\" is not supported by the device and will be decoded!", m_header.format, m_path.c_str());
+            m_imageFormat = BlockDecoder::GetDecodedFormat(GetFormat());
+        }
+        else
+        {
+            Logger::ErrorTF(LOG_TAG, "Format %u of texture \"%s\" is not supported by the device!", m_header.format, m_path.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    bool TextureFile::ReadLevel(const uint32_t& level, eastl::vector<uint8_t>& data)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_file == nullptr || level >= m_levels.size())
+        {
+            Logger::ErrorTF(LOG_TAG, "Cannot read level %u of texture \"%s\"!", level, m_path.c_str());
+            return false;
+        }
+
+        auto size = static_cast<int>(m_levels[level].size);
+        data.resize(size);
+
+        if (!m_file->Seek(SeekMode::Start, static_cast<long>(m_levels[level].offset)) || !m_file->Read(data.data(), size, size))
+        {
+            Logger::ErrorTF(LOG_TAG, "Failed to read level %u of texture \"%s\"!", level, m_path.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    uint64_t TextureFile::Upload(Image& image, const uint32_t& baseLevel, const StreamPriority& priority)
+    {
+        if (baseLevel >= m_header.levelCount)
+        {
+            Logger::ErrorTF(LOG_TAG, "Cannot upload from level %u, texture \"%s\" only has %u levels!", baseLevel, m_path.c_str(), m_header.levelCount);
+            return 0;
+        }
+
+        auto levelCount = m_header.levelCount - baseLevel;
+        auto layerCount = GetLayerCount();
+
+        if (image.GetFormat() != m_imageFormat || image.GetLayerCount() != layerCount || image.GetLevelCount() < levelCount)
+        {
+            Logger::ErrorTF(LOG_TAG, "Image is not compatible with texture \"%s\"!", m_path.c_str());
+            return 0;
+        }
+
+        // the base level is copied to the first level of the image, so they must be the same size
+        auto baseExtent = GetLevelExtent(baseLevel);
+        const auto& imageExtent = image.GetExtents();
+
+        if (imageExtent.width != baseExtent.width || imageExtent.height != baseExtent.height || imageExtent.depth != baseExtent.depth)
+        {
+            Logger::ErrorTF(LOG_TAG, "Image is %ux%ux%u but level %u of texture \"%s\" is %ux%ux%u!", imageExtent.width, imageExtent.height, imageExtent.depth,
+                baseLevel, m_path.c_str(), baseExtent.width, baseExtent.height, baseExtent.depth);
+            return 0;
+        }
+
+        // read the smallest levels first, since they are stored first
+        eastl::vector<eastl::vector<uint8_t>> levels(levelCount);
+
+        for (uint32_t i = levelCount; i-- > 0;)
+        {
+            if (!ReadLevel(baseLevel + i, levels[i]))
+            {
+                return 0;
+            }
+        }
+
+        if (m_imageFormat != GetFormat())
+        {
+            // each layer of each level is decoded separately, largest first, by a bounded number of workers
+            eastl::vector<eastl::vector<uint8_t>> decoded(levelCount * layerCount);
+            std::atomic<uint32_t> next{ 0 };
+
+            auto decode = [this, &levels, &decoded, &next, baseLevel, layerCount]()
+            {
+                for (auto job = next++; job < decoded.size(); job = next++)
+                {
+                    auto level = job / layerCount;
+                    auto layer = job % layerCount;
+                    auto layerSize = levels[level].size() / layerCount;
+                    decoded[job] = BlockDecoder::Decode(levels[level].data() + layer * layerSize, GetLevelExtent(baseLevel + level), GetFormat(), 1);
+                }
+            };
+
+            // the calling thread decodes too, so the upload makes progress even when every worker is busy
+            auto workerCount = ReserveDecodeWorkers(static_cast<uint32_t>(decoded.size()) - 1);
+            eastl::vector<std::future<void>> workers;
+
+            for (uint32_t i = 0; i < workerCount; i++)
+            {
+                workers.push_back(std::async(std::launch::async, decode));
+            }
+
+            decode();
+
+            for (auto& worker : workers)
+            {
+                worker.get();
+            }
+
+            s_decodeWorkers -= workerCount;
+
+            for (uint32_t level = 0; level < levelCount; level++)
+            {
+                levels[level].clear();
+
+                for (uint32_t layer = 0; layer < layerCount; layer++)
+                {
+                    const auto& layerData = decoded[level * layerCount + layer];
+                    levels[level].insert(levels[level].end(), layerData.begin(), layerData.end());
+                }
+            }
+        }
+
+        // the file stores each level with all its layers, while images are set one layer at a time
+        size_t size = 0;
+        for (const auto& level : levels)
+        {
+            size += level.size();
+        }
+
+        eastl::vector<uint8_t> contents;
+        contents.reserve(size);
+
+        for (uint32_t layer = 0; layer < layerCount; layer++)
+        {
+            for (const auto& level : levels)
+            {
+                auto layerSize = level.size() / layerCount;
+                auto layerData = level.data() + layer * layerSize;
+                contents.insert(contents.end(), layerData, layerData + layerSize);
+            }
+        }
+
+        return image.SetContents(contents.data(), 0, levelCount, 0, layerCount, priority);
+    }
+
+    bool TextureFile::Save(
+        const PathRoot& root,
+        const String& path,
+        const uint8_t* contents,
+        const VkFormat& format,
+        const VkExtent3D& extent,
+        const uint32_t& levelCount,
+        const uint32_t& layerCount,
+        const bool& isCube)
+    {
+        if (levelCount == 0 || levelCount > Image::NumMipLevels(extent) || layerCount == 0 || (isCube && layerCount % 6 != 0))
+        {
+            Logger::ErrorTF(LOG_TAG, "Cannot save texture \"%s\" with %u levels and %u layers!", path.c_str(), levelCount, layerCount);
+            return false;
+        }
+
+        TextureFileHeader header = {};
+        memcpy(header.identifier, IDENTIFIER, sizeof(IDENTIFIER));
+        header.format = static_cast<uint32_t>(format);
+        header.width = extent.width;
+        header.height = extent.height;
+        header.depth = extent.depth;
+        header.faceCount = isCube ? 6 : 1;
+        header.layerCount = layerCount / header.faceCount;
+        header.levelCount = levelCount;
+
+        // find where each level of a layer starts in the contents
+        eastl::vector<VkDeviceSize> layerSizes(levelCount);
+        eastl::vector<VkDeviceSize> layerOffsets(levelCount);
+        VkDeviceSize layerStride = 0;
+
+        for (uint32_t level = 0; level < levelCount; level++)
+        {
+            VkExtent3D levelExtent =
+            {
+                eastl::max(extent.width >> level, 1u),
+                eastl::max(extent.height >> level, 1u),
+                eastl::max(extent.depth >> level, 1u),
+            };
+
+            layerSizes[level] = Image::GetSize(levelExtent, format);
+            layerOffsets[level] = layerStride;
+            layerStride += layerSizes[level];
+
+            if (layerSizes[level] == 0)
+            {
+                return false;
+            }
+        }
+
+        // the level data follows the index, with the smallest level first
+        eastl::vector<TextureFileLevel> levels(levelCount);
+        uint64_t offset = sizeof(TextureFileHeader) + levelCount * sizeof(TextureFileLevel);
+
+        for (uint32_t level = levelCount; level-- > 0;)
+        {
+            offset = (offset + LEVEL_ALIGNMENT - 1) & ~(LEVEL_ALIGNMENT - 1);
+
+            levels[level].offset = offset;
+            levels[level].size = layerSizes[level] * layerCount;
+            offset += levels[level].size;
+        }
+
+        auto file = Filesystem::Open(root, path, FileMode::Overwrite);
+
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        auto headerData = reinterpret_cast<const uint8_t*>(&header);
+        auto levelsData = reinterpret_cast<const uint8_t*>(levels.data());
+        auto levelsSize = static_cast<int>(levels.size() * sizeof(TextureFileLevel));
+
+        bool success = file->Write(headerData, sizeof(header), sizeof(header)) && file->Write(levelsData, levelsSize, levelsSize);
+        uint64_t position = sizeof(TextureFileHeader) + levelsSize;
+
+        static const uint8_t PADDING[LEVEL_ALIGNMENT] = {};
+
+        for (uint32_t level = levelCount; success && level-- > 0;)
+        {
+            auto padding = static_cast<int>(levels[level].offset - position);
+            success = file->Write(PADDING, padding, padding);
+
+            for (uint32_t layer = 0; success && layer < layerCount; layer++)
+            {
+                auto layerData = contents + layer * layerStride + layerOffsets[level];
+                auto layerSize = static_cast<int>(layerSizes[level]);
+                success = file->Write(layerData, layerSize, layerSize);
+            }
+
+            position = levels[level].offset + levels[level].size;
+        }
+
+        if (!success)
+        {
+            Logger::ErrorTF(LOG_TAG, "Failed to write texture \"%s\"!", path.c_str());
+        }
+
+        return success;
+    }
+
+    VkExtent3D TextureFile::GetLevelExtent(const uint32_t& level) const
+    {
+        return
+        {
+            eastl::max(m_header.width >> level, 1u),
+            eastl::max(m_header.height >> level, 1u),
+            eastl::max(m_header.depth >> level, 1u),
+        };
+    }
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include "Image.h"
+#include "IO/Filesystem.h"
+
+namespace Mantis
+{
+    /// <summary>
+    /// The header at the start of a texture file.
+    /// </summary>
+    struct TextureFileHeader
+    {
+        /// <summary>
+        /// Identifies the file as a texture file and the version of the container.
+        /// </summary>
+        uint8_t identifier[12];
+        /// <summary>
+        /// The format of the texel data.
+        /// </summary>
+        uint32_t format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t depth;
+        /// <summary>
+        /// The number of array layers, not including cube faces.
+        /// </summary>
+        uint32_t layerCount;
+        /// <summary>
+        /// Six for cube maps, otherwise one.
+        /// </summary>
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t reserved[2];
+    };
+
+    /// <summary>
+    /// Locates a mip level in a texture file.
+    /// </summary>
+    struct TextureFileLevel
+    {
+        /// <summary>
+        /// The offset of the level from the start of the file in bytes.
+        /// </summary>
+        uint64_t offset;
+        /// <summary>
+        /// The size of the level, including every layer and face.
+        /// </summary>
+        uint64_t size;
+    };
+
+    /// <summary>
+    /// Reads textures stored in the engine texture container.
+    /// </summary>
+    /// <remarks>
+    /// The layout follows KTX2. The header is followed by an index with an entry for each level, largest
+    /// first, while the level data is stored smallest first so a partial read gets the low resolution
+    /// levels. Each level holds all of its layers and faces one after another in the layout expected by
+    /// vkCmdCopyBufferToImage, and starts on a 16 byte boundary, so a mapped file can be used without
+    /// copying. Textures are expected to be block compressed, which takes a quarter to an eighth of the
+    /// memory and upload bandwidth of RGBA8. Formats the device cannot sample are decoded when loaded.
+    /// </remarks>
+    class TextureFile :
+        public NonCopyable
+    {
+    public:
+        TextureFile();
+
+        /// <summary>
+        /// Opens a texture file, reading the header and level index. The level data is only read when uploaded.
+        /// </summary>
+        /// <param name="root">The folder to get the absolute path for.</param>
+        /// <param name="path">The relative file path under the folder root.</param>
+        /// <returns>True if the file is a valid texture file.</returns>
+        bool Open(const PathRoot& root, const String& path);
+
+        /// <summary>
+        /// Gets the format the texel data is stored in.
+        /// </summary>
+        VkFormat GetFormat() const { return static_cast<VkFormat>(m_header.format); }
+
+        /// <summary>
+        /// Gets the format the image the texture is uploaded to must be created with. This is the stored
+        /// format if the device can sample it, otherwise the format it is decoded to.
+        /// </summary>
+        const VkFormat& GetImageFormat() const { return m_imageFormat; }
+
+        /// <summary>
+        /// Gets the resolution of the largest level.
+        /// </summary>
+        VkExtent3D GetExtent() const { return { m_header.width, m_header.height, m_header.depth }; }
+
+        /// <summary>
+        /// Gets the number of mip levels.
+        /// </summary>
+        const uint32_t& GetLevelCount() const { return m_header.levelCount; }
+
+        /// <summary>
+        /// Gets the number of image array layers, including cube faces.
+        /// </summary>
+        uint32_t GetLayerCount() const { return m_header.layerCount * m_header.faceCount; }
+
+        /// <summary>
+        /// Gets if the texture is a cube map.
+        /// </summary>
+        bool IsCube() const { return m_header.faceCount == 6; }
+
+        /// <summary>
+        /// Reads the data of a level in the stored format. Thread safe.
+        /// </summary>
+        /// <param name="level">The level to read.</param>
+        /// <param name="data">Returns the level data.</param>
+        /// <returns>True if the level was read successfully.</returns>
+        bool ReadLevel(const uint32_t& level, eastl::vector<uint8_t>& data);
+
+        /// <summary>
+        /// Reads the texture and queues it to be uploaded to an image. Levels which need decoding are decoded
+        /// in parallel, on at most one less worker thread than there are cores across all uploads. Thread safe.
+        /// </summary>
+        /// <param name="image">The image to upload to. Must have the image format, the layer count, the resolution of the base level and a level count of at least the number of levels uploaded.</param>
+        /// <param name="baseLevel">The first level to upload, which is copied to the first level of the image. Skipping the largest levels saves memory on low end devices.</param>
+        /// <param name="priority">The priority of the upload.</param>
+        /// <returns>The streaming request ID, used to check when the upload has completed. Zero if the texture could not be uploaded.</returns>
+        uint64_t Upload(Image& image, const uint32_t& baseLevel = 0, const StreamPriority& priority = StreamPriority::Normal);
+
+        /// <summary>
+        /// Writes a texture file.
+        /// </summary>
+        /// <param name="root">The folder to get the absolute path for.</param>
+        /// <param name="path">The relative file path under the folder root.</param>
+        /// <param name="contents">The texel data, laid out as expected by <see cref="Image::SetContents"/>.</param>
+        /// <param name="format">The format of the texel data.</param>
+        /// <param name="extent">The resolution of the largest level.</param>
+        /// <param name="levelCount">The number of mip levels in the data.</param>
+        /// <param name="layerCount">The number of image array layers in the data, including cube faces.</param>
+        /// <param name="isCube">Are the layers the faces of cube maps.</param>
+        /// <returns>True if the file was written successfully.</returns>
+        static bool Save(
+            const PathRoot& root,
+            const String& path,
+            const uint8_t* contents,
+            const VkFormat& format,
+            const VkExtent3D& extent,
+            const uint32_t& levelCount,
+            const uint32_t& layerCount,
+            const bool& isCube = false
+        );
+
+    private:
+        /// <summary>
+        /// Gets the resolution of a level.
+        /// </summary>
+        /// <param name="level">The mip level.</param>
+        VkExtent3D GetLevelExtent(const uint32_t& level) const;
+
+        std::mutex m_mutex;
+        String m_path;
+        eastl::shared_ptr<FileStream> m_file;
+        TextureFileHeader m_header;
+        eastl::vector<TextureFileLevel> m_levels;
+        VkFormat m_imageFormat;
+    };
+}
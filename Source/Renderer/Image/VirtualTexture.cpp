@@ -0,0 +1,558 @@
+#include "stdafx.h"
+#include "VirtualTexture.h"
+
+#include "Renderer/Renderer.h"
+
+#define LOG_TAG MANTIS_TEXT("VirtualTexture")
+
+namespace Mantis
+{
+    /// <summary>
+    /// Set in page table entries which refer to a resident page.
+    /// </summary>
+    static const uint32_t PAGE_TABLE_VALID = 1u << 31;
+
+    /// <summary>
+    /// The image holding the resident pages.
+    /// </summary>
+    class VirtualTextureAtlas :
+        public Image
+    {
+    public:
+        VirtualTextureAtlas(const VkExtent3D& extent, const VkFormat& format)
+        {
+            Create(
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                0,
+                VK_IMAGE_TYPE_2D,
+                VK_IMAGE_VIEW_TYPE_2D,
+                extent,
+                format,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_SAMPLE_COUNT_1_BIT,
+                1,
+                1,
+                VK_FILTER_LINEAR,
+                VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                false
+            );
+        }
+    };
+
+    static bool IsPowerOfTwo(const uint32_t& value)
+    {
+        return value != 0 && (value & (value - 1)) == 0;
+    }
+
+    VirtualTexture::VirtualTexture(const VirtualTextureCreateInfo& createInfo, PageLoader&& loader) :
+        m_createInfo(createInfo),
+        m_loader(eastl::move(loader)),
+        m_pageCountX(0),
+        m_pageCountY(0),
+        m_levelCount(0),
+        m_pageCount(0),
+        m_tileSize(createInfo.pageSize + 2 * createInfo.border),
+        m_tileBytes(0),
+        m_atlasInitialized(false),
+        m_feedback(eastl::make_shared<Feedback>()),
+        m_pageTableDirty(true)
+    {
+        auto& limits = Renderer::Get()->GetPhysicalDevice()->GetProperties().limits;
+
+        if (!IsPowerOfTwo(createInfo.pageSize) || !IsPowerOfTwo(createInfo.width) || !IsPowerOfTwo(createInfo.height) ||
+            createInfo.width < createInfo.pageSize || createInfo.height < createInfo.pageSize)
+        {
+            Logger::ErrorTF(LOG_TAG, "Virtual texture size %ux%u with page size %u must be powers of two of at least one page!", createInfo.width, createInfo.height, createInfo.pageSize);
+            return;
+        }
+        if (createInfo.atlasPages == 0 || createInfo.atlasPages > 4096 || createInfo.atlasPages * m_tileSize > limits.maxImageDimension2D)
+        {
+            Logger::ErrorTF(LOG_TAG, "Virtual texture atlas of %u pages is not supported!", createInfo.atlasPages);
+            return;
+        }
+
+        m_tileBytes = Image::GetSize({ m_tileSize, m_tileSize, 1 }, createInfo.format);
+
+        if (m_tileBytes == 0)
+        {
+            return;
+        }
+
+        m_pageCountX = createInfo.width / createInfo.pageSize;
+        m_pageCountY = createInfo.height / createInfo.pageSize;
+        m_levelCount = Image::NumMipLevels({ m_pageCountX, m_pageCountY, 1 });
+
+        for (uint32_t level = 0; level < m_levelCount; level++)
+        {
+            m_levelOffsets.push_back(m_pageCount);
+            m_pageCount += eastl::max(m_pageCountX >> level, 1u) * eastl::max(m_pageCountY >> level, 1u);
+        }
+
+        auto coarsestPages = m_pageCount - m_levelOffsets.back();
+        auto slotCount = createInfo.atlasPages * createInfo.atlasPages;
+
+        if (slotCount <= coarsestPages + MAX_PAGE_UPLOADS)
+        {
+            Logger::ErrorTF(LOG_TAG, "Virtual texture atlas of %u pages is too small to hold the %u pages of the coarsest level!", slotCount, coarsestPages);
+            return;
+        }
+
+        VkExtent3D atlasExtent = { createInfo.atlasPages * m_tileSize, createInfo.atlasPages * m_tileSize, 1 };
+        m_atlas = eastl::make_unique<VirtualTextureAtlas>(atlasExtent, createInfo.format);
+        m_atlas->SetName("VirtualTextureAtlas");
+
+        auto pageTableSize = m_pageCount * sizeof(uint32_t);
+        m_pageTable = eastl::make_unique<StorageBuffer>(pageTableSize);
+        m_pageTable->SetName("VirtualTexturePageTable");
+
+        for (uint32_t i = 0; i < RendererConfig::MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            m_feedbackBuffers[i] = eastl::make_unique<StorageBuffer>(pageTableSize, nullptr, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+            m_feedbackBuffers[i]->SetName("VirtualTextureFeedback");
+        }
+
+        m_slots.resize(slotCount);
+        for (uint32_t slot = 0; slot < slotCount; slot++)
+        {
+            m_slots[slot].page = INVALID_INDEX;
+            m_slots[slot].lastUsed = 0;
+            m_slots[slot].pinned = false;
+            m_slots[slot].lru = m_lru.end();
+
+            // allocate from the start of the atlas first
+            m_freeSlots.push_back(slotCount - slot - 1);
+        }
+
+        m_pageSlots.resize(m_pageCount, INVALID_INDEX);
+        m_pageLoading.resize(m_pageCount, false);
+        m_pageTableEntries.resize(m_pageCount, 0);
+
+        // the coarsest level is loaded up front and never evicted
+        for (uint32_t page = m_levelOffsets.back(); page < m_pageCount; page++)
+        {
+            StartLoad(page);
+        }
+    }
+
+    VirtualTexture::~VirtualTexture()
+    {
+        // loads reference the loader, so must finish first
+        for (auto& load : m_loads)
+        {
+            load.data.wait();
+        }
+    }
+
+    void VirtualTexture::Update(const CommandBuffer& commandBuffer)
+    {
+        if (m_atlas == nullptr)
+        {
+            return;
+        }
+
+        auto streamingEngine = Renderer::Get()->GetStreamingEngine();
+        auto frame = Renderer::Get()->GetFrameCount();
+        auto frameIndex = frame % RendererConfig::MAX_FRAMES_IN_FLIGHT;
+
+        // keep the pages sampled in earlier frames resident and find the pages which are missing
+        eastl::vector<uint32_t> requested;
+        {
+            std::lock_guard<std::mutex> lock(m_feedback->mutex);
+            requested.swap(m_feedback->pages);
+        }
+
+        eastl::vector<uint32_t> missing;
+
+        for (auto page : requested)
+        {
+            auto resident = GetResidentPage(page);
+
+            if (resident != INVALID_INDEX)
+            {
+                Touch(m_pageSlots[resident], frame);
+            }
+
+            // the page and any of its ancestors finer than the resident page are all missing
+            auto ancestor = GetPage(page);
+
+            for (auto index = page; index != resident;)
+            {
+                if (!m_pageLoading[index])
+                {
+                    missing.push_back(index);
+                }
+                if (ancestor.level + 1 >= m_levelCount)
+                {
+                    break;
+                }
+
+                ancestor.level++;
+                ancestor.x = eastl::min(ancestor.x >> 1, eastl::max(m_pageCountX >> ancestor.level, 1u) - 1);
+                ancestor.y = eastl::min(ancestor.y >> 1, eastl::max(m_pageCountY >> ancestor.level, 1u) - 1);
+                index = GetPageIndex(ancestor);
+            }
+        }
+
+        // coarser levels have higher indices, and are loaded first so there is a better fallback sooner
+        eastl::sort(missing.begin(), missing.end(), eastl::greater<uint32_t>());
+        missing.erase(eastl::unique(missing.begin(), missing.end()), missing.end());
+
+        for (auto page : missing)
+        {
+            if (m_loads.size() >= MAX_PENDING_LOADS)
+            {
+                break;
+            }
+
+            StartLoad(page);
+        }
+
+        // pages are only made resident once their upload has completed, so the page table never points at a slot still being written
+        for (auto upload = m_uploads.begin(); upload != m_uploads.end();)
+        {
+            if (!streamingEngine->IsComplete(upload->request))
+            {
+                ++upload;
+                continue;
+            }
+
+            m_pageSlots[upload->page] = upload->slot;
+            m_pageLoading[upload->page] = false;
+            Touch(upload->slot, frame);
+            m_pageTableDirty = true;
+
+            upload = m_uploads.erase(upload);
+        }
+
+        // the atlas is made ready to sample before any page is uploaded, since a page upload may not complete for several frames
+        if (!m_atlasInitialized)
+        {
+            m_atlas->TransitionImageLayout(commandBuffer,
+                VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+            );
+
+            m_atlas->SetSubresourceLayout(0, 0, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+
+        // copy the loaded pages into the atlas, only once the frame initializing it has been submitted
+        eastl::vector<uint8_t> pageData;
+        eastl::vector<VkBufferImageCopy> regions;
+        eastl::vector<Upload> uploads;
+
+        for (auto load = m_loads.begin(); m_atlasInitialized && load != m_loads.end() && regions.size() < MAX_PAGE_UPLOADS;)
+        {
+            if (load->data.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                ++load;
+                continue;
+            }
+
+            auto slot = AllocateSlot(frame);
+
+            if (slot == INVALID_INDEX)
+            {
+                // every page is still in use, so the loaded pages stay queued until some are no longer needed
+                break;
+            }
+
+            auto page = load->page;
+            auto data = load->data.get();
+            load = m_loads.erase(load);
+
+            if (data.empty())
+            {
+                // the page is requested again if it is still needed
+                m_pageLoading[page] = false;
+
+                auto p = GetPage(page);
+                Logger::ErrorTF(LOG_TAG, "Failed to load page %u, %u of level %u!", p.x, p.y, p.level);
+                m_freeSlots.push_back(slot);
+                continue;
+            }
+
+            VkBufferImageCopy region = {};
+            region.bufferOffset = pageData.size();
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = 0;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset.x = static_cast<int32_t>((slot % m_createInfo.atlasPages) * m_tileSize);
+            region.imageOffset.y = static_cast<int32_t>((slot / m_createInfo.atlasPages) * m_tileSize);
+            region.imageExtent = { m_tileSize, m_tileSize, 1 };
+            regions.push_back(region);
+
+            pageData.insert(pageData.end(), data.begin(), data.end());
+
+            // the slot is kept out of the LRU list while uploading so it can't be replaced
+            m_slots[slot].page = page;
+            m_slots[slot].pinned = GetPage(page).level == m_levelCount - 1;
+
+            Upload upload = {};
+            upload.page = page;
+            upload.slot = slot;
+            uploads.push_back(upload);
+        }
+
+        // replaced pages are removed from the page table before their slots are overwritten, which the immediate priority
+        // ensures by submitting the table no later than the pages queued after it
+        if (m_pageTableDirty)
+        {
+            BuildPageTable();
+            streamingEngine->Upload(*m_pageTable, m_pageTableEntries.data(), m_pageTableEntries.size() * sizeof(uint32_t), 0, StreamPriority::Immediate);
+            m_pageTableDirty = false;
+        }
+
+        if (!regions.empty())
+        {
+            // staged by the streaming engine, so the uploads count towards the streaming budget
+            auto request = streamingEngine->Upload(*m_atlas, pageData.data(), pageData.size(), regions, StreamPriority::High);
+
+            for (auto& upload : uploads)
+            {
+                if (request == 0)
+                {
+                    // the page is requested again if it is still needed
+                    m_pageLoading[upload.page] = false;
+                    m_slots[upload.slot].page = INVALID_INDEX;
+                    m_freeSlots.push_back(upload.slot);
+                    continue;
+                }
+
+                upload.request = request;
+                m_uploads.push_back(upload);
+            }
+        }
+
+        m_atlasInitialized = true;
+
+        // wait for earlier frames and the readback of the feedback to finish before it is cleared
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            0, nullptr
+        );
+
+        auto& feedbackBuffer = *m_feedbackBuffers[frameIndex];
+        vkCmdFillBuffer(commandBuffer, feedbackBuffer.GetBuffer(), 0, VK_WHOLE_SIZE, 0);
+
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr
+        );
+
+        // the readback is submitted after the frame, so it sees the feedback written by the rendering
+        auto feedback = m_feedback;
+
+        streamingEngine->Readback(feedbackBuffer, feedbackBuffer.GetSize(), 0, [feedback](const void* data, const VkDeviceSize& size)
+        {
+            auto flags = static_cast<const uint32_t*>(data);
+            auto count = static_cast<uint32_t>(size / sizeof(uint32_t));
+
+            std::lock_guard<std::mutex> lock(feedback->mutex);
+
+            for (uint32_t page = 0; page < count; page++)
+            {
+                if (flags[page] != 0)
+                {
+                    feedback->pages.push_back(page);
+                }
+            }
+        }, StreamPriority::High);
+    }
+
+    const StorageBuffer& VirtualTexture::GetFeedbackBuffer() const
+    {
+        return *m_feedbackBuffers[Renderer::Get()->GetFrameCount() % RendererConfig::MAX_FRAMES_IN_FLIGHT];
+    }
+
+    VirtualTextureInfo VirtualTexture::GetInfo(const float& lodBias) const
+    {
+        VirtualTextureInfo info = {};
+        info.pageCount[0] = m_pageCountX;
+        info.pageCount[1] = m_pageCountY;
+        info.levelCount = m_levelCount;
+        info.pageSize = m_createInfo.pageSize;
+        info.border = m_createInfo.border;
+        info.atlasPages = m_createInfo.atlasPages;
+        info.lodBias = lodBias;
+        return info;
+    }
+
+    uint32_t VirtualTexture::GetResidentPageCount() const
+    {
+        return static_cast<uint32_t>(m_slots.size() - m_freeSlots.size());
+    }
+
+    VirtualPage VirtualTexture::GetPage(const uint32_t& index) const
+    {
+        VirtualPage page = {};
+
+        page.level = static_cast<uint32_t>(eastl::upper_bound(m_levelOffsets.begin(), m_levelOffsets.end(), index) - m_levelOffsets.begin()) - 1;
+
+        auto levelIndex = index - m_levelOffsets[page.level];
+        auto levelPagesX = eastl::max(m_pageCountX >> page.level, 1u);
+
+        page.x = levelIndex % levelPagesX;
+        page.y = levelIndex / levelPagesX;
+        return page;
+    }
+
+    uint32_t VirtualTexture::GetPageIndex(const VirtualPage& page) const
+    {
+        return m_levelOffsets[page.level] + page.y * eastl::max(m_pageCountX >> page.level, 1u) + page.x;
+    }
+
+    uint32_t VirtualTexture::GetResidentPage(uint32_t index) const
+    {
+        auto page = GetPage(index);
+
+        // walk up the levels until a resident page is found
+        while (m_pageSlots[index] == INVALID_INDEX)
+        {
+            if (page.level + 1 >= m_levelCount)
+            {
+                return INVALID_INDEX;
+            }
+
+            page.level++;
+            page.x = eastl::min(page.x >> 1, eastl::max(m_pageCountX >> page.level, 1u) - 1);
+            page.y = eastl::min(page.y >> 1, eastl::max(m_pageCountY >> page.level, 1u) - 1);
+            index = GetPageIndex(page);
+        }
+
+        return index;
+    }
+
+    void VirtualTexture::Touch(const uint32_t& slot, const uint64_t& frame)
+    {
+        auto& entry = m_slots[slot];
+        entry.lastUsed = frame;
+
+        if (entry.pinned)
+        {
+            return;
+        }
+
+        // the most recently used pages are at the back
+        if (entry.lru == m_lru.end())
+        {
+            entry.lru = m_lru.insert(m_lru.end(), slot);
+        }
+        else
+        {
+            m_lru.splice(m_lru.end(), m_lru, entry.lru);
+        }
+    }
+
+    uint32_t VirtualTexture::AllocateSlot(const uint64_t& frame)
+    {
+        if (!m_freeSlots.empty())
+        {
+            auto slot = m_freeSlots.back();
+            m_freeSlots.pop_back();
+            return slot;
+        }
+
+        if (m_lru.empty())
+        {
+            return INVALID_INDEX;
+        }
+
+        auto slot = m_lru.front();
+        auto& entry = m_slots[slot];
+
+        // pages used by frames which may still be in flight can't be replaced
+        if (entry.lastUsed + RendererConfig::MAX_FRAMES_IN_FLIGHT >= frame)
+        {
+            return INVALID_INDEX;
+        }
+
+        m_lru.pop_front();
+        entry.lru = m_lru.end();
+
+        m_pageSlots[entry.page] = INVALID_INDEX;
+        entry.page = INVALID_INDEX;
+        m_pageTableDirty = true;
+
+        return slot;
+    }
+
+    void VirtualTexture::StartLoad(const uint32_t& page)
+    {
+        m_pageLoading[page] = true;
+
+        auto loader = m_loader;
+        auto virtualPage = GetPage(page);
+        auto size = m_tileBytes;
+
+        Load load;
+        load.page = page;
+        load.data = std::async(std::launch::async, [loader, virtualPage, size]()
+        {
+            eastl::vector<uint8_t> data;
+
+            if (!loader(virtualPage, data) || data.size() != size)
+            {
+                data.clear();
+            }
+
+            return data;
+        });
+
+        m_loads.push_back(eastl::move(load));
+    }
+
+    void VirtualTexture::BuildPageTable()
+    {
+        // pages which are not resident use the entry of their parent, so fill the table from the coarsest level down
+        for (uint32_t level = m_levelCount; level-- > 0;)
+        {
+            auto levelPagesX = eastl::max(m_pageCountX >> level, 1u);
+            auto levelPagesY = eastl::max(m_pageCountY >> level, 1u);
+
+            for (uint32_t y = 0; y < levelPagesY; y++)
+            {
+                for (uint32_t x = 0; x < levelPagesX; x++)
+                {
+                    auto index = GetPageIndex({ x, y, level });
+                    auto slot = m_pageSlots[index];
+
+                    if (slot != INVALID_INDEX)
+                    {
+                        auto slotX = slot % m_createInfo.atlasPages;
+                        auto slotY = slot / m_createInfo.atlasPages;
+                        m_pageTableEntries[index] = PAGE_TABLE_VALID | (level << 24) | (slotY << 12) | slotX;
+                    }
+                    else if (level + 1 < m_levelCount)
+                    {
+                        VirtualPage parent = {};
+                        parent.level = level + 1;
+                        parent.x = eastl::min(x >> 1, eastl::max(m_pageCountX >> parent.level, 1u) - 1);
+                        parent.y = eastl::min(y >> 1, eastl::max(m_pageCountY >> parent.level, 1u) - 1);
+                        m_pageTableEntries[index] = m_pageTableEntries[GetPageIndex(parent)];
+                    }
+                    else
+                    {
+                        m_pageTableEntries[index] = 0;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include <future>
+
+#include "Image.h"
+#include "Renderer/Buffer/StorageBuffer.h"
+#include "Renderer/Commands/CommandBuffer.h"
+#include "Renderer/RendererConfig.h"
+
+namespace Mantis
+{
+    /// <summary>
+    /// Identifies a page of a virtual texture.
+    /// </summary>
+    struct VirtualPage
+    {
+        uint32_t x;
+        uint32_t y;
+        uint32_t level;
+    };
+
+    /// <summary>
+    /// The creation options for a virtual texture.
+    /// </summary>
+    struct VirtualTextureCreateInfo
+    {
+        /// <summary>
+        /// The resolution of the largest level. Must be powers of two and at least the page size.
+        /// </summary>
+        uint32_t width = 0;
+        uint32_t height = 0;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        /// <summary>
+        /// The width and height of a page in texels, not including the border. Must be a power of two.
+        /// </summary>
+        uint32_t pageSize = 128;
+        /// <summary>
+        /// The number of texels around each page copied from the neighbouring pages, so filtering does not bleed between pages.
+        /// </summary>
+        uint32_t border = 4;
+        /// <summary>
+        /// The number of pages along each side of the physical atlas.
+        /// </summary>
+        uint32_t atlasPages = 32;
+    };
+
+    /// <summary>
+    /// The parameters of a virtual texture used by the shader functions in VirtualTexture.glsl.
+    /// </summary>
+    struct VirtualTextureInfo
+    {
+        uint32_t pageCount[2];
+        uint32_t levelCount;
+        uint32_t pageSize;
+        uint32_t border;
+        uint32_t atlasPages;
+        float lodBias;
+        uint32_t padding;
+    };
+
+    /// <summary>
+    /// A texture too large to keep in memory, which keeps only the pages that are being sampled resident.
+    /// </summary>
+    /// <remarks>
+    /// Shaders sample through a page table which maps each page of every level to a page in a physical
+    /// atlas, falling back to the nearest coarser resident page. While sampling, shaders mark the pages
+    /// they wanted in a feedback buffer, which is read back to the host without stalling. Missing pages are
+    /// loaded on worker threads, coarsest first, and uploaded into the atlas by the streaming engine, replacing
+    /// the least recently used pages. Pages are only added to the page table once their upload has completed.
+    /// The coarsest level is always resident so there is always something to sample.
+    /// </remarks>
+    class VirtualTexture :
+        public NonCopyable
+    {
+    public:
+        /// <summary>
+        /// Loads the texels of a page, including the border, in the format of the texture. Called on
+        /// worker threads, possibly for several pages at once.
+        /// </summary>
+        using PageLoader = eastl::function<bool(const VirtualPage& page, eastl::vector<uint8_t>& data)>;
+
+        /// <summary>
+        /// Creates a new virtual texture.
+        /// </summary>
+        /// <param name="createInfo">The creation options.</param>
+        /// <param name="loader">The function used to load pages.</param>
+        VirtualTexture(const VirtualTextureCreateInfo& createInfo, PageLoader&& loader);
+
+        ~VirtualTexture();
+
+        /// <summary>
+        /// Reads the pages requested by earlier frames, starts loading missing pages and queues the uploads
+        /// of loaded pages into the atlas, then clears the feedback for this frame. Must be called on the render
+        /// thread once per frame, before any use of the texture is recorded.
+        /// </summary>
+        /// <param name="commandBuffer">The graphics command buffer to record to.</param>
+        void Update(const CommandBuffer& commandBuffer);
+
+        /// <summary>
+        /// Gets the atlas of resident pages, sampled by shaders as virtualAtlas, which pipelines should give the
+        /// LinearClamp stock sampler as an immutable sampler.
+        /// </summary>
+        Image& GetAtlas() const { return *m_atlas; }
+
+        /// <summary>
+        /// Gets the page table, which is read by shaders.
+        /// </summary>
+        const StorageBuffer& GetPageTable() const { return *m_pageTable; }
+
+        /// <summary>
+        /// Gets the buffer the current frame writes the pages it wants into, which changes every frame.
+        /// </summary>
+        const StorageBuffer& GetFeedbackBuffer() const;
+
+        /// <summary>
+        /// Gets the parameters used by shaders to sample the texture.
+        /// </summary>
+        /// <param name="lodBias">The bias added to the level of detail chosen for each texel.</param>
+        VirtualTextureInfo GetInfo(const float& lodBias = 0.0f) const;
+
+        /// <summary>
+        /// Gets the number of pages which are resident.
+        /// </summary>
+        uint32_t GetResidentPageCount() const;
+
+    private:
+        /// <summary>
+        /// The maximum number of pages loading at once.
+        /// </summary>
+        static const uint32_t MAX_PENDING_LOADS = 32;
+
+        /// <summary>
+        /// The maximum number of pages queued for upload into the atlas each frame.
+        /// </summary>
+        static const uint32_t MAX_PAGE_UPLOADS = 16;
+
+        static const uint32_t INVALID_INDEX = ~0u;
+
+        struct Slot
+        {
+            uint32_t page;
+            uint64_t lastUsed;
+            bool pinned;
+            eastl::list<uint32_t>::iterator lru;
+        };
+
+        struct Load
+        {
+            uint32_t page;
+            std::future<eastl::vector<uint8_t>> data;
+        };
+
+        /// <summary>
+        /// A page being uploaded into its slot, which is not yet in the page table.
+        /// </summary>
+        struct Upload
+        {
+            uint32_t page;
+            uint32_t slot;
+            uint64_t request;
+        };
+
+        /// <summary>
+        /// The pages requested by read back feedback, shared with the readback callbacks so they
+        /// can outlive the texture.
+        /// </summary>
+        struct Feedback
+        {
+            std::mutex mutex;
+            eastl::vector<uint32_t> pages;
+        };
+
+        VirtualPage GetPage(const uint32_t& index) const;
+        uint32_t GetPageIndex(const VirtualPage& page) const;
+        uint32_t GetResidentPage(uint32_t index) const;
+
+        void Touch(const uint32_t& slot, const uint64_t& frame);
+        uint32_t AllocateSlot(const uint64_t& frame);
+        void StartLoad(const uint32_t& page);
+        void BuildPageTable();
+
+        VirtualTextureCreateInfo m_createInfo;
+        PageLoader m_loader;
+
+        uint32_t m_pageCountX;
+        uint32_t m_pageCountY;
+        uint32_t m_levelCount;
+        uint32_t m_pageCount;
+        uint32_t m_tileSize;
+        VkDeviceSize m_tileBytes;
+        eastl::vector<uint32_t> m_levelOffsets;
+
+        eastl::unique_ptr<Image> m_atlas;
+        bool m_atlasInitialized;
+        eastl::unique_ptr<StorageBuffer> m_pageTable;
+        eastl::array<eastl::unique_ptr<StorageBuffer>, RendererConfig::MAX_FRAMES_IN_FLIGHT> m_feedbackBuffers;
+        eastl::shared_ptr<Feedback> m_feedback;
+
+        eastl::vector<Slot> m_slots;
+        eastl::vector<uint32_t> m_freeSlots;
+        eastl::list<uint32_t> m_lru;
+        eastl::vector<uint32_t> m_pageSlots;
+        eastl::vector<bool> m_pageLoading;
+        eastl::vector<Load> m_loads;
+        eastl::vector<Upload> m_uploads;
+
+        eastl::vector<uint32_t> m_pageTableEntries;
+        bool m_pageTableDirty;
+    };
+}
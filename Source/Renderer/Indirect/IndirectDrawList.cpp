@@ -0,0 +1,205 @@
+#include "stdafx.h"
+#include "IndirectDrawList.h"
+
+#include "Renderer/Renderer.h"
+#include "Renderer/FrameContext.h"
+
+#define LOG_TAG MANTIS_TEXT("IndirectDrawList")
+
+namespace Mantis
+{
+    static const char* CULL_SHADER = "Resources/Shaders/Indirect/Cull.comp";
+
+    IndirectDrawList::IndirectDrawList(const uint32_t& maxDraws)
+        : m_maxDraws(maxDraws)
+        , m_drawCount(0)
+        , m_compact(Renderer::Get()->GetLogicalDevice()->GetCmdDrawIndexedIndirectCount() != nullptr)
+        , m_firstInstance(Renderer::Get()->GetLogicalDevice()->GetEnabledFeatures().drawIndirectFirstInstance)
+        , m_uploadPending(false)
+        , m_draws(maxDraws * sizeof(IndirectDraw), nullptr, VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+        , m_commands(maxDraws * sizeof(VkDrawIndexedIndirectCommand), nullptr, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
+        , m_count(sizeof(uint32_t), nullptr, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
+        , m_drawIndices(maxDraws * sizeof(uint32_t))
+        , m_cullPipeline(CULL_SHADER, {}, false, SpecializationConstants().Set("COMPACT", m_compact).Set("FIRST_INSTANCE", m_firstInstance))
+        , m_descriptorSet(m_cullPipeline)
+    {
+        m_draws.SetName("IndirectDraws");
+        m_commands.SetName("IndirectDrawCommands");
+        m_count.SetName("IndirectDrawCount");
+        m_drawIndices.SetName("IndirectDrawIndices");
+
+        eastl::array<WriteDescriptorSet, 4> writeDescriptors = {
+            m_draws.GetWriteDescriptor(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, eastl::nullopt),
+            m_commands.GetWriteDescriptor(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, eastl::nullopt),
+            m_count.GetWriteDescriptor(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, eastl::nullopt),
+            m_drawIndices.GetWriteDescriptor(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, eastl::nullopt),
+        };
+
+        eastl::vector<VkWriteDescriptorSet> descriptorWrites;
+        for (const auto& writeDescriptor : writeDescriptors)
+        {
+            auto descriptorWrite = writeDescriptor.GetWriteDescriptorSet();
+            descriptorWrite.dstSet = m_descriptorSet.GetDescriptorSet();
+            descriptorWrites.push_back(descriptorWrite);
+        }
+
+        m_descriptorSet.Update(descriptorWrites);
+
+        if (!m_compact)
+        {
+            Logger::InfoT(LOG_TAG, "Draw indirect count is not supported, culled draws will not be compacted.");
+        }
+
+        if (!m_firstInstance)
+        {
+            auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+            if (!logicalDevice->GetEnabledFeatures().multiDrawIndirect || !logicalDevice->GetCapabilities().shaderDrawParameters)
+            {
+                Logger::WarningT(LOG_TAG, "Indirect draws with a first instance, multi draw indirect and shader draw parameters are not all supported, shaders can't identify their draw!");
+            }
+        }
+    }
+
+    void IndirectDrawList::SetDraws(const eastl::vector<IndirectDraw>& draws)
+    {
+        m_drawCount = static_cast<uint32_t>(draws.size());
+
+        if (m_drawCount > m_maxDraws)
+        {
+            Logger::ErrorTF(LOG_TAG, "Cannot add %u draws to a list with space for %u draws!", m_drawCount, m_maxDraws);
+            m_drawCount = m_maxDraws;
+        }
+
+        // frames in flight may still be reading the draws, so they are copied in the next frame's command buffer
+        m_pendingDraws.assign(draws.begin(), draws.begin() + m_drawCount);
+        m_uploadPending = m_drawCount > 0;
+    }
+
+    void IndirectDrawList::Cull(const CommandBuffer& commandBuffer, const Frustum& frustum)
+    {
+        if (m_drawCount == 0)
+        {
+            return;
+        }
+
+        StagingAllocation staging = {};
+
+        if (m_uploadPending)
+        {
+            auto size = m_pendingDraws.size() * sizeof(IndirectDraw);
+            staging = Renderer::Get()->GetFrame().AllocateStaging(size);
+
+            // the draws are left pending and nothing is culled or drawn until they can be uploaded
+            if (staging.data == nullptr)
+            {
+                Logger::ErrorT(LOG_TAG, "Not enough frame staging memory to upload the draws!");
+                return;
+            }
+
+            memcpy(staging.data, m_pendingDraws.data(), size);
+        }
+
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+
+        if (staging.data != nullptr || m_compact)
+        {
+            // the count and draws may still be read by the previous frame's draws before they are overwritten,
+            // and the draws may be read by any shader through GetDrawBuffer
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                staging.data != nullptr ? VK_PIPELINE_STAGE_ALL_COMMANDS_BIT : VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                1, &barrier,
+                0, nullptr,
+                0, nullptr
+            );
+
+            if (staging.data != nullptr)
+            {
+                VkBufferCopy region = {};
+                region.srcOffset = staging.offset;
+                region.size = m_pendingDraws.size() * sizeof(IndirectDraw);
+                vkCmdCopyBuffer(commandBuffer, staging.buffer, m_draws.GetBuffer(), 1, &region);
+
+                m_pendingDraws.clear();
+                m_uploadPending = false;
+            }
+
+            if (m_compact)
+            {
+                vkCmdFillBuffer(commandBuffer, m_count.GetBuffer(), 0, sizeof(uint32_t), 0);
+            }
+        }
+
+        // the commands from the previous cull must be consumed before they are overwritten
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr
+        );
+
+        PushCull push = {};
+        push.frustum = frustum;
+        push.count = m_drawCount;
+
+        m_cullPipeline.BindPipeline(commandBuffer);
+        m_descriptorSet.BindDescriptor(commandBuffer);
+        vkCmdPushConstants(commandBuffer, m_cullPipeline.GetPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushCull), &push);
+        m_cullPipeline.Dispatch(commandBuffer, m_drawCount);
+
+        // make the written commands visible to the indirect draw, and the draws and draw indices to its shaders
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr
+        );
+    }
+
+    void IndirectDrawList::Draw(const CommandBuffer& commandBuffer) const
+    {
+        // nothing was culled while the draws were waiting to be uploaded
+        if (m_drawCount == 0 || m_uploadPending)
+        {
+            return;
+        }
+
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+        auto stride = static_cast<uint32_t>(sizeof(VkDrawIndexedIndirectCommand));
+
+        if (m_compact)
+        {
+            logicalDevice->GetCmdDrawIndexedIndirectCount()(commandBuffer, m_commands.GetBuffer(), 0, m_count.GetBuffer(), 0, m_drawCount, stride);
+        }
+        else if (logicalDevice->GetEnabledFeatures().multiDrawIndirect)
+        {
+            vkCmdDrawIndexedIndirect(commandBuffer, m_commands.GetBuffer(), 0, m_drawCount, stride);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < m_drawCount; i++)
+            {
+                vkCmdDrawIndexedIndirect(commandBuffer, m_commands.GetBuffer(), i * stride, 1, stride);
+            }
+        }
+    }
+}
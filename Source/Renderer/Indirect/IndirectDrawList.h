@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include "Renderer/Buffer/StorageBuffer.h"
+#include "Renderer/Commands/CommandBuffer.h"
+#include "Renderer/Descriptor/DescriptorSet.h"
+#include "Renderer/Pipeline/ComputePipeline.h"
+
+namespace Mantis
+{
+    /// <summary>
+    /// The data describing a single indexed draw, as read by the culling shader.
+    /// </summary>
+    struct IndirectDraw
+    {
+        /// <summary>
+        /// The world space bounds of the draw, with the center in xyz and the radius in w.
+        /// </summary>
+        float boundingSphere[4];
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+        uint32_t padding;
+    };
+
+    /// <summary>
+    /// The planes of a view frustum to cull against. Each plane has an inward facing normal
+    /// in xyz and the distance from the origin in w.
+    /// </summary>
+    struct Frustum
+    {
+        float planes[6][4];
+    };
+
+    /// <summary>
+    /// A list of indexed draws which are frustum culled on the GPU and drawn indirectly,
+    /// so the CPU cost of drawing does not depend on the number of draws.
+    /// </summary>
+    /// <remarks>
+    /// Each draw is recorded with its index in the list as the first instance, which shaders
+    /// can use to find per object data. Devices without drawIndirectFirstInstance must use a
+    /// first instance of zero, so shaders instead read the index from the draw index buffer at
+    /// gl_DrawID, which needs shader draw parameters and multi draw indirect. When the device
+    /// supports draw indirect count the visible draws are compacted, otherwise culled draws are
+    /// issued with no instances. The draws are kept in device local memory and copied through
+    /// the frame's staging memory when they change, so frames in flight never see them change.
+    /// </remarks>
+    class IndirectDrawList :
+        public NonCopyable
+    {
+    public:
+        /// <summary>
+        /// Creates a new indirect draw list.
+        /// </summary>
+        /// <param name="maxDraws">The maximum number of draws the list can hold.</param>
+        explicit IndirectDrawList(const uint32_t& maxDraws);
+
+        /// <summary>
+        /// Gets the maximum number of draws the list can hold.
+        /// </summary>
+        const uint32_t& GetMaxDraws() const { return m_maxDraws; }
+
+        /// <summary>
+        /// Gets the number of draws in the list.
+        /// </summary>
+        const uint32_t& GetDrawCount() const { return m_drawCount; }
+
+        /// <summary>
+        /// Gets the buffer containing the draws, which can be bound for shaders to read.
+        /// </summary>
+        const StorageBuffer& GetDrawBuffer() const { return m_draws; }
+
+        /// <summary>
+        /// Gets the buffer holding the index in the list of each issued draw, in the order the draws are issued.
+        /// Shaders can read it at gl_DrawID when the first instance can't carry the index.
+        /// </summary>
+        const StorageBuffer& GetDrawIndexBuffer() const { return m_drawIndices; }
+
+        /// <summary>
+        /// Gets if each draw is issued with its index in the list as the first instance.
+        /// </summary>
+        const bool& UsesFirstInstance() const { return m_firstInstance; }
+
+        /// <summary>
+        /// Replaces the draws in the list. Only needs to be called when the draws change. The new draws are
+        /// copied to the device by the next <see cref="Cull"/>.
+        /// </summary>
+        /// <param name="draws">The new draws.</param>
+        void SetDraws(const eastl::vector<IndirectDraw>& draws);
+
+        /// <summary>
+        /// Records the upload of any changed draws and the culling of the draws. Must be recorded outside of
+        /// a render pass, in a graphics command buffer of the current frame.
+        /// </summary>
+        /// <param name="commandBuffer">The command buffer to record to.</param>
+        /// <param name="frustum">The frustum to cull against.</param>
+        void Cull(const CommandBuffer& commandBuffer, const Frustum& frustum);
+
+        /// <summary>
+        /// Records the draws which were not culled. The graphics pipeline and index buffer
+        /// must already be bound.
+        /// </summary>
+        /// <param name="commandBuffer">The command buffer to record to.</param>
+        void Draw(const CommandBuffer& commandBuffer) const;
+
+    private:
+        struct PushCull
+        {
+            Frustum frustum;
+            uint32_t count;
+        };
+
+        uint32_t m_maxDraws;
+        uint32_t m_drawCount;
+        bool m_compact;
+        bool m_firstInstance;
+
+        eastl::vector<IndirectDraw> m_pendingDraws;
+        bool m_uploadPending;
+
+        StorageBuffer m_draws;
+        StorageBuffer m_commands;
+        StorageBuffer m_count;
+        StorageBuffer m_drawIndices;
+
+        PipelineCompute m_cullPipeline;
+        DescriptorSet m_descriptorSet;
+    };
+}
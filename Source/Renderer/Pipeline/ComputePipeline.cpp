@@ -2,55 +2,230 @@
 #include "ComputePipeline.h"
 
 #include "Renderer/Renderer.h"
+#include "Renderer/RenderGraph/RenderGraph.h"
+#include "Shader/ShaderReloader.h"
+#include "Utils/Profiler.h"
 
 #define LOG_TAG MANTIS_TEXT("ComputePipline")
 
 namespace Mantis
 {
-    PipelineCompute::PipelineCompute(std::filesystem::path shaderStage, std::vector<Shader::Define> defines, const bool& pushDescriptors) :
+    PipelineCompute::PipelineCompute(
+        std::filesystem::path shaderStage,
+        eastl::vector<Shader::Define> defines,
+        const bool& pushDescriptors,
+        SpecializationConstants specializationConstants,
+        const eastl::array<uint32_t, 3>& localSize,
+        eastl::vector<Shader::ImmutableSampler> immutableSamplers,
+        eastl::vector<String> dynamicUniformBlocks
+    ) :
         m_shaderStage{ std::move(shaderStage) },
-        m_defines{ std::move(defines) },
+        m_defines{ eastl::move(defines) },
         m_pushDescriptors{ pushDescriptors },
-        m_shader{ std::make_unique<Shader>() },
+        m_specializationConstants{ eastl::move(specializationConstants) },
+        m_localSizeOverride{ localSize },
+        m_immutableSamplers{ eastl::move(immutableSamplers) },
+        m_dynamicUniformBlocks{ eastl::move(dynamicUniformBlocks) },
+        m_shader{ eastl::make_unique<Shader>() },
+        m_localSize{ 1, 1, 1 },
         m_pipelineBindPoint{ VK_PIPELINE_BIND_POINT_COMPUTE }
     {
 #if defined(ACID_VERBOSE)
         auto debugStart{ Time::Now() };
 #endif
 
-        CreateShaderProgram();
+        if (!CreateShaderProgram(*m_shader, m_shaderModule, m_shaderStageCreateInfo))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to compile pipeline shader!");
+        }
+
         CreateDescriptorLayout();
         CreateDescriptorPool();
         CreatePipelineLayout();
-        CreatePipelineCompute();
+        m_pipeline = CreatePipelineCompute(*m_shader, m_shaderStageCreateInfo);
+        m_localSize = GetLocalSize(*m_shader);
 
 #if defined(ACID_VERBOSE)
         auto debugEnd{ Time::Now() };
         //Log::Out("%s", m_shader->ToString());
         Log::Out("Pipeline compute '%ls' created in %.3fms\n", m_shaderStage, (debugEnd - debugStart).AsMilliseconds<float>());
 #endif
+
+        if (auto shaderReloader = Renderer::Get()->GetShaderReloader())
+        {
+            shaderReloader->Register(this);
+        }
     }
 
     PipelineCompute::~PipelineCompute()
     {
-        auto logicalDevice{ Graphics::Get()->GetLogicalDevice() };
+        if (auto shaderReloader = Renderer::Get()->GetShaderReloader())
+        {
+            shaderReloader->Unregister(this);
+        }
+
+        DestroyRecompile();
+
+        // frames in flight may still reference the pipeline and its descriptor sets
+        auto renderer = Renderer::Get();
+
+        renderer->DestroyShaderModule(m_shaderModule);
+        renderer->DestroyDescriptorSetLayout(m_descriptorSetLayout);
+        renderer->DestroyDescriptorPool(m_descriptorPool);
+        renderer->DestroyPipeline(m_pipeline);
+        renderer->DestroyPipelineLayout(m_pipelineLayout);
+    }
+
+    void PipelineCompute::CmdRender(const CommandBuffer& commandBuffer, const Vector2Int& extent) const
+    {
+        Dispatch(commandBuffer, static_cast<uint32_t>(extent.x), static_cast<uint32_t>(extent.y));
+    }
+
+    eastl::array<uint32_t, 3> PipelineCompute::GetGroupCount(uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ) const
+    {
+        return {
+            (sizeX + m_localSize[0] - 1) / m_localSize[0],
+            (sizeY + m_localSize[1] - 1) / m_localSize[1],
+            (sizeZ + m_localSize[2] - 1) / m_localSize[2],
+        };
+    }
+
+    void PipelineCompute::Dispatch(const CommandBuffer& commandBuffer, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ) const
+    {
+        // a shader that failed to compile leaves no pipeline to dispatch with
+        if (m_pipeline == VK_NULL_HANDLE)
+        {
+            Logger::ErrorT(LOG_TAG, "Cannot dispatch a compute pipeline that failed to be created!");
+            return;
+        }
+
+        auto groupCount = GetGroupCount(sizeX, sizeY, sizeZ);
+
+        if (groupCount[0] == 0 || groupCount[1] == 0 || groupCount[2] == 0)
+        {
+            return;
+        }
+
+        vkCmdDispatch(commandBuffer, groupCount[0], groupCount[1], groupCount[2]);
+    }
+
+    void PipelineCompute::DispatchIndirect(const CommandBuffer& commandBuffer, const Buffer& buffer, const VkDeviceSize& offset) const
+    {
+        if (m_pipeline == VK_NULL_HANDLE)
+        {
+            Logger::ErrorT(LOG_TAG, "Cannot dispatch a compute pipeline that failed to be created!");
+            return;
+        }
+
+#if defined(MANTIS_DEBUG)
+        if (!HAS_FLAGS(buffer.GetUsage(), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT))
+        {
+            Logger::ErrorT(LOG_TAG, "Indirect dispatch buffer was not created with VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT!");
+        }
+        if (offset % 4 != 0 || offset + sizeof(VkDispatchIndirectCommand) > buffer.GetSize())
+        {
+            Logger::ErrorTF(LOG_TAG, "Indirect dispatch offset %llu is misaligned or out of bounds!", static_cast<unsigned long long>(offset));
+        }
+#endif
+
+        vkCmdDispatchIndirect(commandBuffer, buffer.GetBuffer(), offset);
+    }
+
+    void PipelineCompute::DispatchIndirect(const CommandBuffer& commandBuffer, RenderGraph& graph, const RenderBufferResource& resource, const VkDeviceSize& offset) const
+    {
+        DispatchIndirect(commandBuffer, graph.GetPhysicalBufferResource(resource), offset);
+    }
+
+    bool PipelineCompute::Recompile()
+    {
+        MANTIS_PROFILE_SCOPE("PipelineCompute::Recompile");
+
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        auto shader = eastl::make_unique<Shader>();
+        VkShaderModule shaderModule = VK_NULL_HANDLE;
+        VkPipelineShaderStageCreateInfo shaderStageCreateInfo = {};
+
+        if (!CreateShaderProgram(*shader, shaderModule, shaderStageCreateInfo))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to recompile pipeline shader, keeping the previous pipeline.");
+            vkDestroyShaderModule(*logicalDevice, shaderModule, nullptr);
+            return false;
+        }
+
+        // the descriptor and pipeline layouts are reused, so the shader resources must not change
+        if (!shader->IsLayoutCompatible(*m_shader))
+        {
+            Logger::WarningT(LOG_TAG, "Recompiled shader resources do not match the pipeline layout, a restart is required to apply the changes.");
+            vkDestroyShaderModule(*logicalDevice, shaderModule, nullptr);
+            return false;
+        }
+
+        auto pipeline = CreatePipelineCompute(*shader, shaderStageCreateInfo);
+
+        if (pipeline == VK_NULL_HANDLE)
+        {
+            vkDestroyShaderModule(*logicalDevice, shaderModule, nullptr);
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_recompileMutex);
+
+        // discard any previous recompile that was never applied
+        DestroyRecompile();
+
+        m_recompiledShader = eastl::move(shader);
+        m_recompiledShaderModule = shaderModule;
+        m_recompiledShaderStageCreateInfo = shaderStageCreateInfo;
+        m_recompiledPipeline = pipeline;
+        return true;
+    }
+
+    void PipelineCompute::ApplyRecompile()
+    {
+        std::lock_guard<std::mutex> lock(m_recompileMutex);
+
+        if (m_recompiledPipeline == VK_NULL_HANDLE)
+        {
+            return;
+        }
 
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        // frames in flight may still reference the old pipeline, but the module is no longer needed
+        Renderer::Get()->DestroyPipeline(m_pipeline);
         vkDestroyShaderModule(*logicalDevice, m_shaderModule, nullptr);
 
-        vkDestroyDescriptorSetLayout(*logicalDevice, m_descriptorSetLayout, nullptr);
-        vkDestroyDescriptorPool(*logicalDevice, m_descriptorPool, nullptr);
-        vkDestroyPipeline(*logicalDevice, m_pipeline, nullptr);
-        vkDestroyPipelineLayout(*logicalDevice, m_pipelineLayout, nullptr);
+        m_pipeline = m_recompiledPipeline;
+        m_shader = eastl::move(m_recompiledShader);
+        m_localSize = GetLocalSize(*m_shader);
+        m_shaderModule = m_recompiledShaderModule;
+        m_shaderStageCreateInfo = m_recompiledShaderStageCreateInfo;
+
+        m_recompiledPipeline = VK_NULL_HANDLE;
+        m_recompiledShaderModule = VK_NULL_HANDLE;
     }
 
-    void PipelineCompute::CmdRender(const CommandBuffer& commandBuffer, const Vector2ui& extent) const
+    void PipelineCompute::DestroyRecompile()
     {
-        auto groupCountX{ static_cast<uint32_t>(std::ceil(static_cast<float>(extent.m_x) / static_cast<float>(*m_shader->GetLocalSizes()[0]))) };
-        auto groupCountY{ static_cast<uint32_t>(std::ceil(static_cast<float>(extent.m_y) / static_cast<float>(*m_shader->GetLocalSizes()[1]))) };
-        vkCmdDispatch(commandBuffer, groupCountX, groupCountY, 1);
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        if (m_recompiledPipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(*logicalDevice, m_recompiledPipeline, nullptr);
+            m_recompiledPipeline = VK_NULL_HANDLE;
+        }
+
+        if (m_recompiledShaderModule != VK_NULL_HANDLE)
+        {
+            vkDestroyShaderModule(*logicalDevice, m_recompiledShaderModule, nullptr);
+            m_recompiledShaderModule = VK_NULL_HANDLE;
+        }
+
+        m_recompiledShader.reset();
     }
 
-    void PipelineCompute::CreateShaderProgram()
+    bool PipelineCompute::CreateShaderProgram(Shader& shader, VkShaderModule& shaderModule, VkPipelineShaderStageCreateInfo& shaderStageCreateInfo) const
     {
         std::stringstream defineBlock;
 
@@ -63,19 +238,27 @@ namespace Mantis
 
         if (!fileLoaded)
         {
-            Log::Error("Shader Stage could not be loaded: '%s'\n", m_shaderStage);
-            throw std::runtime_error("Could not create compute pipeline, missing shader stage");
+            Logger::ErrorTF(LOG_TAG, "Shader stage could not be loaded: \"%s\"", m_shaderStage.c_str());
+            return false;
         }
 
         auto stageFlag{ Shader::GetShaderStage(m_shaderStage) };
-        m_shaderModule = m_shader->CreateShaderModule(m_shaderStage, *fileLoaded, defineBlock.str(), stageFlag);
+        shaderModule = shader.CreateShaderModule(m_shaderStage, *fileLoaded, defineBlock.str(), stageFlag);
+
+        if (shaderModule == VK_NULL_HANDLE)
+        {
+            return false;
+        }
 
-        m_shaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        m_shaderStageCreateInfo.stage = stageFlag;
-        m_shaderStageCreateInfo.module = m_shaderModule;
-        m_shaderStageCreateInfo.pName = "main";
+        shaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStageCreateInfo.stage = stageFlag;
+        shaderStageCreateInfo.module = shaderModule;
+        shaderStageCreateInfo.pName = "main";
 
-        m_shader->CreateReflection();
+        shader.SetImmutableSamplers(m_immutableSamplers);
+        shader.SetDynamicUniformBlocks(m_dynamicUniformBlocks);
+        shader.CreateReflection();
+        return true;
     }
 
     void PipelineCompute::CreateDescriptorLayout()
@@ -122,17 +305,86 @@ namespace Mantis
         Graphics::CheckVk(vkCreatePipelineLayout(*logicalDevice, &pipelineLayoutCreateInfo, nullptr, &m_pipelineLayout));
     }
 
-    void PipelineCompute::CreatePipelineCompute()
+    VkPipeline PipelineCompute::CreatePipelineCompute(const Shader& shader, const VkPipelineShaderStageCreateInfo& shaderStageCreateInfo) const
     {
         auto logicalDevice{ Graphics::Get()->GetLogicalDevice() };
         auto pipelineCache{ Graphics::Get()->GetPipelineCache() };
 
+        // a workgroup larger than the device supports is undefined behaviour, so the pipeline is not created
+        auto localSize = GetLocalSize(shader);
+        const auto& limits = Renderer::Get()->GetPhysicalDevice()->GetProperties().limits;
+
+        if (static_cast<uint64_t>(localSize[0]) * localSize[1] * localSize[2] > limits.maxComputeWorkGroupInvocations ||
+            localSize[0] > limits.maxComputeWorkGroupSize[0] ||
+            localSize[1] > limits.maxComputeWorkGroupSize[1] ||
+            localSize[2] > limits.maxComputeWorkGroupSize[2])
+        {
+            Logger::ErrorTF(LOG_TAG, "Workgroup size (%u, %u, %u) exceeds the device limits, the compute pipeline was not created!", localSize[0], localSize[1], localSize[2]);
+            return VK_NULL_HANDLE;
+        }
+
+        // the workgroup size overrides are applied through the specialization constants the shader declares for them
+        auto specializationConstants = m_specializationConstants;
+
+        for (uint32_t dim = 0; dim < 3; dim++)
+        {
+            if (m_localSizeOverride[dim] == 0)
+            {
+                continue;
+            }
+
+            const auto& specId = shader.GetLocalSizeSpecIds()[dim];
+
+            if (!specId)
+            {
+                Logger::WarningTF(LOG_TAG, "Cannot override local size %c, the shader must declare it using local_size_%c_id.", "XYZ"[dim], "xyz"[dim]);
+                continue;
+            }
+
+            specializationConstants.Set(*specId, m_localSizeOverride[dim]);
+        }
+
+        eastl::vector<VkSpecializationMapEntry> mapEntries;
+        eastl::vector<uint8_t> specializationData;
+        VkSpecializationInfo specializationInfo;
+
         VkComputePipelineCreateInfo pipelineCreateInfo{};
         pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-        pipelineCreateInfo.stage = m_shaderStageCreateInfo;
+        pipelineCreateInfo.stage = shaderStageCreateInfo;
+
+        if (specializationConstants.GetSpecializationInfo(shader, mapEntries, specializationData, specializationInfo))
+        {
+            pipelineCreateInfo.stage.pSpecializationInfo = &specializationInfo;
+        }
         pipelineCreateInfo.layout = m_pipelineLayout;
         pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
         pipelineCreateInfo.basePipelineIndex = -1;
-        vkCreateComputePipelines(*logicalDevice, pipelineCache, 1, &pipelineCreateInfo, nullptr, &m_pipeline);
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        if (Renderer::Check(vkCreateComputePipelines(*logicalDevice, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline)))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to create compute pipeline!");
+            return VK_NULL_HANDLE;
+        }
+        return pipeline;
+    }
+
+    eastl::array<uint32_t, 3> PipelineCompute::GetLocalSize(const Shader& shader) const
+    {
+        eastl::array<uint32_t, 3> localSize;
+
+        for (uint32_t dim = 0; dim < 3; dim++)
+        {
+            if (m_localSizeOverride[dim] != 0 && shader.GetLocalSizeSpecIds()[dim])
+            {
+                localSize[dim] = m_localSizeOverride[dim];
+            }
+            else
+            {
+                localSize[dim] = shader.GetLocalSizes()[dim].value_or(1);
+            }
+        }
+
+        return localSize;
     }
-}
+}
\ No newline at end of file
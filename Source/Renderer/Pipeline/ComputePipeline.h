@@ -3,10 +3,15 @@
 #include "Mantis.h"
 
 #include "Pipeline.h"
+#include "SpecializationConstants.h"
 #include "Renderer/Commands/CommandBuffer.h"
 
 namespace Mantis
 {
+    class Buffer;
+    class RenderGraph;
+    class RenderBufferResource;
+
     /**
      * @brief Class that represents a compute compute pipeline.
      */
@@ -19,11 +24,19 @@ namespace Mantis
          * @param shaderStage The shader file that will be loaded.
          * @param defines A list of defines added to the top of each shader.
          * @param pushDescriptors If no actual descriptor sets are allocated but instead pushed.
+         * @param specializationConstants The values of the specialization constants used by the shader.
+         * @param localSize Overrides the workgroup size in each dimension declared with a local_size_*_id, zero keeps the shader's size. The pipeline is not created if the resulting size exceeds the device limits.
+         * @param immutableSamplers The combined image samplers which have a stock sampler baked into the descriptor set layout.
+         * @param dynamicUniformBlocks The uniform blocks bound as dynamic uniform buffers, with the offset given when binding.
          */
         explicit PipelineCompute(
             std::filesystem::path shaderStage,
-            std::vector<Shader::Define> defines = {},
-            const bool& pushDescriptors = false
+            eastl::vector<Shader::Define> defines = {},
+            const bool& pushDescriptors = false,
+            SpecializationConstants specializationConstants = {},
+            const eastl::array<uint32_t, 3>& localSize = {},
+            eastl::vector<Shader::ImmutableSampler> immutableSamplers = {},
+            eastl::vector<String> dynamicUniformBlocks = {}
         );
 
         ~PipelineCompute();
@@ -34,8 +47,54 @@ namespace Mantis
 
         const bool& IsPushDescriptors() const override { return m_pushDescriptors; }
 
+        const SpecializationConstants& GetSpecializationConstants() const { return m_specializationConstants; }
+
+        const eastl::vector<Shader::ImmutableSampler>& GetImmutableSamplers() const { return m_immutableSamplers; }
+
+        const eastl::vector<String>& GetDynamicUniformBlocks() const { return m_dynamicUniformBlocks; }
+
         void CmdRender(const CommandBuffer& commandBuffer, const Vector2Int& extent) const;
 
+        /// <summary>
+        /// Gets the number of invocations in each dimension of a workgroup.
+        /// </summary>
+        const eastl::array<uint32_t, 3>& GetLocalSize() const { return m_localSize; }
+
+        /// <summary>
+        /// Gets the number of workgroups needed to cover a problem size.
+        /// </summary>
+        /// <param name="sizeX">The number of invocations needed in the x dimension.</param>
+        /// <param name="sizeY">The number of invocations needed in the y dimension.</param>
+        /// <param name="sizeZ">The number of invocations needed in the z dimension.</param>
+        eastl::array<uint32_t, 3> GetGroupCount(uint32_t sizeX, uint32_t sizeY = 1, uint32_t sizeZ = 1) const;
+
+        /// <summary>
+        /// Records a dispatch with enough workgroups to cover a problem size. The shader must discard
+        /// invocations outside of the problem size, since the last workgroups may be partially used.
+        /// </summary>
+        /// <param name="commandBuffer">The command buffer to record to.</param>
+        /// <param name="sizeX">The number of invocations needed in the x dimension.</param>
+        /// <param name="sizeY">The number of invocations needed in the y dimension.</param>
+        /// <param name="sizeZ">The number of invocations needed in the z dimension.</param>
+        void Dispatch(const CommandBuffer& commandBuffer, uint32_t sizeX, uint32_t sizeY = 1, uint32_t sizeZ = 1) const;
+
+        /// <summary>
+        /// Records a dispatch using the workgroup counts stored in a buffer as a VkDispatchIndirectCommand.
+        /// </summary>
+        /// <param name="commandBuffer">The command buffer to record to.</param>
+        /// <param name="buffer">The buffer containing the dispatch arguments.</param>
+        /// <param name="offset">The offset in bytes of the dispatch arguments in the buffer.</param>
+        void DispatchIndirect(const CommandBuffer& commandBuffer, const Buffer& buffer, const VkDeviceSize& offset = 0) const;
+
+        /// <summary>
+        /// Records a dispatch using the workgroup counts stored in a render graph buffer as a VkDispatchIndirectCommand.
+        /// </summary>
+        /// <param name="commandBuffer">The command buffer to record to.</param>
+        /// <param name="graph">The render graph which owns the buffer.</param>
+        /// <param name="resource">The buffer containing the dispatch arguments, added to the pass as an indirect buffer input.</param>
+        /// <param name="offset">The offset in bytes of the dispatch arguments in the buffer.</param>
+        void DispatchIndirect(const CommandBuffer& commandBuffer, RenderGraph& graph, const RenderBufferResource& resource, const VkDeviceSize& offset = 0) const;
+
         const Shader* GetShader() const override { return m_shader.get(); }
 
         const VkDescriptorSetLayout& GetDescriptorSetLayout() const override { return m_descriptorSetLayout; }
@@ -48,8 +107,12 @@ namespace Mantis
 
         const VkPipelineBindPoint& GetPipelineBindPoint() const override { return m_pipelineBindPoint; }
 
+        bool Recompile() override;
+
+        void ApplyRecompile() override;
+
     private:
-        void CreateShaderProgram();
+        bool CreateShaderProgram(Shader& shader, VkShaderModule& shaderModule, VkPipelineShaderStageCreateInfo& shaderStageCreateInfo) const;
 
         void CreateDescriptorLayout();
 
@@ -57,13 +120,25 @@ namespace Mantis
 
         void CreatePipelineLayout();
 
-        void CreatePipelineCompute();
+        VkPipeline CreatePipelineCompute(const Shader& shader, const VkPipelineShaderStageCreateInfo& shaderStageCreateInfo) const;
+
+        /// <summary>
+        /// Finds the workgroup size of a shader after applying the local size overrides.
+        /// </summary>
+        eastl::array<uint32_t, 3> GetLocalSize(const Shader& shader) const;
+
+        void DestroyRecompile();
 
         std::filesystem::path m_shaderStage;
         eastl::vector<Shader::Define> m_defines;
         bool m_pushDescriptors;
+        SpecializationConstants m_specializationConstants;
+        eastl::array<uint32_t, 3> m_localSizeOverride;
+        eastl::vector<Shader::ImmutableSampler> m_immutableSamplers;
+        eastl::vector<String> m_dynamicUniformBlocks;
 
         eastl::unique_ptr<Shader> m_shader;
+        eastl::array<uint32_t, 3> m_localSize;
 
         VkShaderModule m_shaderModule{ VK_NULL_HANDLE };
         VkPipelineShaderStageCreateInfo m_shaderStageCreateInfo{};
@@ -74,5 +149,11 @@ namespace Mantis
         VkPipeline m_pipeline{ VK_NULL_HANDLE };
         VkPipelineLayout m_pipelineLayout{ VK_NULL_HANDLE };
         VkPipelineBindPoint m_pipelineBindPoint;
+
+        std::mutex m_recompileMutex;
+        eastl::unique_ptr<Shader> m_recompiledShader;
+        VkShaderModule m_recompiledShaderModule{ VK_NULL_HANDLE };
+        VkPipelineShaderStageCreateInfo m_recompiledShaderStageCreateInfo{};
+        VkPipeline m_recompiledPipeline{ VK_NULL_HANDLE };
     };
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "GraphicsPipeline.h"
 
 #include "Renderer/Renderer.h"
+#include "Shader/ShaderReloader.h"
+#include "Utils/Profiler.h"
 
 #define LOG_TAG MANTIS_TEXT("GraphicsPipline")
 
@@ -14,6 +16,18 @@ namespace Mantis
         VK_DYNAMIC_STATE_LINE_WIDTH,
     };
 
+    /// <summary>
+    /// Gets the render pass pipelines of a stage are created for, which is null when the stage uses dynamic rendering.
+    /// </summary>
+    static VkRenderPass GetStageRenderpass(const RenderStage& renderStage)
+    {
+        if (renderStage.UsesDynamicRendering())
+        {
+            return VK_NULL_HANDLE;
+        }
+        return *renderStage.GetRenderpass();
+    }
+
     PipelineGraphics::PipelineGraphics(
         Stage stage,
         eastl::vector<std::filesystem::path> shaderStages,
@@ -25,7 +39,11 @@ namespace Mantis
         const VkPolygonMode& polygonMode,
         const VkCullModeFlags& cullMode,
         const VkFrontFace& frontFace,
-        const bool& pushDescriptors
+        const bool& pushDescriptors,
+        SpecializationConstants specializationConstants,
+        eastl::vector<Shader::ImmutableSampler> immutableSamplers,
+        eastl::vector<String> dynamicUniformBlocks,
+        const PipelineGraphics* basePipeline
     ) :
         m_stage(eastl::move(stage)),
         m_shaderStages(eastl::move(shaderStages)),
@@ -38,6 +56,9 @@ namespace Mantis
         m_cullMode(cullMode),
         m_frontFace(frontFace),
         m_pushDescriptors(pushDescriptors),
+        m_specializationConstants(eastl::move(specializationConstants)),
+        m_immutableSamplers(eastl::move(immutableSamplers)),
+        m_dynamicUniformBlocks(eastl::move(dynamicUniformBlocks)),
         m_shader(eastl::make_unique<Shader>()),
         m_dynamicStates(DYNAMIC_STATES),
         m_pipelineBindPoint(VK_PIPELINE_BIND_POINT_GRAPHICS)
@@ -47,7 +68,12 @@ namespace Mantis
 #endif
 
         eastl::sort(m_vertexInputs.begin(), m_vertexInputs.end());
-        CreateShaderProgram();
+
+        if (!CreateShaderProgram(*m_shader, m_modules, m_stages))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to compile pipeline shaders!");
+        }
+
         CreateDescriptorLayout();
         CreateDescriptorPool();
         CreatePipelineLayout();
@@ -56,10 +82,10 @@ namespace Mantis
         switch (m_mode)
         {
             case Mode::Polygon:
-                CreatePipelinePolygon();
+                CreatePipelinePolygon(basePipeline);
                 break;
             case Mode::Mrt:
-                CreatePipelineMrt();
+                CreatePipelineMrt(basePipeline);
                 break;
             default:
                 Logger::ErrorT(LOG_TAG, "Unknown pipline mode!");
@@ -69,21 +95,34 @@ namespace Mantis
 #if defined(MANTIS_DEBUG)
         Logger::DebugTF(LOG_TAG, "Pipeline graphics \"%ls\" created in %.3fms", m_shaderStages.back(), (Timer::Now() - startTime).AsMilliseconds<float>());
 #endif
+
+        if (auto shaderReloader = Renderer::Get()->GetShaderReloader())
+        {
+            shaderReloader->Register(this);
+        }
     }
 
     PipelineGraphics::~PipelineGraphics()
     {
-        auto logicalDevice{ Graphics::Get()->GetLogicalDevice() };
+        if (auto shaderReloader = Renderer::Get()->GetShaderReloader())
+        {
+            shaderReloader->Unregister(this);
+        }
+
+        DestroyRecompile();
+
+        // frames in flight may still reference the pipeline and its descriptor sets
+        auto renderer = Renderer::Get();
 
         for (const auto& shaderModule : m_modules)
         {
-            vkDestroyShaderModule(*logicalDevice, shaderModule, nullptr);
+            renderer->DestroyShaderModule(shaderModule);
         }
 
-        vkDestroyDescriptorPool(*logicalDevice, m_descriptorPool, nullptr);
-        vkDestroyPipeline(*logicalDevice, m_pipeline, nullptr);
-        vkDestroyPipelineLayout(*logicalDevice, m_pipelineLayout, nullptr);
-        vkDestroyDescriptorSetLayout(*logicalDevice, m_descriptorSetLayout, nullptr);
+        renderer->DestroyDescriptorPool(m_descriptorPool);
+        renderer->DestroyPipeline(m_pipeline);
+        renderer->DestroyPipelineLayout(m_pipelineLayout);
+        renderer->DestroyDescriptorSetLayout(m_descriptorSetLayout);
     }
 
     const ImageDepth* PipelineGraphics::GetDepthStencil(const eastl::optional<uint32_t>& stage) const
@@ -101,7 +140,136 @@ namespace Mantis
         return Graphics::Get()->GetRenderStage(stage ? *stage : m_stage.first)->GetRenderArea();
     }
 
-    void PipelineGraphics::CreateShaderProgram()
+    PipelineGraphics::Library::~Library()
+    {
+        Renderer::Get()->DestroyPipeline(m_pipeline);
+    }
+
+    bool PipelineGraphics::Recompile()
+    {
+        MANTIS_PROFILE_SCOPE("PipelineGraphics::Recompile");
+
+#if defined(MANTIS_DEBUG)
+        auto startTime = Timer::Now();
+#endif
+
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        auto shader = eastl::make_unique<Shader>();
+        eastl::vector<VkShaderModule> modules;
+        eastl::vector<VkPipelineShaderStageCreateInfo> stages;
+
+        auto destroyModules = [&]()
+        {
+            for (const auto& shaderModule : modules)
+            {
+                vkDestroyShaderModule(*logicalDevice, shaderModule, nullptr);
+            }
+        };
+
+        if (!CreateShaderProgram(*shader, modules, stages))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to recompile pipeline shaders, keeping the previous pipeline.");
+            destroyModules();
+            return false;
+        }
+
+        // the descriptor and pipeline layouts are reused, so the shader resources must not change
+        if (!shader->IsLayoutCompatible(*m_shader))
+        {
+            Logger::WarningT(LOG_TAG, "Recompiled shader resources do not match the pipeline layout, a restart is required to apply the changes.");
+            destroyModules();
+            return false;
+        }
+
+        // only the libraries containing shaders need to be rebuilt
+        Libraries libraries;
+        {
+            std::lock_guard<std::mutex> lock(m_recompileMutex);
+            libraries = m_libraries;
+        }
+
+        libraries[static_cast<size_t>(LibraryPart::PreRasterization)].reset();
+        libraries[static_cast<size_t>(LibraryPart::FragmentShader)].reset();
+
+        auto pipeline = CreatePipeline(*shader, stages, libraries);
+
+        if (pipeline == VK_NULL_HANDLE)
+        {
+            destroyModules();
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_recompileMutex);
+
+        // discard any previous recompile that was never applied
+        DestroyRecompile();
+
+        m_recompiledShader = eastl::move(shader);
+        m_recompiledModules = eastl::move(modules);
+        m_recompiledStages = eastl::move(stages);
+        m_recompiledPipeline = pipeline;
+        m_recompiledLibraries = eastl::move(libraries);
+
+#if defined(MANTIS_DEBUG)
+        Logger::DebugTF(LOG_TAG, "Pipeline graphics \"%ls\" recompiled in %.3fms", m_shaderStages.back(), (Timer::Now() - startTime).AsMilliseconds<float>());
+#endif
+        return true;
+    }
+
+    void PipelineGraphics::ApplyRecompile()
+    {
+        std::lock_guard<std::mutex> lock(m_recompileMutex);
+
+        if (m_recompiledPipeline == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        // frames in flight may still reference the old pipeline, but the modules are no longer needed
+        Renderer::Get()->DestroyPipeline(m_pipeline);
+
+        for (const auto& shaderModule : m_modules)
+        {
+            vkDestroyShaderModule(*logicalDevice, shaderModule, nullptr);
+        }
+
+        m_pipeline = m_recompiledPipeline;
+        m_shader = eastl::move(m_recompiledShader);
+        m_modules = eastl::move(m_recompiledModules);
+        m_stages = eastl::move(m_recompiledStages);
+        m_libraries = eastl::move(m_recompiledLibraries);
+
+        m_recompiledPipeline = VK_NULL_HANDLE;
+        m_recompiledModules.clear();
+        m_recompiledStages.clear();
+        m_recompiledLibraries = {};
+    }
+
+    void PipelineGraphics::DestroyRecompile()
+    {
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        if (m_recompiledPipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(*logicalDevice, m_recompiledPipeline, nullptr);
+            m_recompiledPipeline = VK_NULL_HANDLE;
+        }
+
+        for (const auto& shaderModule : m_recompiledModules)
+        {
+            vkDestroyShaderModule(*logicalDevice, shaderModule, nullptr);
+        }
+
+        m_recompiledShader.reset();
+        m_recompiledModules.clear();
+        m_recompiledStages.clear();
+        m_recompiledLibraries = {};
+    }
+
+    bool PipelineGraphics::CreateShaderProgram(Shader& shader, eastl::vector<VkShaderModule>& modules, eastl::vector<VkPipelineShaderStageCreateInfo>& stages) const
     {
         std::stringstream defineBlock;
 
@@ -116,23 +284,31 @@ namespace Mantis
 
             if (!fileLoaded)
             {
-                Log::Error("Shader Stage could not be loaded: '%s'\n", shaderStage);
-                throw std::runtime_error("Could not create pipeline, missing shader stage");
+                Logger::ErrorTF(LOG_TAG, "Shader stage could not be loaded: \"%s\"", shaderStage.c_str());
+                return false;
             }
 
             auto stageFlag{ Shader::GetShaderStage(shaderStage) };
-            auto shaderModule{ m_shader->CreateShaderModule(shaderStage, *fileLoaded, defineBlock.str(), stageFlag) };
+            auto shaderModule{ shader.CreateShaderModule(shaderStage, *fileLoaded, defineBlock.str(), stageFlag) };
+
+            if (shaderModule == VK_NULL_HANDLE)
+            {
+                return false;
+            }
 
             VkPipelineShaderStageCreateInfo pipelineShaderStageCreateInfo{};
             pipelineShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
             pipelineShaderStageCreateInfo.stage = stageFlag;
             pipelineShaderStageCreateInfo.module = shaderModule;
             pipelineShaderStageCreateInfo.pName = "main";
-            m_stages.emplace_back(pipelineShaderStageCreateInfo);
-            m_modules.emplace_back(shaderModule);
+            stages.emplace_back(pipelineShaderStageCreateInfo);
+            modules.emplace_back(shaderModule);
         }
 
-        m_shader->CreateReflection();
+        shader.SetImmutableSamplers(m_immutableSamplers);
+        shader.SetDynamicUniformBlocks(m_dynamicUniformBlocks);
+        shader.CreateReflection();
+        return true;
     }
 
     void PipelineGraphics::CreateDescriptorLayout()
@@ -269,14 +445,12 @@ namespace Mantis
         m_tessellationState.patchControlPoints = 3;
     }
 
-    void PipelineGraphics::CreatePipeline()
+    void PipelineGraphics::CreateVertexInputState(
+        eastl::vector<VkVertexInputBindingDescription>& bindingDescriptions,
+        eastl::vector<VkVertexInputAttributeDescription>& attributeDescriptions,
+        VkPipelineVertexInputStateCreateInfo& vertexInputState
+    ) const
     {
-        auto logicalDevice{ Graphics::Get()->GetLogicalDevice() };
-        auto pipelineCache{ Graphics::Get()->GetPipelineCache() };
-        auto renderStage{ Graphics::Get()->GetRenderStage(m_stage.first) };
-
-        std::vector<VkVertexInputBindingDescription> bindingDescriptions;
-        std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
         uint32_t lastAttribute{};
 
         for (const auto& vertexInput : m_vertexInputs)
@@ -312,18 +486,72 @@ namespace Mantis
             }
         }
 
-        m_vertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        m_vertexInputStateCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
-        m_vertexInputStateCreateInfo.pVertexBindingDescriptions = bindingDescriptions.data();
-        m_vertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-        m_vertexInputStateCreateInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+        vertexInputState = {};
+        vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInputState.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+        vertexInputState.pVertexBindingDescriptions = bindingDescriptions.data();
+        vertexInputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+        vertexInputState.pVertexAttributeDescriptions = attributeDescriptions.data();
+    }
+
+    VkPipeline PipelineGraphics::CreatePipeline(
+        const Shader& shader,
+        const eastl::vector<VkPipelineShaderStageCreateInfo>& stages,
+        Libraries& libraries,
+        const VkPipeline& basePipeline
+    ) const
+    {
+        eastl::vector<VkSpecializationMapEntry> mapEntries;
+        eastl::vector<uint8_t> specializationData;
+        VkSpecializationInfo specializationInfo;
+        auto specializedStages = stages;
+
+        if (m_specializationConstants.GetSpecializationInfo(shader, mapEntries, specializationData, specializationInfo))
+        {
+            for (auto& stage : specializedStages)
+            {
+                stage.pSpecializationInfo = &specializationInfo;
+            }
+        }
+
+        if (!Renderer::Get()->GetLogicalDevice()->SupportsGraphicsPipelineLibrary())
+        {
+            return CreateCompletePipeline(specializedStages, basePipeline);
+        }
+
+        for (size_t i = 0; i < libraries.size(); i++)
+        {
+            if (!libraries[i])
+            {
+                libraries[i] = CreateLibrary(static_cast<LibraryPart>(i), specializedStages);
+
+                if (!libraries[i])
+                {
+                    return VK_NULL_HANDLE;
+                }
+            }
+        }
+
+        return LinkLibraries(libraries);
+    }
+
+    VkPipeline PipelineGraphics::CreateCompletePipeline(const eastl::vector<VkPipelineShaderStageCreateInfo>& stages, const VkPipeline& basePipeline) const
+    {
+        auto logicalDevice{ Graphics::Get()->GetLogicalDevice() };
+        auto pipelineCache{ Graphics::Get()->GetPipelineCache() };
+        auto renderStage{ Graphics::Get()->GetRenderStage(m_stage.first) };
+
+        eastl::vector<VkVertexInputBindingDescription> bindingDescriptions;
+        eastl::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+        VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo;
+        CreateVertexInputState(bindingDescriptions, attributeDescriptions, vertexInputStateCreateInfo);
 
         VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
         pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineCreateInfo.stageCount = static_cast<uint32_t>(m_stages.size());
-        pipelineCreateInfo.pStages = m_stages.data();
+        pipelineCreateInfo.stageCount = static_cast<uint32_t>(stages.size());
+        pipelineCreateInfo.pStages = stages.data();
 
-        pipelineCreateInfo.pVertexInputState = &m_vertexInputStateCreateInfo;
+        pipelineCreateInfo.pVertexInputState = &vertexInputStateCreateInfo;
         pipelineCreateInfo.pInputAssemblyState = &m_inputAssemblyState;
         pipelineCreateInfo.pTessellationState = &m_tessellationState;
         pipelineCreateInfo.pViewportState = &m_viewportState;
@@ -334,25 +562,223 @@ namespace Mantis
         pipelineCreateInfo.pDynamicState = &m_dynamicState;
 
         pipelineCreateInfo.layout = m_pipelineLayout;
-        pipelineCreateInfo.renderPass = *renderStage->GetRenderpass();
+        pipelineCreateInfo.renderPass = GetStageRenderpass(*renderStage);
         pipelineCreateInfo.subpass = m_stage.second;
+
+        // without a render pass the attachment formats are given instead
+        if (renderStage->UsesDynamicRendering())
+        {
+            pipelineCreateInfo.pNext = &renderStage->GetPipelineRenderingInfo();
+        }
+
+        // any pipeline may be used as the base of a variant, which lets the driver reuse some of its work
+        pipelineCreateInfo.flags = VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
+        pipelineCreateInfo.basePipelineHandle = basePipeline;
+        pipelineCreateInfo.basePipelineIndex = -1;
+
+        if (basePipeline != VK_NULL_HANDLE)
+        {
+            pipelineCreateInfo.flags |= VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+        }
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        if (Renderer::Check(vkCreateGraphicsPipelines(*logicalDevice, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline)))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to create graphics pipeline!");
+            return VK_NULL_HANDLE;
+        }
+        return pipeline;
+    }
+
+    eastl::shared_ptr<PipelineGraphics::Library> PipelineGraphics::CreateLibrary(const LibraryPart& part, const eastl::vector<VkPipelineShaderStageCreateInfo>& stages) const
+    {
+        auto logicalDevice{ Graphics::Get()->GetLogicalDevice() };
+        auto pipelineCache{ Graphics::Get()->GetPipelineCache() };
+        auto renderStage{ Graphics::Get()->GetRenderStage(m_stage.first) };
+
+        VkGraphicsPipelineLibraryCreateInfoEXT libraryCreateInfo = {};
+        libraryCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+
+        VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
+        pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineCreateInfo.pNext = &libraryCreateInfo;
+        pipelineCreateInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
         pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
         pipelineCreateInfo.basePipelineIndex = -1;
-        Graphics::CheckVk(vkCreateGraphicsPipelines(*logicalDevice, pipelineCache, 1, &pipelineCreateInfo, nullptr, &m_pipeline));
+
+        eastl::vector<VkVertexInputBindingDescription> bindingDescriptions;
+        eastl::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+        VkPipelineVertexInputStateCreateInfo vertexInputState;
+        eastl::vector<VkPipelineShaderStageCreateInfo> libraryStages;
+
+        switch (part)
+        {
+            case LibraryPart::VertexInput:
+            {
+                CreateVertexInputState(bindingDescriptions, attributeDescriptions, vertexInputState);
+
+                libraryCreateInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+                pipelineCreateInfo.pVertexInputState = &vertexInputState;
+                pipelineCreateInfo.pInputAssemblyState = &m_inputAssemblyState;
+                break;
+            }
+            case LibraryPart::PreRasterization:
+            {
+                for (const auto& stage : stages)
+                {
+                    if (stage.stage != VK_SHADER_STAGE_FRAGMENT_BIT)
+                    {
+                        libraryStages.push_back(stage);
+                    }
+                }
+
+                libraryCreateInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+                pipelineCreateInfo.pTessellationState = &m_tessellationState;
+                pipelineCreateInfo.pViewportState = &m_viewportState;
+                pipelineCreateInfo.pRasterizationState = &m_rasterizationState;
+                pipelineCreateInfo.pDynamicState = &m_dynamicState;
+                pipelineCreateInfo.layout = m_pipelineLayout;
+                pipelineCreateInfo.renderPass = GetStageRenderpass(*renderStage);
+                pipelineCreateInfo.subpass = m_stage.second;
+                break;
+            }
+            case LibraryPart::FragmentShader:
+            {
+                for (const auto& stage : stages)
+                {
+                    if (stage.stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+                    {
+                        libraryStages.push_back(stage);
+                    }
+                }
+
+                libraryCreateInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+                pipelineCreateInfo.pMultisampleState = &m_multisampleState;
+                pipelineCreateInfo.pDepthStencilState = &m_depthStencilState;
+                pipelineCreateInfo.pDynamicState = &m_dynamicState;
+                pipelineCreateInfo.layout = m_pipelineLayout;
+                pipelineCreateInfo.renderPass = GetStageRenderpass(*renderStage);
+                pipelineCreateInfo.subpass = m_stage.second;
+                break;
+            }
+            case LibraryPart::FragmentOutput:
+            {
+                libraryCreateInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+                pipelineCreateInfo.pMultisampleState = &m_multisampleState;
+                pipelineCreateInfo.pColorBlendState = &m_colourBlendState;
+                pipelineCreateInfo.pDynamicState = &m_dynamicState;
+                pipelineCreateInfo.renderPass = GetStageRenderpass(*renderStage);
+                pipelineCreateInfo.subpass = m_stage.second;
+                break;
+            }
+            default:
+                Logger::ErrorT(LOG_TAG, "Unknown pipeline library part!");
+                return nullptr;
+        }
+
+        // every part but the vertex input depends on the attachments, which are given as formats without a render pass
+        if (part != LibraryPart::VertexInput && renderStage->UsesDynamicRendering())
+        {
+            libraryCreateInfo.pNext = &renderStage->GetPipelineRenderingInfo();
+        }
+
+        pipelineCreateInfo.stageCount = static_cast<uint32_t>(libraryStages.size());
+        pipelineCreateInfo.pStages = libraryStages.data();
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        if (Renderer::Check(vkCreateGraphicsPipelines(*logicalDevice, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline)))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to create graphics pipeline library!");
+            return nullptr;
+        }
+        return eastl::make_shared<Library>(pipeline);
+    }
+
+    VkPipeline PipelineGraphics::LinkLibraries(const Libraries& libraries) const
+    {
+        auto logicalDevice{ Graphics::Get()->GetLogicalDevice() };
+        auto pipelineCache{ Graphics::Get()->GetPipelineCache() };
+
+        eastl::array<VkPipeline, static_cast<size_t>(LibraryPart::Count)> pipelines;
+        for (size_t i = 0; i < libraries.size(); i++)
+        {
+            pipelines[i] = libraries[i]->GetPipeline();
+        }
+
+        VkPipelineLibraryCreateInfoKHR libraryCreateInfo = {};
+        libraryCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+        libraryCreateInfo.libraryCount = static_cast<uint32_t>(pipelines.size());
+        libraryCreateInfo.pLibraries = pipelines.data();
+
+        // link time optimization is skipped so that linking stays cheap enough to do while loading variants
+        VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
+        pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineCreateInfo.pNext = &libraryCreateInfo;
+        pipelineCreateInfo.layout = m_pipelineLayout;
+        pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+        pipelineCreateInfo.basePipelineIndex = -1;
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        if (Renderer::Check(vkCreateGraphicsPipelines(*logicalDevice, pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline)))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to link graphics pipeline libraries!");
+            return VK_NULL_HANDLE;
+        }
+        return pipeline;
     }
 
-    void PipelineGraphics::CreatePipelinePolygon()
+    bool PipelineGraphics::CanShareLibrary(const LibraryPart& part, const PipelineGraphics& other) const
     {
-        CreatePipeline();
+        if (!other.m_libraries[static_cast<size_t>(part)] || m_stage != other.m_stage)
+        {
+            return false;
+        }
+
+        // libraries containing shaders must also use an identically defined pipeline layout
+        auto sameShaders = m_shaderStages == other.m_shaderStages &&
+            m_defines == other.m_defines &&
+            m_specializationConstants == other.m_specializationConstants &&
+            m_pushDescriptors == other.m_pushDescriptors &&
+            m_shader->IsLayoutCompatible(*other.m_shader);
+
+        switch (part)
+        {
+            case LibraryPart::VertexInput:
+                return m_vertexInputs == other.m_vertexInputs && m_topology == other.m_topology;
+            case LibraryPart::PreRasterization:
+                return sameShaders && m_polygonMode == other.m_polygonMode && m_cullMode == other.m_cullMode && m_frontFace == other.m_frontFace;
+            case LibraryPart::FragmentShader:
+                return sameShaders && m_depth == other.m_depth;
+            case LibraryPart::FragmentOutput:
+                return m_mode == other.m_mode;
+            default:
+                return false;
+        }
+    }
+
+    void PipelineGraphics::CreatePipelinePolygon(const PipelineGraphics* basePipeline)
+    {
+        if (basePipeline)
+        {
+            for (size_t i = 0; i < m_libraries.size(); i++)
+            {
+                if (CanShareLibrary(static_cast<LibraryPart>(i), *basePipeline))
+                {
+                    m_libraries[i] = basePipeline->m_libraries[i];
+                }
+            }
+        }
+
+        m_pipeline = CreatePipeline(*m_shader, m_stages, m_libraries, basePipeline ? basePipeline->m_pipeline : VK_NULL_HANDLE);
     }
 
-    void PipelineGraphics::CreatePipelineMrt()
+    void PipelineGraphics::CreatePipelineMrt(const PipelineGraphics* basePipeline)
     {
         auto renderStage{ Graphics::Get()->GetRenderStage(m_stage.first) };
         auto attachmentCount{ renderStage->GetAttachmentCount(m_stage.second) };
 
-        std::vector<VkPipelineColorBlendAttachmentState> blendAttachmentStates;
-        blendAttachmentStates.reserve(attachmentCount);
+        m_mrtBlendAttachmentStates.clear();
+        m_mrtBlendAttachmentStates.reserve(attachmentCount);
 
         for (uint32_t i{}; i < attachmentCount; i++)
         {
@@ -365,12 +791,13 @@ namespace Mantis
             blendAttachmentState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
             blendAttachmentState.alphaBlendOp = VK_BLEND_OP_ADD;
             blendAttachmentState.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-            blendAttachmentStates.emplace_back(blendAttachmentState);
+            m_mrtBlendAttachmentStates.emplace_back(blendAttachmentState);
         }
 
-        m_colourBlendState.attachmentCount = static_cast<uint32_t>(blendAttachmentStates.size());
-        m_colourBlendState.pAttachments = blendAttachmentStates.data();
+        // keep the blend states alive so the pipeline can be recreated when recompiling
+        m_colourBlendState.attachmentCount = static_cast<uint32_t>(m_mrtBlendAttachmentStates.size());
+        m_colourBlendState.pAttachments = m_mrtBlendAttachmentStates.data();
 
-        CreatePipeline();
+        CreatePipelinePolygon(basePipeline);
     }
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Mantis.h"
 
 #include "Pipeline.h"
+#include "SpecializationConstants.h"
 #include "Shader/Shader.h"
 #include "Renderer/RenderStage.h"
 
@@ -44,6 +45,10 @@ namespace Mantis
          * @param cullMode The vertex cull mode.
          * @param frontFace The direction to render faces.
          * @param pushDescriptors If no actual descriptor sets are allocated but instead pushed.
+         * @param specializationConstants The values of the specialization constants used by the shaders.
+         * @param immutableSamplers The combined image samplers which have a stock sampler baked into the descriptor set layout.
+         * @param dynamicUniformBlocks The uniform blocks bound as dynamic uniform buffers, with the offset given when binding.
+         * @param basePipeline A pipeline this pipeline is a variant of, used to share compiled state.
          */
         PipelineGraphics(
             Stage stage,
@@ -56,7 +61,11 @@ namespace Mantis
             const VkPolygonMode& polygonMode = VK_POLYGON_MODE_FILL,
             const VkCullModeFlags& cullMode = VK_CULL_MODE_BACK_BIT,
             const VkFrontFace& frontFace = VK_FRONT_FACE_CLOCKWISE,
-            const bool& pushDescriptors = false
+            const bool& pushDescriptors = false,
+            SpecializationConstants specializationConstants = {},
+            eastl::vector<Shader::ImmutableSampler> immutableSamplers = {},
+            eastl::vector<String> dynamicUniformBlocks = {},
+            const PipelineGraphics* basePipeline = nullptr
         );
 
         ~PipelineGraphics();
@@ -105,6 +114,12 @@ namespace Mantis
 
         const bool& IsPushDescriptors() const override { return m_pushDescriptors; }
 
+        const SpecializationConstants& GetSpecializationConstants() const { return m_specializationConstants; }
+
+        const eastl::vector<Shader::ImmutableSampler>& GetImmutableSamplers() const { return m_immutableSamplers; }
+
+        const eastl::vector<String>& GetDynamicUniformBlocks() const { return m_dynamicUniformBlocks; }
+
         const Shader* GetShader() const override { return m_shader.get(); }
 
         const VkDescriptorSetLayout& GetDescriptorSetLayout() const override { return m_descriptorSetLayout; }
@@ -117,8 +132,43 @@ namespace Mantis
 
         const VkPipelineBindPoint& GetPipelineBindPoint() const override { return m_pipelineBindPoint; }
 
+        bool Recompile() override;
+
+        void ApplyRecompile() override;
+
     private:
-        void CreateShaderProgram();
+        /// <summary>
+        /// The parts of a graphics pipeline which can be compiled separately as pipeline libraries.
+        /// </summary>
+        enum class LibraryPart : uint32_t
+        {
+            VertexInput,
+            PreRasterization,
+            FragmentShader,
+            FragmentOutput,
+            Count,
+        };
+
+        /// <summary>
+        /// A compiled pipeline library, which may be shared between pipeline variants.
+        /// </summary>
+        class Library :
+            public NonCopyable
+        {
+        public:
+            explicit Library(VkPipeline pipeline) : m_pipeline(pipeline) {}
+
+            ~Library();
+
+            const VkPipeline& GetPipeline() const { return m_pipeline; }
+
+        private:
+            VkPipeline m_pipeline;
+        };
+
+        using Libraries = eastl::array<eastl::shared_ptr<Library>, static_cast<size_t>(LibraryPart::Count)>;
+
+        bool CreateShaderProgram(Shader& shader, eastl::vector<VkShaderModule>& modules, eastl::vector<VkPipelineShaderStageCreateInfo>& stages) const;
 
         void CreateDescriptorLayout();
 
@@ -128,11 +178,44 @@ namespace Mantis
 
         void CreateAttributes();
 
-        void CreatePipeline();
+        void CreateVertexInputState(
+            eastl::vector<VkVertexInputBindingDescription>& bindingDescriptions,
+            eastl::vector<VkVertexInputAttributeDescription>& attributeDescriptions,
+            VkPipelineVertexInputStateCreateInfo& vertexInputState
+        ) const;
+
+        /// <summary>
+        /// Creates a pipeline from the given shader stages. When pipeline libraries are supported any missing
+        /// libraries are created and all of them are linked, otherwise a complete pipeline is created.
+        /// </summary>
+        /// <param name="shader">The reflection of the shader stages.</param>
+        /// <param name="stages">The shader stages of the pipeline.</param>
+        /// <param name="libraries">The libraries to link, missing entries are filled in.</param>
+        /// <param name="basePipeline">A pipeline to derive from when pipeline libraries are not supported.</param>
+        /// <returns>The new pipeline, or VK_NULL_HANDLE on failure.</returns>
+        VkPipeline CreatePipeline(
+            const Shader& shader,
+            const eastl::vector<VkPipelineShaderStageCreateInfo>& stages,
+            Libraries& libraries,
+            const VkPipeline& basePipeline = VK_NULL_HANDLE
+        ) const;
+
+        VkPipeline CreateCompletePipeline(const eastl::vector<VkPipelineShaderStageCreateInfo>& stages, const VkPipeline& basePipeline) const;
+
+        eastl::shared_ptr<Library> CreateLibrary(const LibraryPart& part, const eastl::vector<VkPipelineShaderStageCreateInfo>& stages) const;
+
+        VkPipeline LinkLibraries(const Libraries& libraries) const;
 
-        void CreatePipelinePolygon();
+        /// <summary>
+        /// Checks if a library of another pipeline was created using the same state this pipeline requires.
+        /// </summary>
+        bool CanShareLibrary(const LibraryPart& part, const PipelineGraphics& other) const;
+
+        void DestroyRecompile();
+
+        void CreatePipelinePolygon(const PipelineGraphics* basePipeline);
 
-        void CreatePipelineMrt();
+        void CreatePipelineMrt(const PipelineGraphics* basePipeline);
 
         Stage m_stage;
         eastl::vector<std::filesystem::path> m_shaderStages;
@@ -145,6 +228,9 @@ namespace Mantis
         VkCullModeFlags m_cullMode;
         VkFrontFace m_frontFace;
         bool m_pushDescriptors;
+        SpecializationConstants m_specializationConstants;
+        eastl::vector<Shader::ImmutableSampler> m_immutableSamplers;
+        eastl::vector<String> m_dynamicUniformBlocks;
 
         eastl::unique_ptr<Shader> m_shader;
 
@@ -159,11 +245,19 @@ namespace Mantis
         VkPipeline m_pipeline{ VK_NULL_HANDLE };
         VkPipelineLayout m_pipelineLayout{ VK_NULL_HANDLE };
         VkPipelineBindPoint m_pipelineBindPoint;
+        Libraries m_libraries;
+
+        std::mutex m_recompileMutex;
+        eastl::unique_ptr<Shader> m_recompiledShader;
+        eastl::vector<VkShaderModule> m_recompiledModules;
+        eastl::vector<VkPipelineShaderStageCreateInfo> m_recompiledStages;
+        VkPipeline m_recompiledPipeline{ VK_NULL_HANDLE };
+        Libraries m_recompiledLibraries;
 
-        VkPipelineVertexInputStateCreateInfo m_vertexInputStateCreateInfo{};
         VkPipelineInputAssemblyStateCreateInfo m_inputAssemblyState{};
         VkPipelineRasterizationStateCreateInfo m_rasterizationState{};
         eastl::array<VkPipelineColorBlendAttachmentState, 1> m_blendAttachmentStates;
+        eastl::vector<VkPipelineColorBlendAttachmentState> m_mrtBlendAttachmentStates;
         VkPipelineColorBlendStateCreateInfo m_colourBlendState{};
         VkPipelineDepthStencilStateCreateInfo m_depthStencilState{};
         VkPipelineViewportStateCreateInfo m_viewportState{};
@@ -185,7 +279,10 @@ namespace Mantis
             const VkPolygonMode& polygonMode = VK_POLYGON_MODE_FILL,
             const VkCullModeFlags& cullMode = VK_CULL_MODE_BACK_BIT,
             const VkFrontFace& frontFace = VK_FRONT_FACE_CLOCKWISE,
-            const bool& pushDescriptors = false
+            const bool& pushDescriptors = false,
+            SpecializationConstants specializationConstants = {},
+            eastl::vector<Shader::ImmutableSampler> immutableSamplers = {},
+            eastl::vector<String> dynamicUniformBlocks = {}
         ) :
             m_shaderStages(eastl::move(shaderStages)),
             m_vertexInputs(eastl::move(vertexInputs)),
@@ -196,18 +293,22 @@ namespace Mantis
             m_polygonMode(polygonMode),
             m_cullMode(cullMode),
             m_frontFace(frontFace),
-            m_pushDescriptors(pushDescriptors)
+            m_pushDescriptors(pushDescriptors),
+            m_specializationConstants(eastl::move(specializationConstants)),
+            m_immutableSamplers(eastl::move(immutableSamplers)),
+            m_dynamicUniformBlocks(eastl::move(dynamicUniformBlocks))
         {}
 
         /// <summary>
         /// Creates a new pipeline.
         /// </summary>
         /// <param name="pipelineStage">The pipelines graphics stage.</param>
+        /// <param name="basePipeline">A pipeline the new pipeline is a variant of, used to speed up creation.</param>
         /// <returns>The created graphics pipeline.</returns>
-        PipelineGraphics* Create(const Pipeline::Stage& pipelineStage) const
+        PipelineGraphics* Create(const Pipeline::Stage& pipelineStage, const PipelineGraphics* basePipeline = nullptr) const
         {
             return new PipelineGraphics(pipelineStage, m_shaderStages, m_vertexInputs, m_defines, m_mode, m_depth, m_topology, m_polygonMode, m_cullMode, m_frontFace,
-                m_pushDescriptors);
+                m_pushDescriptors, m_specializationConstants, m_immutableSamplers, m_dynamicUniformBlocks, basePipeline);
         }
 
         const eastl::vector<std::filesystem::path>& GetShaderStages() const { return m_shaderStages; }
@@ -230,6 +331,12 @@ namespace Mantis
 
         const bool& GetPushDescriptors() const { return m_pushDescriptors; }
 
+        const SpecializationConstants& GetSpecializationConstants() const { return m_specializationConstants; }
+
+        const eastl::vector<Shader::ImmutableSampler>& GetImmutableSamplers() const { return m_immutableSamplers; }
+
+        const eastl::vector<String>& GetDynamicUniformBlocks() const { return m_dynamicUniformBlocks; }
+
     private:
         eastl::vector<std::filesystem::path> m_shaderStages;
         eastl::vector<Shader::VertexInput> m_vertexInputs;
@@ -242,5 +349,8 @@ namespace Mantis
         VkCullModeFlags m_cullMode;
         VkFrontFace m_frontFace;
         bool m_pushDescriptors;
+        SpecializationConstants m_specializationConstants;
+        eastl::vector<Shader::ImmutableSampler> m_immutableSamplers;
+        eastl::vector<String> m_dynamicUniformBlocks;
     };
 }
\ No newline at end of file
@@ -41,5 +41,19 @@ namespace Mantis
         virtual const VkPipelineLayout& GetPipelineLayout() const = 0;
 
         virtual const VkPipelineBindPoint& GetPipelineBindPoint() const = 0;
+
+        /// <summary>
+        /// Recompiles the shaders and creates a replacement pipeline, leaving the active pipeline
+        /// untouched. May be called from any thread.
+        /// </summary>
+        /// <returns>True if a replacement pipeline is ready to be applied.</returns>
+        virtual bool Recompile() = 0;
+
+        /// <summary>
+        /// Replaces the active pipeline with the one created by the last successful recompile.
+        /// Must be called on the render thread at a frame boundary, and never while <see cref="Recompile"/>
+        /// is running, since it reads the shader being replaced.
+        /// </summary>
+        virtual void ApplyRecompile() = 0;
     };
 }
\ No newline at end of file
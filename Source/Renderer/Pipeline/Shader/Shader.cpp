@@ -6,9 +6,14 @@
 #include "Renderer/Buffer/UniformBuffer.h"
 #include "Renderer/Texture/Image2d.h"
 #include "Renderer/Images/ImageCube.h"
+#include "Renderer/Image/Image.h"
+#include "Renderer/Image/SamplerCache.h"
+#include "Utils/Profiler.h"
 
 #include <SPIRV/GlslangToSpv.h>
+#include <SPIRV/spirv.hpp>
 #include <glslang/Public/ShaderLang.h>
+#include <glslang/MachineIndependent/localintermediate.h>
 
 #define LOG_TAG MANTIS_TEXT("Shader")
 
@@ -18,10 +23,20 @@ namespace Mantis
         public glslang::TShader::Includer
     {
     public:
+        /// <summary>
+        /// Creates a new includer.
+        /// </summary>
+        /// <param name="dependencies">The list to append the path of each resolved include to.</param>
+        explicit ShaderIncluder(eastl::vector<String>& dependencies) :
+            m_dependencies(dependencies)
+        {
+        }
+
         IncludeResult* includeLocal(const char* headerName, const char* includerName, size_t inclusionDepth) override
         {
             auto directory = FileSystem::ParentDirectory(includerName);
-            auto fileLoaded = Files::Read(directory + "/" + headerName);
+            auto path = directory + "/" + headerName;
+            auto fileLoaded = Files::Read(path);
 
             if (!fileLoaded)
             {
@@ -29,6 +44,8 @@ namespace Mantis
                 return nullptr;
             }
 
+            AddDependency(path);
+
             auto content = new char[fileLoaded->size()];
             memcpy(content, fileLoaded->c_str(), fileLoaded->size());
             return new IncludeResult(headerName, content, fileLoaded->size(), content);
@@ -44,6 +61,8 @@ namespace Mantis
                 return nullptr;
             }
 
+            AddDependency(headerName);
+
             auto content = new char[fileLoaded->size()];
             memcpy(content, fileLoaded->c_str(), fileLoaded->size());
             return new IncludeResult(headerName, content, fileLoaded->size(), content);
@@ -57,6 +76,17 @@ namespace Mantis
                 delete result;
             }
         }
+
+    private:
+        void AddDependency(const String& path)
+        {
+            if (eastl::find(m_dependencies.begin(), m_dependencies.end(), path) == m_dependencies.end())
+            {
+                m_dependencies.push_back(path);
+            }
+        }
+
+        eastl::vector<String>& m_dependencies;
     };
 
     Shader::Shader()
@@ -194,6 +224,53 @@ namespace Mantis
         return it->second;
     }
 
+    bool Shader::IsLayoutCompatible(const Shader& other) const
+    {
+        if (m_descriptorSetLayouts.size() != other.m_descriptorSetLayouts.size())
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < m_descriptorSetLayouts.size(); i++)
+        {
+            const auto& a = m_descriptorSetLayouts[i];
+            const auto& b = other.m_descriptorSetLayouts[i];
+
+            if (a.binding != b.binding ||
+                a.descriptorType != b.descriptorType ||
+                a.descriptorCount != b.descriptorCount ||
+                a.stageFlags != b.stageFlags ||
+                (a.pImmutableSamplers == nullptr) != (b.pImmutableSamplers == nullptr) ||
+                (a.pImmutableSamplers != nullptr && a.pImmutableSamplers[0] != b.pImmutableSamplers[0]))
+            {
+                return false;
+            }
+        }
+
+        auto pushConstantRanges = GetPushConstantRanges();
+        auto otherPushConstantRanges = other.GetPushConstantRanges();
+
+        if (pushConstantRanges.size() != otherPushConstantRanges.size())
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < pushConstantRanges.size(); i++)
+        {
+            const auto& a = pushConstantRanges[i];
+            const auto& b = otherPushConstantRanges[i];
+
+            if (a.offset != b.offset ||
+                a.size != b.size ||
+                a.stageFlags != b.stageFlags)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
     VkShaderStageFlagBits Shader::GetShaderStage(const String& filename)
     {
         auto fileExt{ String::Lowercase(FileSystem::FileSuffix(filename)) };
@@ -347,10 +424,17 @@ namespace Mantis
 
     VkShaderModule Shader::CreateShaderModule(const String& moduleName, const String& moduleCode, const String& preamble, const VkShaderStageFlags& moduleFlag)
     {
+        MANTIS_PROFILE_SCOPE("Shader::CreateShaderModule");
+
         auto logicalDevice = Renderer::Get()->GetLogicalDevice();
 
         m_stages.emplace_back(moduleName);
 
+        if (eastl::find(m_dependencies.begin(), m_dependencies.end(), moduleName) == m_dependencies.end())
+        {
+            m_dependencies.push_back(moduleName);
+        }
+
         // enable SPIR-V and Vulkan rules when parsing GLSL
         auto messages = static_cast<EShMessages>(EShMsgSpvRules | EShMsgVulkanRules | EShMsgDefault);
 #if defined(MANTIS_DEBUG)
@@ -373,7 +457,7 @@ namespace Mantis
         shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_3);
 
         auto defaultVersion = glslang::EShTargetVulkan_1_1;
-        ShaderIncluder includer;
+        ShaderIncluder includer(m_dependencies);
 
         std::string str;
         if (!shader.preprocess(&resources, defaultVersion, ENoProfile, false, false, messages, &str, includer))
@@ -381,6 +465,7 @@ namespace Mantis
             Logger::ErrorT(LOG_TAG, shader.getInfoLog());
             Logger::ErrorT(LOG_TAG, shader.getInfoDebugLog());
             Logger::ErrorT(LOG_TAG, "SPRIV shader preprocess failed!");
+            return VK_NULL_HANDLE;
         }
 
         if (!shader.parse(&resources, defaultVersion, true, messages, includer))
@@ -388,6 +473,7 @@ namespace Mantis
             Logger::ErrorT(LOG_TAG, shader.getInfoLog());
             Logger::ErrorT(LOG_TAG, shader.getInfoDebugLog());
             Logger::ErrorT(LOG_TAG, "SPRIV shader parse failed!");
+            return VK_NULL_HANDLE;
         }
 
         program.addShader(&shader);
@@ -395,6 +481,7 @@ namespace Mantis
         if (!program.link(messages) || !program.mapIO())
         {
             Logger::ErrorT(LOG_TAG, "Error while linking shader program!");
+            return VK_NULL_HANDLE;
         }
 
         program.buildReflection();
@@ -407,6 +494,13 @@ namespace Mantis
             {
                 m_localSizes[dim] = localSize;
             }
+
+            auto localSizeSpecId{ program.getIntermediate(language)->getLocalSizeSpecId(dim) };
+
+            if (localSizeSpecId != glslang::TQualifier::layoutNotSet)
+            {
+                m_localSizeSpecIds[dim] = static_cast<uint32_t>(localSizeSpecId);
+            }
         }
 
         for (int32_t i{ program.getNumLiveUniformBlocks() - 1 }; i >= 0; i--)
@@ -439,15 +533,19 @@ namespace Mantis
         std::vector<uint32_t> spirv;
         GlslangToSpv(*program.getIntermediate(static_cast<EShLanguage>(language)), spirv, &logger, &spvOptions);
 
+        // glslang does not reflect specialization constants, so they are found in the generated code
+        LoadSpecializationConstants(spirv, moduleFlag);
+
         VkShaderModuleCreateInfo shaderModuleCreateInfo = {};
         shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
         shaderModuleCreateInfo.codeSize = spirv.size() * sizeof(uint32_t);
         shaderModuleCreateInfo.pCode = spirv.data();
 
-        VkShaderModule shaderModule;
+        VkShaderModule shaderModule = VK_NULL_HANDLE;
         if (Renderer::Check(vkCreateShaderModule(*logicalDevice, &shaderModuleCreateInfo, nullptr, &shaderModule)))
         {
             Logger::ErrorT(LOG_TAG, "Failed to create shader module!");
+            return VK_NULL_HANDLE;
         }
         
         return shaderModule;
@@ -457,6 +555,19 @@ namespace Mantis
     {
         eastl::map<VkDescriptorType, uint32_t> descriptorPoolCounts;
 
+        for (const auto& name : m_dynamicUniformBlockNames)
+        {
+            auto it = m_uniformBlocks.find(name);
+
+            if (it == m_uniformBlocks.end() || it->second.m_type != UniformBlock::Type::Uniform)
+            {
+                Logger::WarningTF(LOG_TAG, "Dynamic uniform block \"%s\" is not a uniform block of the shader", name.c_str());
+                continue;
+            }
+
+            it->second.m_type = UniformBlock::Type::UniformDynamic;
+        }
+
         // process to descriptors
         for (const auto& [uniformBlockName, uniformBlock] : m_uniformBlocks)
         {
@@ -468,6 +579,10 @@ namespace Mantis
                     descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
                     m_descriptorSetLayouts.emplace_back(UniformBuffer::GetDescriptorSetLayout(static_cast<uint32_t>(uniformBlock.m_binding), descriptorType, uniformBlock.m_stageFlags, 1));
                     break;
+                case UniformBlock::Type::UniformDynamic:
+                    descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+                    m_descriptorSetLayouts.emplace_back(UniformBuffer::GetDescriptorSetLayout(static_cast<uint32_t>(uniformBlock.m_binding), descriptorType, uniformBlock.m_stageFlags, 1));
+                    break;
                 case UniformBlock::Type::Storage:
                     descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
                     m_descriptorSetLayouts.emplace_back(StorageBuffer::GetDescriptorSetLayout(static_cast<uint32_t>(uniformBlock.m_binding), descriptorType, uniformBlock.m_stageFlags, 1));
@@ -502,15 +617,52 @@ namespace Mantis
                     descriptorType = uniform.m_writeOnly ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
                     m_descriptorSetLayouts.emplace_back(ImageCube::GetDescriptorSetLayout(static_cast<uint32_t>(uniform.m_binding), descriptorType, uniform.m_stageFlags, 1));
                     break;
+                case 0x8DC1: // GL_SAMPLER_2D_ARRAY
+                case 0x9053: // GL_IMAGE_2D_ARRAY
+                    descriptorType = uniform.m_writeOnly ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                    m_descriptorSetLayouts.emplace_back(Image::GetDescriptorSetLayout(static_cast<uint32_t>(uniform.m_binding), descriptorType, uniform.m_stageFlags, static_cast<uint32_t>(uniform.m_count)));
+                    break;
                 default:
                     break;
             }
 
+            // samplers given a stock sampler have it baked into the layout, so it never needs to be written
+            if (descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+            {
+                auto it = eastl::find_if(m_immutableSamplerNames.begin(), m_immutableSamplerNames.end(), [&uniformName](const ImmutableSampler& immutableSampler)
+                {
+                    return immutableSampler.first == uniformName;
+                });
+
+                if (it != m_immutableSamplerNames.end())
+                {
+                    auto sampler = Renderer::Get()->GetSamplerCache()->GetStockSampler(it->second).GetSampler();
+                    auto count = static_cast<uint32_t>(uniform.m_count);
+
+                    auto samplers = eastl::make_unique<VkSampler[]>(count);
+                    for (uint32_t i = 0; i < count; i++)
+                    {
+                        samplers[i] = sampler;
+                    }
+
+                    m_descriptorSetLayouts.back().pImmutableSamplers = samplers.get();
+                    m_immutableSamplers.push_back(eastl::move(samplers));
+                }
+            }
+
             IncrementDescriptorPool(descriptorPoolCounts, descriptorType);
             m_descriptorLocations.emplace(uniformName, uniform.m_binding);
             m_descriptorSizes.emplace(uniformName, uniform.m_size);
         }
 
+        for (const auto& [name, stockSampler] : m_immutableSamplerNames)
+        {
+            if (m_descriptorLocations.find(name) == m_descriptorLocations.end())
+            {
+                Logger::WarningTF(LOG_TAG, "Immutable sampler \"%s\" is not used by the shader", name.c_str());
+            }
+        }
+
         for (const auto& [type, descriptorCount] : descriptorPoolCounts)
         {
             VkDescriptorPoolSize descriptorPoolSize{};
@@ -520,7 +672,7 @@ namespace Mantis
         }
 
         // TODO: This is a AMD workaround that works on NVidia too...
-        m_descriptorPools.resize(6);
+        m_descriptorPools.resize(7);
         m_descriptorPools[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         m_descriptorPools[0].descriptorCount = 4096;
         m_descriptorPools[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -533,6 +685,8 @@ namespace Mantis
         m_descriptorPools[4].descriptorCount = 2048;
         m_descriptorPools[5].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         m_descriptorPools[5].descriptorCount = 2048;
+        m_descriptorPools[6].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        m_descriptorPools[6].descriptorCount = 2048;
 
         // Sort descriptors by binding.
         std::sort(m_descriptorSetLayouts.begin(), m_descriptorSetLayouts.end(), [](const VkDescriptorSetLayoutBinding & l, const VkDescriptorSetLayoutBinding & r)
@@ -606,6 +760,16 @@ namespace Mantis
             }
         }
 
+        if (!m_constants.empty())
+        {
+            stream << "Specialization Constants: \n";
+
+            for (const auto& [constantName, constant] : m_constants)
+            {
+                stream << "  - " << constantName << ": " << constant.ToString() << " \n";
+            }
+        }
+
         for (uint32_t dim{}; dim < m_localSizes.size(); dim++)
         {
             if (m_localSizes[dim])
@@ -649,6 +813,7 @@ namespace Mantis
 
         auto type = UniformBlock::Type::None;
 
+        // blocks are made dynamic when the reflection is created, since which ones are dynamic may be set after compiling
         if (reflection.getType()->getQualifier().storage == glslang::EvqUniform)
         {
             type = UniformBlock::Type::Uniform;
@@ -700,7 +865,91 @@ namespace Mantis
         }
 
         auto& qualifier{ reflection.getType()->getQualifier() };
-        m_uniforms.emplace(reflection.name, Uniform(reflection.getBinding(), reflection.offset, -1, reflection.glDefineType, qualifier.readonly, qualifier.writeonly, stageFlag));
+        m_uniforms.emplace(reflection.name, Uniform(reflection.getBinding(), reflection.offset, -1, reflection.glDefineType, qualifier.readonly, qualifier.writeonly, stageFlag,
+            eastl::max(reflection.size, 1)));
+    }
+
+    void Shader::LoadSpecializationConstants(const std::vector<uint32_t>& spirv, const VkShaderStageFlags& stageFlag)
+    {
+        eastl::map<uint32_t, String> names;
+        eastl::map<uint32_t, uint32_t> specIds;
+        eastl::map<uint32_t, eastl::pair<int32_t, int32_t>> types;
+        eastl::map<uint32_t, uint32_t> constantTypes;
+
+        // skip the header, then walk the instructions collecting everything needed to describe the constants
+        for (size_t i = 5; i < spirv.size();)
+        {
+            auto op = static_cast<spv::Op>(spirv[i] & spv::OpCodeMask);
+            auto wordCount = spirv[i] >> spv::WordCountShift;
+
+            if (wordCount == 0 || i + wordCount > spirv.size())
+            {
+                Logger::ErrorT(LOG_TAG, "Invalid SPIR-V instruction while finding specialization constants!");
+                return;
+            }
+
+            const auto* operands = &spirv[i + 1];
+
+            switch (op)
+            {
+                case spv::OpName:
+                    names[operands[0]] = String(reinterpret_cast<const char*>(&operands[1]));
+                    break;
+                case spv::OpDecorate:
+                    if (operands[1] == spv::DecorationSpecId)
+                    {
+                        specIds[operands[0]] = operands[2];
+                    }
+                    break;
+                case spv::OpTypeBool:
+                    types[operands[0]] = eastl::make_pair(0x8B56, 4); // GL_BOOL
+                    break;
+                case spv::OpTypeInt:
+                    types[operands[0]] = eastl::make_pair(operands[2] ? 0x1404 : 0x1405, static_cast<int32_t>(operands[1] / 8)); // GL_INT, GL_UNSIGNED_INT
+                    break;
+                case spv::OpTypeFloat:
+                    types[operands[0]] = eastl::make_pair(operands[1] == 64 ? 0x140A : 0x1406, static_cast<int32_t>(operands[1] / 8)); // GL_DOUBLE, GL_FLOAT
+                    break;
+                case spv::OpSpecConstantTrue:
+                case spv::OpSpecConstantFalse:
+                case spv::OpSpecConstant:
+                    constantTypes[operands[1]] = operands[0];
+                    break;
+                default:
+                    break;
+            }
+
+            i += wordCount;
+        }
+
+        for (const auto& [resultId, constantId] : specIds)
+        {
+            auto constantType = constantTypes.find(resultId);
+
+            // composites such as gl_WorkGroupSize are decorated too, but only scalars can be specialized
+            if (constantType == constantTypes.end())
+            {
+                continue;
+            }
+
+            auto type = types.find(constantType->second);
+            if (type == types.end())
+            {
+                continue;
+            }
+
+            auto name = names.find(resultId);
+            auto constantName = name != names.end() && !name->second.empty() ? name->second : String().sprintf("constant_%u", constantId);
+
+            auto it = m_constants.find(constantName);
+            if (it != m_constants.end())
+            {
+                it->second.m_stageFlags |= stageFlag;
+                continue;
+            }
+
+            m_constants.emplace(constantName, Constant(static_cast<int32_t>(constantId), type->second.second, stageFlag, type->second.first));
+        }
     }
 
     void Shader::LoadVertexAttribute(const glslang::TProgram& program, const VkShaderStageFlags& stageFlag, const int32_t& i)
@@ -10,6 +10,8 @@ namespace glslang
 
 namespace Mantis
 {
+    enum struct StockSampler;
+
     /**
      * @brief Class that loads and processes a shader, and provides a reflection.
      */
@@ -24,6 +26,11 @@ namespace Mantis
          */
         using Define = eastl::pair<String, String>;
 
+        /**
+         * A stock sampler baked into the descriptor set layout, first value is the name of the combined image sampler and second is the stock sampler.
+         */
+        using ImmutableSampler = eastl::pair<String, StockSampler>;
+
         /// <summary>
         /// Class used to define sets of vertex inputs used in a shader.
         /// </summary>
@@ -45,6 +52,19 @@ namespace Mantis
                 return m_bindingDescriptions.front().binding < other.m_bindingDescriptions.front().binding;
             }
 
+            bool operator == (const VertexInput& other) const
+            {
+                return m_bindingDescriptions.size() == other.m_bindingDescriptions.size() &&
+                    m_attributeDescriptions.size() == other.m_attributeDescriptions.size() &&
+                    memcmp(m_bindingDescriptions.data(), other.m_bindingDescriptions.data(), m_bindingDescriptions.size() * sizeof(VkVertexInputBindingDescription)) == 0 &&
+                    memcmp(m_attributeDescriptions.data(), other.m_attributeDescriptions.data(), m_attributeDescriptions.size() * sizeof(VkVertexInputAttributeDescription)) == 0;
+            }
+
+            bool operator != (const VertexInput& other) const
+            {
+                return !(*this == other);
+            }
+
         private:
             uint32_t m_binding;
             eastl::vector<VkVertexInputBindingDescription> m_bindingDescriptions;
@@ -55,14 +75,15 @@ namespace Mantis
         {
         public:
             explicit Uniform(const int32_t& binding = -1, const int32_t& offset = -1, const int32_t& size = -1, const int32_t& glType = -1, const bool& readOnly = false,
-                const bool& writeOnly = false, const VkShaderStageFlags& stageFlags = 0) :
+                const bool& writeOnly = false, const VkShaderStageFlags& stageFlags = 0, const int32_t& count = 1) :
                 m_binding(binding),
                 m_offset(offset),
                 m_size(size),
                 m_glType(glType),
                 m_readOnly(readOnly),
                 m_writeOnly(writeOnly),
-                m_stageFlags(stageFlags)
+                m_stageFlags(stageFlags),
+                m_count(count)
             {
             }
 
@@ -80,6 +101,11 @@ namespace Mantis
 
             const VkShaderStageFlags& GetStageFlags() const { return m_stageFlags; }
 
+            /// <summary>
+            /// Gets the number of descriptors bound, which is greater than one for arrays of images.
+            /// </summary>
+            const int32_t& GetCount() const { return m_count; }
+
             bool operator == (const Uniform& other) const
             {
                 return
@@ -89,7 +115,8 @@ namespace Mantis
                     m_glType == other.m_glType &&
                     m_readOnly == other.m_readOnly &&
                     m_writeOnly == other.m_writeOnly &&
-                    m_stageFlags == other.m_stageFlags;
+                    m_stageFlags == other.m_stageFlags &&
+                    m_count == other.m_count;
             }
 
             bool operator != (const Uniform& other) const
@@ -114,14 +141,19 @@ namespace Mantis
             bool m_readOnly;
             bool m_writeOnly;
             VkShaderStageFlags m_stageFlags;
+            int32_t m_count;
         };
 
         class UniformBlock
         {
         public:
+            /// <summary>
+            /// The kind of buffer backing a block. Uniform blocks named with <see cref="Shader::SetDynamicUniformBlocks"/>
+            /// are bound as dynamic uniform buffers, so the offset can be changed when binding.
+            /// </summary>
             enum struct Type
             {
-                None, Uniform, Storage, Push
+                None, Uniform, UniformDynamic, Storage, Push
             };
 
             explicit UniformBlock(const int32_t& binding = -1, const int32_t& size = -1, const VkShaderStageFlags& stageFlags = 0, const Type& type = Type::Uniform) :
@@ -233,6 +265,9 @@ namespace Mantis
             int32_t m_glType;
         };
 
+        /// <summary>
+        /// A specialization constant. The binding is the constant ID used to specialize it.
+        /// </summary>
         class Constant
         {
         public:
@@ -314,6 +349,23 @@ namespace Mantis
 
         const eastl::array<eastl::optional<uint32_t>, 3>& GetLocalSizes() const { return m_localSizes; }
 
+        /// <summary>
+        /// Gets the specialization constant IDs which can be used to override each dimension of the local size.
+        /// </summary>
+        const eastl::array<eastl::optional<uint32_t>, 3>& GetLocalSizeSpecIds() const { return m_localSizeSpecIds; }
+
+        /// <summary>
+        /// Gets the paths of all source files used to compile this shader, including any includes.
+        /// </summary>
+        const eastl::vector<String>& GetDependencies() const { return m_dependencies; }
+
+        /// <summary>
+        /// Checks if the resources declared by this shader match another shader, such that
+        /// pipelines created with either shader can use the same pipeline layout.
+        /// </summary>
+        /// <param name="other">The shader to compare against.</param>
+        bool IsLayoutCompatible(const Shader& other) const;
+
         const eastl::vector<VkDescriptorSetLayoutBinding>& GetDescriptorSetLayouts() const { return m_descriptorSetLayouts; }
 
         const eastl::vector<VkDescriptorPoolSize>& GetDescriptorPools() const { return m_descriptorPools; }
@@ -324,8 +376,30 @@ namespace Mantis
 
         static VkShaderStageFlagBits GetShaderStage(const String& filename);
 
+        /// <summary>
+        /// Compiles a shader stage and adds it to the reflection.
+        /// </summary>
+        /// <param name="moduleName">The path of the shader source.</param>
+        /// <param name="moduleCode">The shader source code.</param>
+        /// <param name="preamble">Code inserted before the source, such as defines.</param>
+        /// <param name="moduleFlag">The stage of the shader.</param>
+        /// <returns>The shader module, or null if compilation failed.</returns>
         VkShaderModule CreateShaderModule(const String& moduleName, const String& moduleCode, const String& preamble, const VkShaderStageFlags& moduleFlag);
 
+        /// <summary>
+        /// Sets the combined image samplers which have a stock sampler baked into the descriptor set layout as an
+        /// immutable sampler, so the sampler never needs to be written. Must be set before creating the reflection.
+        /// </summary>
+        /// <param name="immutableSamplers">The combined image samplers and the stock sampler used by each.</param>
+        void SetImmutableSamplers(eastl::vector<ImmutableSampler> immutableSamplers) { m_immutableSamplerNames = eastl::move(immutableSamplers); }
+
+        /// <summary>
+        /// Sets the uniform blocks which are bound as dynamic uniform buffers, so the offset into the buffer is given
+        /// when binding, such as blocks allocated from the per frame uniform allocator. Must be set before creating the reflection.
+        /// </summary>
+        /// <param name="dynamicUniformBlocks">The names of the uniform blocks.</param>
+        void SetDynamicUniformBlocks(eastl::vector<String> dynamicUniformBlocks) { m_dynamicUniformBlockNames = eastl::move(dynamicUniformBlocks); }
+
         void CreateReflection();
 
         String ToString() const;
@@ -339,20 +413,32 @@ namespace Mantis
 
         void LoadVertexAttribute(const glslang::TProgram& program, const VkShaderStageFlags& stageFlag, const int32_t& i);
 
+        /// <summary>
+        /// Adds the specialization constants declared in a compiled shader stage to the reflection.
+        /// </summary>
+        /// <param name="spirv">The SPIR-V code of the stage.</param>
+        /// <param name="stageFlag">The stage of the shader.</param>
+        void LoadSpecializationConstants(const std::vector<uint32_t>& spirv, const VkShaderStageFlags& stageFlag);
+
         static int32_t ComputeSize(const glslang::TType* ttype);
 
         eastl::vector<String> m_stages;
+        eastl::vector<String> m_dependencies;
         eastl::map<String, Uniform> m_uniforms;
         eastl::map<String, UniformBlock> m_uniformBlocks;
         eastl::map<String, Attribute> m_attributes;
         eastl::map<String, Constant> m_constants;
 
         eastl::array<eastl::optional<uint32_t>, 3> m_localSizes;
+        eastl::array<eastl::optional<uint32_t>, 3> m_localSizeSpecIds;
 
         eastl::map<String, uint32_t> m_descriptorLocations;
         eastl::map<String, uint32_t> m_descriptorSizes;
 
         eastl::vector<VkDescriptorSetLayoutBinding> m_descriptorSetLayouts;
+        eastl::vector<ImmutableSampler> m_immutableSamplerNames;
+        eastl::vector<eastl::unique_ptr<VkSampler[]>> m_immutableSamplers;
+        eastl::vector<String> m_dynamicUniformBlockNames;
         uint32_t m_lastDescriptorBinding;
         eastl::vector<VkDescriptorPoolSize> m_descriptorPools;
         eastl::map<uint32_t, VkDescriptorType> m_descriptorTypes;
@@ -0,0 +1,192 @@
+#include "stdafx.h"
+#include "ShaderReloader.h"
+
+#include "Shader.h"
+#include "Renderer/Renderer.h"
+#include "Renderer/Pipeline/Pipeline.h"
+#include "Utils/Profiler.h"
+
+#define LOG_TAG MANTIS_TEXT("ShaderReloader")
+
+namespace Mantis
+{
+    /// <summary>
+    /// How long in milliseconds the watcher waits for changes before checking if it should stop.
+    /// </summary>
+    static const uint32_t POLL_TIMEOUT = 100;
+
+    /// <summary>
+    /// How long in milliseconds to collect further changes after the first, since editors often
+    /// write a file several times when saving.
+    /// </summary>
+    static const uint32_t DEBOUNCE_TIME = 50;
+
+    ShaderReloader::ShaderReloader()
+        : m_running(true)
+        , m_compiling(nullptr)
+    {
+        m_thread = std::thread(&ShaderReloader::Run, this);
+
+        Logger::InfoT(LOG_TAG, "Shader hot reloading enabled.");
+    }
+
+    ShaderReloader::~ShaderReloader()
+    {
+        m_running = false;
+
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    void ShaderReloader::Register(Pipeline* pipeline)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (eastl::find(m_pipelines.begin(), m_pipelines.end(), pipeline) == m_pipelines.end())
+        {
+            m_pipelines.push_back(pipeline);
+            WatchDependencies(pipeline);
+        }
+    }
+
+    void ShaderReloader::Unregister(Pipeline* pipeline)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_compileFinished.wait(lock, [this, pipeline]()
+        {
+            return m_compiling != pipeline;
+        });
+
+        m_pipelines.erase(eastl::remove(m_pipelines.begin(), m_pipelines.end(), pipeline), m_pipelines.end());
+        m_recompiled.erase(eastl::remove(m_recompiled.begin(), m_recompiled.end(), pipeline), m_recompiled.end());
+    }
+
+    void ShaderReloader::Update()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        uint32_t applied = 0;
+
+        for (auto it = m_recompiled.begin(); it != m_recompiled.end();)
+        {
+            auto pipeline = *it;
+
+            // the background thread reads the current shader while compiling, so a pipeline being compiled again
+            // keeps its pending result until the compile finishes, which then replaces it
+            if (pipeline == m_compiling)
+            {
+                ++it;
+                continue;
+            }
+
+            pipeline->ApplyRecompile();
+
+            // the new shader may have picked up new includes
+            WatchDependencies(pipeline);
+
+            it = m_recompiled.erase(it);
+            applied++;
+        }
+
+        if (applied > 0)
+        {
+            Logger::InfoTF(LOG_TAG, "Reloaded %u pipeline(s).", applied);
+        }
+    }
+
+    void ShaderReloader::Run()
+    {
+        Profiler::SetThreadName(MANTIS_TEXT("ShaderReloader"));
+
+        while (m_running)
+        {
+            auto modified = m_watcher.Poll(POLL_TIMEOUT);
+
+            if (modified.empty())
+            {
+                continue;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(DEBOUNCE_TIME));
+
+            for (const auto& path : m_watcher.Poll(0))
+            {
+                if (eastl::find(modified.begin(), modified.end(), path) == modified.end())
+                {
+                    modified.push_back(path);
+                }
+            }
+
+            for (const auto& path : modified)
+            {
+                Logger::InfoTF(LOG_TAG, "Detected change to \"%s\".", path.c_str());
+            }
+
+            // find every pipeline that uses a modified file
+            eastl::vector<Pipeline*> dependents;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                for (auto pipeline : m_pipelines)
+                {
+                    const auto& dependencies = pipeline->GetShader()->GetDependencies();
+
+                    for (const auto& path : modified)
+                    {
+                        if (eastl::find(dependencies.begin(), dependencies.end(), path) != dependencies.end())
+                        {
+                            dependents.push_back(pipeline);
+                            break;
+                        }
+                    }
+                }
+            }
+
+            for (auto pipeline : dependents)
+            {
+                if (!m_running)
+                {
+                    break;
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+
+                    // the pipeline may have been destroyed while compiling others
+                    if (eastl::find(m_pipelines.begin(), m_pipelines.end(), pipeline) == m_pipelines.end())
+                    {
+                        continue;
+                    }
+
+                    m_compiling = pipeline;
+                }
+
+                auto success = pipeline->Recompile();
+
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+
+                    m_compiling = nullptr;
+
+                    if (success && eastl::find(m_recompiled.begin(), m_recompiled.end(), pipeline) == m_recompiled.end())
+                    {
+                        m_recompiled.push_back(pipeline);
+                    }
+                }
+
+                m_compileFinished.notify_all();
+            }
+        }
+    }
+
+    void ShaderReloader::WatchDependencies(const Pipeline* pipeline)
+    {
+        for (const auto& path : pipeline->GetShader()->GetDependencies())
+        {
+            m_watcher.Watch(path);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include "ShaderWatcher.h"
+
+#include <atomic>
+#include <condition_variable>
+
+namespace Mantis
+{
+    class Pipeline;
+
+    /// <summary>
+    /// Rebuilds pipelines on a background thread when their shader sources change.
+    /// </summary>
+    /// <remarks>
+    /// Rebuilt pipelines are only swapped in by <see cref="Update"/>, so the render thread never
+    /// waits on shader compilation.
+    /// </remarks>
+    class ShaderReloader :
+        public NonCopyable
+    {
+    public:
+        /// <summary>
+        /// Creates a new shader reloader and starts watching for changes.
+        /// </summary>
+        ShaderReloader();
+
+        /// <summary>
+        /// Stops watching for changes and destroys the shader reloader.
+        /// </summary>
+        ~ShaderReloader();
+
+        /// <summary>
+        /// Starts rebuilding a pipeline when any of its shader sources change.
+        /// </summary>
+        /// <param name="pipeline">The pipeline to register.</param>
+        void Register(Pipeline* pipeline);
+
+        /// <summary>
+        /// Stops rebuilding a pipeline. Waits for the pipeline to finish compiling if needed.
+        /// </summary>
+        /// <param name="pipeline">The pipeline to unregister.</param>
+        void Unregister(Pipeline* pipeline);
+
+        /// <summary>
+        /// Swaps in all pipelines that have finished rebuilding. Must be called on the render
+        /// thread at a frame boundary.
+        /// </summary>
+        void Update();
+
+    private:
+        /// <summary>
+        /// The loop run by the background thread.
+        /// </summary>
+        void Run();
+
+        /// <summary>
+        /// Watches all the shader sources used by a pipeline.
+        /// </summary>
+        void WatchDependencies(const Pipeline* pipeline);
+
+        ShaderWatcher m_watcher;
+        std::thread m_thread;
+        std::atomic<bool> m_running;
+
+        std::mutex m_mutex;
+        std::condition_variable m_compileFinished;
+        eastl::vector<Pipeline*> m_pipelines;
+        eastl::vector<Pipeline*> m_recompiled;
+        const Pipeline* m_compiling;
+    };
+}
@@ -0,0 +1,239 @@
+#include "stdafx.h"
+#include "ShaderWatcher.h"
+
+#if defined(MANTIS_WINDOWS)
+#include "Utils/Platform/WindowsUtils.h"
+#elif defined(MANTIS_LINUX)
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#endif
+
+#define LOG_TAG MANTIS_TEXT("ShaderWatcher")
+
+namespace Mantis
+{
+    ShaderWatcher::ShaderWatcher()
+    {
+#if defined(MANTIS_LINUX)
+        m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+        if (m_inotify < 0)
+        {
+            Logger::ErrorTF(LOG_TAG, "Failed to initialize inotify: %s", strerror(errno));
+        }
+#endif
+    }
+
+    ShaderWatcher::~ShaderWatcher()
+    {
+        for (const auto& directory : m_directories)
+        {
+#if defined(MANTIS_WINDOWS)
+            FindCloseChangeNotification(directory.handle);
+#elif defined(MANTIS_LINUX)
+            inotify_rm_watch(m_inotify, directory.handle);
+#endif
+        }
+
+#if defined(MANTIS_LINUX)
+        if (m_inotify >= 0)
+        {
+            close(m_inotify);
+        }
+#endif
+    }
+
+    void ShaderWatcher::Watch(const String& path)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto [directoryPath, fileName] = SplitPath(path);
+
+        auto directory = eastl::find_if(m_directories.begin(), m_directories.end(), [&directoryPath](const WatchedDirectory& d)
+        {
+            return d.path == directoryPath;
+        });
+
+        if (directory == m_directories.end())
+        {
+            WatchedDirectory newDirectory = {};
+            newDirectory.path = directoryPath;
+
+#if defined(MANTIS_WINDOWS)
+            newDirectory.handle = FindFirstChangeNotificationW(
+                StringToWideChar(directoryPath).c_str(),
+                FALSE,
+                FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME
+            );
+
+            if (newDirectory.handle == INVALID_HANDLE_VALUE)
+            {
+                Logger::ErrorTF(LOG_TAG, "Failed to watch directory \"%s\": %s", directoryPath.c_str(), GetLastWindowsError().c_str());
+                return;
+            }
+#elif defined(MANTIS_LINUX)
+            newDirectory.handle = inotify_add_watch(m_inotify, directoryPath.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+            if (newDirectory.handle < 0)
+            {
+                Logger::ErrorTF(LOG_TAG, "Failed to watch directory \"%s\": %s", directoryPath.c_str(), strerror(errno));
+                return;
+            }
+#else
+            Logger::WarningT(LOG_TAG, "File watching is not supported on this platform!");
+            return;
+#endif
+
+            m_directories.push_back(newDirectory);
+            directory = m_directories.end() - 1;
+        }
+
+        if (eastl::find(directory->names.begin(), directory->names.end(), fileName) != directory->names.end())
+        {
+            return;
+        }
+
+        directory->names.push_back(fileName);
+        directory->files.push_back(path);
+
+#if defined(MANTIS_WINDOWS)
+        // record the current write time so only later modifications are reported
+        FILETIME writeTime = {};
+        WIN32_FILE_ATTRIBUTE_DATA attributes;
+        if (GetFileAttributesExW(StringToWideChar(path).c_str(), GetFileExInfoStandard, &attributes))
+        {
+            writeTime = attributes.ftLastWriteTime;
+        }
+        directory->writeTimes.push_back(writeTime);
+#endif
+    }
+
+    eastl::vector<String> ShaderWatcher::Poll(uint32_t timeout)
+    {
+        eastl::vector<String> modified;
+
+        auto addModified = [&modified](const String& path)
+        {
+            if (eastl::find(modified.begin(), modified.end(), path) == modified.end())
+            {
+                modified.push_back(path);
+            }
+        };
+
+#if defined(MANTIS_WINDOWS)
+        eastl::vector<HANDLE> handles;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto& directory : m_directories)
+            {
+                handles.push_back(directory.handle);
+            }
+        }
+
+        if (handles.empty())
+        {
+            Sleep(timeout);
+            return modified;
+        }
+
+        auto count = static_cast<DWORD>(eastl::min<size_t>(handles.size(), MAXIMUM_WAIT_OBJECTS));
+        auto result = WaitForMultipleObjects(count, handles.data(), FALSE, timeout);
+
+        if (result == WAIT_TIMEOUT || result == WAIT_FAILED)
+        {
+            return modified;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // the notification only tells us the directory changed, so compare write times of the watched files
+        for (auto& directory : m_directories)
+        {
+            if (WaitForSingleObject(directory.handle, 0) != WAIT_OBJECT_0)
+            {
+                continue;
+            }
+
+            FindNextChangeNotification(directory.handle);
+
+            for (size_t i = 0; i < directory.files.size(); i++)
+            {
+                const auto& path = directory.files[i];
+
+                WIN32_FILE_ATTRIBUTE_DATA attributes;
+                if (!GetFileAttributesExW(StringToWideChar(path).c_str(), GetFileExInfoStandard, &attributes))
+                {
+                    continue;
+                }
+
+                if (CompareFileTime(&attributes.ftLastWriteTime, &directory.writeTimes[i]) != 0)
+                {
+                    directory.writeTimes[i] = attributes.ftLastWriteTime;
+                    addModified(path);
+                }
+            }
+        }
+#elif defined(MANTIS_LINUX)
+        pollfd descriptor = {};
+        descriptor.fd = m_inotify;
+        descriptor.events = POLLIN;
+
+        if (poll(&descriptor, 1, static_cast<int>(timeout)) <= 0)
+        {
+            return modified;
+        }
+
+        alignas(inotify_event) char buffer[4096];
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        ssize_t length;
+        while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* ptr = buffer; ptr < buffer + length; ptr += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(ptr)->len)
+            {
+                auto event = reinterpret_cast<const inotify_event*>(ptr);
+
+                if (event->len == 0)
+                {
+                    continue;
+                }
+
+                for (const auto& directory : m_directories)
+                {
+                    if (directory.handle != event->wd)
+                    {
+                        continue;
+                    }
+
+                    auto name = eastl::find(directory.names.begin(), directory.names.end(), String(event->name));
+                    if (name != directory.names.end())
+                    {
+                        addModified(directory.files[name - directory.names.begin()]);
+                    }
+                    break;
+                }
+            }
+        }
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+#endif
+
+        return modified;
+    }
+
+    eastl::pair<String, String> ShaderWatcher::SplitPath(const String& path)
+    {
+        auto separator = path.find_last_of("/\\");
+
+        if (separator == String::npos)
+        {
+            return eastl::make_pair(String("."), path);
+        }
+
+        return eastl::make_pair(path.substr(0, separator), path.substr(separator + 1));
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Mantis.h"
+
+namespace Mantis
+{
+    /// <summary>
+    /// Watches shader source files for modifications.
+    /// </summary>
+    /// <remarks>
+    /// Directories are watched rather than files, since many editors save by replacing the file.
+    /// </remarks>
+    class ShaderWatcher :
+        public NonCopyable
+    {
+    public:
+        /// <summary>
+        /// Creates a new shader watcher.
+        /// </summary>
+        ShaderWatcher();
+
+        /// <summary>
+        /// Destroys the shader watcher.
+        /// </summary>
+        ~ShaderWatcher();
+
+        /// <summary>
+        /// Starts watching a file for modifications. Has no effect if the file is already watched.
+        /// </summary>
+        /// <param name="path">The path of the file to watch.</param>
+        void Watch(const String& path);
+
+        /// <summary>
+        /// Waits for any watched files to be modified.
+        /// </summary>
+        /// <param name="timeout">The maximum time to wait in milliseconds.</param>
+        /// <returns>The paths, as passed to <see cref="Watch"/>, of the files modified since the last poll.</returns>
+        eastl::vector<String> Poll(uint32_t timeout);
+
+    private:
+        /// <summary>
+        /// A directory containing watched files.
+        /// </summary>
+        struct WatchedDirectory
+        {
+            String path;
+            eastl::vector<String> names;
+            eastl::vector<String> files;
+#if defined(MANTIS_WINDOWS)
+            HANDLE handle;
+            eastl::vector<FILETIME> writeTimes;
+#elif defined(MANTIS_LINUX)
+            int handle;
+#endif
+        };
+
+        /// <summary>
+        /// Splits a path into the directory and file name.
+        /// </summary>
+        static eastl::pair<String, String> SplitPath(const String& path);
+
+        eastl::vector<WatchedDirectory> m_directories;
+        std::mutex m_mutex;
+
+#if defined(MANTIS_LINUX)
+        int m_inotify;
+#endif
+    };
+}
@@ -0,0 +1,168 @@
+#include "stdafx.h"
+#include "SpecializationConstants.h"
+
+#include "Shader/Shader.h"
+
+#define LOG_TAG MANTIS_TEXT("SpecializationConstants")
+
+namespace Mantis
+{
+    void SpecializationConstants::SetValue(const String& name, const uint32_t& id, const uint64_t& value, const uint32_t& size, const int32_t& glType)
+    {
+        for (size_t i = 0; i < m_entries.size(); i++)
+        {
+            auto& entry = m_entries[i];
+
+            if (name.empty() ? (entry.name.empty() && entry.id == id) : entry.name == name)
+            {
+                entry.size = size;
+                entry.glType = glType;
+                m_values[i] = value;
+                return;
+            }
+        }
+
+        Entry entry = {};
+        entry.name = name;
+        entry.id = id;
+        entry.size = size;
+        entry.glType = glType;
+        m_entries.push_back(entry);
+        m_values.push_back(value);
+    }
+
+    bool SpecializationConstants::GetSpecializationInfo(
+        const Shader& shader,
+        eastl::vector<VkSpecializationMapEntry>& mapEntries,
+        eastl::vector<uint8_t>& data,
+        VkSpecializationInfo& specializationInfo
+    ) const
+    {
+        mapEntries.clear();
+        data.clear();
+
+        for (size_t i = 0; i < m_entries.size(); i++)
+        {
+            const auto& entry = m_entries[i];
+
+            const Shader::Constant* constant = nullptr;
+            String constantName = entry.name;
+
+            for (const auto& [name, shaderConstant] : shader.GetConstants())
+            {
+                if (entry.name.empty() ? static_cast<uint32_t>(shaderConstant.GetBinding()) == entry.id : name == entry.name)
+                {
+                    constant = &shaderConstant;
+                    constantName = name;
+                    break;
+                }
+            }
+
+            // constants may be declared in only some of the shaders they are shared with, so this is not an error
+            if (constant == nullptr)
+            {
+                continue;
+            }
+
+            // the value is read using the size of the constant, so a value of another size can't be used
+            if (static_cast<uint32_t>(constant->GetSize()) != entry.size)
+            {
+                Logger::ErrorTF(LOG_TAG, "Specialization constant \"%s\" in shader \"%s\" is %i bytes, but is set to a %u byte value, the shader's default is used!",
+                    constantName.c_str(), shader.GetName().c_str(), constant->GetSize(), entry.size);
+                continue;
+            }
+
+            if (constant->GetGlType() != entry.glType)
+            {
+                Logger::WarningTF(LOG_TAG, "Specialization constant \"%s\" in shader \"%s\" does not match the type of the value it is set to!", constantName.c_str(), shader.GetName().c_str());
+            }
+
+            auto id = static_cast<uint32_t>(constant->GetBinding());
+
+            auto duplicate = eastl::find_if(mapEntries.begin(), mapEntries.end(), [&id](const VkSpecializationMapEntry& mapEntry)
+            {
+                return mapEntry.constantID == id;
+            });
+
+            if (duplicate != mapEntries.end())
+            {
+                Logger::WarningTF(LOG_TAG, "Specialization constant \"%s\" was set by both name and ID, using the first value.", constantName.c_str());
+                continue;
+            }
+
+            // each value is aligned to its size
+            auto offset = (data.size() + entry.size - 1) & ~static_cast<size_t>(entry.size - 1);
+            data.resize(offset + entry.size);
+            memcpy(data.data() + offset, &m_values[i], entry.size);
+
+            VkSpecializationMapEntry mapEntry = {};
+            mapEntry.constantID = id;
+            mapEntry.offset = static_cast<uint32_t>(offset);
+            mapEntry.size = entry.size;
+            mapEntries.push_back(mapEntry);
+        }
+
+        if (mapEntries.empty())
+        {
+            return false;
+        }
+
+        specializationInfo = {};
+        specializationInfo.mapEntryCount = static_cast<uint32_t>(mapEntries.size());
+        specializationInfo.pMapEntries = mapEntries.data();
+        specializationInfo.dataSize = data.size();
+        specializationInfo.pData = data.data();
+        return true;
+    }
+
+    size_t SpecializationConstants::GetHash() const
+    {
+        size_t hash = 0;
+
+        for (size_t i = 0; i < m_entries.size(); i++)
+        {
+            const auto& entry = m_entries[i];
+
+            auto entryHash = entry.name.empty() ? eastl::hash<uint32_t>()(entry.id) : eastl::hash<String>()(entry.name);
+            entryHash ^= eastl::hash<uint64_t>()(m_values[i]) * 31;
+
+            // combine without depending on the order the constants were set
+            hash += entryHash * 0x9E3779B9;
+        }
+
+        return hash;
+    }
+
+    bool SpecializationConstants::operator == (const SpecializationConstants& other) const
+    {
+        if (m_entries.size() != other.m_entries.size())
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < m_entries.size(); i++)
+        {
+            const auto& entry = m_entries[i];
+
+            auto found = false;
+
+            for (size_t j = 0; j < other.m_entries.size(); j++)
+            {
+                const auto& otherEntry = other.m_entries[j];
+
+                if (entry.name == otherEntry.name && entry.id == otherEntry.id)
+                {
+                    found = m_values[i] == other.m_values[j] && entry.size == otherEntry.size && entry.glType == otherEntry.glType;
+                    break;
+                }
+            }
+
+            if (!found)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include <EASTL/type_traits.h>
+
+namespace Mantis
+{
+    class Shader;
+
+    /// <summary>
+    /// A set of specialization constant values used when creating a pipeline.
+    /// </summary>
+    /// <remarks>
+    /// Constants can be set either by their constant ID or by name, in which case the ID is found
+    /// from the shader reflection when the pipeline is created. Values apply to all stages.
+    /// </remarks>
+    class SpecializationConstants
+    {
+    public:
+        SpecializationConstants() = default;
+
+        /// <summary>
+        /// Sets the value of a specialization constant.
+        /// </summary>
+        /// <param name="id">The constant ID declared in the shader using constant_id.</param>
+        /// <param name="value">The value of the constant. Must be a bool, a 32 or 64 bit integer, a float or a double,
+        /// the same size as the constant declared in the shader.</param>
+        template<typename T>
+        SpecializationConstants& Set(const uint32_t& id, const T& value)
+        {
+            SetValue(String(), id, ToValue(value), GetSize<T>(), GetGlType<T>());
+            return *this;
+        }
+
+        /// <summary>
+        /// Sets the value of a specialization constant.
+        /// </summary>
+        /// <param name="name">The name of the constant in the shader.</param>
+        /// <param name="value">The value of the constant. Must be a bool, a 32 or 64 bit integer, a float or a double,
+        /// the same size as the constant declared in the shader.</param>
+        template<typename T>
+        SpecializationConstants& Set(const String& name, const T& value)
+        {
+            SetValue(name, 0, ToValue(value), GetSize<T>(), GetGlType<T>());
+            return *this;
+        }
+
+        /// <summary>
+        /// Checks if no constants have been set.
+        /// </summary>
+        bool IsEmpty() const { return m_entries.empty(); }
+
+        /// <summary>
+        /// Creates the specialization info for a shader.
+        /// </summary>
+        /// <param name="shader">The shader to resolve named constants with.</param>
+        /// <param name="mapEntries">Returns the map entries, which must outlive the specialization info.</param>
+        /// <param name="data">Returns the constant values laid out to match the map entries, which must outlive the specialization info.</param>
+        /// <param name="specializationInfo">Returns the specialization info.</param>
+        /// <returns>False if no constants apply to the shader.</returns>
+        bool GetSpecializationInfo(
+            const Shader& shader,
+            eastl::vector<VkSpecializationMapEntry>& mapEntries,
+            eastl::vector<uint8_t>& data,
+            VkSpecializationInfo& specializationInfo
+        ) const;
+
+        /// <summary>
+        /// Gets a hash of the constant values, used when identifying pipeline variants.
+        /// </summary>
+        size_t GetHash() const;
+
+        bool operator == (const SpecializationConstants& other) const;
+
+        bool operator != (const SpecializationConstants& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        struct Entry
+        {
+            String name;
+            uint32_t id;
+            uint32_t size;
+            int32_t glType;
+        };
+
+        /// <summary>
+        /// Stores a value in the first bytes of a 64 bit integer, so its bytes can be copied back out in order.
+        /// </summary>
+        template<typename T>
+        static uint64_t ToValue(const T& value)
+        {
+            static_assert(sizeof(T) == sizeof(uint32_t) || sizeof(T) == sizeof(uint64_t) || eastl::is_same<T, bool>::value,
+                "Specialization constants must be a bool, a 32 or 64 bit integer, a float or a double!");
+
+            uint64_t result = 0;
+
+            if constexpr (eastl::is_same<T, bool>::value)
+            {
+                VkBool32 word = value ? VK_TRUE : VK_FALSE;
+                memcpy(&result, &word, sizeof(word));
+            }
+            else
+            {
+                memcpy(&result, &value, sizeof(T));
+            }
+
+            return result;
+        }
+
+        template<typename T>
+        static constexpr uint32_t GetSize()
+        {
+            return eastl::is_same<T, bool>::value ? sizeof(VkBool32) : sizeof(T);
+        }
+
+        template<typename T>
+        static constexpr int32_t GetGlType()
+        {
+            if constexpr (eastl::is_same<T, bool>::value)
+            {
+                return 0x8B56; // GL_BOOL
+            }
+            else if constexpr (eastl::is_same<T, float>::value)
+            {
+                return 0x1406; // GL_FLOAT
+            }
+            else if constexpr (eastl::is_same<T, double>::value)
+            {
+                return 0x140A; // GL_DOUBLE
+            }
+            else if constexpr (eastl::is_signed<T>::value)
+            {
+                return 0x1404; // GL_INT
+            }
+            else
+            {
+                return 0x1405; // GL_UNSIGNED_INT
+            }
+        }
+
+        void SetValue(const String& name, const uint32_t& id, const uint64_t& value, const uint32_t& size, const int32_t& glType);
+
+        eastl::vector<Entry> m_entries;
+        eastl::vector<uint64_t> m_values;
+    };
+}
+
+namespace eastl
+{
+    template<>
+    struct hash<Mantis::SpecializationConstants>
+    {
+        size_t operator () (const Mantis::SpecializationConstants& constants) const
+        {
+            return constants.GetHash();
+        }
+    };
+}
@@ -1,13 +1,17 @@
 #include "stdafx.h"
 #include "RenderGraph.h"
 
+#include "Renderer/Renderer.h"
+#include "Renderer/GpuProfiler.h"
 #include "Renderer/Utils/Stringify.h"
+#include "Utils/Profiler.h"
 
 #define LOG_TAG MANTIS_TEXT("RenderGraph")
 
 namespace Mantis
 {
     static const RenderGraphQueue COMPUTE_QUEUES = RenderGraphQueue::AsyncCompute | RenderGraphQueue::Compute;
+    static const RenderGraphQueue MAIN_QUEUES = RenderGraphQueue::Graphics | RenderGraphQueue::Compute;
 
     RenderGraph::RenderGraph()
     {
@@ -28,6 +32,26 @@ namespace Mantis
         m_physicalEvents.clear();
         m_physicalHistoryEvents.clear();
         m_physicalHistoryImageAttachments.clear();
+        m_asyncComputePasses.clear();
+        m_asyncComputeOverlaps.clear();
+    }
+
+    void RenderGraph::SetPassTime(const String& name, const float& milliseconds)
+    {
+        m_passTimes[name] = milliseconds;
+    }
+
+    void RenderGraph::SetPassTimes(const GpuProfiler& profiler)
+    {
+        for (auto& pass : m_passes)
+        {
+            auto time = profiler.GetAverageTime(pass->GetName());
+
+            if (time > 0.0f)
+            {
+                SetPassTime(pass->GetName(), time);
+            }
+        }
     }
 
     void RenderGraph::OnSwapchainChanged(const Vulkan::SwapchainParameterEvent&)
@@ -36,10 +60,106 @@ namespace Mantis
 
     void RenderGraph::OnSwapchainDestroyed(const Vulkan::SwapchainParameterEvent&)
     {
-        m_physicalImageAttachments.clear();
-        m_physicalHistoryImageAttachments.clear();
-        m_physicalEvents.clear();
-        m_physicalHistoryEvents.clear();
+        // images that don't depend on the swapchain are still valid for the next one
+        ReleaseSwapchainRelative();
+    }
+
+    void RenderGraph::ResizeBackbuffer(const ResourceDimensions& dim)
+    {
+        MANTIS_PROFILE_SCOPE("RenderGraph::ResizeBackbuffer");
+
+        auto formatChanged = dim.format != m_swapchainDimensions.format;
+        m_swapchainDimensions = dim;
+
+        // without a baked graph there is nothing to resize
+        if (m_physicalDimensions.empty())
+        {
+            return;
+        }
+
+        // a new format can change which resources may alias, so the whole graph must be baked again
+        if (formatChanged)
+        {
+            Bake();
+            return;
+        }
+
+        for (auto& resource : m_resources)
+        {
+            if (resource->GetType() != RenderResource::Type::Texture || resource->GetPhysicalIndex() == RenderResource::Unused)
+            {
+                continue;
+            }
+
+            auto& physicalDim = m_physicalDimensions[resource->GetPhysicalIndex()];
+
+            if (!physicalDim.swapchainRelative)
+            {
+                continue;
+            }
+
+            // only the size changes, the usage and queues gathered while baking still apply
+            auto newDim = GetResourceDimensions(static_cast<RenderTextureResource&>(*resource));
+            physicalDim.width = newDim.width;
+            physicalDim.height = newDim.height;
+            physicalDim.depth = newDim.depth;
+            physicalDim.levels = newDim.levels;
+        }
+
+        // aliases share one image, so if their sizes no longer match they must be found again
+        for (uint32_t i = 0; i < m_physicalAliases.size(); i++)
+        {
+            auto alias = m_physicalAliases[i];
+
+            if (alias != RenderResource::Unused && m_physicalDimensions[i] != m_physicalDimensions[alias])
+            {
+                Bake();
+                return;
+            }
+        }
+
+        // the backbuffer source can only be the swapchain image while they are the same size
+        if (m_swapchainPhysicalIndex != RenderResource::Unused)
+        {
+            const auto& backbufferDim = m_physicalDimensions[m_swapchainPhysicalIndex];
+
+            if (backbufferDim.width != dim.width || backbufferDim.height != dim.height)
+            {
+                Bake();
+                return;
+            }
+        }
+
+        ReleaseSwapchainRelative();
+    }
+
+    void RenderGraph::ReleaseSwapchainRelative()
+    {
+        // the images are destroyed once the frames using them complete, and are created at the new size when next set up
+        for (uint32_t i = 0; i < m_physicalDimensions.size(); i++)
+        {
+            if (!m_physicalDimensions[i].swapchainRelative)
+            {
+                continue;
+            }
+
+            if (i < m_physicalImageAttachments.size())
+            {
+                m_physicalImageAttachments[i].reset();
+            }
+            if (i < m_physicalHistoryImageAttachments.size())
+            {
+                m_physicalHistoryImageAttachments[i].reset();
+            }
+            if (i < m_physicalEvents.size())
+            {
+                m_physicalEvents[i] = {};
+            }
+            if (i < m_physicalHistoryEvents.size())
+            {
+                m_physicalHistoryEvents[i] = {};
+            }
+        }
     }
 
     RenderTextureResource& RenderGraph::GetTextureResource(const String& name)
@@ -119,6 +239,18 @@ namespace Mantis
         else
         {
             uint32_t index = m_passes.size();
+
+            if (queue == RenderGraphQueue::AsyncCompute)
+            {
+                m_asyncComputePasses.insert(index);
+
+                // use the graphics queue if there is no separate compute queue, or if overlapping was not worthwhile last bake
+                if (!Renderer::Get()->GetLogicalDevice()->HasAsyncCompute() || m_serialAsyncComputePasses.count(name))
+                {
+                    queue = RenderGraphQueue::Compute;
+                }
+            }
+
             m_passes.emplace_back(new RenderPass(*this, name, index, queue));
             m_passToIndex[name] = index;
             return *m_passes.back();
@@ -132,6 +264,8 @@ namespace Mantis
 
     void RenderGraph::Bake()
     {
+        MANTIS_PROFILE_SCOPE("RenderGraph::Bake");
+
         // reset state
         m_passStack.clear();
 
@@ -172,9 +306,15 @@ namespace Mantis
         eastl::reverse(begin(m_passStack), end(m_passStack));
         FilterPasses(m_passStack);
 
+        // find which passes each pass depends on, directly or indirectly, so the scheduling below doesn't walk the graph
+        BuildPassReachability();
+
         // reorder passes to extract better pipelining
         ReorderPasses(m_passStack);
 
+        // decide which async compute passes are worth overlapping with the graphics work
+        ScheduleAsyncCompute(m_passStack);
+
         // Figure out which physical resources are needed. Here we will alias resources which can trivially alias via renaming.
         BuildPhysicalResources();
 
@@ -523,6 +663,7 @@ namespace Mantis
                     if (mergeDep != dependee)
                     {
                         m_passDependencies[mergeDep].insert(dependee);
+                        AddPassReachability(mergeDep, dependee);
                     }
                 }
             }
@@ -615,6 +756,151 @@ namespace Mantis
         }
     }
 
+    void RenderGraph::ScheduleAsyncCompute(const eastl::vector<uint32_t>& flattenedPasses)
+    {
+        const auto& config = RendererConfig::Get();
+        auto available = Renderer::Get()->GetLogicalDevice()->HasAsyncCompute() && !config.renderGraphForceSingleQueue;
+
+        const auto getPassTime = [&](const RenderPass& pass, float& time)
+        {
+            auto itr = m_passTimes.find(pass.GetName());
+            if (itr == end(m_passTimes))
+            {
+                return false;
+            }
+            time += itr->second;
+            return true;
+        };
+
+        m_asyncComputeOverlaps.clear();
+
+        for (uint32_t i = 0; i < flattenedPasses.size(); i++)
+        {
+            auto& pass = *m_passes[flattenedPasses[i]];
+
+            if (!m_asyncComputePasses.count(pass.GetIndex()))
+            {
+                continue;
+            }
+
+            AsyncComputeOverlap overlap = {};
+            overlap.pass = pass.GetIndex();
+            overlap.waitPass = RenderResource::Unused;
+
+            // The graphics queue passes submitted after the compute pass may run alongside it, up until
+            // the first one that needs its results and must wait on a semaphore from the compute queue.
+            for (uint32_t j = i + 1; j < flattenedPasses.size(); j++)
+            {
+                auto& other = *m_passes[flattenedPasses[j]];
+
+                if (m_asyncComputePasses.count(other.GetIndex()) || HAS_NO_FLAG(other.GetQueue(), MAIN_QUEUES))
+                {
+                    continue;
+                }
+                if (DependsOnPass(other.GetIndex(), pass.GetIndex()))
+                {
+                    overlap.waitPass = other.GetIndex();
+                    break;
+                }
+
+                overlap.overlappedPasses.push_back(other.GetIndex());
+            }
+
+            // The time saved by overlapping is at most the shorter of the compute pass and the overlapped graphics
+            // work, and must make up for the cost of the queue hand-off. Until every pass involved has been measured,
+            // the pass is run asynchronously as requested.
+            auto measured = getPassTime(pass, overlap.computeTime);
+
+            for (auto& other : overlap.overlappedPasses)
+            {
+                measured &= getPassTime(*m_passes[other], overlap.graphicsTime);
+            }
+
+            auto saving = eastl::min(overlap.computeTime, overlap.graphicsTime);
+            overlap.async = available && (!measured || saving > config.asyncComputeHandoffCost);
+
+            if (available)
+            {
+                if (overlap.async)
+                {
+                    m_serialAsyncComputePasses.erase(pass.GetName());
+                }
+                else
+                {
+                    m_serialAsyncComputePasses.insert(pass.GetName());
+                }
+            }
+
+            m_asyncComputeOverlaps.push_back(eastl::move(overlap));
+        }
+    }
+
+    void RenderGraph::BuildPassReachability()
+    {
+        auto passCount = static_cast<uint32_t>(m_passes.size());
+        auto words = (passCount + 63) / 64;
+
+        m_passReachability.assign(passCount, eastl::vector<uint64_t>(words, 0));
+        eastl::vector<uint8_t> state(passCount, 0);
+
+        // each pass reaches itself and everything its dependencies reach, with every pass visited once
+        eastl::function<void(uint32_t)> visit = [&](uint32_t pass)
+        {
+            if (state[pass] != 0)
+            {
+                return;
+            }
+
+            // a cycle has already been reported when the dependencies were traversed, so it is just cut here
+            state[pass] = 1;
+
+            auto& reachable = m_passReachability[pass];
+            reachable[pass / 64] |= 1ull << (pass % 64);
+
+            for (auto& dependency : m_passDependencies[pass])
+            {
+                visit(dependency);
+
+                const auto& dependencyReachable = m_passReachability[dependency];
+                for (uint32_t i = 0; i < words; i++)
+                {
+                    reachable[i] |= dependencyReachable[i];
+                }
+            }
+
+            state[pass] = 2;
+        };
+
+        for (uint32_t pass = 0; pass < passCount; pass++)
+        {
+            visit(pass);
+        }
+    }
+
+    void RenderGraph::AddPassReachability(uint32_t dstPass, uint32_t srcPass)
+    {
+        // every pass which reaches the new dependee now also reaches everything the dependency reaches
+        const auto added = m_passReachability[srcPass];
+
+        for (uint32_t pass = 0; pass < m_passReachability.size(); pass++)
+        {
+            auto& reachable = m_passReachability[pass];
+
+            if ((reachable[dstPass / 64] >> (dstPass % 64)) & 1)
+            {
+                for (uint32_t i = 0; i < reachable.size(); i++)
+                {
+                    reachable[i] |= added[i];
+                }
+            }
+        }
+    }
+
+    bool RenderGraph::DependsOnPass(uint32_t dstPass, uint32_t srcPass) const
+    {
+        return (m_passReachability[dstPass][srcPass / 64] >> (srcPass % 64)) & 1;
+    }
+
     void RenderGraph::BuildPhysicalResources()
     {
         uint32_t physIndex = 0;
@@ -986,9 +1272,14 @@ namespace Mantis
             return itr != end(resourceList);
         };
 
+        // with dynamic rendering merging only helps tile based GPUs, while it forces the use of render pass objects
+        auto renderer = Renderer::Get();
+        auto mergeSubpasses = RendererConfig::Get().mergeSubpasses &&
+            (!renderer->UseDynamicRendering() || renderer->GetLogicalDevice()->GetCapabilities().tileBasedRenderer);
+
         const auto shouldMerge = [&](const RenderPass& prev, const RenderPass& next) -> bool
         {
-            if (!RendererConfig::Get().mergeSubpasses)
+            if (!mergeSubpasses)
             {
                 return false;
             }
@@ -1421,7 +1712,7 @@ namespace Mantis
                     // if this is the first subpass the attachment is used, we need to load it
                     if (res.second)
                     {
-                        rp.loadAttachments |= 1u << res.first;
+                        rp.opFlags |= RenderPassOp::LoadDepthStencil;
                     }
 
                     rp.opFlags |= RenderPassOp::StoreDepthStencil;
@@ -1503,6 +1794,11 @@ namespace Mantis
             }
 
             physicalPass.renderPassInfo.numColorAttachments = physicalPass.physicalColorAttachments.size();
+
+            // subpasses and input attachments need a render pass object
+            physicalPass.dynamicRendering = Renderer::Get()->UseDynamicRendering() &&
+                physicalPass.subpasses.size() == 1 &&
+                physicalPass.subpasses[0].numInputAttachments == 0;
         }
     }
 
@@ -2432,7 +2728,10 @@ namespace Mantis
                     continue;
                 }
 
-                if (m_physicalDimensions[i] == m_physicalDimensions[j])
+                // A resize only changes the swapchain relative resources, so one can't share an image with a fixed size
+                // resource even while their sizes happen to match.
+                if (m_physicalDimensions[i] == m_physicalDimensions[j] &&
+                    m_physicalDimensions[i].swapchainRelative == m_physicalDimensions[j].swapchainRelative)
                 {
                     // Only alias if the resources are used in the same queue, this way we avoid introducing
                     // multi-queue shenanigans. We can only use events to pass aliasing barriers.
@@ -2526,7 +2825,7 @@ namespace Mantis
 
         for (auto& subpasses : m_physicalPasses)
         {
-            Logger::DebugTF(LOG_TAG, "Pass #%u:", uint32_t(&subpasses - m_physicalPasses.data()));
+            Logger::DebugTF(LOG_TAG, "Pass #%u (%s):", uint32_t(&subpasses - m_physicalPasses.data()), subpasses.dynamicRendering ? "dynamic rendering" : "render pass");
 
             for (auto& barrier : subpasses.invalidate)
             {
@@ -2540,8 +2839,17 @@ namespace Mantis
 
             for (auto& subpass : subpasses.passes)
             {
-                Logger::DebugTF(LOG_TAG, "    Subpass #%u (%s):", uint32_t(&subpass - subpasses.passes.data()), m_passes[subpass]->GetName().c_str());
                 auto& pass = *m_passes[subpass];
+                auto passTime = m_passTimes.find(pass.GetName());
+
+                if (passTime != end(m_passTimes))
+                {
+                    Logger::DebugTF(LOG_TAG, "    Subpass #%u (%s): %.3f ms", uint32_t(&subpass - subpasses.passes.data()), pass.GetName().c_str(), passTime->second);
+                }
+                else
+                {
+                    Logger::DebugTF(LOG_TAG, "    Subpass #%u (%s):", uint32_t(&subpass - subpasses.passes.data()), pass.GetName().c_str());
+                }
 
                 auto& barriers = *barrierItr;
                 for (auto& barrier : barriers.invalidate)
@@ -2623,6 +2931,17 @@ namespace Mantis
             }
         }
 
+        for (auto& overlap : m_asyncComputeOverlaps)
+        {
+            Logger::DebugTF(LOG_TAG, "Async compute \"%s\" on %s queue: overlaps %u passes (%.3f ms compute, %.3f ms graphics), waited on by %s",
+                m_passes[overlap.pass]->GetName().c_str(),
+                overlap.async ? "compute" : "graphics",
+                uint32_t(overlap.overlappedPasses.size()),
+                overlap.computeTime,
+                overlap.graphicsTime,
+                overlap.waitPass != RenderResource::Unused ? m_passes[overlap.waitPass]->GetName().c_str() : "none");
+        }
+
         Logger::DebugT(LOG_TAG, "------------------------RENDER GRAPH END------------------------");
     }
 
@@ -2660,6 +2979,7 @@ namespace Mantis
                 break;
 
             case SizeMode::SwapchainRelative:
+                dim.swapchainRelative = true;
                 dim.width   = eastl::max(uint32_t(std::ceil(info.sizeX * m_swapchainDimensions.width)), 1u);
                 dim.height  = eastl::max(uint32_t(std::ceil(info.sizeY * m_swapchainDimensions.height)), 1u);
                 dim.depth   = eastl::max(uint32_t(std::ceil(info.sizeZ)), 1u);
@@ -2675,6 +2995,7 @@ namespace Mantis
                 auto& input = static_cast<RenderTextureResource&>(*m_resources[itr->second]);
                 auto inputDim = GetResourceDimensions(input);
 
+                dim.swapchainRelative = inputDim.swapchainRelative;
                 dim.width   = eastl::max(uint32_t(std::ceil(inputDim.width * info.sizeX)), 1u);
                 dim.height  = eastl::max(uint32_t(std::ceil(inputDim.height * info.sizeY)), 1u);
                 dim.depth   = eastl::max(uint32_t(std::ceil(inputDim.depth * info.sizeZ)), 1u);
@@ -2684,6 +3005,7 @@ namespace Mantis
 
         if (dim.format == VK_FORMAT_UNDEFINED)
         {
+            dim.swapchainRelative = true;
             dim.format = m_swapchainDimensions.format;
         }
 
@@ -13,6 +13,40 @@
 
 namespace Mantis
 {
+    class GpuProfiler;
+
+    /// <summary>
+    /// How an async compute pass was scheduled against the graphics queue when the graph was baked.
+    /// </summary>
+    struct AsyncComputeOverlap
+    {
+        /// <summary>
+        /// The index of the async compute pass.
+        /// </summary>
+        uint32_t pass;
+        /// <summary>
+        /// The index of the first graphics queue pass that uses the results of the compute pass, which must wait
+        /// on the compute queue. Unused if no graphics queue pass depends on it.
+        /// </summary>
+        uint32_t waitPass;
+        /// <summary>
+        /// The graphics queue passes that may execute while the compute pass runs.
+        /// </summary>
+        eastl::vector<uint32_t> overlappedPasses;
+        /// <summary>
+        /// The last measured GPU time of the compute pass in milliseconds.
+        /// </summary>
+        float computeTime;
+        /// <summary>
+        /// The last measured GPU time of the overlapped passes in milliseconds.
+        /// </summary>
+        float graphicsTime;
+        /// <summary>
+        /// Is the pass run on the compute queue. If false, it runs on the graphics queue once the graph is next built.
+        /// </summary>
+        bool async;
+    };
+
     /// <summary>
     /// Manages renderpasses and their dependencies, automatically handling
     /// transitions between them where possible.
@@ -56,11 +90,41 @@ namespace Mantis
             m_swapchainDimensions = dim;
         }
 
+        /// <summary>
+        /// Sets the dimensions of the graph output and resizes the swapchain relative resources to match, without
+        /// baking the graph again unless the change affects more than their size. Resources of a fixed size are kept.
+        /// </summary>
+        /// <param name="dim">The new output dimensions.</param>
+        void ResizeBackbuffer(const ResourceDimensions& dim);
+
         /// <summary>
         /// Resets the graph.
         /// </summary>
         void Reset();
 
+        /// <summary>
+        /// Sets the last measured GPU time of a renderpass, used to decide which async compute passes are worth
+        /// running on the compute queue. Takes effect the next time the graph is built and baked.
+        /// </summary>
+        /// <param name="name">The name of the renderpass.</param>
+        /// <param name="milliseconds">The GPU time of the renderpass in milliseconds.</param>
+        void SetPassTime(const String& name, const float& milliseconds);
+
+        /// <summary>
+        /// Sets the GPU time of each renderpass from the average time the profiler measured for the scope with
+        /// the same name. Passes the profiler has not measured keep their last time.
+        /// </summary>
+        /// <param name="profiler">The profiler to get the times from.</param>
+        void SetPassTimes(const GpuProfiler& profiler);
+
+        /// <summary>
+        /// Gets how the async compute passes were scheduled when the graph was last baked.
+        /// </summary>
+        const eastl::vector<AsyncComputeOverlap>& GetAsyncComputeOverlaps() const
+        {
+            return m_asyncComputeOverlaps;
+        }
+
         /// <summary>
         /// Bakes the graph from the current passes.
         /// </summary>
@@ -237,6 +301,9 @@ namespace Mantis
             eastl::vector<eastl::vector<ScaledClearRequests>> scaledClearRequests;
             eastl::vector<MipmapRequests> mipmapRequests;
             uint32_t layers = 1;
+
+            // if the pass is begun using dynamic rendering, or needs a render pass object
+            bool dynamicRendering = false;
         };
 
         struct PipelineEvent
@@ -255,6 +322,11 @@ namespace Mantis
         void OnSwapchainChanged(const Vulkan::SwapchainParameterEvent& e);
         void OnSwapchainDestroyed(const Vulkan::SwapchainParameterEvent& e);
 
+        /// <summary>
+        /// Releases the physical images whose size or format depends on the swapchain, so they are created again.
+        /// </summary>
+        void ReleaseSwapchainRelative();
+
         ResourceDimensions GetResourceDimensions(const RenderBufferResource& resource) const;
         ResourceDimensions GetResourceDimensions(const RenderTextureResource& resource) const;
 
@@ -268,6 +340,7 @@ namespace Mantis
         void TraverseDependencies(const RenderPass& pass, uint32_t stackCount);
         void FilterPasses(eastl::vector<uint32_t>& list);
         void ReorderPasses(eastl::vector<uint32_t>& flattenedPasses);
+        void ScheduleAsyncCompute(const eastl::vector<uint32_t>& flattenedPasses);
         void BuildPhysicalResources();
         void BuildPhysicalPasses();
         void BuildTransients();
@@ -285,7 +358,23 @@ namespace Mantis
             bool mergeDependency
         );
 
-        bool DependsOnPass(uint32_t dstPass, uint32_t srcPass);
+        /// <summary>
+        /// Finds the passes each pass depends on, directly or through other passes. Must be done once the dependencies are
+        /// known and before <see cref="DependsOnPass"/> is used.
+        /// </summary>
+        void BuildPassReachability();
+
+        /// <summary>
+        /// Updates the reachability after a dependency is added.
+        /// </summary>
+        /// <param name="dstPass">The pass which now depends on another pass.</param>
+        /// <param name="srcPass">The pass depended on.</param>
+        void AddPassReachability(uint32_t dstPass, uint32_t srcPass);
+
+        /// <summary>
+        /// Checks if a pass depends on another pass, directly or through other passes. Every pass depends on itself.
+        /// </summary>
+        bool DependsOnPass(uint32_t dstPass, uint32_t srcPass) const;
 
         static bool NeedInvalidate(const Barrier& barrier, const PipelineEvent& event);
 
@@ -307,9 +396,18 @@ namespace Mantis
         eastl::vector<PipelineEvent> m_physicalEvents;
         eastl::vector<PipelineEvent> m_physicalHistoryEvents;
 
+        eastl::unordered_map<String, float> m_passTimes;
+        eastl::unordered_set<uint32_t> m_asyncComputePasses;
+        eastl::unordered_set<String> m_serialAsyncComputePasses;
+        eastl::vector<AsyncComputeOverlap> m_asyncComputeOverlaps;
+
         eastl::vector<uint32_t> m_passStack;
         eastl::vector<eastl::unordered_set<uint32_t>> m_passDependencies;
         eastl::vector<eastl::unordered_set<uint32_t>> m_passMergeDependencies;
+        /// <summary>
+        /// A bitset for each pass of the passes it depends on, including itself.
+        /// </summary>
+        eastl::vector<eastl::vector<uint64_t>> m_passReachability;
 
         eastl::vector<PhysicalPass> m_physicalPasses;
         eastl::vector<bool> m_physicalImageHasHistory;
@@ -105,12 +105,17 @@ namespace Mantis
         bool transient = false;
         bool unormSrgb = false;
         bool persistent = true;
+        /// <summary>
+        /// Does the size or format depend on the swapchain, either directly or through an input.
+        /// </summary>
+        bool swapchainRelative = false;
         RenderGraphQueue queues = static_cast<RenderGraphQueue>(0);
         VkImageUsageFlags imageUsage = 0;
 
         bool operator == (const ResourceDimensions& other) const
         {
-            // imageUsage and queues are deliberately not part of this test
+            // imageUsage, queues and swapchainRelative are deliberately not part of this test, aliasing checks the
+            // queues and swapchainRelative separately
             return format == other.format &&
                 width == other.width &&
                 height == other.height &&
@@ -6,6 +6,8 @@
 
 namespace Mantis
 {
+    class ImageView;
+
     enum struct RenderPassOp : int
     {
         None                    = 0,
@@ -3,7 +3,9 @@
 
 #include "Renderer.h"
 #include "Renderpass/Renderpass.h"
+#include "Renderpass/RenderingInfo.h"
 #include "Image/ImageDepth.h"
+#include "Utils/Format.h"
 #include "Device/Window/Window.h"
 
 #define LOG_TAG MANTIS_TEXT("RenderStage")
@@ -19,7 +21,10 @@ namespace Mantis
         m_subpasses(eastl::move(subpasses)),
         m_viewport(viewport),
         m_subpassAttachmentCount(m_subpasses.size()),
-        m_subpassMultisampled(m_subpasses.size())
+        m_subpassMultisampled(m_subpasses.size()),
+        m_dynamicRendering(false),
+        m_colorFormats(),
+        m_pipelineRenderingInfo({})
     {
         for (const auto& attachment : m_attachments)
         {
@@ -111,13 +116,59 @@ namespace Mantis
             m_depthStencil = std::make_unique<ImageDepth>(m_renderArea.Size(), m_depthAttachment->IsMultisampled() ? msaaSamples : VK_SAMPLE_COUNT_1_BIT);
         }
 
-        if (m_renderpass == nullptr)
+        auto surface = Renderer::Get()->GetSurface();
+
+        // input attachments need a render pass to be read, as do several subpasses
+        m_dynamicRendering = Renderer::Get()->UseDynamicRendering() && m_subpasses.size() == 1 &&
+            eastl::none_of(m_subpasses.front().GetAttachmentRefs().begin(), m_subpasses.front().GetAttachmentRefs().end(), [](const AttachmentRef& attachmentRef)
+            {
+                return attachmentRef.mode == AttachmentMode::Input;
+            });
+
+        if (m_dynamicRendering)
         {
-            auto surface = Renderer::Get()->GetSurface();
+            m_colorFormats.clear();
+
+            for (const auto& attachmentRef : m_subpasses.front().GetAttachmentRefs())
+            {
+                if (attachmentRef.mode != AttachmentMode::Color)
+                {
+                    continue;
+                }
+
+                auto attachment = GetAttachment(attachmentRef.binding);
+
+                if (attachment->GetType() == Attachment::Type::Swapchain)
+                {
+                    m_colorFormats.emplace_back(surface->GetFormat().format);
+                }
+                else
+                {
+                    m_colorFormats.emplace_back(attachment->GetFormat());
+                }
+            }
+
+            m_pipelineRenderingInfo = {};
+            m_pipelineRenderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+            m_pipelineRenderingInfo.colorAttachmentCount = static_cast<uint32_t>(m_colorFormats.size());
+            m_pipelineRenderingInfo.pColorAttachmentFormats = m_colorFormats.data();
+
+            if (m_depthStencil)
+            {
+                auto depthFormat = m_depthStencil->GetFormat();
+                m_pipelineRenderingInfo.depthAttachmentFormat = Format::HasDepth(depthFormat) ? depthFormat : VK_FORMAT_UNDEFINED;
+                m_pipelineRenderingInfo.stencilAttachmentFormat = Format::HasStencil(depthFormat) ? depthFormat : VK_FORMAT_UNDEFINED;
+            }
+
+            m_renderpass = nullptr;
+        }
+        else
+        {
+            // the render pass comes from the cache, so getting it again is cheap and picks up surface format changes
             m_renderpass = std::make_unique<Renderpass>(*this, m_depthStencil->GetFormat(), surface->GetFormat().format, msaaSamples);
         }
 
-        m_framebuffers = std::make_unique<Framebuffers>(m_renderArea.Size(), *this, *m_renderpass, swapchain, *m_depthStencil, msaaSamples);
+        m_framebuffers = std::make_unique<Framebuffers>(m_renderArea.Size(), *this, m_renderpass.get(), swapchain, *m_depthStencil, msaaSamples);
 
         m_descriptors.clear();
 
@@ -176,12 +227,86 @@ namespace Mantis
         return nullptr;
     }
 
-    const VkFramebuffer& RenderStage::GetFramebuffer(const uint32_t& index) const
+    void RenderStage::SetRenderingAttachments(RenderingInfo& renderingInfo, const Swapchain& swapchain, const uint32_t& imageIndex) const
+    {
+        if (!m_dynamicRendering)
+        {
+            Logger::ErrorT(LOG_TAG, "Render stage uses a render pass, so can't be rendered dynamically!");
+            return;
+        }
+
+        const auto getView = [&](const Attachment& attachment)
+        {
+            if (attachment.GetType() == Attachment::Type::Swapchain)
+            {
+                return swapchain.GetImageViews().at(imageIndex);
+            }
+            return m_framebuffers->GetAttachment(attachment.GetBinding())->GetView();
+        };
+
+        // resolve attachments are given in the same order as the color attachments they resolve
+        eastl::vector<VkImageView> resolveViews;
+
+        for (const auto& attachmentRef : m_subpasses.front().GetAttachmentRefs())
+        {
+            if (attachmentRef.mode == AttachmentMode::Resolve)
+            {
+                resolveViews.emplace_back(getView(*GetAttachment(attachmentRef.binding)));
+            }
+        }
+
+        uint32_t colorIndex = 0;
+
+        for (const auto& attachmentRef : m_subpasses.front().GetAttachmentRefs())
+        {
+            auto attachment = GetAttachment(attachmentRef.binding);
+
+            switch (attachmentRef.mode)
+            {
+                case AttachmentMode::Color:
+                {
+                    auto format = m_colorFormats[colorIndex];
+                    auto resolveView = colorIndex < resolveViews.size() ? resolveViews[colorIndex] : VK_NULL_HANDLE;
+
+                    renderingInfo.AddColorAttachment(
+                        getView(*attachment),
+                        format,
+                        static_cast<VkAttachmentLoadOp>(attachment->GetLoadOp()),
+                        static_cast<VkAttachmentStoreOp>(attachment->GetStoreOp()),
+                        m_clearValues[attachmentRef.binding].color,
+                        resolveView);
+
+                    colorIndex++;
+                    break;
+                }
+                case AttachmentMode::Depth:
+                    renderingInfo.SetDepthStencilAttachment(
+                        m_depthStencil->GetView(),
+                        m_depthStencil->GetFormat(),
+                        false,
+                        static_cast<VkAttachmentLoadOp>(attachment->GetLoadOp()),
+                        static_cast<VkAttachmentStoreOp>(attachment->GetStoreOp()),
+                        m_clearValues[attachmentRef.binding].depthStencil);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    VkFramebuffer RenderStage::GetFramebuffer(const uint32_t& index) const
     {
-        if (index > m_framebuffers->GetFramebuffers().size())
+        // there are no framebuffers to fall back to when rendering dynamically
+        if (m_dynamicRendering || m_framebuffers->GetFramebufferCount() == 0)
+        {
+            Logger::ErrorT(LOG_TAG, "Render stage has no framebuffers, since it uses dynamic rendering!");
+            return VK_NULL_HANDLE;
+        }
+
+        if (index >= m_framebuffers->GetFramebufferCount())
         {
-            return m_framebuffers->GetFramebuffers().at(0);
+            return m_framebuffers->GetFramebuffer(0);
         }
-        return m_framebuffers->GetFramebuffers().at(index);
+        return m_framebuffers->GetFramebuffer(index);
     }
 }
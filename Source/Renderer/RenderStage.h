@@ -10,6 +10,8 @@
 
 namespace Mantis
 {
+    class RenderingInfo;
+
     class Viewport
     {
     public:
@@ -108,10 +110,29 @@ namespace Mantis
         const bool& IsOutOfDate() const { return m_outOfDate; }
 
         /// <summary>
-        /// Gets the renderpass for this render stage.
+        /// Gets the renderpass for this render stage, which is null if the stage uses dynamic rendering.
         /// </summary>
         const Renderpass* GetRenderpass() const { return m_renderpass.get(); };
 
+        /// <summary>
+        /// Gets if this stage renders without a render pass or framebuffers, which is the case when dynamic rendering
+        /// is supported and the stage has a single subpass that doesn't read input attachments.
+        /// </summary>
+        const bool& UsesDynamicRendering() const { return m_dynamicRendering; }
+
+        /// <summary>
+        /// Gets the attachment formats pipelines are created with when the stage uses dynamic rendering.
+        /// </summary>
+        const VkPipelineRenderingCreateInfo& GetPipelineRenderingInfo() const { return m_pipelineRenderingInfo; }
+
+        /// <summary>
+        /// Adds the attachments of this stage to a dynamic rendering, in place of beginning its render pass.
+        /// </summary>
+        /// <param name="renderingInfo">The rendering to add the attachments to.</param>
+        /// <param name="swapchain">The swapchain the swapchain attachment is taken from.</param>
+        /// <param name="imageIndex">The index of the swapchain image being rendered to.</param>
+        void SetRenderingAttachments(RenderingInfo& renderingInfo, const Swapchain& swapchain, const uint32_t& imageIndex) const;
+
         /// <summary>
         /// Gets the depth stencil for this render stage.
         /// </summary>
@@ -130,11 +151,13 @@ namespace Mantis
         const Descriptor* GetDescriptor(const String& name) const;
 
         /// <summary>
-        /// Gets a framebuffer by index.
+        /// Gets a framebuffer by index. Must be called each frame the framebuffer is used, as unused framebuffers
+        /// are destroyed by the renderpass cache.
         /// </summary>
         /// <param name="index">The index of the framebuffer to get.</param>
-        /// <returns>The framebuffer, or the first frambuffer in the index is invalid.</returns>
-        const VkFramebuffer& GetFramebuffer(const uint32_t& index) const;
+        /// <returns>The framebuffer, or the first frambuffer in the index is invalid. Null if the stage uses dynamic
+        /// rendering, which has no framebuffers.</returns>
+        VkFramebuffer GetFramebuffer(const uint32_t& index) const;
 
         /// <summary>
         /// Gets the clear values for all the attachments.
@@ -179,6 +202,10 @@ namespace Mantis
         eastl::optional<Attachment> m_depthAttachment;
         eastl::optional<Attachment> m_swapchainAttachment;
 
+        bool m_dynamicRendering;
+        eastl::vector<VkFormat> m_colorFormats;
+        VkPipelineRenderingCreateInfo m_pipelineRenderingInfo;
+
         Viewport m_viewport;
         RectInt m_renderArea;
         bool m_outOfDate;
@@ -5,16 +5,32 @@
 #include "vk_mem_alloc.h"
 
 #include "Renderer.h"
+#include "FrameContext.h"
+#include "FramePacer.h"
+#include "GpuProfiler.h"
+#include "Pipeline/Shader/ShaderReloader.h"
+#include "Streaming/StreamingEngine.h"
+#include "Buffer/UniformAllocator.h"
+#include "Image/MipGenerator.h"
+#include "Image/SamplerCache.h"
+#include "Renderpass/RenderpassCache.h"
+#include "Utils/Profiler.h"
 
 #define LOG_TAG MANTIS_TEXT("Renderer")
 
 namespace Mantis
 {
-    void Renderer::InitStart()
+    void Renderer::InitHeadless()
+    {
+        InitStart(true);
+        InitEnd(nullptr);
+    }
+
+    void Renderer::InitStart(const bool& headless)
     {
         if (!m_renderer)
         {
-            m_renderer = eastl::make_unique<Renderer>();
+            m_renderer = eastl::make_unique<Renderer>(headless);
         }
     }
 
@@ -24,6 +40,23 @@ namespace Mantis
         {
             m_renderer->CreateLogicalDevice(surface);
             m_renderer->CreateAllocator();
+            m_renderer->CreateFrames();
+            m_renderer->m_framePacer = eastl::make_unique<FramePacer>();
+
+            if (RendererConfig::Get().gpuProfiling)
+            {
+                m_renderer->m_gpuProfiler = eastl::make_unique<GpuProfiler>();
+            }
+
+            m_renderer->m_streamingEngine = eastl::make_unique<StreamingEngine>();
+            m_renderer->m_samplerCache = eastl::make_unique<SamplerCache>();
+            m_renderer->m_renderpassCache = eastl::make_unique<RenderpassCache>();
+            m_renderer->m_mipGenerator = eastl::make_unique<MipGenerator>();
+
+            if (RendererConfig::Get().shaderHotReload)
+            {
+                m_renderer->m_shaderReloader = eastl::make_unique<ShaderReloader>();
+            }
         }
     }
 
@@ -31,21 +64,111 @@ namespace Mantis
     {
         if (m_renderer)
         {
+            // the staging buffers must be released while the renderer is still accessible
+            m_renderer->m_streamingEngine.reset();
+
+            // the descriptor sets used by recent mip generation may still be in use
+            if (m_renderer->m_device)
+            {
+                vkDeviceWaitIdle(*m_renderer->m_device);
+            }
+
+            m_renderer->m_mipGenerator.reset();
+            m_renderer->m_samplerCache.reset();
+            m_renderer->m_renderpassCache.reset();
+
+            m_renderer->m_framePacer.reset();
+            m_renderer->m_gpuProfiler.reset();
+
+            // move the frames out first, so anything they release is destroyed immediately
+            auto frames = eastl::move(m_renderer->m_frames);
+            frames.clear();
+
+            m_renderer->m_uniformAllocator.reset();
+
             m_renderer.reset();
         }
     }
 
-    Renderer::Renderer() :
-        m_instance(eastl::make_unique<Instance>()),
-        m_physicalDevice(eastl::make_unique<PhysicalDevice>(m_instance))
+    Renderer::Renderer(const bool& headless) :
+        m_headless(headless),
+        m_instance(eastl::make_unique<Instance>(headless)),
+        m_physicalDevice(eastl::make_unique<PhysicalDevice>(m_instance, headless)),
+        m_frameCount(0),
+        m_frameActive(false)
     {
     }
 
     Renderer::~Renderer()
     {
+        // stop watching shaders before any pipelines are destroyed
+        m_shaderReloader.reset();
+
+        if (m_device)
+        {
+            vkDeviceWaitIdle(*m_device);
+        }
+
         vmaDestroyAllocator(m_allocator);
     }
 
+    FrameContext& Renderer::BeginFrame()
+    {
+        auto& frame = GetFrame();
+
+        if (!m_frameActive)
+        {
+            MANTIS_PROFILE_SCOPE("Renderer::BeginFrame");
+
+            m_framePacer->BeginFrame();
+            frame.Begin(m_frameCount);
+            m_frameActive = true;
+
+            m_renderpassCache->Update();
+
+            if (m_gpuProfiler)
+            {
+                m_gpuProfiler->BeginFrame(frame);
+            }
+        }
+
+        return frame;
+    }
+
+    void Renderer::EndFrame()
+    {
+        auto& frame = BeginFrame();
+
+        MANTIS_PROFILE_SCOPE("Renderer::EndFrame");
+
+        // uploads are submitted before the frame so it sees the data, and readbacks after it so they see what it rendered
+        m_streamingEngine->FlushUploads();
+        m_streamingEngine->Update();
+
+        frame.Submit();
+        m_streamingEngine->FlushReadbacks();
+        m_framePacer->EndFrame(frame);
+
+        if (m_shaderReloader)
+        {
+            m_shaderReloader->Update();
+        }
+
+        m_frameCount++;
+        m_frameActive = false;
+    }
+
+    void Renderer::DeferDestroy(eastl::function<void()>&& destroy)
+    {
+        if (m_frames.empty())
+        {
+            destroy();
+            return;
+        }
+
+        GetFrame().DeferDestroy(eastl::move(destroy));
+    }
+
     void Renderer::CreateLogicalDevice(const Surface* surface)
     {
         m_device = eastl::make_unique<LogicalDevice>(m_instance, m_physicalDevice, surface);
@@ -64,6 +187,20 @@ namespace Mantis
         }
     }
 
+    void Renderer::CreateFrames()
+    {
+        const auto& config = RendererConfig::Get();
+        auto frameCount = eastl::clamp(config.framesInFlight, 2u, RendererConfig::MAX_FRAMES_IN_FLIGHT);
+
+        // each frame context allocates from its own region, which it recycles once its fence has been waited on
+        m_uniformAllocator = eastl::make_unique<UniformAllocator>(config.frameUniformSize, frameCount, config.frameUniformRange);
+
+        for (uint32_t i = 0; i < frameCount; i++)
+        {
+            m_frames.push_back(eastl::make_unique<FrameContext>(i));
+        }
+    }
+
     const eastl::shared_ptr<CommandPool>& Renderer::GetCommandPool(const QueueType& queueType, const std::thread::id& threadId)
     {
         switch (queueType)
@@ -91,30 +228,112 @@ namespace Mantis
 
     void Renderer::DestroyBuffer(const VkBuffer& buffer, const VmaAllocation& allocation)
     {
+        DeferDestroy([this, buffer, allocation]()
+        {
+            vmaDestroyBuffer(m_allocator, buffer, allocation);
+        });
     }
 
     void Renderer::DestroyBufferView(const VkBufferView& view)
     {
+        DeferDestroy([this, view]()
+        {
+            vkDestroyBufferView(*m_device, view, nullptr);
+        });
     }
 
     void Renderer::DestroyImage(const VkImage& image, const VmaAllocation& allocation)
     {
+        DeferDestroy([this, image, allocation]()
+        {
+            vmaDestroyImage(m_allocator, image, allocation);
+        });
     }
 
     void Renderer::DestroyImageView(const VkImageView& view)
     {
+        // a new view could be given the same handle, which must not find the framebuffers using this one
+        if (m_renderpassCache)
+        {
+            m_renderpassCache->ReleaseView(view);
+        }
+
+        DeferDestroy([this, view]()
+        {
+            vkDestroyImageView(*m_device, view, nullptr);
+        });
     }
 
     void Renderer::DestroySampler(const VkSampler& sampler)
     {
+        DeferDestroy([this, sampler]()
+        {
+            vkDestroySampler(*m_device, sampler, nullptr);
+        });
     }
 
     void Renderer::DestroyFramebuffer(const VkFramebuffer& framebuffer)
     {
+        DeferDestroy([this, framebuffer]()
+        {
+            vkDestroyFramebuffer(*m_device, framebuffer, nullptr);
+        });
+    }
+
+    void Renderer::DestroySwapchain(const VkSwapchainKHR& swapchain)
+    {
+        DeferDestroy([this, swapchain]()
+        {
+            vkDestroySwapchainKHR(*m_device, swapchain, nullptr);
+        });
+    }
+
+    void Renderer::ReleaseSwapchain(const Swapchain& swapchain)
+    {
+        for (const auto& frame : m_frames)
+        {
+            frame->ReleaseSwapchain(swapchain);
+        }
     }
 
     void Renderer::DestroyPipeline(const VkPipeline& pipeline)
     {
+        DeferDestroy([this, pipeline]()
+        {
+            vkDestroyPipeline(*m_device, pipeline, nullptr);
+        });
+    }
+
+    void Renderer::DestroyPipelineLayout(const VkPipelineLayout& pipelineLayout)
+    {
+        DeferDestroy([this, pipelineLayout]()
+        {
+            vkDestroyPipelineLayout(*m_device, pipelineLayout, nullptr);
+        });
+    }
+
+    void Renderer::DestroyDescriptorSetLayout(const VkDescriptorSetLayout& descriptorSetLayout)
+    {
+        DeferDestroy([this, descriptorSetLayout]()
+        {
+            vkDestroyDescriptorSetLayout(*m_device, descriptorSetLayout, nullptr);
+        });
+    }
+
+    void Renderer::DestroyDescriptorPool(const VkDescriptorPool& descriptorPool)
+    {
+        DeferDestroy([this, descriptorPool]()
+        {
+            vkDestroyDescriptorPool(*m_device, descriptorPool, nullptr);
+        });
+    }
+
+    void Renderer::DestroyShaderModule(const VkShaderModule& shaderModule)
+    {
+        DeferDestroy([this, shaderModule]()
+        {
+            vkDestroyShaderModule(*m_device, shaderModule, nullptr);
+        });
     }
 
     bool Renderer::Check(const VkResult& result)
@@ -8,6 +8,7 @@
 #include "Device/Graphics/LogicalDevice.h"
 #include "Device/Graphics/Surface.h"
 
+#include "Renderer/RendererConfig.h"
 #include "Renderer/Utils/Stringify.h"
 #include "Renderer/Commands/CommandPool.h"
 
@@ -15,6 +16,17 @@
 
 namespace Mantis
 {
+    class FrameContext;
+    class FramePacer;
+    class GpuProfiler;
+    class MipGenerator;
+    class RenderpassCache;
+    class SamplerCache;
+    class ShaderReloader;
+    class StreamingEngine;
+    class Swapchain;
+    class UniformAllocator;
+
     class Renderer
     {
     public:
@@ -23,6 +35,22 @@ namespace Mantis
         /// </summary>
         static Renderer* Get() { return m_renderer.get(); }
 
+        /// <summary>
+        /// Creates a renderer which does not use the windowing system, for rendering offscreen where there is no display.
+        /// Present to an <see cref="OffscreenSwapchain"/> instead of a window. Works with software Vulkan implementations.
+        /// </summary>
+        static void InitHeadless();
+
+        /// <summary>
+        /// Destroys the renderer.
+        /// </summary>
+        static void Deinit();
+
+        /// <summary>
+        /// Gets if the renderer was created without the windowing system.
+        /// </summary>
+        const bool& IsHeadless() const { return m_headless; }
+
         /// <summary>
         /// Gets the Vulkan instance.
         /// </summary>
@@ -38,6 +66,11 @@ namespace Mantis
         /// </summary>
         const LogicalDevice* GetLogicalDevice() const { return m_device.get(); }
 
+        /// <summary>
+        /// Gets if render passes should be begun using dynamic rendering instead of render pass and framebuffer objects.
+        /// </summary>
+        bool UseDynamicRendering() const { return RendererConfig::Get().useDynamicRendering && m_device->GetCapabilities().dynamicRendering; }
+
         /// <summary>
         /// Gets the allocator instance.
         /// </summary>
@@ -51,13 +84,95 @@ namespace Mantis
         /// <returns>The command pool.</returns>
         const eastl::shared_ptr<CommandPool>& GetCommandPool(const QueueType& queueType, const std::thread::id& threadId = std::this_thread::get_id());
 
+        /// <summary>
+        /// Gets the shader reloader. Will be null if shader hot reloading is disabled.
+        /// </summary>
+        ShaderReloader* GetShaderReloader() const { return m_shaderReloader.get(); }
+
+        /// <summary>
+        /// Gets the streaming engine used to transfer data to and from device local resources.
+        /// </summary>
+        StreamingEngine* GetStreamingEngine() const { return m_streamingEngine.get(); }
+
+        /// <summary>
+        /// Gets the cache used to share samplers.
+        /// </summary>
+        SamplerCache* GetSamplerCache() const { return m_samplerCache.get(); }
+
+        /// <summary>
+        /// Gets the cache used to share render passes and framebuffers.
+        /// </summary>
+        RenderpassCache* GetRenderpassCache() const { return m_renderpassCache.get(); }
+
+        /// <summary>
+        /// Gets the generator used to create image mip maps using compute.
+        /// </summary>
+        MipGenerator* GetMipGenerator() const { return m_mipGenerator.get(); }
+
+        /// <summary>
+        /// Gets the allocator each frame context makes its uniform allocations from.
+        /// </summary>
+        UniformAllocator* GetUniformAllocator() const { return m_uniformAllocator.get(); }
+
+        /// <summary>
+        /// Gets the frame pacer, which schedules the start of frames and measures frame timings.
+        /// </summary>
+        FramePacer* GetFramePacer() const { return m_framePacer.get(); }
+
+        /// <summary>
+        /// Gets the profiler used to measure GPU time, or null if GPU profiling is disabled.
+        /// </summary>
+        GpuProfiler* GetGpuProfiler() const { return m_gpuProfiler.get(); }
+
+        /// <summary>
+        /// Gets the number of frames that have been completed.
+        /// </summary>
+        const uint64_t& GetFrameCount() const { return m_frameCount; }
+
+        /// <summary>
+        /// Gets the number of frames that may be in flight at once.
+        /// </summary>
+        uint32_t GetFramesInFlight() const { return static_cast<uint32_t>(m_frames.size()); }
+
+        /// <summary>
+        /// Begins recording a frame. Waits until the frame pacer allows the frame to start and the GPU has finished
+        /// the frame that last used the next frame context, then recycles its resources. Does nothing if the frame
+        /// has already begun.
+        /// </summary>
+        /// <returns>The context to record the frame with.</returns>
+        FrameContext& BeginFrame();
+
+        /// <summary>
+        /// Gets the context for the frame being recorded.
+        /// </summary>
+        FrameContext& GetFrame() const { return *m_frames[m_frameCount % m_frames.size()]; }
+
+        /// <summary>
+        /// Ends the current frame. Submits any queued streaming uploads, submits the frame's command buffers and
+        /// presents any acquired swapchain image, then submits any queued streaming readbacks, so they see what
+        /// the frame rendered, and swaps in any pipelines rebuilt since the last frame.
+        /// </summary>
+        void EndFrame();
+
         void DestroyBuffer(const VkBuffer& buffer, const VmaAllocation& allocation);
         void DestroyBufferView(const VkBufferView& view);
         void DestroyImage(const VkImage& image, const VmaAllocation& allocation);
         void DestroyImageView(const VkImageView& view);
         void DestroySampler(const VkSampler& sampler);
         void DestroyFramebuffer(const VkFramebuffer& framebuffer);
+        void DestroySwapchain(const VkSwapchainKHR& swapchain);
+
+        /// <summary>
+        /// Clears the references the frame contexts hold to a swapchain which is being destroyed, so a swapchain
+        /// later created at the same address is not mistaken for it.
+        /// </summary>
+        /// <param name="swapchain">The swapchain being destroyed.</param>
+        void ReleaseSwapchain(const Swapchain& swapchain);
         void DestroyPipeline(const VkPipeline& pipeline);
+        void DestroyPipelineLayout(const VkPipelineLayout& pipelineLayout);
+        void DestroyDescriptorSetLayout(const VkDescriptorSetLayout& descriptorSetLayout);
+        void DestroyDescriptorPool(const VkDescriptorPool& descriptorPool);
+        void DestroyShaderModule(const VkShaderModule& shaderModule);
 
         /// <summary>
         /// Determines if an operation was successful and logs any appropriate errors.
@@ -72,25 +187,30 @@ namespace Mantis
         /// <summary>
         /// Does the first stage of initialization.
         /// </summary>
-        static void InitStart();
+        /// <param name="headless">Create the renderer without the windowing system.</param>
+        static void InitStart(const bool& headless = false);
 
         /// <summary>
         /// Does the final stage of initialization.
         /// </summary>
+        /// <param name="surface">The surface of the first window, or null if headless.</param>
         static void InitEnd(const Surface* surface);
 
-        /// <summary>
-        /// Destroys the renderer.
-        /// </summary>
-        static void Deinit();
-
         static eastl::unique_ptr<Renderer> m_renderer;
 
-        Renderer();
+        explicit Renderer(const bool& headless);
         ~Renderer();
 
         void CreateLogicalDevice(const Surface* surface);
         void CreateAllocator();
+        void CreateFrames();
+
+        /// <summary>
+        /// Queues a destruction to run once the current frame is no longer in flight. Runs immediately if
+        /// there are no frames, since nothing can be in flight.
+        /// </summary>
+        /// <param name="destroy">The function that destroys the resource.</param>
+        void DeferDestroy(eastl::function<void()>&& destroy);
 
         /// <summary>
         /// Gets a command pool for a thread for a given queue.
@@ -100,6 +220,7 @@ namespace Mantis
         /// <returns>A command pool.</returns>
         const eastl::shared_ptr<CommandPool>& GetCommandPool(eastl::map<std::thread::id, eastl::shared_ptr<CommandPool>>& pools, const std::thread::id& threadId);
 
+        bool m_headless;
         eastl::unique_ptr<Instance> m_instance;
         eastl::unique_ptr<PhysicalDevice> m_physicalDevice;
         eastl::unique_ptr<LogicalDevice> m_device;
@@ -109,5 +230,18 @@ namespace Mantis
         eastl::map<std::thread::id, eastl::shared_ptr<CommandPool>> m_graphicsCommandPools;
         eastl::map<std::thread::id, eastl::shared_ptr<CommandPool>> m_computeCommandPools;
         eastl::map<std::thread::id, eastl::shared_ptr<CommandPool>> m_transferCommandPools;
+
+        eastl::unique_ptr<ShaderReloader> m_shaderReloader;
+        eastl::unique_ptr<StreamingEngine> m_streamingEngine;
+        eastl::unique_ptr<SamplerCache> m_samplerCache;
+        eastl::unique_ptr<RenderpassCache> m_renderpassCache;
+        eastl::unique_ptr<MipGenerator> m_mipGenerator;
+
+        eastl::unique_ptr<UniformAllocator> m_uniformAllocator;
+        eastl::vector<eastl::unique_ptr<FrameContext>> m_frames;
+        eastl::unique_ptr<FramePacer> m_framePacer;
+        eastl::unique_ptr<GpuProfiler> m_gpuProfiler;
+        uint64_t m_frameCount;
+        bool m_frameActive;
     };
 }
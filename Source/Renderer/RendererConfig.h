@@ -2,8 +2,26 @@
 
 #include "Mantis.h"
 
+#include "Device/Graphics/DeviceCapabilities.h"
+
 namespace Mantis
 {
+    /// <summary>
+    /// How the start of each frame is scheduled.
+    /// </summary>
+    enum struct FramePacing
+    {
+        /// <summary>
+        /// Frames start as soon as there is a free frame context, which gives the highest frame rate.
+        /// </summary>
+        Throughput,
+        /// <summary>
+        /// Frames start just in time to be presented at the next display refresh, which minimizes the latency
+        /// between reading input and the frame being displayed.
+        /// </summary>
+        LowLatency,
+    };
+
     /// <summary>
     /// Manages core configuration of the renderer.
     /// </summary>
@@ -14,11 +32,94 @@ namespace Mantis
         /// </summary>
         static const uint32_t MAX_ATTACHMENTS = 8;
 
+        /// <summary>
+        /// The most frames that may ever be in flight. Resources that are duplicated per frame use this
+        /// many copies, so they are safe to reuse whichever frame count is configured.
+        /// </summary>
+        static const uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+
+        /// <summary>
+        /// The highest device tier to enable, even if the device supports a higher one. Lowering it allows testing the
+        /// slower paths on any device. Read when the renderer is initialized.
+        /// </summary>
+        DeviceTier maxDeviceTier = DeviceTier::Modern;
+        /// <summary>
+        /// The number of frames the CPU may record ahead of the GPU, from 2 to MAX_FRAMES_IN_FLIGHT. More frames
+        /// hide stalls better at the cost of latency. Read when the renderer is initialized.
+        /// </summary>
+        uint32_t framesInFlight = 2;
+        /// <summary>
+        /// The maximum number of frames that may be submitted but not yet displayed. Also determines the number of swapchain images.
+        /// </summary>
+        uint32_t maxQueuedFrames = 2;
+        /// <summary>
+        /// How the start of each frame is scheduled.
+        /// </summary>
+        FramePacing framePacing = FramePacing::Throughput;
+        /// <summary>
+        /// The time in milliseconds low latency pacing leaves spare before the predicted display refresh, to absorb variation in frame times.
+        /// </summary>
+        float framePacingMargin = 1.0f;
+        /// <summary>
+        /// The time in milliseconds a window must stop resizing for before its swapchain is recreated. Zero recreates
+        /// the swapchain on every resize. A swapchain that can no longer be presented to is always recreated at once.
+        /// </summary>
+        float resizeDebounce = 100.0f;
+        /// <summary>
+        /// Scales the render resolution to keep the GPU time of each frame near the target.
+        /// </summary>
+        bool dynamicResolution = false;
+        /// <summary>
+        /// The GPU time in milliseconds dynamic resolution aims for.
+        /// </summary>
+        float dynamicResolutionTarget = 14.0f;
+        /// <summary>
+        /// The smallest render scale dynamic resolution may use, relative to the swapchain resolution.
+        /// </summary>
+        float dynamicResolutionMinScale = 0.5f;
+        /// <summary>
+        /// Measures the GPU time of profiler scopes using timestamp queries. Read when the renderer is initialized.
+        /// </summary>
+#if defined(MANTIS_DEBUG)
+        bool gpuProfiling = true;
+#else
+        bool gpuProfiling = false;
+#endif
+        /// <summary>
+        /// The most scopes that may be profiled on each queue in a frame.
+        /// </summary>
+        uint32_t gpuProfilerMaxScopes = 256;
+        /// <summary>
+        /// The number of recent frames the profiler timings and traces are computed from.
+        /// </summary>
+        uint32_t gpuProfilerHistory = 240;
+        /// <summary>
+        /// Allows profiler scopes to count pipeline statistics, if the device supports it.
+        /// </summary>
+        bool gpuProfilerStatistics = true;
+        /// <summary>
+        /// The number of bytes of uniform data each frame may allocate from its frame context.
+        /// </summary>
+        uint64_t frameUniformSize = 1024 * 1024;
+        /// <summary>
+        /// The size in bytes of the largest uniform block bound using the frame uniform allocations, at most maxUniformBufferRange.
+        /// </summary>
+        uint32_t frameUniformRange = 256;
+        /// <summary>
+        /// The number of bytes of staging memory each frame may allocate from its frame context.
+        /// </summary>
+        uint64_t frameStagingSize = 8 * 1024 * 1024;
         /// <summary>
         /// Combine renderpasses into subpasses where possible.
         /// </summary>
         bool mergeSubpasses = true;
         /// <summary>
+        /// Begins render passes using dynamic rendering where the device supports it, so no render pass or framebuffer
+        /// objects need to be created. Passes are then only merged into subpasses on tile based GPUs, which fall back
+        /// to render passes for the merged passes.
+        /// </summary>
+        bool useDynamicRendering = true;
+        /// <summary>
         /// Color rendertextures are transient.
         /// </summary>
         bool useTransientColor = true;
@@ -34,6 +135,23 @@ namespace Mantis
         /// Forces using a unified queue.
         /// </summary>
         bool renderGraphForceSingleQueue = false;
+        /// <summary>
+        /// The estimated GPU time in milliseconds lost handing work between queues. Async compute passes that would
+        /// save less than this by overlapping with graphics work are run on the graphics queue instead.
+        /// </summary>
+        float asyncComputeHandoffCost = 0.05f;
+        /// <summary>
+        /// The maximum number of bytes the streaming engine may have in flight before lower priority requests are delayed.
+        /// </summary>
+        uint64_t streamingBudget = 32 * 1024 * 1024;
+        /// <summary>
+        /// Watches shader source files and rebuilds pipelines when they change.
+        /// </summary>
+#if defined(MANTIS_DEBUG)
+        bool shaderHotReload = true;
+#else
+        bool shaderHotReload = false;
+#endif
 
         static RendererConfig& Get()
         {
@@ -4,6 +4,7 @@
 #include "Renderer/Renderer.h"
 #include "Renderer/RenderStage.h"
 #include "Renderpass.h"
+#include "RenderpassCache.h"
 
 #define LOG_TAG MANTIS_TEXT("Framebuffer")
 
@@ -12,16 +13,16 @@ namespace Mantis
     Framebuffers::Framebuffers(
         const Vector2Int& extent,
         const RenderStage& renderStage,
-        const Renderpass& renderPass,
+        const Renderpass* renderPass,
         const Swapchain& swapchain,
         const ImageDepth& depthStencil,
         const VkSampleCountFlagBits& samples
     ) : 
         m_imageAttachments({}),
-        m_framebuffers({})
+        m_attachmentViews({}),
+        m_renderpass(VK_NULL_HANDLE),
+        m_extent({ static_cast<uint32_t>(extent.x), static_cast<uint32_t>(extent.y) })
     {
-        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
-
         for (const auto& attachment : renderStage.GetAttachments())
         {
             auto attachmentSamples = attachment.IsMultisampled() ? samples : VK_SAMPLE_COUNT_1_BIT;
@@ -43,11 +44,18 @@ namespace Mantis
             }
         }
 
-        m_framebuffers.resize(swapchain.GetImageCount());
+        // dynamic rendering uses the attachment views directly
+        if (renderPass == nullptr)
+        {
+            return;
+        }
+
+        m_renderpass = renderPass->GetRenderpass();
+        m_attachmentViews.resize(swapchain.GetImageCount());
 
         for (uint32_t i = 0; i < swapchain.GetImageCount(); i++)
         {
-            eastl::vector<VkImageView> attachments;
+            auto& attachments = m_attachmentViews[i];
 
             for (const auto& attachment : renderStage.GetAttachments())
             {
@@ -64,30 +72,18 @@ namespace Mantis
                         break;
                 }
             }
-
-            VkFramebufferCreateInfo createInfo = {};
-            createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            createInfo.renderPass = renderPass.GetRenderpass();
-            createInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-            createInfo.pAttachments = attachments.data();
-            createInfo.width = static_cast<uint32_t>(extent.x);
-            createInfo.height = static_cast<uint32_t>(extent.y);
-            createInfo.layers = 1;
-
-            if (Renderer::Check(vkCreateFramebuffer(*logicalDevice, &createInfo, nullptr, &m_framebuffers[i])))
-            {
-                Logger::ErrorT(LOG_TAG, "Failed to crete framebuffer!");
-            }
         }
     }
 
-    Framebuffers::~Framebuffers()
+    VkFramebuffer Framebuffers::GetFramebuffer(const uint32_t& index) const
     {
-        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+        const auto& attachments = m_attachmentViews[index];
 
-        for (const auto& framebuffer : m_framebuffers)
-        {
-            vkDestroyFramebuffer(*logicalDevice, framebuffer, nullptr);
-        }
+        return Renderer::Get()->GetRenderpassCache()->GetFramebuffer(
+            m_renderpass,
+            attachments.data(),
+            static_cast<uint32_t>(attachments.size()),
+            m_extent
+        );
     }
 }
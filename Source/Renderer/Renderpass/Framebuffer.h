@@ -10,21 +10,28 @@ namespace Mantis
     class Renderpass;
     class RenderStage;
     
+    /// <summary>
+    /// Creates the attachment images of a render stage, and gets the framebuffers that use them with each swapchain
+    /// image from the renderpass cache.
+    /// </summary>
     class Framebuffers :
         public NonCopyable
     {
     public:
+        /// <summary>
+        /// Creates the attachments.
+        /// </summary>
+        /// <param name="renderPass">The render pass the framebuffers are used with, or null if the stage uses dynamic
+        /// rendering, in which case there are no framebuffers.</param>
         Framebuffers(
             const Vector2Int& extent,
             const RenderStage& renderStage,
-            const Renderpass& renderPass,
+            const Renderpass* renderPass,
             const Swapchain& swapchain,
             const ImageDepth& depthStencil,
             const VkSampleCountFlagBits& samples
         );
 
-        ~Framebuffers();
-
         /// <summary>
         /// Gets the image attachment for the given framebuffer index.
         /// </summary>
@@ -32,12 +39,21 @@ namespace Mantis
         ImageFramebuffer* GetAttachment(const uint32_t& index) const { return m_imageAttachments[index].get(); }
 
         /// <summary>
-        /// Gets all of the underlying framebuffer instances.
+        /// Gets the number of framebuffers, one for each swapchain image.
+        /// </summary>
+        uint32_t GetFramebufferCount() const { return static_cast<uint32_t>(m_attachmentViews.size()); }
+
+        /// <summary>
+        /// Gets the framebuffer used with a swapchain image. The cache destroys framebuffers that go unused,
+        /// so this must be called each frame the framebuffer is used instead of keeping the result.
         /// </summary>
-        const eastl::vector<VkFramebuffer>& GetFramebuffers() const { return m_framebuffers; }
+        /// <param name="index">The index of the swapchain image.</param>
+        VkFramebuffer GetFramebuffer(const uint32_t& index) const;
 
     private:
         eastl::vector<eastl::unique_ptr<ImageFramebuffer>> m_imageAttachments;
-        eastl::vector<VkFramebuffer> m_framebuffers;
+        eastl::vector<eastl::vector<VkImageView>> m_attachmentViews;
+        VkRenderPass m_renderpass;
+        VkExtent2D m_extent;
     };
 }
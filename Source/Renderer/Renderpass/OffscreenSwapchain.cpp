@@ -0,0 +1,271 @@
+#include "stdafx.h"
+#include "OffscreenSwapchain.h"
+
+#include "Renderer/Renderer.h"
+#include "Renderer/FrameContext.h"
+#include "Renderer/RenderGraph/RenderPass.h"
+#include "IO/FileStream.h"
+
+#define LOG_TAG MANTIS_TEXT("OffscreenSwapchain")
+
+namespace Mantis
+{
+    class OffscreenImage :
+        public Image
+    {
+    public:
+        OffscreenImage(const VkExtent3D& extent, const VkFormat& format)
+        {
+            Create(
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                0,
+                VK_IMAGE_TYPE_2D,
+                VK_IMAGE_VIEW_TYPE_2D,
+                extent,
+                format,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_SAMPLE_COUNT_1_BIT,
+                1,
+                1,
+                VK_FILTER_LINEAR,
+                VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                false
+            );
+        }
+    };
+
+    /// <summary>
+    /// Gets if the red and blue channels of a dumpable format are swapped, returning false if the format can't be dumped.
+    /// </summary>
+    static bool GetDumpSwizzle(const VkFormat& format, bool& swapRedBlue)
+    {
+        switch (format)
+        {
+            case VK_FORMAT_R8G8B8A8_UNORM:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+                swapRedBlue = false;
+                return true;
+            case VK_FORMAT_B8G8R8A8_UNORM:
+            case VK_FORMAT_B8G8R8A8_SRGB:
+                swapRedBlue = true;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    OffscreenSwapchain::OffscreenSwapchain(const Vector2Int& resolution, const VkFormat& format, const uint32_t& imageCount) :
+        m_extent({ static_cast<uint32_t>(resolution.x), static_cast<uint32_t>(resolution.y), 1 }),
+        m_format(format),
+        m_activeImageIndex(0),
+        m_presentCount(0),
+        m_dumpRoot(PathRoot::OutputDir),
+        m_dumpPath()
+    {
+        // an image must not be reused while a frame that rendered to it may still be executing
+        auto count = eastl::max(imageCount, Renderer::Get()->GetFramesInFlight());
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            m_images.push_back(eastl::make_unique<OffscreenImage>(m_extent, m_format));
+        }
+
+        m_dumps.resize(count);
+        m_activeImageIndex = count - 1;
+
+        Logger::InfoTF(LOG_TAG, "Created offscreen swapchain (%ix%i, %u images)", resolution.x, resolution.y, count);
+    }
+
+    OffscreenSwapchain::~OffscreenSwapchain()
+    {
+        for (auto& dump : m_dumps)
+        {
+            WriteDump(dump);
+        }
+    }
+
+    void OffscreenSwapchain::SetDumpPath(const PathRoot& root, const String& path)
+    {
+        bool swapRedBlue;
+        if (!path.empty() && !GetDumpSwizzle(m_format, swapRedBlue))
+        {
+            Logger::WarningTF(LOG_TAG, "Images with format %i can't be dumped!", m_format);
+            return;
+        }
+
+        m_dumpRoot = root;
+        m_dumpPath = path;
+    }
+
+    uint32_t OffscreenSwapchain::AcquireNextImage()
+    {
+        m_activeImageIndex = (m_activeImageIndex + 1) % GetImageCount();
+
+        // the copy from the last use of this image must be written before it is overwritten
+        WriteDump(m_dumps[m_activeImageIndex]);
+
+        return m_activeImageIndex;
+    }
+
+    void OffscreenSwapchain::Present(FrameContext& frame, const VkImageLayout& layout)
+    {
+        auto number = m_presentCount++;
+
+        if (m_dumpPath.empty())
+        {
+            return;
+        }
+
+        auto& image = GetActiveImage();
+        auto& dump = m_dumps[m_activeImageIndex];
+        auto size = static_cast<VkDeviceSize>(m_extent.width) * m_extent.height * 4;
+
+        if (dump.buffer == nullptr)
+        {
+            dump.buffer = eastl::make_unique<Buffer>(
+                size,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VMA_MEMORY_USAGE_GPU_TO_CPU,
+                nullptr,
+                VMA_ALLOCATION_CREATE_MAPPED_BIT
+            );
+        }
+
+        auto& commandBuffer = frame.RequestCommandBuffer();
+
+        VkImageMemoryBarrier imageBarrier = {};
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        imageBarrier.oldLayout = layout;
+        imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image = image.GetImage();
+        imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &imageBarrier
+        );
+
+        VkBufferImageCopy region = {};
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.imageExtent = m_extent;
+
+        vkCmdCopyImageToBuffer(
+            commandBuffer,
+            image.GetImage(),
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            dump.buffer->GetBuffer(),
+            1,
+            &region
+        );
+
+        VkMemoryBarrier hostBarrier = {};
+        hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+        // the image is returned to the layout the rendering left it in, so the next frame finds it as expected
+        imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        imageBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imageBarrier.newLayout = layout;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            1, &hostBarrier,
+            0, nullptr,
+            1, &imageBarrier
+        );
+
+        dump.pending = true;
+        dump.context = &frame;
+        dump.frame = frame.GetFrame();
+        dump.number = number;
+    }
+
+    ResourceDimensions OffscreenSwapchain::GetBackbufferDimensions() const
+    {
+        ResourceDimensions dimensions;
+        dimensions.format = m_format;
+        dimensions.width = m_extent.width;
+        dimensions.height = m_extent.height;
+        dimensions.transient = false;
+        dimensions.persistent = true;
+        dimensions.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        return dimensions;
+    }
+
+    void OffscreenSwapchain::WriteDump(Dump& dump)
+    {
+        if (!dump.pending)
+        {
+            return;
+        }
+
+        dump.pending = false;
+
+        // the context has been reused for a later frame, so the copy must have completed
+        if (dump.context->GetFrame() == dump.frame)
+        {
+            dump.context->Wait();
+        }
+
+        bool swapRedBlue;
+        if (!GetDumpSwizzle(m_format, swapRedBlue))
+        {
+            return;
+        }
+
+        String path = m_dumpPath;
+        path.append_sprintf("_%06llu.ppm", static_cast<unsigned long long>(dump.number));
+
+        auto file = Filesystem::Open(m_dumpRoot, path, FileMode::Overwrite);
+
+        if (file == nullptr)
+        {
+            Logger::ErrorTF(LOG_TAG, "Failed to open \"%s\" to dump image!", path.c_str());
+            return;
+        }
+
+        dump.buffer->Invalidate();
+
+        auto width = m_extent.width;
+        auto height = m_extent.height;
+        auto src = static_cast<const uint8_t*>(dump.buffer->GetMappedData());
+
+        // binary PPM stores tightly packed RGB rows
+        String header;
+        header.sprintf("P6\n%u %u\n255\n", width, height);
+
+        eastl::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 3);
+
+        for (size_t i = 0; i < static_cast<size_t>(width) * height; i++)
+        {
+            auto pixel = src + i * 4;
+            pixels[i * 3 + 0] = pixel[swapRedBlue ? 2 : 0];
+            pixels[i * 3 + 1] = pixel[1];
+            pixels[i * 3 + 2] = pixel[swapRedBlue ? 0 : 2];
+        }
+
+        auto headerSize = static_cast<int>(header.size());
+        auto pixelsSize = static_cast<int>(pixels.size());
+
+        if (!file->Write(reinterpret_cast<const uint8_t*>(header.data()), headerSize, headerSize) ||
+            !file->Write(pixels.data(), pixelsSize, pixelsSize))
+        {
+            Logger::ErrorTF(LOG_TAG, "Failed to write image dump \"%s\"!", path.c_str());
+        }
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include "IO/Filesystem.h"
+#include "Renderer/Buffer/Buffer.h"
+#include "Renderer/Image/Image.h"
+#include "Renderer/RendererConfig.h"
+
+namespace Mantis
+{
+    class FrameContext;
+    struct ResourceDimensions;
+
+    /// <summary>
+    /// Stands in for a swapchain when rendering without a window, cycling through a set of offscreen images.
+    /// </summary>
+    /// <remarks>
+    /// Acquire an image once per frame, render into the active image, then present it with the frame context.
+    /// The render graph is sized to the images through <see cref="GetBackbufferDimensions"/>, but does not yet
+    /// resolve its backbuffer into them, so the backbuffer must be copied into the active image by the caller. Presented images may be dumped to a numbered sequence of binary PPM
+    /// files, which are written once the GPU has finished with the frame, so recording is never stalled on
+    /// the copy. There are at least as many images as frames in flight, so an image is never rendered to while
+    /// an earlier frame that used it is still executing.
+    /// </remarks>
+    class OffscreenSwapchain :
+        public NonCopyable
+    {
+    public:
+        /// <summary>
+        /// Creates a new offscreen swapchain.
+        /// </summary>
+        /// <param name="resolution">The size of the images.</param>
+        /// <param name="format">The format of the images.</param>
+        /// <param name="imageCount">The number of images to cycle through.</param>
+        explicit OffscreenSwapchain(
+            const Vector2Int& resolution,
+            const VkFormat& format = VK_FORMAT_R8G8B8A8_UNORM,
+            const uint32_t& imageCount = RendererConfig::MAX_FRAMES_IN_FLIGHT
+        );
+
+        /// <summary>
+        /// Writes any pending dumps, waiting for the frames to complete.
+        /// </summary>
+        ~OffscreenSwapchain();
+
+        /// <summary>
+        /// Dumps every image presented from now on to "path_000000.ppm", numbered by present count. Only 8 bit RGBA
+        /// and BGRA formats can be dumped.
+        /// </summary>
+        /// <param name="root">The folder the path is relative to.</param>
+        /// <param name="path">The path to write the images to, without the number or extention. Empty to stop dumping.</param>
+        void SetDumpPath(const PathRoot& root, const String& path);
+
+        /// <summary>
+        /// Makes the next image active. Must be called once per frame after the frame has begun.
+        /// </summary>
+        /// <returns>The index of the acquired image.</returns>
+        uint32_t AcquireNextImage();
+
+        /// <summary>
+        /// Presents the active image, recording any dump into a new command buffer from the frame. Must be called after
+        /// all rendering to the image has been recorded.
+        /// </summary>
+        /// <param name="frame">The frame the image was rendered in.</param>
+        /// <param name="layout">The layout the rendering left the image in, which it is returned to after any dump.</param>
+        void Present(FrameContext& frame, const VkImageLayout& layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+        /// <summary>
+        /// Gets the resolution of the images.
+        /// </summary>
+        Vector2Int GetResolution() const { return Vector2Int(static_cast<int>(m_extent.width), static_cast<int>(m_extent.height)); }
+
+        /// <summary>
+        /// Gets the format of the images.
+        /// </summary>
+        const VkFormat& GetFormat() const { return m_format; }
+
+        /// <summary>
+        /// Gets the dimensions to give the render graph with <see cref="RenderGraph::SetBackbufferDimensions"/>, so the
+        /// swapchain relative resources are sized to the images.
+        /// </summary>
+        ResourceDimensions GetBackbufferDimensions() const;
+
+        /// <summary>
+        /// Gets the number of images.
+        /// </summary>
+        uint32_t GetImageCount() const { return static_cast<uint32_t>(m_images.size()); }
+
+        /// <summary>
+        /// Gets an image.
+        /// </summary>
+        /// <param name="index">The index of the image.</param>
+        Image& GetImage(const uint32_t& index) const { return *m_images[index]; }
+
+        /// <summary>
+        /// Gets the active image index.
+        /// </summary>
+        const uint32_t& GetActiveImageIndex() const { return m_activeImageIndex; }
+
+        /// <summary>
+        /// Gets the active image, which the graph backbuffer is rendered into.
+        /// </summary>
+        Image& GetActiveImage() const { return *m_images[m_activeImageIndex]; }
+
+        /// <summary>
+        /// Gets the number of images that have been presented.
+        /// </summary>
+        const uint64_t& GetPresentCount() const { return m_presentCount; }
+
+    private:
+        /// <summary>
+        /// A presented image being copied for dumping.
+        /// </summary>
+        struct Dump
+        {
+            bool pending = false;
+            FrameContext* context = nullptr;
+            uint64_t frame = 0;
+            uint64_t number = 0;
+            eastl::unique_ptr<Buffer> buffer;
+        };
+
+        /// <summary>
+        /// Writes the dump of an image to a file, waiting for the copy to complete.
+        /// </summary>
+        void WriteDump(Dump& dump);
+
+        VkExtent3D m_extent;
+        VkFormat m_format;
+        eastl::vector<eastl::unique_ptr<Image>> m_images;
+        uint32_t m_activeImageIndex;
+        uint64_t m_presentCount;
+
+        PathRoot m_dumpRoot;
+        String m_dumpPath;
+        eastl::vector<Dump> m_dumps;
+    };
+}
@@ -0,0 +1,268 @@
+#include "stdafx.h"
+#include "RenderingInfo.h"
+
+#include "Renderer/Image/ImageView.h"
+#include "Renderer/Utils/Format.h"
+
+#define LOG_TAG MANTIS_TEXT("RenderingInfo")
+
+namespace Mantis
+{
+    /// <summary>
+    /// Checks if a subpass renders to or reads from a color attachment of its render pass.
+    /// </summary>
+    static bool UsesColorAttachment(const RenderPassInfo::Subpass& subpass, const uint32_t& attachment)
+    {
+        for (uint32_t i = 0; i < subpass.numColorAttachments; i++)
+        {
+            if (subpass.colorAttachments[i] == attachment)
+            {
+                return true;
+            }
+        }
+        for (uint32_t i = 0; i < subpass.numResolveAttachments; i++)
+        {
+            if (subpass.resolveAttachments[i] == attachment)
+            {
+                return true;
+            }
+        }
+        for (uint32_t i = 0; i < subpass.numInputAttachments; i++)
+        {
+            if (subpass.inputAttachments[i] == attachment)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    RenderingInfo::RenderingInfo(const VkRect2D& renderArea, const uint32_t& layers) :
+        m_renderingInfo({}),
+        m_colorAttachments(),
+        m_depthAttachment({}),
+        m_stencilAttachment({}),
+        m_pipelineRenderingInfo({}),
+        m_colorFormats()
+    {
+        m_renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+        m_renderingInfo.renderArea = renderArea;
+        m_renderingInfo.layerCount = layers;
+        m_renderingInfo.pColorAttachments = m_colorAttachments;
+
+        m_pipelineRenderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+        m_pipelineRenderingInfo.pColorAttachmentFormats = m_colorFormats;
+    }
+
+    RenderingInfo::RenderingInfo(const RenderPassInfo& info, const uint32_t& subpass) :
+        RenderingInfo(info.renderArea, info.numLayers)
+    {
+        if (subpass >= info.numSubpasses)
+        {
+            Logger::ErrorTF(LOG_TAG, "Subpass %u is out of range for a render pass with %u subpasses!", subpass, info.numSubpasses);
+            return;
+        }
+
+        const auto& desc = info.subpasses[subpass];
+
+        if (desc.numInputAttachments > 0)
+        {
+            Logger::ErrorT(LOG_TAG, "Input attachments can't be read with dynamic rendering, a render pass must be used instead!");
+        }
+
+        const auto usedBefore = [&](const uint32_t& attachment)
+        {
+            for (uint32_t i = 0; i < subpass; i++)
+            {
+                if (UsesColorAttachment(info.subpasses[i], attachment))
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+        const auto usedAfter = [&](const uint32_t& attachment)
+        {
+            for (uint32_t i = subpass + 1; i < info.numSubpasses; i++)
+            {
+                if (UsesColorAttachment(info.subpasses[i], attachment))
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        // the render area defaults to the whole attachment
+        VkExtent2D extent = { UINT32_MAX, UINT32_MAX };
+
+        for (uint32_t i = 0; i < desc.numColorAttachments; i++)
+        {
+            auto attachment = desc.colorAttachments[i];
+            auto view = info.colorAttachments[attachment];
+
+            // attachments written by earlier subpasses must keep their contents
+            VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+
+            if (usedBefore(attachment) || (info.loadAttachments & (1u << attachment)))
+            {
+                loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+            }
+            else if (info.clearAttachments & (1u << attachment))
+            {
+                loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            }
+
+            VkAttachmentStoreOp storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+            if (usedAfter(attachment) || (info.storeAttachments & (1u << attachment)))
+            {
+                storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            }
+
+            VkImageView resolveView = VK_NULL_HANDLE;
+
+            if (i < desc.numResolveAttachments)
+            {
+                resolveView = info.colorAttachments[desc.resolveAttachments[i]]->GetView();
+            }
+
+            AddColorAttachment(view->GetView(), view->GetFormat(), loadOp, storeOp, info.clearColor[attachment], resolveView);
+
+            extent.width = eastl::min(extent.width, view->GetExtent().width);
+            extent.height = eastl::min(extent.height, view->GetExtent().height);
+        }
+
+        if (desc.depthStencilMode != RenderPassInfo::DepthStencilMode::None && info.depthStencil != nullptr)
+        {
+            auto view = info.depthStencil;
+
+            bool depthUsedBefore = false;
+            for (uint32_t i = 0; i < subpass; i++)
+            {
+                depthUsedBefore |= info.subpasses[i].depthStencilMode != RenderPassInfo::DepthStencilMode::None;
+            }
+
+            bool depthUsedAfter = false;
+            for (uint32_t i = subpass + 1; i < info.numSubpasses; i++)
+            {
+                depthUsedAfter |= info.subpasses[i].depthStencilMode != RenderPassInfo::DepthStencilMode::None;
+            }
+
+            VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+
+            if (depthUsedBefore || HAS_FLAGS(info.opFlags, RenderPassOp::LoadDepthStencil))
+            {
+                loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+            }
+            else if (HAS_FLAGS(info.opFlags, RenderPassOp::ClearDepthStencil))
+            {
+                loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            }
+
+            VkAttachmentStoreOp storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+            if (depthUsedAfter || HAS_FLAGS(info.opFlags, RenderPassOp::StoreDepthStencil))
+            {
+                storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            }
+
+            auto readOnly = desc.depthStencilMode == RenderPassInfo::DepthStencilMode::ReadOnly;
+
+            SetDepthStencilAttachment(view->GetView(), view->GetFormat(), readOnly, loadOp, storeOp, info.clearDepthStencil);
+
+            extent.width = eastl::min(extent.width, view->GetExtent().width);
+            extent.height = eastl::min(extent.height, view->GetExtent().height);
+        }
+
+        // unlike a framebuffer there is nothing to clamp the render area to, so it is done here
+        m_renderingInfo.renderArea = ClampRenderArea(m_renderingInfo.renderArea, extent);
+    }
+
+    VkRect2D RenderingInfo::ClampRenderArea(const VkRect2D& renderArea, const VkExtent2D& extent)
+    {
+        auto area = renderArea;
+
+        if (extent.width != UINT32_MAX && extent.height != UINT32_MAX)
+        {
+            area.offset.x = eastl::min(area.offset.x, static_cast<int32_t>(extent.width));
+            area.offset.y = eastl::min(area.offset.y, static_cast<int32_t>(extent.height));
+            area.extent.width = eastl::min(area.extent.width, extent.width - area.offset.x);
+            area.extent.height = eastl::min(area.extent.height, extent.height - area.offset.y);
+        }
+
+        return area;
+    }
+
+    void RenderingInfo::AddColorAttachment(
+        const VkImageView& view,
+        const VkFormat& format,
+        const VkAttachmentLoadOp& loadOp,
+        const VkAttachmentStoreOp& storeOp,
+        const VkClearColorValue& clearColor,
+        const VkImageView& resolveView)
+    {
+        if (m_renderingInfo.colorAttachmentCount >= RendererConfig::MAX_ATTACHMENTS)
+        {
+            Logger::ErrorTF(LOG_TAG, "At most %u color attachments may be used!", RendererConfig::MAX_ATTACHMENTS);
+            return;
+        }
+
+        auto index = m_renderingInfo.colorAttachmentCount++;
+        m_pipelineRenderingInfo.colorAttachmentCount = m_renderingInfo.colorAttachmentCount;
+
+        auto& attachment = m_colorAttachments[index];
+        attachment = {};
+        attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        attachment.imageView = view;
+        attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachment.loadOp = loadOp;
+        attachment.storeOp = storeOp;
+        attachment.clearValue.color = clearColor;
+
+        if (resolveView != VK_NULL_HANDLE)
+        {
+            attachment.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
+            attachment.resolveImageView = resolveView;
+            attachment.resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        }
+
+        m_colorFormats[index] = format;
+    }
+
+    void RenderingInfo::SetDepthStencilAttachment(
+        const VkImageView& view,
+        const VkFormat& format,
+        const bool& readOnly,
+        const VkAttachmentLoadOp& loadOp,
+        const VkAttachmentStoreOp& storeOp,
+        const VkClearDepthStencilValue& clearValue)
+    {
+        VkRenderingAttachmentInfo attachment = {};
+        attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        attachment.imageView = view;
+        attachment.imageLayout = readOnly ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        attachment.loadOp = loadOp;
+        attachment.storeOp = storeOp;
+        attachment.clearValue.depthStencil = clearValue;
+
+        // the depth and stencil aspects are given separately, and only those the format has may be given
+        m_renderingInfo.pDepthAttachment = nullptr;
+        m_renderingInfo.pStencilAttachment = nullptr;
+        m_pipelineRenderingInfo.depthAttachmentFormat = VK_FORMAT_UNDEFINED;
+        m_pipelineRenderingInfo.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+
+        if (Format::HasDepth(format))
+        {
+            m_depthAttachment = attachment;
+            m_renderingInfo.pDepthAttachment = &m_depthAttachment;
+            m_pipelineRenderingInfo.depthAttachmentFormat = format;
+        }
+        if (Format::HasStencil(format))
+        {
+            m_stencilAttachment = attachment;
+            m_renderingInfo.pStencilAttachment = &m_stencilAttachment;
+            m_pipelineRenderingInfo.stencilAttachmentFormat = format;
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include "Renderer/RendererConfig.h"
+#include "Renderer/RenderGraph/RenderPassInfo.h"
+
+namespace Mantis
+{
+    /// <summary>
+    /// Describes the attachments of a render pass begun with dynamic rendering, which needs no render pass or
+    /// framebuffer objects to be created.
+    /// </summary>
+    /// <remarks>
+    /// Unlike a render pass, dynamic rendering does not transition the attachments, so they must already be in the
+    /// attachment layouts when rendering begins and be transitioned by the caller afterwards.
+    /// </remarks>
+    class RenderingInfo :
+        public NonCopyable
+    {
+    public:
+        /// <summary>
+        /// Creates a description without attachments.
+        /// </summary>
+        /// <param name="renderArea">The area of the attachments to render to.</param>
+        /// <param name="layers">The number of layers to render to.</param>
+        explicit RenderingInfo(const VkRect2D& renderArea, const uint32_t& layers = 1);
+
+        /// <summary>
+        /// Creates a description of one subpass of a render graph pass. The attachments used by earlier subpasses
+        /// are loaded, and those used by later subpasses are stored.
+        /// </summary>
+        /// <param name="info">The render pass to describe.</param>
+        /// <param name="subpass">The index of the subpass to describe.</param>
+        RenderingInfo(const RenderPassInfo& info, const uint32_t& subpass);
+
+        /// <summary>
+        /// Adds a color attachment.
+        /// </summary>
+        /// <param name="view">The view to render to.</param>
+        /// <param name="format">The format of the view.</param>
+        /// <param name="loadOp">How the contents are initialized.</param>
+        /// <param name="storeOp">How the contents are kept once rendering ends.</param>
+        /// <param name="clearColor">The color to clear to, if the contents are cleared.</param>
+        /// <param name="resolveView">A view to resolve the multisampled contents to, or null.</param>
+        void AddColorAttachment(
+            const VkImageView& view,
+            const VkFormat& format,
+            const VkAttachmentLoadOp& loadOp,
+            const VkAttachmentStoreOp& storeOp,
+            const VkClearColorValue& clearColor = {},
+            const VkImageView& resolveView = VK_NULL_HANDLE
+        );
+
+        /// <summary>
+        /// Sets the depth stencil attachment.
+        /// </summary>
+        /// <param name="view">The view to render to.</param>
+        /// <param name="format">The format of the view.</param>
+        /// <param name="readOnly">Is the attachment only read from.</param>
+        /// <param name="loadOp">How the contents are initialized.</param>
+        /// <param name="storeOp">How the contents are kept once rendering ends.</param>
+        /// <param name="clearValue">The value to clear to, if the contents are cleared.</param>
+        void SetDepthStencilAttachment(
+            const VkImageView& view,
+            const VkFormat& format,
+            const bool& readOnly,
+            const VkAttachmentLoadOp& loadOp,
+            const VkAttachmentStoreOp& storeOp,
+            const VkClearDepthStencilValue& clearValue = { 1.0f, 0 }
+        );
+
+        /// <summary>
+        /// Gets the description to begin rendering with.
+        /// </summary>
+        const VkRenderingInfo& GetRenderingInfo() const { return m_renderingInfo; }
+
+        /// <summary>
+        /// Gets the attachment formats, which pipelines used while rendering must be created with.
+        /// </summary>
+        const VkPipelineRenderingCreateInfo& GetPipelineRenderingInfo() const { return m_pipelineRenderingInfo; }
+
+        /// <summary>
+        /// Limits a render area to the attachments, since the default render area covers any size.
+        /// </summary>
+        /// <param name="renderArea">The requested render area.</param>
+        /// <param name="extent">The size of the smallest attachment, or UINT32_MAX if there are no attachments.</param>
+        /// <returns>The part of the render area within the attachments.</returns>
+        static VkRect2D ClampRenderArea(const VkRect2D& renderArea, const VkExtent2D& extent);
+
+    private:
+        VkRenderingInfo m_renderingInfo;
+        VkRenderingAttachmentInfo m_colorAttachments[RendererConfig::MAX_ATTACHMENTS];
+        VkRenderingAttachmentInfo m_depthAttachment;
+        VkRenderingAttachmentInfo m_stencilAttachment;
+
+        VkPipelineRenderingCreateInfo m_pipelineRenderingInfo;
+        VkFormat m_colorFormats[RendererConfig::MAX_ATTACHMENTS];
+    };
+}
@@ -4,6 +4,7 @@
 #include "Subpass.h"
 #include "Renderer/Renderer.h"
 #include "Renderer/RenderStage.h"
+#include "RenderpassCache.h"
 
 #define LOG_TAG MANTIS_TEXT("Renderpass")
 
@@ -17,8 +18,6 @@ namespace Mantis
     ) :
         m_renderpass(VK_NULL_HANDLE)
     {
-        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
-
         // create the renderpasses attachment descriptions
         eastl::vector<VkAttachmentDescription> attachmentDescriptions;
 
@@ -114,7 +113,8 @@ namespace Mantis
             ));
         }
 
-        eastl::vector<VkSubpassDescription> subpassDescriptions(subpasses.size());
+        eastl::vector<VkSubpassDescription> subpassDescriptions;
+        subpassDescriptions.reserve(subpasses.size());
         for (const auto& subpass : subpasses)
         {
             subpassDescriptions.push_back(subpass->GetSubpassDescription());
@@ -174,7 +174,7 @@ namespace Mantis
 
         subpassDependencies.emplace_back(dependency);
 
-        // create the render pass
+        // get the render pass, which is shared with any other stage with the same layout
         VkRenderPassCreateInfo renderPassCreateInfo = {};
         renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
         renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(attachmentDescriptions.size());
@@ -183,17 +183,7 @@ namespace Mantis
         renderPassCreateInfo.pSubpasses = subpassDescriptions.data();
         renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(subpassDependencies.size());
         renderPassCreateInfo.pDependencies = subpassDependencies.data();
-        
-        if (Renderer::Check(vkCreateRenderPass(*logicalDevice, &renderPassCreateInfo, nullptr, &m_renderpass)))
-        {
-            Logger::ErrorT(LOG_TAG, "Failed to create renderpass!");
-        }
-    }
-
-    Renderpass::~Renderpass()
-    {
-        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
 
-        vkDestroyRenderPass(*logicalDevice, m_renderpass, nullptr);
+        m_renderpass = Renderer::Get()->GetRenderpassCache()->GetRenderpass(renderPassCreateInfo);
     }
 }
@@ -76,7 +76,7 @@ namespace Mantis
         };
 
         /// <summary>
-        /// Creates a new renderpass.
+        /// Gets the renderpass for a render stage from the renderpass cache, which owns it.
         /// </summary>
         /// <param name="renderStage">The render stage for this renderpass.</param>
         /// <param name="depthFormat">The format of the depth buffer, if applicable.</param>
@@ -89,11 +89,6 @@ namespace Mantis
             const VkSampleCountFlagBits& samples
         );
 
-        /// <summary>
-        /// Destroys the renderpass.
-        /// </summary>
-        ~Renderpass();
-
         /// <summary>
         /// Gets the underlying renderpass instance.
         /// </summary>
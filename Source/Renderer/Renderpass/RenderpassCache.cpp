@@ -0,0 +1,485 @@
+#include "stdafx.h"
+#include "RenderpassCache.h"
+
+#include "Renderer/Renderer.h"
+#include "Renderer/RenderGraph/RenderPassInfo.h"
+#include "Renderer/Image/ImageView.h"
+#include "Renderer/Utils/Format.h"
+#include "Utils/Profiler.h"
+
+#define LOG_TAG MANTIS_TEXT("RenderpassCache")
+
+namespace Mantis
+{
+    /// <summary>
+    /// The number of frames a framebuffer may go unused before it is destroyed.
+    /// </summary>
+    static const uint64_t FRAMEBUFFER_MAX_AGE = 8;
+
+    /// <summary>
+    /// Accumulates values into a key, along with its 64 bit hash. The hash finds the candidates and the key is
+    /// compared to tell them apart, since different descriptions may hash the same.
+    /// </summary>
+    class KeyBuilder
+    {
+    public:
+        void Combine(const uint64_t& value)
+        {
+            m_key.push_back(value);
+            m_hash ^= value + 0x9e3779b97f4a7c15ull + (m_hash << 6) + (m_hash >> 2);
+        }
+
+        template<typename T>
+        void Combine(const T* values, const uint32_t& count)
+        {
+            Combine(count);
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                Combine(static_cast<uint64_t>(values[i]));
+            }
+        }
+
+        const uint64_t& GetHash() const { return m_hash; }
+
+        eastl::vector<uint64_t>& GetKey() { return m_key; }
+
+    private:
+        uint64_t m_hash = 0;
+        eastl::vector<uint64_t> m_key;
+    };
+
+    static void HashAttachmentReferences(KeyBuilder& hasher, const VkAttachmentReference* references, const uint32_t& count)
+    {
+        hasher.Combine(references != nullptr ? count : 0);
+
+        for (uint32_t i = 0; references != nullptr && i < count; i++)
+        {
+            hasher.Combine(references[i].attachment);
+            hasher.Combine(references[i].layout);
+        }
+    }
+
+    static void HashRenderpass(KeyBuilder& hasher, const VkRenderPassCreateInfo& createInfo)
+    {
+        hasher.Combine(createInfo.flags);
+        hasher.Combine(createInfo.attachmentCount);
+
+        for (uint32_t i = 0; i < createInfo.attachmentCount; i++)
+        {
+            const auto& attachment = createInfo.pAttachments[i];
+            hasher.Combine(attachment.flags);
+            hasher.Combine(attachment.format);
+            hasher.Combine(attachment.samples);
+            hasher.Combine(attachment.loadOp);
+            hasher.Combine(attachment.storeOp);
+            hasher.Combine(attachment.stencilLoadOp);
+            hasher.Combine(attachment.stencilStoreOp);
+            hasher.Combine(attachment.initialLayout);
+            hasher.Combine(attachment.finalLayout);
+        }
+
+        hasher.Combine(createInfo.subpassCount);
+
+        for (uint32_t i = 0; i < createInfo.subpassCount; i++)
+        {
+            const auto& subpass = createInfo.pSubpasses[i];
+            hasher.Combine(subpass.flags);
+            hasher.Combine(subpass.pipelineBindPoint);
+            HashAttachmentReferences(hasher, subpass.pInputAttachments, subpass.inputAttachmentCount);
+            HashAttachmentReferences(hasher, subpass.pColorAttachments, subpass.colorAttachmentCount);
+            HashAttachmentReferences(hasher, subpass.pResolveAttachments, subpass.colorAttachmentCount);
+            HashAttachmentReferences(hasher, subpass.pDepthStencilAttachment, 1);
+            hasher.Combine(subpass.pPreserveAttachments, subpass.preserveAttachmentCount);
+        }
+
+        hasher.Combine(createInfo.dependencyCount);
+
+        for (uint32_t i = 0; i < createInfo.dependencyCount; i++)
+        {
+            const auto& dependency = createInfo.pDependencies[i];
+            hasher.Combine(dependency.srcSubpass);
+            hasher.Combine(dependency.dstSubpass);
+            hasher.Combine(dependency.srcStageMask);
+            hasher.Combine(dependency.dstStageMask);
+            hasher.Combine(dependency.srcAccessMask);
+            hasher.Combine(dependency.dstAccessMask);
+            hasher.Combine(dependency.dependencyFlags);
+        }
+    }
+
+    RenderpassCache::RenderpassCache() :
+        m_renderpasses(),
+        m_framebuffers(),
+        m_stats()
+    {
+    }
+
+    RenderpassCache::~RenderpassCache()
+    {
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        // the device is idle by now, so nothing can still be using these
+        for (const auto& entry : m_framebuffers)
+        {
+            vkDestroyFramebuffer(*logicalDevice, entry.second.framebuffer, nullptr);
+        }
+        for (const auto& entry : m_renderpasses)
+        {
+            vkDestroyRenderPass(*logicalDevice, entry.second.renderPass, nullptr);
+        }
+    }
+
+    VkRenderPass RenderpassCache::GetRenderpass(const VkRenderPassCreateInfo& createInfo)
+    {
+        KeyBuilder hasher;
+        HashRenderpass(hasher, createInfo);
+        auto hash = hasher.GetHash();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto range = m_renderpasses.equal_range(hash);
+
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second.key == hasher.GetKey())
+            {
+                m_stats.renderpassHits++;
+                return it->second.renderPass;
+            }
+        }
+
+        MANTIS_PROFILE_SCOPE("RenderpassCache::CreateRenderpass");
+
+        m_stats.renderpassMisses++;
+
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        if (Renderer::Check(vkCreateRenderPass(*logicalDevice, &createInfo, nullptr, &renderPass)))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to create renderpass!");
+            return VK_NULL_HANDLE;
+        }
+
+        m_renderpasses.insert(eastl::make_pair(hash, RenderpassEntry{ eastl::move(hasher.GetKey()), renderPass }));
+        return renderPass;
+    }
+
+    VkRenderPass RenderpassCache::GetRenderpass(const RenderPassInfo& info)
+    {
+        auto numAttachments = info.numColorAttachments + (info.depthStencil != nullptr ? 1 : 0);
+
+        // the render graph transitions the attachments itself, so layouts stay the same across the render pass
+        VkAttachmentDescription attachments[RendererConfig::MAX_ATTACHMENTS + 1] = {};
+
+        for (uint32_t i = 0; i < info.numColorAttachments; i++)
+        {
+            auto view = info.colorAttachments[i];
+            auto& attachment = attachments[i];
+
+            attachment.format = view->GetFormat();
+            attachment.samples = view->GetSamples();
+            attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            if (info.clearAttachments & (1u << i))
+            {
+                attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            }
+            else if (info.loadAttachments & (1u << i))
+            {
+                attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+                attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            }
+
+            if (info.storeAttachments & (1u << i))
+            {
+                attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            }
+        }
+
+        auto depthLayout = HAS_FLAGS(info.opFlags, RenderPassOp::DepthStencilReadOnly) ?
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        if (info.depthStencil != nullptr)
+        {
+            auto& attachment = attachments[info.numColorAttachments];
+            auto hasStencil = Format::HasStencil(info.depthStencil->GetFormat());
+
+            attachment.format = info.depthStencil->GetFormat();
+            attachment.samples = info.depthStencil->GetSamples();
+            attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachment.finalLayout = depthLayout;
+
+            if (HAS_FLAGS(info.opFlags, RenderPassOp::ClearDepthStencil))
+            {
+                attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            }
+            else if (HAS_FLAGS(info.opFlags, RenderPassOp::LoadDepthStencil))
+            {
+                attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+                attachment.initialLayout = depthLayout;
+            }
+
+            if (HAS_FLAGS(info.opFlags, RenderPassOp::StoreDepthStencil))
+            {
+                attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            }
+
+            attachment.stencilLoadOp = hasStencil ? attachment.loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.stencilStoreOp = hasStencil ? attachment.storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        }
+
+        // a render pass with no subpasses given has one that writes every attachment
+        RenderPassInfo::Subpass defaultSubpass;
+        auto subpasses = info.subpasses;
+        auto numSubpasses = info.numSubpasses;
+
+        if (numSubpasses == 0)
+        {
+            for (uint32_t i = 0; i < info.numColorAttachments; i++)
+            {
+                defaultSubpass.colorAttachments[i] = i;
+            }
+
+            defaultSubpass.numColorAttachments = info.numColorAttachments;
+            defaultSubpass.depthStencilMode = HAS_FLAGS(info.opFlags, RenderPassOp::DepthStencilReadOnly) ?
+                RenderPassInfo::DepthStencilMode::ReadOnly : RenderPassInfo::DepthStencilMode::ReadWrite;
+
+            subpasses = &defaultSubpass;
+            numSubpasses = 1;
+        }
+
+        eastl::vector<VkAttachmentReference> references(numSubpasses * (RendererConfig::MAX_ATTACHMENTS * 3 + 1));
+        eastl::vector<VkSubpassDescription> subpassDescriptions(numSubpasses);
+        eastl::vector<VkSubpassDependency> dependencies;
+
+        for (uint32_t i = 0; i < numSubpasses; i++)
+        {
+            const auto& subpass = subpasses[i];
+            auto inputReferences = &references[i * (RendererConfig::MAX_ATTACHMENTS * 3 + 1)];
+            auto colorReferences = inputReferences + RendererConfig::MAX_ATTACHMENTS;
+            auto resolveReferences = colorReferences + RendererConfig::MAX_ATTACHMENTS;
+            auto depthReference = resolveReferences + RendererConfig::MAX_ATTACHMENTS;
+
+            // input attachments index the color attachments, where the index past them is the depth stencil
+            for (uint32_t j = 0; j < subpass.numInputAttachments; j++)
+            {
+                auto attachment = subpass.inputAttachments[j];
+                auto isDepth = attachment == info.numColorAttachments;
+                inputReferences[j] = { attachment, isDepth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+            }
+            for (uint32_t j = 0; j < subpass.numColorAttachments; j++)
+            {
+                colorReferences[j] = { subpass.colorAttachments[j], VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+                resolveReferences[j] = { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED };
+            }
+            for (uint32_t j = 0; j < subpass.numResolveAttachments && j < subpass.numColorAttachments; j++)
+            {
+                resolveReferences[j] = { subpass.resolveAttachments[j], VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+            }
+
+            auto& description = subpassDescriptions[i];
+            description.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            description.inputAttachmentCount = subpass.numInputAttachments;
+            description.pInputAttachments = inputReferences;
+            description.colorAttachmentCount = subpass.numColorAttachments;
+            description.pColorAttachments = colorReferences;
+            description.pResolveAttachments = subpass.numResolveAttachments > 0 ? resolveReferences : nullptr;
+
+            if (info.depthStencil != nullptr && subpass.depthStencilMode != RenderPassInfo::DepthStencilMode::None)
+            {
+                auto readOnly = subpass.depthStencilMode == RenderPassInfo::DepthStencilMode::ReadOnly;
+                *depthReference = { info.numColorAttachments, readOnly ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : depthLayout };
+                description.pDepthStencilAttachment = depthReference;
+            }
+
+            // each subpass may read what the previous one wrote, which stays in tile memory on tile based GPUs
+            if (i > 0)
+            {
+                VkSubpassDependency dependency = {};
+                dependency.srcSubpass = i - 1;
+                dependency.dstSubpass = i;
+                dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+                dependency.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+                dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+                dependency.dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+                dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+                dependencies.emplace_back(dependency);
+            }
+        }
+
+        VkRenderPassCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        createInfo.attachmentCount = numAttachments;
+        createInfo.pAttachments = attachments;
+        createInfo.subpassCount = numSubpasses;
+        createInfo.pSubpasses = subpassDescriptions.data();
+        createInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        createInfo.pDependencies = dependencies.data();
+
+        return GetRenderpass(createInfo);
+    }
+
+    VkFramebuffer RenderpassCache::GetFramebuffer(
+        const VkRenderPass& renderPass,
+        const VkImageView* views,
+        const uint32_t& viewCount,
+        const VkExtent2D& extent,
+        const uint32_t& layers)
+    {
+        KeyBuilder hasher;
+        hasher.Combine(reinterpret_cast<uint64_t>(renderPass));
+        hasher.Combine(viewCount);
+
+        for (uint32_t i = 0; i < viewCount; i++)
+        {
+            hasher.Combine(reinterpret_cast<uint64_t>(views[i]));
+        }
+
+        hasher.Combine(extent.width);
+        hasher.Combine(extent.height);
+        hasher.Combine(layers);
+
+        auto hash = hasher.GetHash();
+        auto frame = Renderer::Get()->GetFrameCount();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto range = m_framebuffers.equal_range(hash);
+
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second.key == hasher.GetKey())
+            {
+                m_stats.framebufferHits++;
+                it->second.lastUsed = frame;
+                return it->second.framebuffer;
+            }
+        }
+
+        MANTIS_PROFILE_SCOPE("RenderpassCache::CreateFramebuffer");
+
+        m_stats.framebufferMisses++;
+
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        VkFramebufferCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        createInfo.renderPass = renderPass;
+        createInfo.attachmentCount = viewCount;
+        createInfo.pAttachments = views;
+        createInfo.width = extent.width;
+        createInfo.height = extent.height;
+        createInfo.layers = layers;
+
+        FramebufferEntry entry = {};
+        entry.views.assign(views, views + viewCount);
+        entry.lastUsed = frame;
+        entry.key = eastl::move(hasher.GetKey());
+
+        if (Renderer::Check(vkCreateFramebuffer(*logicalDevice, &createInfo, nullptr, &entry.framebuffer)))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to create framebuffer!");
+            return VK_NULL_HANDLE;
+        }
+
+        auto framebuffer = entry.framebuffer;
+        m_framebuffers.insert(eastl::make_pair(hash, eastl::move(entry)));
+        return framebuffer;
+    }
+
+    VkFramebuffer RenderpassCache::GetFramebuffer(const VkRenderPass& renderPass, const RenderPassInfo& info)
+    {
+        VkImageView views[RendererConfig::MAX_ATTACHMENTS + 1];
+        uint32_t viewCount = 0;
+
+        // the framebuffer covers the smallest attachment
+        VkExtent2D extent = { UINT32_MAX, UINT32_MAX };
+
+        const auto addView = [&](const ImageView* view)
+        {
+            views[viewCount++] = view->GetView();
+            extent.width = eastl::min(extent.width, view->GetExtent().width);
+            extent.height = eastl::min(extent.height, view->GetExtent().height);
+        };
+
+        for (uint32_t i = 0; i < info.numColorAttachments; i++)
+        {
+            addView(info.colorAttachments[i]);
+        }
+        if (info.depthStencil != nullptr)
+        {
+            addView(info.depthStencil);
+        }
+
+        return GetFramebuffer(renderPass, views, viewCount, extent, info.numLayers);
+    }
+
+    void RenderpassCache::ReleaseView(const VkImageView& view)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto it = m_framebuffers.begin(); it != m_framebuffers.end();)
+        {
+            const auto& views = it->second.views;
+
+            if (eastl::find(views.begin(), views.end(), view) != views.end())
+            {
+                Evict(it->second);
+                it = m_framebuffers.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void RenderpassCache::Update()
+    {
+        auto frame = Renderer::Get()->GetFrameCount();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto it = m_framebuffers.begin(); it != m_framebuffers.end();)
+        {
+            if (frame - it->second.lastUsed > FRAMEBUFFER_MAX_AGE)
+            {
+                Evict(it->second);
+                it = m_framebuffers.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    RenderpassCacheStats RenderpassCache::GetStats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto stats = m_stats;
+        stats.renderpassCount = static_cast<uint32_t>(m_renderpasses.size());
+        stats.framebufferCount = static_cast<uint32_t>(m_framebuffers.size());
+        return stats;
+    }
+
+    void RenderpassCache::Evict(const FramebufferEntry& entry)
+    {
+        m_stats.framebufferEvictions++;
+
+        // the framebuffer may have been used by a frame that is still in flight
+        Renderer::Get()->DestroyFramebuffer(entry.framebuffer);
+    }
+}
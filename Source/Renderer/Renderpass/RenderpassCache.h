@@ -0,0 +1,131 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include "Renderer/RendererConfig.h"
+
+namespace Mantis
+{
+    struct RenderPassInfo;
+
+    /// <summary>
+    /// The number of lookups made in a <see cref="RenderpassCache"/>.
+    /// </summary>
+    struct RenderpassCacheStats
+    {
+        uint64_t renderpassHits = 0;
+        uint64_t renderpassMisses = 0;
+        uint64_t framebufferHits = 0;
+        uint64_t framebufferMisses = 0;
+        /// <summary>
+        /// The number of framebuffers destroyed because they went unused or an attachment was destroyed.
+        /// </summary>
+        uint64_t framebufferEvictions = 0;
+        uint32_t renderpassCount = 0;
+        uint32_t framebufferCount = 0;
+    };
+
+    /// <summary>
+    /// Shares render passes and framebuffers between everything that renders with compatible attachments.
+    /// </summary>
+    /// <remarks>
+    /// Render passes are keyed by their attachment formats, samples, load and store operations, layouts, subpasses and
+    /// dependencies, so render stages and render graph passes with the same layout share one render pass, and so can
+    /// share pipelines. Keys are looked up by hash and compared in full, so a hash collision can't return the wrong
+    /// object. There are few distinct render passes, so they are kept until the cache is destroyed. Framebuffers are keyed by their render pass, attachment views and size. They are transient: one
+    /// that has not been used for a number of frames is destroyed, as is any that uses a view being destroyed, so
+    /// a recycled view handle can never match a stale framebuffer. Framebuffers must therefore be fetched every
+    /// frame they are used instead of being kept.
+    /// </remarks>
+    class RenderpassCache :
+        public NonCopyable
+    {
+    public:
+        RenderpassCache();
+
+        ~RenderpassCache();
+
+        /// <summary>
+        /// Gets a render pass with the given description, creating it if no matching render pass exists. Thread safe.
+        /// </summary>
+        /// <param name="createInfo">The render pass description.</param>
+        VkRenderPass GetRenderpass(const VkRenderPassCreateInfo& createInfo);
+
+        /// <summary>
+        /// Gets the render pass used to render the subpasses of a render graph pass. Thread safe.
+        /// </summary>
+        /// <param name="info">The attachments and subpasses to render.</param>
+        VkRenderPass GetRenderpass(const RenderPassInfo& info);
+
+        /// <summary>
+        /// Gets a framebuffer with the given attachments, creating it if no matching framebuffer exists. Thread safe.
+        /// </summary>
+        /// <param name="renderPass">The render pass the framebuffer is used with.</param>
+        /// <param name="views">The attachment views, in the order of the render pass attachments.</param>
+        /// <param name="viewCount">The number of attachment views.</param>
+        /// <param name="extent">The size of the framebuffer.</param>
+        /// <param name="layers">The number of layers in the framebuffer.</param>
+        VkFramebuffer GetFramebuffer(
+            const VkRenderPass& renderPass,
+            const VkImageView* views,
+            const uint32_t& viewCount,
+            const VkExtent2D& extent,
+            const uint32_t& layers = 1
+        );
+
+        /// <summary>
+        /// Gets the framebuffer used to render a render graph pass. Thread safe.
+        /// </summary>
+        /// <param name="renderPass">The render pass obtained for the same info.</param>
+        /// <param name="info">The attachments to render to.</param>
+        VkFramebuffer GetFramebuffer(const VkRenderPass& renderPass, const RenderPassInfo& info);
+
+        /// <summary>
+        /// Destroys the framebuffers that use a view, which must be called before the view is destroyed. Thread safe.
+        /// </summary>
+        /// <param name="view">The view being destroyed.</param>
+        void ReleaseView(const VkImageView& view);
+
+        /// <summary>
+        /// Destroys the framebuffers which have not been used recently. Called once each frame.
+        /// </summary>
+        void Update();
+
+        /// <summary>
+        /// Gets the number of lookups made and objects held.
+        /// </summary>
+        RenderpassCacheStats GetStats();
+
+    private:
+        struct RenderpassEntry
+        {
+            /// <summary>
+            /// The full description the render pass was created from, compared on lookup since hashes may collide.
+            /// </summary>
+            eastl::vector<uint64_t> key;
+            VkRenderPass renderPass;
+        };
+
+        struct FramebufferEntry
+        {
+            VkFramebuffer framebuffer;
+            eastl::vector<VkImageView> views;
+            uint64_t lastUsed;
+            /// <summary>
+            /// The render pass, views and size the framebuffer was created with, compared on lookup since hashes may collide.
+            /// </summary>
+            eastl::vector<uint64_t> key;
+        };
+
+        /// <summary>
+        /// Queues a framebuffer entry to be destroyed once the frames using it have completed.
+        /// </summary>
+        void Evict(const FramebufferEntry& entry);
+
+        std::mutex m_mutex;
+        eastl::unordered_multimap<uint64_t, RenderpassEntry> m_renderpasses;
+        eastl::unordered_multimap<uint64_t, FramebufferEntry> m_framebuffers;
+
+        RenderpassCacheStats m_stats;
+    };
+}
@@ -2,6 +2,7 @@
 #include "Swapchain.h"
 
 #include "Renderer/Renderer.h"
+#include "Renderer/FramePacer.h"
 
 #define LOG_TAG MANTIS_TEXT("Swapchain")
 
@@ -18,13 +19,14 @@ namespace Mantis
         VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR,
     };
 
-    Swapchain::Swapchain(const Window* window, const Vector2Int& resolution, bool vsync, const Swapchain* oldSwapchain = nullptr) :
+    Swapchain::Swapchain(const Window* window, const Vector2Int& resolution, bool vsync, const Swapchain* oldSwapchain) :
         m_swapchain(VK_NULL_HANDLE),
         m_presentMode(VK_PRESENT_MODE_FIFO_KHR),
         m_imageCount(0),
         m_preTransform(VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR),
         m_compositeAlpha(VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR),
-        m_activeImageIndex(std::numeric_limits<uint32_t>::max())
+        m_activeImageIndex(std::numeric_limits<uint32_t>::max()),
+        m_presentId(0)
     {
         auto surface = window->GetSurface();
         auto capabilities = surface->GetCapabilities();
@@ -36,20 +38,26 @@ namespace Mantis
 
         CreateSwapchain(surface, oldSwapchain);
         CreateImageViews(surface);
-
-        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
     }
 
     Swapchain::~Swapchain()
     {
-        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+        // the pacer must stop waiting on presentations from this swapchain
+        if (auto framePacer = Renderer::Get()->GetFramePacer())
+        {
+            framePacer->OnSwapchainDestroyed(*this);
+        }
 
-        vkDestroySwapchainKHR(*logicalDevice, m_swapchain, nullptr);
+        Renderer::Get()->ReleaseSwapchain(*this);
 
+        // frames still in flight may be rendering to or presenting the images, so the swapchain is only destroyed
+        // once they complete, which lets a replacement be created without waiting for the device to idle
         for (const auto& imageView : m_imageViews)
         {
-            vkDestroyImageView(*logicalDevice, imageView, nullptr);
+            Renderer::Get()->DestroyImageView(imageView);
         }
+
+        Renderer::Get()->DestroySwapchain(m_swapchain);
     }
 
     void Swapchain::ChooseExtent(const VkSurfaceCapabilitiesKHR& capabilities, const Vector2Int& targetResolution)
@@ -156,8 +164,8 @@ namespace Mantis
         auto format = surface->GetFormat();
         auto capabilities = surface->GetCapabilities();
 
-        // pick the number of images in the swap chain
-        uint32_t desiredImageCount = capabilities.minImageCount + 1;
+        // one image is displayed while the others are queued, so more images only add latency
+        uint32_t desiredImageCount = eastl::max(capabilities.minImageCount, RendererConfig::Get().maxQueuedFrames + 1);
 
         if (capabilities.maxImageCount > 0 && desiredImageCount > capabilities.maxImageCount)
         {
@@ -297,6 +305,37 @@ namespace Mantis
 			presentInfo.pWaitSemaphores = &waitSemaphore->GetSemaphore();
 		}
 
+        // identify the presentation so it can be waited on
+        VkPresentIdKHR presentId = {};
+        presentId.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+
+        if (SupportsPresentWait())
+        {
+            m_presentId++;
+
+            presentId.swapchainCount = 1;
+            presentId.pPresentIds = &m_presentId;
+            presentInfo.pNext = &presentId;
+        }
+
         return vkQueuePresentKHR(presentQueue, &presentInfo);
     }
+
+    VkResult Swapchain::WaitForPresent(const uint64_t& presentId, const uint64_t& timeout) const
+    {
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        if (!SupportsPresentWait())
+        {
+            Logger::ErrorT(LOG_TAG, "Present waits are not supported by the device!");
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+
+        return logicalDevice->GetWaitForPresent()(*logicalDevice, m_swapchain, presentId, timeout);
+    }
+
+    bool Swapchain::SupportsPresentWait() const
+    {
+        return Renderer::Get()->GetLogicalDevice()->GetWaitForPresent() != nullptr;
+    }
 }
\ No newline at end of file
@@ -38,6 +38,24 @@ namespace Mantis
         /// <returns>Result of the queue presentation.</returns>
         VkResult QueuePresent(const VkQueue& presentQueue, const Semaphore* waitSemaphore = nullptr);
 
+        /// <summary>
+        /// Waits until a presentation has been displayed. Only supported if the device supports present waits.
+        /// </summary>
+        /// <param name="presentId">The ID of the presentation to wait for.</param>
+        /// <param name="timeout">The timeout for the wait in nanoseconds.</param>
+        /// <returns>VK_SUCCESS once the presentation has been displayed, or VK_TIMEOUT.</returns>
+        VkResult WaitForPresent(const uint64_t& presentId, const uint64_t& timeout) const;
+
+        /// <summary>
+        /// Gets if the presentations can be waited on.
+        /// </summary>
+        bool SupportsPresentWait() const;
+
+        /// <summary>
+        /// Gets the ID of the last presentation, or zero if nothing has been presented.
+        /// </summary>
+        const uint64_t& GetPresentId() const { return m_presentId; }
+
         /// <summary>
         /// Gets the underlying swapchain.
         /// </summary>
@@ -51,8 +69,8 @@ namespace Mantis
         /// <summary>
         /// Gets the resolution of the swapchain.
         /// </summary>
-        const Vector2Int& GetResolution() const
-        { 
+        Vector2Int GetResolution() const
+        {
             return Vector2Int(
                 static_cast<int>(m_extent.width), 
                 static_cast<int>(m_extent.height));
@@ -120,5 +138,6 @@ namespace Mantis
         eastl::vector<VkImageView> m_imageViews;
 
         uint32_t m_activeImageIndex;
+        uint64_t m_presentId;
     };
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "stdafx.h"
+#include "SwapchainPresenter.h"
+
+#include "Renderer/Renderer.h"
+#include "Renderer/FrameContext.h"
+#include "Renderer/FramePacer.h"
+#include "Device/Window/Window.h"
+#include "Utils/Profiler.h"
+
+#define LOG_TAG MANTIS_TEXT("SwapchainPresenter")
+
+namespace Mantis
+{
+    /// <summary>
+    /// The render scale moves in steps of this size, so small changes in GPU time don't resize the render targets.
+    /// </summary>
+    static const float RENDER_SCALE_STEP = 0.05f;
+
+    /// <summary>
+    /// The fewest frames between dynamic changes to the render scale, which gives the GPU time of the new scale time to settle.
+    /// </summary>
+    static const uint64_t RENDER_SCALE_INTERVAL = 30;
+
+    SwapchainPresenter::SwapchainPresenter(Window* window, const bool& vsync) :
+        m_window(window),
+        m_vsync(vsync),
+        m_swapchain(nullptr),
+        m_resizePending(false),
+        m_lastResize(Timer::Now()),
+        m_recreateCount(0),
+        m_renderScale(1.0f),
+        m_renderResolution(0, 0),
+        m_lastScaleChange(0)
+    {
+        m_swapchain = eastl::make_unique<Swapchain>(m_window, m_window->GetSize(), m_vsync);
+        UpdateRenderResolution();
+
+        // the swapchain is only recreated once the window has stopped changing size
+        m_window->OnSize().Add([this](Vector2Int)
+        {
+            m_resizePending = true;
+            m_lastResize = Timer::Now();
+        }, this);
+    }
+
+    VkResult SwapchainPresenter::Acquire(FrameContext& frame)
+    {
+        auto size = m_window->GetSize();
+
+        // there is nothing to present to while minimized
+        if (m_window->IsIconified() || size.x <= 0 || size.y <= 0)
+        {
+            return VK_NOT_READY;
+        }
+
+        // presenting with a suboptimal swapchain still works, so it is treated like a resize
+        if (frame.GetPresentedSwapchain() == m_swapchain.get() && frame.GetPresentResult() == VK_SUBOPTIMAL_KHR && !m_resizePending)
+        {
+            m_resizePending = true;
+            m_lastResize = Timer::Now();
+        }
+
+        auto sinceResize = (Timer::Now() - m_lastResize).AsMilliseconds<float>();
+        auto outOfDate = frame.GetPresentedSwapchain() == m_swapchain.get() && frame.GetPresentResult() == VK_ERROR_OUT_OF_DATE_KHR;
+
+        if (outOfDate || (m_resizePending && sinceResize >= RendererConfig::Get().resizeDebounce))
+        {
+            Recreate();
+        }
+
+        auto result = frame.AcquireImage(*m_swapchain);
+
+        // the swapchain can't be used at all, so it must be recreated now even if the window is still resizing
+        if (result == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            Recreate();
+            result = frame.AcquireImage(*m_swapchain);
+        }
+
+        UpdateDynamicResolution();
+
+        return result;
+    }
+
+    void SwapchainPresenter::SetRenderScale(const float& scale)
+    {
+        m_renderScale = eastl::clamp(scale, RendererConfig::Get().dynamicResolutionMinScale, 1.0f);
+        UpdateRenderResolution();
+    }
+
+    void SwapchainPresenter::Recreate()
+    {
+        MANTIS_PROFILE_SCOPE("SwapchainPresenter::Recreate");
+
+        // the old swapchain is passed on so its images can be reused, and is destroyed after the frames using it complete
+        auto oldSwapchain = eastl::move(m_swapchain);
+        m_swapchain = eastl::make_unique<Swapchain>(m_window, m_window->GetSize(), m_vsync, oldSwapchain.get());
+        oldSwapchain.reset();
+
+        m_resizePending = false;
+        m_recreateCount++;
+
+        Logger::DebugTF(LOG_TAG, "Swapchain recreated at %ix%i", m_swapchain->GetResolution().x, m_swapchain->GetResolution().y);
+
+        UpdateRenderResolution();
+    }
+
+    void SwapchainPresenter::UpdateDynamicResolution()
+    {
+        const auto& config = RendererConfig::Get();
+
+        if (!config.dynamicResolution)
+        {
+            return;
+        }
+
+        auto renderer = Renderer::Get();
+        auto gpuTime = renderer->GetFramePacer()->GetStats().gpuTime;
+        auto frame = renderer->GetFrameCount();
+
+        if (gpuTime <= 0.0f || frame - m_lastScaleChange < RENDER_SCALE_INTERVAL)
+        {
+            return;
+        }
+
+        // GPU time is roughly proportional to the pixel count, which goes with the square of the scale
+        auto scale = m_renderScale * std::sqrt(config.dynamicResolutionTarget / gpuTime);
+        scale = std::round(scale / RENDER_SCALE_STEP) * RENDER_SCALE_STEP;
+        scale = eastl::clamp(scale, config.dynamicResolutionMinScale, 1.0f);
+
+        if (std::abs(scale - m_renderScale) >= RENDER_SCALE_STEP * 0.5f)
+        {
+            m_lastScaleChange = frame;
+            SetRenderScale(scale);
+        }
+    }
+
+    void SwapchainPresenter::UpdateRenderResolution()
+    {
+        auto resolution = m_swapchain->GetResolution();
+        auto renderResolution = Vector2Int(
+            eastl::max(static_cast<int>(resolution.x * m_renderScale), 1),
+            eastl::max(static_cast<int>(resolution.y * m_renderScale), 1));
+
+        if (renderResolution.x != m_renderResolution.x || renderResolution.y != m_renderResolution.y)
+        {
+            m_renderResolution = renderResolution;
+            m_onRenderResolution.Invoke(m_renderResolution);
+        }
+    }
+}
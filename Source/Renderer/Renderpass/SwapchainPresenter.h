@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include "Swapchain.h"
+#include "Utils/Delegate.h"
+#include "Utils/Timer.h"
+
+namespace Mantis
+{
+    class FrameContext;
+    class Window;
+
+    /// <summary>
+    /// Owns the swapchain of a window and recreates it when the window is resized, without stalling the device.
+    /// </summary>
+    /// <remarks>
+    /// The new swapchain is created from the old one, which is retired and destroyed once the frames that used it
+    /// have completed, so recreation never waits for the device to idle. Window resizes are debounced so dragging
+    /// the window edge doesn't recreate the swapchain every frame. The swapchain is only recreated sooner if it can
+    /// no longer be presented to. Rendering is done at the render resolution, which is the swapchain resolution
+    /// scaled by the render scale. The render scale may be changed freely, or adjusted automatically to keep the GPU
+    /// time within budget, without rebuilding the swapchain. Users should resize their swapchain relative render
+    /// targets when notified through <see cref="OnRenderResolution"/>, instead of rebuilding everything.
+    /// </remarks>
+    class SwapchainPresenter :
+        public NonCopyable,
+        public Observer
+    {
+    public:
+        /// <summary>
+        /// Creates the swapchain for a window.
+        /// </summary>
+        /// <param name="window">The window to present to.</param>
+        /// <param name="vsync">Should vsync be used.</param>
+        explicit SwapchainPresenter(Window* window, const bool& vsync = true);
+
+        /// <summary>
+        /// Acquires the next swapchain image for a frame, first recreating the swapchain if it is out of date or the
+        /// window was resized long enough ago, and updating the render scale if it is dynamic.
+        /// </summary>
+        /// <param name="frame">The frame to acquire the image for.</param>
+        /// <returns>The result of the acquisition. Nothing should be presented unless an image was acquired, such as
+        /// when the window is minimized.</returns>
+        VkResult Acquire(FrameContext& frame);
+
+        /// <summary>
+        /// Gets the current swapchain.
+        /// </summary>
+        const Swapchain& GetSwapchain() const { return *m_swapchain; }
+
+        /// <summary>
+        /// Gets the size rendering should be done at, which is the swapchain resolution scaled by the render scale.
+        /// </summary>
+        const Vector2Int& GetRenderResolution() const { return m_renderResolution; }
+
+        /// <summary>
+        /// Gets the scale of the render resolution relative to the swapchain resolution.
+        /// </summary>
+        const float& GetRenderScale() const { return m_renderScale; }
+
+        /// <summary>
+        /// Sets the scale of the render resolution relative to the swapchain resolution. Overridden each frame when
+        /// dynamic resolution is enabled.
+        /// </summary>
+        /// <param name="scale">The new scale, which is clamped between the minimum dynamic resolution scale and one.</param>
+        void SetRenderScale(const float& scale);
+
+        /// <summary>
+        /// Called with the new render resolution whenever it changes, either because the swapchain was recreated at
+        /// a new size or the render scale changed.
+        /// </summary>
+        Delegate<void(Vector2Int)>& OnRenderResolution() { return m_onRenderResolution; }
+
+        /// <summary>
+        /// Gets the number of times the swapchain was recreated.
+        /// </summary>
+        const uint32_t& GetRecreateCount() const { return m_recreateCount; }
+
+    private:
+        /// <summary>
+        /// Creates a new swapchain, retiring the current one.
+        /// </summary>
+        void Recreate();
+
+        /// <summary>
+        /// Moves the render scale towards the one that meets the GPU time target.
+        /// </summary>
+        void UpdateDynamicResolution();
+
+        /// <summary>
+        /// Computes the render resolution, notifying listeners if it changed.
+        /// </summary>
+        void UpdateRenderResolution();
+
+        Window* m_window;
+        bool m_vsync;
+        eastl::unique_ptr<Swapchain> m_swapchain;
+
+        bool m_resizePending;
+        Timer m_lastResize;
+        uint32_t m_recreateCount;
+
+        float m_renderScale;
+        Vector2Int m_renderResolution;
+        uint64_t m_lastScaleChange;
+        Delegate<void(Vector2Int)> m_onRenderResolution;
+    };
+}
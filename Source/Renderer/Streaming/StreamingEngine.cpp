@@ -0,0 +1,922 @@
+#include "stdafx.h"
+#include "StreamingEngine.h"
+
+#include "Renderer/Renderer.h"
+#include "Renderer/FrameContext.h"
+#include "Renderer/Image/Image.h"
+#include "Utils/Profiler.h"
+
+#define LOG_TAG MANTIS_TEXT("StreamingEngine")
+
+namespace Mantis
+{
+    StreamingEngine::StreamingEngine() :
+        m_nextRequest(1),
+        m_readbackPoolSize(0),
+        m_bytesInFlight(0)
+    {
+    }
+
+    StreamingEngine::~StreamingEngine()
+    {
+        eastl::vector<Request> completed;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            // submitting would begin a new frame while the renderer is shutting down, and nothing is left to use the data
+            if (!m_pending.empty())
+            {
+                Logger::WarningTF(LOG_TAG, "Dropped %u queued requests on shutdown!", static_cast<uint32_t>(m_pending.size()));
+                m_pending.clear();
+            }
+
+            auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+            for (const auto& batch : m_batches)
+            {
+                if (Renderer::Check(vkWaitForFences(*logicalDevice, 1, &batch.fence, VK_TRUE, eastl::numeric_limits<uint64_t>::max())))
+                {
+                    Logger::ErrorT(LOG_TAG, "Failed to wait for fence!");
+                }
+            }
+
+            UpdateLocked(completed);
+        }
+
+        Complete(completed);
+    }
+
+    uint64_t StreamingEngine::Upload(const Buffer& buffer, const void* data, const VkDeviceSize& size, const VkDeviceSize& offset, const StreamPriority& priority)
+    {
+        if (offset + size > buffer.GetSize())
+        {
+            Logger::ErrorTF(LOG_TAG, "Cannot upload %llu bytes at offset %llu to a buffer of %llu bytes!",
+                static_cast<unsigned long long>(size), static_cast<unsigned long long>(offset), static_cast<unsigned long long>(buffer.GetSize()));
+            return 0;
+        }
+
+        if (HAS_NO_FLAG(buffer.GetUsage(), VK_BUFFER_USAGE_TRANSFER_DST_BIT))
+        {
+            Logger::ErrorT(LOG_TAG, "Cannot upload to a buffer without transfer destination usage!");
+            return 0;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Request request = {};
+        request.id = m_nextRequest++;
+        request.type = RequestType::BufferUpload;
+        request.priority = priority;
+        request.buffer = buffer.GetBuffer();
+        request.offset = offset;
+        request.size = size;
+
+        // the data is only staged when the request is submitted, since the frame staging memory may still be in use
+        auto bytes = static_cast<const uint8_t*>(data);
+        request.data.assign(bytes, bytes + size);
+
+        m_pending.push_back(eastl::move(request));
+        return m_pending.back().id;
+    }
+
+    uint64_t StreamingEngine::Upload(Image& image, const void* data, const VkDeviceSize& size, const eastl::vector<VkBufferImageCopy>& regions, const StreamPriority& priority)
+    {
+        if (regions.empty())
+        {
+            Logger::ErrorT(LOG_TAG, "Cannot upload to an image without any regions!");
+            return 0;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Request request = {};
+        request.id = m_nextRequest++;
+        request.type = RequestType::ImageUpload;
+        request.priority = priority;
+        request.image = &image;
+        request.size = size;
+        request.regions = regions;
+
+        auto bytes = static_cast<const uint8_t*>(data);
+        request.data.assign(bytes, bytes + size);
+
+        m_pending.push_back(eastl::move(request));
+        return m_pending.back().id;
+    }
+
+    uint64_t StreamingEngine::Readback(const Buffer& buffer, const VkDeviceSize& size, const VkDeviceSize& offset, ReadbackCallback&& callback, const StreamPriority& priority)
+    {
+        if (offset + size > buffer.GetSize())
+        {
+            Logger::ErrorTF(LOG_TAG, "Cannot read back %llu bytes at offset %llu from a buffer of %llu bytes!",
+                static_cast<unsigned long long>(size), static_cast<unsigned long long>(offset), static_cast<unsigned long long>(buffer.GetSize()));
+            return 0;
+        }
+
+        if (HAS_NO_FLAG(buffer.GetUsage(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT))
+        {
+            Logger::ErrorT(LOG_TAG, "Cannot read back a buffer without transfer source usage!");
+            return 0;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Request request = {};
+        request.id = m_nextRequest++;
+        request.type = RequestType::BufferReadback;
+        request.priority = priority;
+        request.buffer = buffer.GetBuffer();
+        request.offset = offset;
+        request.size = size;
+        request.callback = eastl::move(callback);
+
+        m_pending.push_back(eastl::move(request));
+        return m_pending.back().id;
+    }
+
+    uint64_t StreamingEngine::Readback(Image& image, const VkDeviceSize& size, const VkBufferImageCopy& region, const VkImageLayout& layout, ReadbackCallback&& callback, const StreamPriority& priority)
+    {
+        if (HAS_NO_FLAG(image.GetUsage(), VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+        {
+            Logger::ErrorT(LOG_TAG, "Cannot read back an image without transfer source usage!");
+            return 0;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Request request = {};
+        request.id = m_nextRequest++;
+        request.type = RequestType::ImageReadback;
+        request.priority = priority;
+        request.image = &image;
+        request.layout = layout;
+        request.size = size;
+        request.regions.push_back(region);
+        request.callback = eastl::move(callback);
+
+        m_pending.push_back(eastl::move(request));
+        return m_pending.back().id;
+    }
+
+    void StreamingEngine::FlushUploads()
+    {
+        MANTIS_PROFILE_SCOPE("StreamingEngine::FlushUploads");
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        FlushLocked(false, false);
+    }
+
+    void StreamingEngine::FlushReadbacks()
+    {
+        MANTIS_PROFILE_SCOPE("StreamingEngine::FlushReadbacks");
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        FlushLocked(false, true);
+    }
+
+    void StreamingEngine::Cancel(const Image& image)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto cancelled = eastl::remove_if(m_pending.begin(), m_pending.end(), [&image](const Request& request)
+        {
+            return request.image == &image;
+        });
+
+        if (cancelled != m_pending.end())
+        {
+            Logger::WarningTF(LOG_TAG, "Dropped %u queued requests for an image that was destroyed!", static_cast<uint32_t>(m_pending.end() - cancelled));
+            m_pending.erase(cancelled, m_pending.end());
+        }
+    }
+
+    void StreamingEngine::Cancel(const Buffer& buffer)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto handle = buffer.GetBuffer();
+        m_uploadedBuffers.erase(handle);
+
+        auto cancelled = eastl::remove_if(m_pending.begin(), m_pending.end(), [&handle](const Request& request)
+        {
+            return (request.type == RequestType::BufferUpload || request.type == RequestType::BufferReadback) && request.buffer == handle;
+        });
+
+        if (cancelled != m_pending.end())
+        {
+            Logger::WarningTF(LOG_TAG, "Dropped %u queued requests for a buffer that was destroyed!", static_cast<uint32_t>(m_pending.end() - cancelled));
+            m_pending.erase(cancelled, m_pending.end());
+        }
+    }
+
+    bool StreamingEngine::IsComplete(const uint64_t& request)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (const auto& pending : m_pending)
+        {
+            if (pending.id == request)
+            {
+                return false;
+            }
+        }
+
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        for (const auto& batch : m_batches)
+        {
+            for (const auto& submitted : batch.requests)
+            {
+                if (submitted.id == request)
+                {
+                    return vkGetFenceStatus(*logicalDevice, batch.fence) == VK_SUCCESS;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void StreamingEngine::Wait(const uint64_t& request)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            for (auto& pending : m_pending)
+            {
+                if (pending.id == request)
+                {
+                    pending.priority = StreamPriority::Immediate;
+                    FlushLocked(false, IsReadback(pending));
+                    break;
+                }
+            }
+
+            auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+            for (const auto& batch : m_batches)
+            {
+                auto contains = eastl::any_of(batch.requests.begin(), batch.requests.end(), [&request](const Request& submitted)
+                {
+                    return submitted.id == request;
+                });
+
+                if (contains && Renderer::Check(vkWaitForFences(*logicalDevice, 1, &batch.fence, VK_TRUE, eastl::numeric_limits<uint64_t>::max())))
+                {
+                    Logger::ErrorT(LOG_TAG, "Failed to wait for fence!");
+                }
+            }
+        }
+
+        Update();
+    }
+
+    void StreamingEngine::Update()
+    {
+        MANTIS_PROFILE_SCOPE("StreamingEngine::Update");
+
+        eastl::vector<Request> completed;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            UpdateLocked(completed);
+        }
+
+        Complete(completed);
+    }
+
+    void StreamingEngine::Complete(eastl::vector<Request>& completed)
+    {
+        // the callbacks may queue new requests, so are invoked without holding the lock
+        for (const auto& request : completed)
+        {
+            if (request.callback)
+            {
+                request.stagingBuffer->Invalidate(0, request.size);
+                request.callback(request.stagingBuffer->GetMappedData(), request.size);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto& request : completed)
+        {
+            if (!IsReadback(request))
+            {
+                continue;
+            }
+
+            // keep the readback buffers around so requests made every frame don't need new allocations
+            auto size = request.stagingBuffer->GetSize();
+
+            if (m_readbackPoolSize + size <= READBACK_POOL_SIZE)
+            {
+                m_readbackPoolSize += size;
+                m_readbackPool.push_back(eastl::move(request.stagingBuffer));
+            }
+        }
+    }
+
+    eastl::shared_ptr<Buffer> StreamingEngine::AcquireReadbackBuffer(const VkDeviceSize& size)
+    {
+        // use the smallest pooled buffer that is large enough
+        auto best = m_readbackPool.end();
+
+        for (auto buffer = m_readbackPool.begin(); buffer != m_readbackPool.end(); buffer++)
+        {
+            auto bufferSize = (*buffer)->GetSize();
+
+            if (bufferSize >= size && (best == m_readbackPool.end() || bufferSize < (*best)->GetSize()))
+            {
+                best = buffer;
+            }
+        }
+
+        if (best != m_readbackPool.end())
+        {
+            auto buffer = eastl::move(*best);
+            m_readbackPool.erase_unsorted(best);
+            m_readbackPoolSize -= buffer->GetSize();
+            return buffer;
+        }
+
+        // prefers host cached memory, so reading the results is not slow
+        return eastl::make_shared<Buffer>(
+            (size + READBACK_BLOCK_SIZE - 1) & ~(READBACK_BLOCK_SIZE - 1),
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_GPU_TO_CPU,
+            nullptr,
+            VMA_ALLOCATION_CREATE_MAPPED_BIT
+        );
+    }
+
+    bool StreamingEngine::Stage(FrameContext& frame, Request& request, const bool& force)
+    {
+        MANTIS_PROFILE_SCOPE("StreamingEngine::Stage");
+
+        // image copies must start on a whole texel block as well as a multiple of four bytes
+        VkDeviceSize alignment = 16;
+
+        if (request.type == RequestType::ImageUpload)
+        {
+            auto blockSize = eastl::max<VkDeviceSize>(Image::GetSize({ 1, 1, 1 }, request.image->GetFormat()), 1);
+
+            while (alignment % blockSize != 0)
+            {
+                alignment += 16;
+            }
+        }
+
+        if (request.size <= frame.GetStagingAvailable(alignment))
+        {
+            auto allocation = frame.AllocateStaging(request.size, alignment);
+
+            if (allocation.data != nullptr)
+            {
+                Buffer::StreamCopy(allocation.data, request.data.data(), static_cast<size_t>(request.size));
+
+                request.staging = allocation.buffer;
+                request.stagingOffset = allocation.offset;
+                request.data = {};
+                return true;
+            }
+        }
+
+        if (!force && request.size <= RendererConfig::Get().frameStagingSize)
+        {
+            return false;
+        }
+
+        // the buffer is released with the request once its batch completes
+        request.stagingBuffer = eastl::make_shared<Buffer>(
+            request.size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            static_cast<VkMemoryPropertyFlags>(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+            nullptr,
+            VMA_ALLOCATION_CREATE_MAPPED_BIT
+        );
+        request.stagingBuffer->Write(request.data.data(), request.size);
+
+        request.staging = request.stagingBuffer->GetBuffer();
+        request.stagingOffset = 0;
+        request.data = {};
+        return true;
+    }
+
+    void StreamingEngine::FlushLocked(const bool& ignoreBudget, const bool& readbacks)
+    {
+        auto hasRequests = eastl::any_of(m_pending.begin(), m_pending.end(), [&readbacks](const Request& request)
+        {
+            return IsReadback(request) == readbacks;
+        });
+
+        if (!hasRequests)
+        {
+            return;
+        }
+
+        // requests with the same priority are submitted in the order they were queued
+        eastl::stable_sort(m_pending.begin(), m_pending.end(), [](const Request& a, const Request& b)
+        {
+            return a.priority < b.priority;
+        });
+
+        auto budget = RendererConfig::Get().streamingBudget;
+        auto bytes = m_bytesInFlight;
+
+        // uploads are staged in the memory of the frame being recorded, which is only recycled once the frame's
+        // fence has signaled. Upload batches are submitted to the graphics queue before the frame, so that fence
+        // also covers them. Readbacks don't use the frame's memory, and are submitted after the frame has ended.
+        auto frame = readbacks ? nullptr : &Renderer::Get()->BeginFrame();
+
+        Batch batch = {};
+        eastl::vector<Request> remaining;
+
+        for (auto& request : m_pending)
+        {
+            if (IsReadback(request) != readbacks)
+            {
+                remaining.push_back(eastl::move(request));
+                continue;
+            }
+
+            auto force = ignoreBudget || request.priority == StreamPriority::Immediate;
+
+            // requests larger than the whole budget are allowed once nothing else is in flight
+            auto fits = force || bytes + request.size <= budget || bytes == 0;
+
+            if (fits && !readbacks)
+            {
+                fits = Stage(*frame, request, force);
+            }
+
+            if (fits)
+            {
+                bytes += request.size;
+                batch.requests.push_back(eastl::move(request));
+            }
+            else
+            {
+                remaining.push_back(eastl::move(request));
+            }
+        }
+
+        m_pending = eastl::move(remaining);
+
+        if (batch.requests.empty())
+        {
+            return;
+        }
+
+        batch.bytes = bytes - m_bytesInFlight;
+        m_bytesInFlight = bytes;
+
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        VkFenceCreateInfo fenceCreateInfo = {};
+        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        if (Renderer::Check(vkCreateFence(*logicalDevice, &fenceCreateInfo, nullptr, &batch.fence)))
+        {
+            Logger::ErrorT(LOG_TAG, "Failed to create fence!");
+        }
+
+        if (readbacks)
+        {
+            // readback staging memory is only needed once the request is submitted
+            for (auto& request : batch.requests)
+            {
+                request.stagingBuffer = AcquireReadbackBuffer(request.size);
+                request.staging = request.stagingBuffer->GetBuffer();
+                request.stagingOffset = 0;
+            }
+        }
+        else
+        {
+            // the copies read the staged data before the frame is submitted
+            frame->FlushStaging();
+        }
+
+        // use the transfer queue if the device has one separate from the graphics queue, otherwise there is no ownership to transfer
+        auto isUnifiedQueue = !logicalDevice->HasDedicatedTransfer();
+
+        auto hasTransferUploads = !isUnifiedQueue && eastl::any_of(batch.requests.begin(), batch.requests.end(), [this](const Request& request)
+        {
+            return (request.type == RequestType::BufferUpload || request.type == RequestType::ImageUpload) && IsFirstUpload(request);
+        });
+
+        batch.graphicsCommands = eastl::make_unique<CommandBuffer>(QueueType::Graphics);
+
+        if (hasTransferUploads)
+        {
+            VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+            semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+            if (Renderer::Check(vkCreateSemaphore(*logicalDevice, &semaphoreCreateInfo, nullptr, &batch.semaphore)))
+            {
+                Logger::ErrorT(LOG_TAG, "Failed to create semaphore!");
+            }
+
+            batch.transferCommands = eastl::make_unique<CommandBuffer>(QueueType::Transfer);
+            RecordUploads(*batch.transferCommands, batch.requests, true);
+            batch.transferCommands->Submit(VK_NULL_HANDLE, batch.semaphore);
+
+            RecordAcquires(*batch.graphicsCommands, batch.requests);
+        }
+
+        // anything the transfer queue didn't claim is uploaded on the graphics queue
+        RecordUploads(*batch.graphicsCommands, batch.requests, false);
+        RecordReadbacks(*batch.graphicsCommands, batch.requests);
+        batch.graphicsCommands->Submit(batch.fence, VK_NULL_HANDLE, batch.semaphore, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+        m_batches.push_back(eastl::move(batch));
+    }
+
+    void StreamingEngine::UpdateLocked(eastl::vector<Request>& completed)
+    {
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+
+        // batches complete in the order they were submitted to the graphics queue
+        auto batch = m_batches.begin();
+
+        for (; batch != m_batches.end(); batch++)
+        {
+            if (vkGetFenceStatus(*logicalDevice, batch->fence) != VK_SUCCESS)
+            {
+                break;
+            }
+
+            vkDestroyFence(*logicalDevice, batch->fence, nullptr);
+
+            if (batch->semaphore != VK_NULL_HANDLE)
+            {
+                vkDestroySemaphore(*logicalDevice, batch->semaphore, nullptr);
+            }
+
+            m_bytesInFlight -= batch->bytes;
+
+            for (auto& request : batch->requests)
+            {
+                completed.push_back(eastl::move(request));
+            }
+        }
+
+        m_batches.erase(m_batches.begin(), batch);
+    }
+
+    bool StreamingEngine::RecordUploads(const CommandBuffer& commandBuffer, eastl::vector<Request>& requests, const bool& isTransferQueue)
+    {
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+        auto graphicsFamily = logicalDevice->GetGraphicsFamily();
+        auto transferFamily = logicalDevice->GetTransferFamily();
+
+        eastl::vector<VkBufferMemoryBarrier> releases;
+        auto recorded = false;
+        auto waitedForReads = false;
+
+        for (auto& request : requests)
+        {
+            if (request.type != RequestType::BufferUpload && request.type != RequestType::ImageUpload)
+            {
+                continue;
+            }
+
+            // the graphics queue records whatever the transfer queue did not
+            if (!isTransferQueue && request.transferQueue)
+            {
+                continue;
+            }
+
+            // only the transfer queue can't keep the existing contents, since it doesn't own the resource
+            if (isTransferQueue && !IsFirstUpload(request))
+            {
+                continue;
+            }
+
+            request.transferQueue = isTransferQueue;
+            recorded = true;
+
+            switch (request.type)
+            {
+                case RequestType::BufferUpload:
+                {
+                    // frames already submitted may still be reading the buffer, the transfer queue only writes buffers they never used
+                    if (!isTransferQueue && !waitedForReads)
+                    {
+                        VkMemoryBarrier barrier = {};
+                        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                        barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+                        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+                        vkCmdPipelineBarrier(
+                            commandBuffer,
+                            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                            VK_PIPELINE_STAGE_TRANSFER_BIT,
+                            0,
+                            1, &barrier,
+                            0, nullptr,
+                            0, nullptr
+                        );
+
+                        waitedForReads = true;
+                    }
+
+                    VkBufferCopy region = {};
+                    region.srcOffset = request.stagingOffset;
+                    region.dstOffset = request.offset;
+                    region.size = request.size;
+
+                    vkCmdCopyBuffer(commandBuffer, request.staging, request.buffer, 1, &region);
+
+                    // recorded in submission order, so later requests in the batch keep the contents
+                    m_uploadedBuffers.insert(request.buffer);
+
+                    if (isTransferQueue)
+                    {
+                        VkBufferMemoryBarrier barrier = {};
+                        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                        barrier.dstAccessMask = 0;
+                        barrier.srcQueueFamilyIndex = transferFamily;
+                        barrier.dstQueueFamilyIndex = graphicsFamily;
+                        barrier.buffer = request.buffer;
+                        barrier.offset = request.offset;
+                        barrier.size = request.size;
+                        releases.push_back(barrier);
+                    }
+                    break;
+                }
+                case RequestType::ImageUpload:
+                {
+                    eastl::vector<VkBufferImageCopy> regions = request.regions;
+
+                    for (auto& region : regions)
+                    {
+                        region.bufferOffset += request.stagingOffset;
+                    }
+
+                    auto subresources = GetSubresources(request);
+
+                    VkImageSubresourceRange range = {};
+                    range.aspectMask = request.regions.front().imageSubresource.aspectMask;
+                    range.levelCount = 1;
+                    range.layerCount = 1;
+
+                    // subresources uploaded before keep their contents, the rest start out undefined
+                    for (const auto& [mipLevel, arrayLayer] : subresources)
+                    {
+                        range.baseMipLevel = mipLevel;
+                        range.baseArrayLayer = arrayLayer;
+
+                        request.image->TransitionImageLayout(commandBuffer,
+                            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                            request.image->GetSubresourceLayout(mipLevel, arrayLayer), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                            range
+                        );
+                    }
+
+                    vkCmdCopyBufferToImage(commandBuffer, request.staging, request.image->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+                    for (const auto& [mipLevel, arrayLayer] : subresources)
+                    {
+                        range.baseMipLevel = mipLevel;
+                        range.baseArrayLayer = arrayLayer;
+
+                        request.image->TransitionImageLayout(commandBuffer,
+                            isTransferQueue ? transferFamily : VK_QUEUE_FAMILY_IGNORED,
+                            isTransferQueue ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                            range
+                        );
+
+                        // recorded in submission order, so later requests in the batch see the new layout
+                        request.image->SetSubresourceLayout(mipLevel, arrayLayer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+
+        if (!isTransferQueue && recorded)
+        {
+            // make the writes visible to everything submitted afterwards
+            VkMemoryBarrier barrier = {};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                0,
+                1, &barrier,
+                0, nullptr,
+                0, nullptr
+            );
+        }
+        else if (!releases.empty())
+        {
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0, nullptr,
+                static_cast<uint32_t>(releases.size()), releases.data(),
+                0, nullptr
+            );
+        }
+
+        return recorded;
+    }
+
+    void StreamingEngine::RecordAcquires(const CommandBuffer& commandBuffer, const eastl::vector<Request>& requests) const
+    {
+        auto logicalDevice = Renderer::Get()->GetLogicalDevice();
+        auto graphicsFamily = logicalDevice->GetGraphicsFamily();
+        auto transferFamily = logicalDevice->GetTransferFamily();
+
+        eastl::vector<VkBufferMemoryBarrier> acquires;
+
+        for (const auto& request : requests)
+        {
+            if (!request.transferQueue)
+            {
+                continue;
+            }
+
+            switch (request.type)
+            {
+                case RequestType::BufferUpload:
+                {
+                    VkBufferMemoryBarrier barrier = {};
+                    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                    barrier.srcAccessMask = 0;
+                    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+                    barrier.srcQueueFamilyIndex = transferFamily;
+                    barrier.dstQueueFamilyIndex = graphicsFamily;
+                    barrier.buffer = request.buffer;
+                    barrier.offset = request.offset;
+                    barrier.size = request.size;
+                    acquires.push_back(barrier);
+                    break;
+                }
+                case RequestType::ImageUpload:
+                {
+                    VkImageSubresourceRange range = {};
+                    range.aspectMask = request.regions.front().imageSubresource.aspectMask;
+                    range.levelCount = 1;
+                    range.layerCount = 1;
+
+                    for (const auto& [mipLevel, arrayLayer] : GetSubresources(request))
+                    {
+                        range.baseMipLevel = mipLevel;
+                        range.baseArrayLayer = arrayLayer;
+
+                        request.image->TransitionImageLayout(commandBuffer,
+                            transferFamily, graphicsFamily,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                            range
+                        );
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+
+        if (!acquires.empty())
+        {
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                0,
+                0, nullptr,
+                static_cast<uint32_t>(acquires.size()), acquires.data(),
+                0, nullptr
+            );
+        }
+    }
+
+    void StreamingEngine::RecordReadbacks(const CommandBuffer& commandBuffer, const eastl::vector<Request>& requests) const
+    {
+        auto hasReadbacks = eastl::any_of(requests.begin(), requests.end(), IsReadback);
+
+        if (!hasReadbacks)
+        {
+            return;
+        }
+
+        // wait for any work that wrote to the buffers before copying them
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr
+        );
+
+        for (const auto& request : requests)
+        {
+            switch (request.type)
+            {
+                case RequestType::BufferReadback:
+                {
+                    VkBufferCopy region = {};
+                    region.srcOffset = request.offset;
+                    region.dstOffset = 0;
+                    region.size = request.size;
+
+                    vkCmdCopyBuffer(commandBuffer, request.buffer, request.staging, 1, &region);
+                    break;
+                }
+                case RequestType::ImageReadback:
+                {
+                    request.image->TransitionImageLayout(commandBuffer,
+                        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                        request.layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                    );
+
+                    vkCmdCopyImageToBuffer(commandBuffer, request.image->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, request.staging, static_cast<uint32_t>(request.regions.size()), request.regions.data());
+
+                    request.image->TransitionImageLayout(commandBuffer,
+                        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, request.layout
+                    );
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+
+        // make the copied data visible to the host
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_HOST_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr
+        );
+    }
+
+    eastl::vector<eastl::pair<uint32_t, uint32_t>> StreamingEngine::GetSubresources(const Request& request)
+    {
+        eastl::vector<eastl::pair<uint32_t, uint32_t>> subresources;
+
+        for (const auto& region : request.regions)
+        {
+            for (uint32_t layer = 0; layer < region.imageSubresource.layerCount; layer++)
+            {
+                eastl::pair<uint32_t, uint32_t> subresource(region.imageSubresource.mipLevel, region.imageSubresource.baseArrayLayer + layer);
+
+                // several regions may write to parts of the same subresource
+                if (eastl::find(subresources.begin(), subresources.end(), subresource) == subresources.end())
+                {
+                    subresources.push_back(subresource);
+                }
+            }
+        }
+
+        return subresources;
+    }
+
+    bool StreamingEngine::IsReadback(const Request& request)
+    {
+        return request.type == RequestType::BufferReadback || request.type == RequestType::ImageReadback;
+    }
+
+    bool StreamingEngine::IsFirstUpload(const Request& request) const
+    {
+        if (request.type == RequestType::BufferUpload)
+        {
+            return m_uploadedBuffers.find(request.buffer) == m_uploadedBuffers.end();
+        }
+
+        for (const auto& [mipLevel, arrayLayer] : GetSubresources(request))
+        {
+            if (request.image->GetSubresourceLayout(mipLevel, arrayLayer) != VK_IMAGE_LAYOUT_UNDEFINED)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,298 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include "Renderer/Buffer/Buffer.h"
+#include "Renderer/Commands/CommandBuffer.h"
+
+namespace Mantis
+{
+    class FrameContext;
+    class Image;
+
+    /// <summary>
+    /// The order in which queued transfers are submitted.
+    /// </summary>
+    enum struct StreamPriority
+    {
+        /// <summary>
+        /// Submitted with the next batch regardless of the budget. Used for data needed by the next frame.
+        /// </summary>
+        Immediate,
+        High,
+        Normal,
+        Low,
+    };
+
+    /// <summary>
+    /// Streams data between the host and device local resources using staging memory.
+    /// </summary>
+    /// <remarks>
+    /// Requests may be queued from any thread, and are submitted in batches in priority order by the render
+    /// thread. Uploads are staged from the staging memory of the frame being recorded when they are submitted,
+    /// and uploads that don't fit wait for the next frame, unless they are immediate or larger than the frame's
+    /// staging memory, which get a staging buffer of their own. The number of bytes in flight is limited by the streaming budget in the renderer config so
+    /// streaming does not starve rendering of bandwidth. When the device has a dedicated transfer queue
+    /// uploads run on it, and a semaphore orders the transfer of ownership back to the graphics queue, so
+    /// any work submitted to the graphics queue after a batch is flushed will see the uploaded data. Only the
+    /// first upload to each buffer and image subresource runs on the transfer queue, later uploads are recorded
+    /// on the graphics queue which owns the resource, after the work already submitted that may still read it,
+    /// and so the parts they don't write are kept. Requests
+    /// with different priorities may complete out of order. Uploads are submitted before the frame's rendering
+    /// and readbacks after it, on the graphics queue, so readbacks queued while recording a frame see what that
+    /// frame rendered. Readbacks copy into host cached memory that is pooled between requests.
+    /// </remarks>
+    class StreamingEngine :
+        public NonCopyable
+    {
+    public:
+        /// <summary>
+        /// The function invoked with the contents of a completed readback. The data is only valid during the call.
+        /// </summary>
+        using ReadbackCallback = eastl::function<void(const void* data, const VkDeviceSize& size)>;
+
+        StreamingEngine();
+
+        /// <summary>
+        /// Waits for the submitted requests to complete and invokes their callbacks. Requests which were never
+        /// submitted are dropped.
+        /// </summary>
+        ~StreamingEngine();
+
+        /// <summary>
+        /// Queues a copy of data into a buffer. The data is copied immediately, so it does not need
+        /// to be kept alive. Thread safe.
+        /// </summary>
+        /// <param name="buffer">The buffer to copy to. Must have transfer destination usage.</param>
+        /// <param name="data">The data to copy in.</param>
+        /// <param name="size">The number of bytes to copy.</param>
+        /// <param name="offset">The offset in the buffer to copy to in bytes.</param>
+        /// <param name="priority">The priority of the upload.</param>
+        /// <returns>The request ID, used to check for completion. Zero if the request was invalid.</returns>
+        uint64_t Upload(
+            const Buffer& buffer,
+            const void* data,
+            const VkDeviceSize& size,
+            const VkDeviceSize& offset = 0,
+            const StreamPriority& priority = StreamPriority::Immediate
+        );
+
+        /// <summary>
+        /// Queues a copy of data into an image, which is left in the shader read only layout. The subresources
+        /// written must be in that layout already, unless this is the first upload to them. The data is copied
+        /// immediately, so it does not need to be kept alive. Thread safe.
+        /// </summary>
+        /// <param name="image">The image to copy to.</param>
+        /// <param name="data">The data to copy in.</param>
+        /// <param name="size">The number of bytes to copy.</param>
+        /// <param name="regions">The regions to copy, with buffer offsets relative to the start of the data.</param>
+        /// <param name="priority">The priority of the upload.</param>
+        /// <returns>The request ID, used to check for completion. Zero if the request was invalid.</returns>
+        uint64_t Upload(
+            Image& image,
+            const void* data,
+            const VkDeviceSize& size,
+            const eastl::vector<VkBufferImageCopy>& regions,
+            const StreamPriority& priority = StreamPriority::Immediate
+        );
+
+        /// <summary>
+        /// Queues a copy of the contents of a buffer back to the host. Thread safe.
+        /// </summary>
+        /// <param name="buffer">The buffer to copy from. Must have transfer source usage.</param>
+        /// <param name="size">The number of bytes to copy.</param>
+        /// <param name="offset">The offset in the buffer to copy from in bytes.</param>
+        /// <param name="callback">The function given the data once the copy completes, invoked from <see cref="Update"/>.</param>
+        /// <param name="priority">The priority of the readback.</param>
+        /// <returns>The request ID, used to check for completion. Zero if the request was invalid.</returns>
+        uint64_t Readback(
+            const Buffer& buffer,
+            const VkDeviceSize& size,
+            const VkDeviceSize& offset,
+            ReadbackCallback&& callback,
+            const StreamPriority& priority = StreamPriority::Normal
+        );
+
+        /// <summary>
+        /// Queues a copy of part of an image back to the host. Thread safe.
+        /// </summary>
+        /// <param name="image">The image to copy from. Must have transfer source usage.</param>
+        /// <param name="size">The number of bytes to copy.</param>
+        /// <param name="region">The region to copy, with a buffer offset relative to the start of the data.</param>
+        /// <param name="layout">The layout the whole image is in when the readback is submitted, which it is returned to afterwards.</param>
+        /// <param name="callback">The function given the data once the copy completes, invoked from <see cref="Update"/>.</param>
+        /// <param name="priority">The priority of the readback.</param>
+        /// <returns>The request ID, used to check for completion. Zero if the request was invalid.</returns>
+        uint64_t Readback(
+            Image& image,
+            const VkDeviceSize& size,
+            const VkBufferImageCopy& region,
+            const VkImageLayout& layout,
+            ReadbackCallback&& callback,
+            const StreamPriority& priority = StreamPriority::Normal
+        );
+
+        /// <summary>
+        /// Submits queued uploads in priority order until the streaming budget is used, so work submitted
+        /// afterwards sees the data. Must be called on the render thread before the frame is submitted.
+        /// </summary>
+        void FlushUploads();
+
+        /// <summary>
+        /// Submits queued readbacks in priority order until the streaming budget is used, so they see the work
+        /// submitted before them. Must be called on the render thread after the frame is submitted.
+        /// </summary>
+        void FlushReadbacks();
+
+        /// <summary>
+        /// Drops the queued requests for an image which is being destroyed. Requests that were already submitted
+        /// don't touch the image again. Thread safe.
+        /// </summary>
+        /// <param name="image">The image being destroyed.</param>
+        void Cancel(const Image& image);
+
+        /// <summary>
+        /// Drops the queued requests for a buffer which is being destroyed. Requests that were already submitted
+        /// don't touch the buffer again. Thread safe.
+        /// </summary>
+        /// <param name="buffer">The buffer being destroyed.</param>
+        void Cancel(const Buffer& buffer);
+
+        /// <summary>
+        /// Checks if a request has completed. Thread safe.
+        /// </summary>
+        /// <param name="request">The request to check.</param>
+        bool IsComplete(const uint64_t& request);
+
+        /// <summary>
+        /// Blocks until a request has completed, submitting it if needed. Must be called on the render thread.
+        /// </summary>
+        /// <param name="request">The request to wait for.</param>
+        void Wait(const uint64_t& request);
+
+        /// <summary>
+        /// Releases the resources of completed batches and invokes the callbacks of completed readbacks.
+        /// Must be called on the render thread.
+        /// </summary>
+        void Update();
+
+        /// <summary>
+        /// Gets the number of bytes submitted which have not yet completed.
+        /// </summary>
+        const VkDeviceSize& GetBytesInFlight() const { return m_bytesInFlight; }
+
+    private:
+        /// <summary>
+        /// The granularity readback buffers are allocated with, so they can be reused by similar requests.
+        /// </summary>
+        static const VkDeviceSize READBACK_BLOCK_SIZE = 64 * 1024;
+
+        /// <summary>
+        /// The maximum number of bytes of idle readback buffers kept for reuse.
+        /// </summary>
+        static const VkDeviceSize READBACK_POOL_SIZE = 32 * 1024 * 1024;
+
+        enum struct RequestType
+        {
+            BufferUpload,
+            ImageUpload,
+            BufferReadback,
+            ImageReadback,
+        };
+
+        struct Request
+        {
+            uint64_t id;
+            RequestType type;
+            StreamPriority priority;
+            VkBuffer buffer;
+            Image* image;
+            VkImageLayout layout;
+            VkDeviceSize offset;
+            VkDeviceSize size;
+            eastl::vector<uint8_t> data;
+            VkBuffer staging;
+            VkDeviceSize stagingOffset;
+            eastl::shared_ptr<Buffer> stagingBuffer;
+            eastl::vector<VkBufferImageCopy> regions;
+            ReadbackCallback callback;
+            bool transferQueue;
+        };
+
+        struct Batch
+        {
+            VkFence fence;
+            VkSemaphore semaphore;
+            VkDeviceSize bytes;
+            eastl::unique_ptr<CommandBuffer> transferCommands;
+            eastl::unique_ptr<CommandBuffer> graphicsCommands;
+            eastl::vector<Request> requests;
+        };
+
+        /// <summary>
+        /// Copies the data of an upload into the staging memory of a frame, or a staging buffer of its own.
+        /// </summary>
+        /// <param name="frame">The frame the upload is submitted in.</param>
+        /// <param name="request">The upload to stage.</param>
+        /// <param name="force">If the upload must be staged now, even if the frame's staging memory is full.</param>
+        /// <returns>If the upload was staged, otherwise it should wait for the next frame.</returns>
+        bool Stage(FrameContext& frame, Request& request, const bool& force);
+
+        /// <summary>
+        /// Gets a buffer from the readback pool large enough for a request.
+        /// </summary>
+        eastl::shared_ptr<Buffer> AcquireReadbackBuffer(const VkDeviceSize& size);
+
+        /// <summary>
+        /// Invokes the callbacks of completed requests and returns their readback buffers to the pool.
+        /// </summary>
+        void Complete(eastl::vector<Request>& completed);
+
+        /// <summary>
+        /// Submits the queued uploads or readbacks in a batch.
+        /// </summary>
+        /// <param name="ignoreBudget">If every request should be submitted regardless of the streaming budget.</param>
+        /// <param name="readbacks">If readbacks should be submitted rather than uploads.</param>
+        void FlushLocked(const bool& ignoreBudget, const bool& readbacks);
+        void UpdateLocked(eastl::vector<Request>& completed);
+
+        /// <summary>
+        /// Records the uploads that run on a queue. The first upload to buffers and image subresources runs on
+        /// the transfer queue when there is one, which claims them by being recorded first.
+        /// </summary>
+        /// <returns>If any uploads were recorded.</returns>
+        bool RecordUploads(const CommandBuffer& commandBuffer, eastl::vector<Request>& requests, const bool& isTransferQueue);
+        void RecordAcquires(const CommandBuffer& commandBuffer, const eastl::vector<Request>& requests) const;
+        void RecordReadbacks(const CommandBuffer& commandBuffer, const eastl::vector<Request>& requests) const;
+
+        /// <summary>
+        /// Gets the mip level and array layer of each subresource an image upload writes to.
+        /// </summary>
+        static eastl::vector<eastl::pair<uint32_t, uint32_t>> GetSubresources(const Request& request);
+
+        /// <summary>
+        /// Gets if the buffer, or none of the image subresources, an upload writes to have been uploaded to before.
+        /// </summary>
+        bool IsFirstUpload(const Request& request) const;
+
+        /// <summary>
+        /// Gets if a request copies data back to the host.
+        /// </summary>
+        static bool IsReadback(const Request& request);
+
+        std::mutex m_mutex;
+        uint64_t m_nextRequest;
+
+        eastl::vector<eastl::shared_ptr<Buffer>> m_readbackPool;
+        VkDeviceSize m_readbackPoolSize;
+
+        /// <summary>
+        /// The buffers which have had an upload submitted, so later uploads must keep their contents.
+        /// </summary>
+        eastl::unordered_set<VkBuffer> m_uploadedBuffers;
+
+        eastl::vector<Request> m_pending;
+        eastl::vector<Batch> m_batches;
+        VkDeviceSize m_bytesInFlight;
+    };
+}
\ No newline at end of file
@@ -22,12 +22,55 @@ namespace Mantis
                 case VK_FORMAT_R8G8B8A8_SRGB:
                 case VK_FORMAT_B8G8R8A8_SRGB:
                 case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+                case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                case VK_FORMAT_BC2_SRGB_BLOCK:
+                case VK_FORMAT_BC3_SRGB_BLOCK:
+                case VK_FORMAT_BC7_SRGB_BLOCK:
                     return true;
                 default:
                     return false;
             }
         }
 
+        /// <summary>
+        /// Gets the format with the same layout as an sRGB format but without the sRGB encoding.
+        /// </summary>
+        /// <param name="format">The format to convert.</param>
+        /// <returns>The UNORM equivalent of sRGB formats, otherwise the format unchanged.</returns>
+        static inline VkFormat GetLinearFormat(VkFormat format)
+        {
+            switch (format)
+            {
+                case VK_FORMAT_R8_SRGB:
+                    return VK_FORMAT_R8_UNORM;
+                case VK_FORMAT_R8G8_SRGB:
+                    return VK_FORMAT_R8G8_UNORM;
+                case VK_FORMAT_R8G8B8_SRGB:
+                    return VK_FORMAT_R8G8B8_UNORM;
+                case VK_FORMAT_B8G8R8_SRGB:
+                    return VK_FORMAT_B8G8R8_UNORM;
+                case VK_FORMAT_R8G8B8A8_SRGB:
+                    return VK_FORMAT_R8G8B8A8_UNORM;
+                case VK_FORMAT_B8G8R8A8_SRGB:
+                    return VK_FORMAT_B8G8R8A8_UNORM;
+                case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+                    return VK_FORMAT_A8B8G8R8_UNORM_PACK32;
+                case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                    return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+                case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                    return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+                case VK_FORMAT_BC2_SRGB_BLOCK:
+                    return VK_FORMAT_BC2_UNORM_BLOCK;
+                case VK_FORMAT_BC3_SRGB_BLOCK:
+                    return VK_FORMAT_BC3_UNORM_BLOCK;
+                case VK_FORMAT_BC7_SRGB_BLOCK:
+                    return VK_FORMAT_BC7_UNORM_BLOCK;
+                default:
+                    return format;
+            }
+        }
+
         /// <summary>
         /// Checks if a format has a depth aspect.
         /// </summary>
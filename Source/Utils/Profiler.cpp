@@ -0,0 +1,342 @@
+#include "stdafx.h"
+#include "Profiler.h"
+
+#include "TraceWriter.h"
+
+#define LOG_TAG MANTIS_TEXT("Profiler")
+
+namespace Mantis
+{
+#if defined(MANTIS_PROFILE)
+    /// <summary>
+    /// How long in milliseconds the collector waits between draining the thread buffers.
+    /// </summary>
+    static const uint32_t COLLECT_INTERVAL = 5;
+
+    /// <summary>
+    /// The most events a capture may hold, after which further events are not captured.
+    /// </summary>
+    static const size_t MAX_CAPTURE_EVENTS = 1 << 22;
+
+    thread_local Profiler::ThreadBuffer* Profiler::s_threadBuffer = nullptr;
+
+    /// <summary>
+    /// Marks the buffer of a thread as retired when the thread exits, so the collector can release it once drained.
+    /// </summary>
+    struct ThreadBufferOwner
+    {
+        eastl::shared_ptr<Profiler::ThreadBuffer> buffer;
+
+        ~ThreadBufferOwner()
+        {
+            if (buffer)
+            {
+                buffer->retired = true;
+            }
+        }
+    };
+
+    static thread_local ThreadBufferOwner s_threadBufferOwner;
+
+    struct CapturedEvent
+    {
+        Profiler::Event event;
+        uint32_t thread;
+    };
+
+    struct ProfilerState
+    {
+        std::mutex mutex;
+        eastl::vector<eastl::shared_ptr<Profiler::ThreadBuffer>> buffers;
+        eastl::unordered_map<uint32_t, String> threadNames;
+        uint32_t nextThreadId = 0;
+
+        eastl::unordered_map<const ProfileSite*, ProfileStats> stats;
+        uint64_t dropped = 0;
+
+        bool capturing = false;
+        bool captureFull = false;
+        eastl::vector<CapturedEvent> capture;
+
+        std::thread thread;
+        std::atomic<bool> running { false };
+
+        // the ticks are calibrated against the steady clock over the time since the first use
+        uint64_t startTicks = Profiler::GetTicks();
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        double ticksPerNanosecond = 1.0;
+    };
+
+    static ProfilerState& GetState()
+    {
+        static ProfilerState state;
+        return state;
+    }
+
+    static void UpdateCalibration(ProfilerState& state)
+    {
+        auto ticks = Profiler::GetTicks() - state.startTicks;
+        auto nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - state.startTime).count();
+
+        if (nanoseconds > 0.0 && ticks > 0)
+        {
+            state.ticksPerNanosecond = static_cast<double>(ticks) / nanoseconds;
+        }
+    }
+
+    static double TicksToMilliseconds(const ProfilerState& state, const uint64_t& ticks)
+    {
+        return static_cast<double>(ticks) / state.ticksPerNanosecond / 1000000.0;
+    }
+
+    Profiler::ThreadBuffer* Profiler::RegisterThread()
+    {
+        auto& state = GetState();
+        auto buffer = eastl::make_shared<ThreadBuffer>();
+
+        buffer->write = 0;
+        buffer->read = 0;
+        buffer->dropped = 0;
+        buffer->retired = false;
+        buffer->depth = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            buffer->id = state.nextThreadId++;
+            state.buffers.push_back(buffer);
+        }
+
+        s_threadBufferOwner.buffer = buffer;
+        s_threadBuffer = buffer.get();
+        return s_threadBuffer;
+    }
+#endif
+
+    void Profiler::Init()
+    {
+#if defined(MANTIS_PROFILE)
+        auto& state = GetState();
+
+        if (state.running)
+        {
+            return;
+        }
+
+        SetThreadName(MANTIS_TEXT("Main"));
+
+        state.running = true;
+        state.thread = std::thread([]()
+        {
+            SetThreadName(MANTIS_TEXT("Profiler"));
+
+            while (GetState().running)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(COLLECT_INTERVAL));
+                Collect();
+            }
+        });
+#endif
+    }
+
+    void Profiler::Deinit()
+    {
+#if defined(MANTIS_PROFILE)
+        auto& state = GetState();
+
+        if (!state.running)
+        {
+            return;
+        }
+
+        state.running = false;
+
+        if (state.thread.joinable())
+        {
+            state.thread.join();
+        }
+
+        Collect();
+
+        if (state.dropped > 0)
+        {
+            Logger::WarningTF(LOG_TAG, "%llu profiler events were dropped because a thread buffer was full!", static_cast<unsigned long long>(state.dropped));
+        }
+#endif
+    }
+
+    void Profiler::SetThreadName(const String& name)
+    {
+#if defined(MANTIS_PROFILE)
+        auto buffer = GetThreadBuffer();
+        auto& state = GetState();
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.threadNames[buffer->id] = name;
+#endif
+    }
+
+    void Profiler::Collect()
+    {
+#if defined(MANTIS_PROFILE)
+        auto& state = GetState();
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        UpdateCalibration(state);
+
+        for (auto itr = state.buffers.begin(); itr != state.buffers.end();)
+        {
+            auto& buffer = **itr;
+
+            // check if the thread has exited before draining, so no events can be missed
+            auto retired = buffer.retired.load();
+            auto read = buffer.read.load(std::memory_order_relaxed);
+            auto write = buffer.write.load(std::memory_order_acquire);
+
+            for (; read != write; read++)
+            {
+                const auto& event = buffer.events[read & (ThreadBuffer::CAPACITY - 1)];
+                auto time = TicksToMilliseconds(state, event.end - event.begin);
+
+                auto statsItr = state.stats.find(event.site);
+
+                if (statsItr == state.stats.end())
+                {
+                    state.stats[event.site] = { event.site, 1, time, time, time };
+                }
+                else
+                {
+                    auto& stats = statsItr->second;
+                    stats.count++;
+                    stats.total += time;
+                    stats.min = eastl::min(stats.min, time);
+                    stats.max = eastl::max(stats.max, time);
+                }
+
+                if (state.capturing)
+                {
+                    if (state.capture.size() < MAX_CAPTURE_EVENTS)
+                    {
+                        state.capture.push_back({ event, buffer.id });
+                    }
+                    else if (!state.captureFull)
+                    {
+                        Logger::WarningT(LOG_TAG, "The profiler capture is full, later events are not captured!");
+                        state.captureFull = true;
+                    }
+                }
+            }
+
+            // let the thread reuse the drained space
+            buffer.read.store(read, std::memory_order_release);
+            state.dropped += buffer.dropped.exchange(0, std::memory_order_relaxed);
+
+            if (retired)
+            {
+                itr = state.buffers.erase(itr);
+            }
+            else
+            {
+                ++itr;
+            }
+        }
+#endif
+    }
+
+    eastl::vector<ProfileStats> Profiler::GetStats()
+    {
+        eastl::vector<ProfileStats> stats;
+
+#if defined(MANTIS_PROFILE)
+        auto& state = GetState();
+
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+
+            for (const auto& entry : state.stats)
+            {
+                stats.push_back(entry.second);
+            }
+        }
+
+        eastl::sort(stats.begin(), stats.end(), [](const ProfileStats& a, const ProfileStats& b)
+        {
+            return a.total > b.total;
+        });
+#endif
+
+        return stats;
+    }
+
+    void Profiler::ResetStats()
+    {
+#if defined(MANTIS_PROFILE)
+        auto& state = GetState();
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.stats.clear();
+#endif
+    }
+
+    void Profiler::BeginCapture()
+    {
+#if defined(MANTIS_PROFILE)
+        auto& state = GetState();
+
+        // events recorded before the capture began should not be part of it
+        Collect();
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.capture.clear();
+        state.captureFull = false;
+        state.capturing = true;
+#endif
+    }
+
+    void Profiler::EndCapture()
+    {
+#if defined(MANTIS_PROFILE)
+        auto& state = GetState();
+
+        Collect();
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.capturing = false;
+#endif
+    }
+
+    bool Profiler::WriteTrace(const PathRoot& root, const String& path)
+    {
+#if defined(MANTIS_PROFILE)
+        auto& state = GetState();
+
+        TraceWriter trace;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+
+            for (const auto& thread : state.threadNames)
+            {
+                trace.AddThreadName(thread.first, thread.second);
+            }
+
+            for (const auto& captured : state.capture)
+            {
+                const auto& event = captured.event;
+
+                trace.BeginEvent(event.site->name, "cpu", captured.thread,
+                    TicksToMilliseconds(state, event.begin - state.startTicks) * 1000.0,
+                    TicksToMilliseconds(state, event.end - event.begin) * 1000.0);
+                trace.AddArgument("depth", event.depth);
+                trace.AddArgument("line", event.site->line);
+                trace.AddArgument("file", event.site->file);
+                trace.EndEvent();
+            }
+        }
+
+        return trace.Write(root, path);
+#else
+        Logger::WarningT(LOG_TAG, "Profiling is disabled in this build!");
+        return false;
+#endif
+    }
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include "IO/Filesystem.h"
+
+#if defined(MANTIS_PROFILE)
+#   include <atomic>
+#   include <chrono>
+#   if (defined(MANTIS_64) || defined(MANTIS_32)) && defined(MANTIS_MSCV)
+#       include <intrin.h>
+#   elif defined(MANTIS_64) || defined(MANTIS_32)
+#       include <x86intrin.h>
+#   endif
+#endif
+
+#define MANTIS_PROFILE_CONCAT_INNER(a, b) a##b
+#define MANTIS_PROFILE_CONCAT(a, b) MANTIS_PROFILE_CONCAT_INNER(a, b)
+
+#if defined(MANTIS_PROFILE)
+/// <summary>
+/// Measures the CPU time until the end of the enclosing scope. The name must be a string literal.
+/// </summary>
+#   define MANTIS_PROFILE_SCOPE(name) \
+        static const ::Mantis::ProfileSite MANTIS_PROFILE_CONCAT(mantisProfileSite, __LINE__) = { name, __FILE__, __LINE__ }; \
+        const ::Mantis::ProfileScope MANTIS_PROFILE_CONCAT(mantisProfileScope, __LINE__)(&MANTIS_PROFILE_CONCAT(mantisProfileSite, __LINE__))
+#else
+#   define MANTIS_PROFILE_SCOPE(name)
+#endif
+
+namespace Mantis
+{
+    /// <summary>
+    /// A location in the source code that is profiled. Sites are static, so events refer to them by pointer.
+    /// </summary>
+    struct ProfileSite
+    {
+        const char* name;
+        const char* file;
+        uint32_t line;
+    };
+
+    /// <summary>
+    /// The CPU time spent in a profiled site, in milliseconds.
+    /// </summary>
+    struct ProfileStats
+    {
+        const ProfileSite* site;
+        uint64_t count;
+        double total;
+        double min;
+        double max;
+    };
+
+    /// <summary>
+    /// Collects the CPU time of scopes marked using MANTIS_PROFILE_SCOPE.
+    /// </summary>
+    /// <remarks>
+    /// Each thread records the start and end of its scopes into its own lock-free ring buffer, which costs a couple of
+    /// timestamp reads and a store. A collector thread drains the buffers, accumulating the time spent in each site
+    /// and, while capturing, keeping the events for export. Events are dropped if a thread fills its buffer before the
+    /// collector drains it. Compiled out entirely when MANTIS_NO_PROFILE is defined, as it is in the Release-NoProfile
+    /// configuration.
+    /// </remarks>
+    class Profiler
+    {
+    public:
+        /// <summary>
+        /// Starts the collector thread.
+        /// </summary>
+        static void Init();
+
+        /// <summary>
+        /// Stops the collector thread.
+        /// </summary>
+        static void Deinit();
+
+        /// <summary>
+        /// Names the calling thread in exported traces.
+        /// </summary>
+        /// <param name="name">The name of the thread.</param>
+        static void SetThreadName(const String& name);
+
+        /// <summary>
+        /// Drains the events recorded by all threads. Called periodically by the collector thread.
+        /// </summary>
+        static void Collect();
+
+        /// <summary>
+        /// Gets the time spent in each site since the stats were last reset, most total time first.
+        /// </summary>
+        static eastl::vector<ProfileStats> GetStats();
+
+        /// <summary>
+        /// Clears the accumulated stats.
+        /// </summary>
+        static void ResetStats();
+
+        /// <summary>
+        /// Starts keeping the recorded events for export, discarding any previous capture.
+        /// </summary>
+        static void BeginCapture();
+
+        /// <summary>
+        /// Stops keeping the recorded events.
+        /// </summary>
+        static void EndCapture();
+
+        /// <summary>
+        /// Writes the captured events to a trace file, which can be opened in chrome://tracing or Perfetto, or
+        /// converted for Tracy using its chrome trace importer.
+        /// </summary>
+        /// <param name="root">The folder the path is relative to.</param>
+        /// <param name="path">The path of the file.</param>
+        /// <returns>True if the file was written.</returns>
+        static bool WriteTrace(const PathRoot& root, const String& path);
+
+#if defined(MANTIS_PROFILE)
+        /// <summary>
+        /// A completed scope.
+        /// </summary>
+        struct Event
+        {
+            const ProfileSite* site;
+            uint64_t begin;
+            uint64_t end;
+            uint32_t depth;
+        };
+
+        /// <summary>
+        /// The events recorded by one thread, written by that thread and read by the collector.
+        /// </summary>
+        struct ThreadBuffer
+        {
+            /// <summary>
+            /// The number of events each buffer can hold. Must be a power of two.
+            /// </summary>
+            static const uint32_t CAPACITY = 1 << 14;
+
+            std::atomic<uint64_t> write;
+            std::atomic<uint64_t> read;
+            std::atomic<uint64_t> dropped;
+            std::atomic<bool> retired;
+            uint32_t depth;
+            uint32_t id;
+            Event events[CAPACITY];
+        };
+
+        /// <summary>
+        /// Gets the current time in ticks of the fastest available clock.
+        /// </summary>
+        static uint64_t GetTicks()
+        {
+#if defined(MANTIS_64) || defined(MANTIS_32)
+            return __rdtsc();
+#else
+            return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+        }
+
+        /// <summary>
+        /// Gets the buffer of the calling thread.
+        /// </summary>
+        static ThreadBuffer* GetThreadBuffer()
+        {
+            return s_threadBuffer != nullptr ? s_threadBuffer : RegisterThread();
+        }
+
+        /// <summary>
+        /// Adds an event to a thread buffer, dropping it if the buffer is full.
+        /// </summary>
+        static void Record(ThreadBuffer* buffer, const Event& event)
+        {
+            auto write = buffer->write.load(std::memory_order_relaxed);
+
+            if (write - buffer->read.load(std::memory_order_acquire) >= ThreadBuffer::CAPACITY)
+            {
+                buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            buffer->events[write & (ThreadBuffer::CAPACITY - 1)] = event;
+            buffer->write.store(write + 1, std::memory_order_release);
+        }
+
+    private:
+        static ThreadBuffer* RegisterThread();
+
+        static thread_local ThreadBuffer* s_threadBuffer;
+#endif
+    };
+
+#if defined(MANTIS_PROFILE)
+    /// <summary>
+    /// Records the time spent until the object goes out of scope. Use MANTIS_PROFILE_SCOPE rather than using this directly.
+    /// </summary>
+    class ProfileScope
+    {
+    public:
+        explicit ProfileScope(const ProfileSite* site) :
+            m_site(site),
+            m_buffer(Profiler::GetThreadBuffer())
+        {
+            m_depth = m_buffer->depth++;
+            m_begin = Profiler::GetTicks();
+        }
+
+        ~ProfileScope()
+        {
+            auto end = Profiler::GetTicks();
+            m_buffer->depth--;
+            Profiler::Record(m_buffer, { m_site, m_begin, end, m_depth });
+        }
+
+        // not derived from NonCopyable, to keep the scope free of a vtable
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        const ProfileSite* m_site;
+        Profiler::ThreadBuffer* m_buffer;
+        uint64_t m_begin;
+        uint32_t m_depth;
+    };
+#endif
+}
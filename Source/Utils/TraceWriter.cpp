@@ -0,0 +1,123 @@
+#include "stdafx.h"
+#include "TraceWriter.h"
+
+#include "IO/FileStream.h"
+
+#define LOG_TAG MANTIS_TEXT("TraceWriter")
+
+namespace Mantis
+{
+    TraceWriter::TraceWriter() :
+        m_json("{\"traceEvents\":["),
+        m_hasEvents(false),
+        m_hasArguments(false)
+    {
+    }
+
+    void TraceWriter::AddThreadName(const uint32_t& thread, const String& name)
+    {
+        m_json.append(m_hasEvents ? ",\n" : "\n");
+        m_json.append_sprintf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":", thread);
+        AppendString(name.c_str());
+        m_json.append("}}");
+        m_hasEvents = true;
+    }
+
+    void TraceWriter::BeginEvent(const char* name, const char* category, const uint32_t& thread, const double& start, const double& duration)
+    {
+        m_json.append(m_hasEvents ? ",\n" : "\n");
+        m_json.append("{\"name\":");
+        AppendString(name);
+        m_json.append(",\"cat\":");
+        AppendString(category);
+        m_json.append_sprintf(",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{", thread, start, duration);
+        m_hasEvents = true;
+        m_hasArguments = false;
+    }
+
+    void TraceWriter::AddArgument(const char* name, const uint64_t& value)
+    {
+        AppendArgumentName(name);
+        m_json.append_sprintf("%llu", static_cast<unsigned long long>(value));
+    }
+
+    void TraceWriter::AddArgument(const char* name, const char* value)
+    {
+        AppendArgumentName(name);
+        AppendString(value);
+    }
+
+    void TraceWriter::EndEvent()
+    {
+        m_json.append("}}");
+    }
+
+    bool TraceWriter::Write(const PathRoot& root, const String& path) const
+    {
+        auto json = m_json;
+        json.append("\n],\"displayTimeUnit\":\"ms\"}\n");
+
+        return WriteFile(root, path, json);
+    }
+
+    bool TraceWriter::WriteFile(const PathRoot& root, const String& path, const String& contents)
+    {
+        auto file = Filesystem::Open(root, path, FileMode::Overwrite);
+
+        if (file == nullptr)
+        {
+            Logger::ErrorTF(LOG_TAG, "Failed to open \"%s\"!", path.c_str());
+            return false;
+        }
+
+        auto size = static_cast<int>(contents.size());
+
+        if (!file->Write(reinterpret_cast<const uint8_t*>(contents.data()), size, size))
+        {
+            Logger::ErrorTF(LOG_TAG, "Failed to write \"%s\"!", path.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    void TraceWriter::AppendString(const char* value)
+    {
+        m_json.push_back('"');
+
+        for (auto c = value; *c != '\0'; c++)
+        {
+            switch (*c)
+            {
+                case '"':   m_json.append("\\\""); break;
+                case '\\':  m_json.append("\\\\"); break;
+                case '\n':  m_json.append("\\n"); break;
+                case '\t':  m_json.append("\\t"); break;
+                default:
+                    if (static_cast<uint8_t>(*c) < 0x20)
+                    {
+                        m_json.append_sprintf("\\u%04x", static_cast<uint32_t>(*c));
+                    }
+                    else
+                    {
+                        m_json.push_back(*c);
+                    }
+                    break;
+            }
+        }
+
+        m_json.push_back('"');
+    }
+
+    void TraceWriter::AppendArgumentName(const char* name)
+    {
+        if (m_hasArguments)
+        {
+            m_json.push_back(',');
+        }
+
+        AppendString(name);
+        m_json.push_back(':');
+        m_hasArguments = true;
+    }
+}
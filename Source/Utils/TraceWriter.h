@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Mantis.h"
+
+#include "IO/Filesystem.h"
+
+namespace Mantis
+{
+    /// <summary>
+    /// Builds a trace in the Chrome trace event format, which can be opened in chrome://tracing or Perfetto.
+    /// </summary>
+    /// <remarks>
+    /// All events belong to a single process. Each thread is shown as its own track, which may also be used for
+    /// things that aren't threads, such as GPU queues. Times are given in microseconds.
+    /// </remarks>
+    class TraceWriter :
+        public NonCopyable
+    {
+    public:
+        TraceWriter();
+
+        /// <summary>
+        /// Names a track.
+        /// </summary>
+        /// <param name="thread">The id of the track.</param>
+        /// <param name="name">The name shown for the track.</param>
+        void AddThreadName(const uint32_t& thread, const String& name);
+
+        /// <summary>
+        /// Begins an event with a duration. Arguments may be added until the event is ended.
+        /// </summary>
+        /// <param name="name">The name of the event.</param>
+        /// <param name="category">The category of the event.</param>
+        /// <param name="thread">The id of the track the event is on.</param>
+        /// <param name="start">The start time of the event in microseconds.</param>
+        /// <param name="duration">The duration of the event in microseconds.</param>
+        void BeginEvent(const char* name, const char* category, const uint32_t& thread, const double& start, const double& duration);
+
+        /// <summary>
+        /// Adds an argument shown with the current event.
+        /// </summary>
+        void AddArgument(const char* name, const uint64_t& value);
+
+        /// <summary>
+        /// Adds an argument shown with the current event.
+        /// </summary>
+        void AddArgument(const char* name, const char* value);
+
+        /// <summary>
+        /// Ends the current event.
+        /// </summary>
+        void EndEvent();
+
+        /// <summary>
+        /// Writes the trace to a file.
+        /// </summary>
+        /// <param name="root">The folder the path is relative to.</param>
+        /// <param name="path">The path of the file.</param>
+        /// <returns>True if the file was written.</returns>
+        bool Write(const PathRoot& root, const String& path) const;
+
+        /// <summary>
+        /// Writes text to a file, replacing its contents and logging an error on failure.
+        /// </summary>
+        /// <param name="root">The folder the path is relative to.</param>
+        /// <param name="path">The path of the file.</param>
+        /// <param name="contents">The text to write.</param>
+        /// <returns>True if the file was written.</returns>
+        static bool WriteFile(const PathRoot& root, const String& path, const String& contents);
+
+    private:
+        /// <summary>
+        /// Appends a quoted string with the characters JSON requires escaped.
+        /// </summary>
+        void AppendString(const char* value);
+
+        /// <summary>
+        /// Begins an argument, separating it from the previous one.
+        /// </summary>
+        void AppendArgumentName(const char* name);
+
+        String m_json;
+        bool m_hasEvents;
+        bool m_hasArguments;
+    };
+}